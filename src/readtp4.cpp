@@ -495,47 +495,8 @@ bool ReadTP4::compareManifest(struct MANIFEST& m1, struct MANIFEST& m2)
 
 string ReadTP4::cp1250ToUTF8(const string& str)
 {
-    string out;
-
-    for (size_t j = 0; j < str.length(); j++)
-    {
-        int i = -1;
-        unsigned char ch = str.at(j);
-        short utf = -1;
-
-        if (ch < 0x80)
-        {
-            do
-            {
-                i++;
-
-                if (__cht[i].ch == ch)
-                {
-                    utf = __cht[i].byte;
-                    break;
-                }
-            }
-            while (__cht[i].ch != 0xff);
-
-            if (utf < 0)
-                utf = ch;
-        }
-        else
-            utf = ch;
-
-        if (utf > 0x00ff)
-        {
-            out.push_back((utf >> 8) & 0x00ff);
-            out.push_back(utf & 0x00ff);
-        }
-        else if (ch > 0x7f)
-        {
-            out.push_back(0xc0 | ch >> 6);
-            out.push_back(0x80 | (ch & 0x3f));
-        }
-        else
-            out.push_back(ch);
-    }
-
-    return out;
+    // The former conversion table was never consulted for characters above
+    // 0x7f. Therefore this always was a conversion from Latin-1. The names of
+    // the files already extracted depend on it, so it is kept as it is.
+    return latin1ToUTF8(str);
 }
@@ -269,7 +269,7 @@ CMD_DEFINATIONS cmdDefinations[] = {
     { "", false, false, '\0' }
 };
 
-CMD_DEFINATIONS& findCmdDefines(const string& cmd)
+const CMD_DEFINATIONS *findCmdDefines(const string& cmd)
 {
     DECL_TRACER("findCmdDefines(const string& cmd)");
 
@@ -280,17 +280,19 @@ CMD_DEFINATIONS& findCmdDefines(const string& cmd)
     while (cmdDefinations[i].cmd.length() > 0)
     {
         if (cmdDefinations[i].cmd.compare(uCmd) == 0)
-            return cmdDefinations[i];
+            return &cmdDefinations[i];
 
         i++;
     }
 
-    return cmdDefinations[i];
+    return nullptr;
 }
 
 TAmxCommands::TAmxCommands()
 {
     DECL_TRACER("TAmxCommands::TAmxCommands()");
+
+    mCmdTable.reserve(sizeof(cmdDefinations) / sizeof(CMD_DEFINATIONS));
 }
 
 TAmxCommands::~TAmxCommands()
@@ -337,9 +339,9 @@ bool TAmxCommands::readMap(bool tp5)
     return !err;
 }
 
-vector<string> TAmxCommands::getFields(string& msg, char sep)
+vector<string> TAmxCommands::getFields(const string& msg, char sep)
 {
-    DECL_TRACER("TAmxCommands::getFields(string& msg, char sep)");
+    DECL_TRACER("TAmxCommands::getFields(const string& msg, char sep)");
 
     vector<string> flds;
     bool bStr = false;
@@ -358,7 +360,7 @@ vector<string> TAmxCommands::getFields(string& msg, char sep)
         else if (msg.at(i) == '\'' && bStr)
             bStr = false;
         else
-            part.append(msg.substr(i, 1));
+            part.push_back(msg[i]);
     }
 
     if (!part.empty())
@@ -473,92 +475,81 @@ bool TAmxCommands::parseCommand(int device, int port, const string& cmd)
 {
     DECL_TRACER("TAmxCommands::parseCommand(int device, int port, const string& cmd)");
 
-    vector<CMD_TABLE>::iterator iter;
     size_t pos = cmd.find_first_of("-");
     int system = TConfig::getSystem();
     string scmd = getCommand(cmd);
 
     MSG_TRACE("Parsing for device <" << device << ":" << port << ":" << system << "> the command: " << scmd);
 
-    if (pos != string::npos)    // Command with parameters
+    std::unordered_map<string, CMD_TABLE>::iterator iter = mCmdTable.find(scmd);
+
+    if (iter != mCmdTable.end() && iter->second.command)
     {
-        string rest = cmd.substr(pos + 1);
+        CMD_TABLE& ctbl = iter->second;
+        ctbl.channels.clear();
+        ctbl.pars.clear();
 
-        for (iter = mCmdTable.begin(); iter != mCmdTable.end(); ++iter)
+        // A command without parameters is called directly.
+        if (pos == string::npos || setParameters(ctbl, scmd, cmd.substr(pos + 1)))
         {
-            iter->channels.clear();
-            iter->pars.clear();
+            ctbl.command(port, ctbl.channels, ctbl.pars);
+            return true;
+        }
+    }
 
-            if (iter->cmd.compare(scmd) == 0 && iter->command)
-            {
-                CMD_DEFINATIONS cdef = findCmdDefines(scmd);
+    MSG_WARNING("Command \"" << cmd << "\" currently not supported!");
+#if TESTMODE == 1
+    __done = true;
+#endif
+    return false;
+}
 
-                if (cdef.cmd.empty())
-                {
-                    MSG_WARNING("Command \"" << scmd << "\" not found in command table! Ignoring it.");
-                    continue;
-                }
+bool TAmxCommands::setParameters(CMD_TABLE& ctbl, const string& scmd, const string& rest)
+{
+    DECL_TRACER("TAmxCommands::setParameters(CMD_TABLE& ctbl, const string& scmd, const string& rest)");
 
-                if (cdef.hasChannels || cdef.hasPars)
-                {
-                    vector<string> parts = getFields(rest, cdef.separator);
+    const CMD_DEFINATIONS *cdef = ctbl.cdef;
 
-                    if (cdef.hasChannels && !parts.empty())
-                        extractChannels(parts[0], &iter->channels);
-                    else if (parts.empty())
-                    {
-                        MSG_WARNING("Malformed command " << scmd << ". Ignoring it!");
-                        continue;
-                    }
+    if (!cdef)
+    {
+        MSG_WARNING("Command \"" << scmd << "\" not found in command table! Ignoring it.");
+        return false;
+    }
 
-                    if (cdef.hasPars)
-                    {
-                        MSG_DEBUG("Command may have parameters. Found " << parts.size() << " parameters.");
-
-                        if (parts.size() > 0)
-                        {
-                            vector<string>::iterator piter;
-                            int cnt = 0;
-
-                            for (piter = parts.begin(); piter != parts.end(); ++piter)
-                            {
-                                if (cdef.hasChannels && !cnt)
-                                {
-                                    cnt++;
-                                    continue;
-                                }
-
-                                iter->pars.push_back(*piter);
-                                cnt++;
-                            }
-                        }
-                        else
-                            iter->pars.push_back(rest);
-                    }
-                }
+    if (!cdef->hasChannels && !cdef->hasPars)
+        return true;
 
-                iter->command(port, iter->channels, iter->pars);
-                return true;
-            }
-        }
+    vector<string> parts = getFields(rest, cdef->separator);
+
+    if (cdef->hasChannels && !parts.empty())
+        extractChannels(parts[0], &ctbl.channels);
+    else if (parts.empty())
+    {
+        MSG_WARNING("Malformed command " << scmd << ". Ignoring it!");
+        return false;
     }
-    else        // Command without parameter
+
+    if (cdef->hasPars)
     {
-        for (iter = mCmdTable.begin(); iter != mCmdTable.end(); ++iter)
+        MSG_DEBUG("Command may have parameters. Found " << parts.size() << " parameters.");
+
+        if (parts.size() > 0)
         {
-            if (iter->cmd.compare(scmd) == 0 && iter->command)
-            {
-                iter->command(port, iter->channels, iter->pars);
-                return true;
-            }
+            vector<string>::iterator piter = parts.begin();
+
+            if (cdef->hasChannels)
+                ++piter;
+
+            ctbl.pars.reserve(parts.size());
+
+            for (; piter != parts.end(); ++piter)
+                ctbl.pars.push_back(std::move(*piter));
         }
+        else
+            ctbl.pars.push_back(rest);
     }
 
-    MSG_WARNING("Command \"" << cmd << "\" currently not supported!");
-#if TESTMODE == 1
-    __done = true;
-#endif
-    return false;
+    return true;
 }
 
 bool TAmxCommands::extractChannels(const string& schan, vector<int>* ch)
@@ -621,21 +612,12 @@ void TAmxCommands::registerCommand(std::function<void (int port, vector<int>& ch
 {
     DECL_TRACER("TAmxCommands::registerCommand(std::function<void (vector<int>& channels, vector<string>& pars)> command, const string& name)");
 
-    vector<CMD_TABLE>::iterator iter;
-
-    for (iter = mCmdTable.begin(); iter != mCmdTable.end(); ++iter)
-    {
-        if (iter->cmd.compare(name) == 0)
-        {
-            iter->command = command;
-            iter->channels.clear();
-            iter->pars.clear();
-            return;
-        }
-    }
-
-    CMD_TABLE ctbl;
+    // The syntax definition of the command is resolved here once, so
+    // parseCommand() needs only one lookup in the hash table.
+    CMD_TABLE& ctbl = mCmdTable[name];
     ctbl.cmd = name;
     ctbl.command = command;
-    mCmdTable.push_back(ctbl);
+    ctbl.cdef = findCmdDefines(name);
+    ctbl.channels.clear();
+    ctbl.pars.clear();
 }
@@ -21,6 +21,7 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <functional>
 
 #include "tbutton.h"
@@ -29,6 +30,7 @@
 
 class TPage;
 class TSubPage;
+struct CMD_DEFINATIONS;
 
 typedef struct PCHAIN_T
 {
@@ -51,6 +53,7 @@ class TAmxCommands : public TValidateFile
             std::vector<int> channels;      // Channels the command affects (200&210, ...)
             std::vector<std::string> pars;  // Rest of parameters of the command
             std::function<void (int port, std::vector<int>& channels, std::vector<std::string>& pars)> command{nullptr};
+            const CMD_DEFINATIONS *cdef{nullptr};   // The syntax definition of the command; resolved on registration
         }CMD_TABLE;
 
         TAmxCommands();
@@ -73,9 +76,10 @@ class TAmxCommands : public TValidateFile
 
     private:
         bool extractChannels(const std::string& schan, std::vector<int> *ch);
-        std::vector<std::string> getFields(std::string& msg, char sep);
+        bool setParameters(CMD_TABLE& ctbl, const std::string& scmd, const std::string& rest);
+        std::vector<std::string> getFields(const std::string& msg, char sep);
 
-        std::vector<CMD_TABLE> mCmdTable;
+        std::unordered_map<std::string, CMD_TABLE> mCmdTable;   // Registered commands, indexed by the command token
         PCHAIN_T *mPChain{nullptr};
         SPCHAIN_T *mSPChain{nullptr};
         TMap *mMap{nullptr};                // Map data of panel file
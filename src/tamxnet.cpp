@@ -90,7 +90,6 @@ std::map<ulong, FUNC_NETWORK_t> mFuncsNetwork;
 std::map<ulong, FUNC_TIMER_t> mFuncsTimer;
 std::map<ulong, FUNC_COORD_t> mFuncsCoord;
 
-//std::vector<ANET_COMMAND> TAmxNet::comStack; // commands to answer
 extern TPageManager *gPageManager;
 
 //mutex read_mutex;
@@ -157,6 +156,8 @@ void TAmxNet::init()
     stopped_ = false;
     write_busy = false;
     gAmxNet = this;
+    mSendQueue.reserve(RECV_BUF_SIZE);
+    mSendBatch.reserve(RECV_BUF_SIZE);
 
     if (!mSocket)
     {
@@ -339,6 +340,8 @@ void TAmxNet::stop(bool soft)
 
     if (mSocket)
         mSocket->close();
+
+    mSendCond.notify_all();
 }
 
 bool TAmxNet::reconnect()
@@ -396,6 +399,9 @@ void TAmxNet::start()
     {
         initSend = false;
         ready = false;
+        // A partial frame of a former connection must not be taken as the
+        // start of the new one.
+        mRecvStart = mRecvEnd = 0;
 
         if (__CommValid && TConfig::getController() == "0.0.0.0")
         {
@@ -463,6 +469,7 @@ void TAmxNet::handle_connect()
             mSocket->close();
     }
 
+    mRecvStart = mRecvEnd = 0;
     sendAllFuncNetwork(NSTATE_CONNECTING);
     setWaitTime(WAIT_RECONNECT);
 }
@@ -475,212 +482,173 @@ void TAmxNet::start_read()
         return;
 
     string _message = "TAmxNet::start_read(): Invalid argument received!";
-    protError = false;
-    comm.clear();
 
     try
     {
-        // Read the first byte. It should be 0x02
-        if (mSocket->readAbsolut(buff_, 1) == 1)
-            handle_read(1, RT_ID);
-        else if (mSocket->isConnected())
-        {
-            _message.append(" [RT_ID]");
-            XCEPTCOMM(_message);
-        }
-        else
-        {
-            setWaitTime(WAIT_RECONNECT);
-            return;
-        }
+        if (mRecvStart == mRecvEnd)
+            mRecvStart = mRecvEnd = 0;
 
-        if (mSocket->readAbsolut(buff_, 2) == 2)
-            handle_read(2, RT_LEN);
-        else if (mSocket->isConnected())
+        // Wait for at least one complete frame. All other frames already
+        // in the buffer are processed in the same pass.
+        do
         {
-            _message.append(" [RT_LEN]");
-            XCEPTCOMM(_message);
-        }
-        else
-        {
-            setWaitTime(WAIT_RECONNECT);
-            return;
-        }
+            protError = false;
+            comm.clear();
 
-        if (mSocket->readAbsolut(buff_, 1) == 1)
-            handle_read(1, RT_SEP1);
-        else if (mSocket->isConnected())
-        {
-            _message.append(" [RT_SEP1]");
-            XCEPTCOMM(_message);
-        }
-        else
-        {
-            setWaitTime(WAIT_RECONNECT);
-            return;
-        }
+            if (!fillBuffer(ICSP_HEADER_SIZE))
+            {
+                if (mSocket && mSocket->isConnected())
+                {
+                    _message.append(" [HEADER]");
+                    XCEPTCOMM(_message);
+                }
 
-        if (mSocket->readAbsolut(buff_, 1) == 1)
-            handle_read(1, RT_TYPE);
-        else if (mSocket->isConnected())
-        {
-            _message.append(" [RT_TYPE]");
-            XCEPTCOMM(_message);
-        }
-        else
-        {
-            setWaitTime(WAIT_RECONNECT);
-            return;
-        }
+                setWaitTime(WAIT_RECONNECT);
+                return;
+            }
 
-        if (mSocket->readAbsolut(buff_, 2) == 2)
-            handle_read(2, RT_WORD1);
-        else if (mSocket->isConnected())
-        {
-            _message.append(" [RT_WORD1]");
-            XCEPTCOMM(_message);
-        }
-        else
-        {
-            setWaitTime(30);
-            return;
-        }
+            decodeHeader(reinterpret_cast<const unsigned char *>(&mRecvBuffer[mRecvStart]));
 
-        if (mSocket->readAbsolut(buff_, 2) == 2)
-            handle_read(2, RT_DEVICE);
-        else if (mSocket->isConnected())
-        {
-            _message.append(" [RT_DEVIVE]");
-            XCEPTCOMM(_message);
-        }
-        else
-        {
-            setWaitTime(WAIT_RECONNECT);
-            return;
-        }
+            // Calculate the length of the data block. This is the rest of the total length
+            if ((comm.hlen + 3) <= 0x0015)
+            {
+                // The position of the next frame is unknown. Therefore all
+                // received data is dropped.
+                mRecvStart = mRecvEnd = 0;
+                _message = "Invalid length " + to_string(comm.hlen) + " in header!";
+                XCEPTCOMM(_message);
+            }
 
-        if (mSocket->readAbsolut(buff_, 2) == 2)
-            handle_read(2, RT_WORD2);
-        else if (mSocket->isConnected())
-        {
-            _message.append(" [RT_WORD2]");
-            XCEPTCOMM(_message);
-        }
-        else
-        {
-            setWaitTime(WAIT_RECONNECT);
-            return;
-        }
+            size_t len = (comm.hlen + 3) - 0x0015;
 
-        if (mSocket->readAbsolut(buff_, 2) == 2)
-            handle_read(2, RT_WORD3);
-        else if (mSocket->isConnected())
-        {
-            _message.append(" [RT_WORD3]");
-            XCEPTCOMM(_message);
-        }
-        else
-        {
-            setWaitTime(WAIT_RECONNECT);
-            return;
-        }
+            if (len > BUF_SIZE)
+            {
+                mRecvStart = mRecvEnd = 0;
+                _message = "Length to read is " + to_string(len) + " bytes, but the buffer is only " + to_string(BUF_SIZE) + " bytes!";
+                XCEPTCOMM(_message);
+            }
 
-        if (mSocket->readAbsolut(buff_, 2) == 2)
-            handle_read(2, RT_WORD4);
-        else if (mSocket->isConnected())
-        {
-            _message.append(" [RT_WORD4]");
-            XCEPTCOMM(_message);
-        }
-        else
-        {
-            setWaitTime(WAIT_RECONNECT);
-            return;
-        }
+            if (!fillBuffer(ICSP_HEADER_SIZE + len))
+            {
+                if (mSocket && mSocket->isConnected())
+                {
+                    _message.append(" [DATA]");
+                    XCEPTCOMM(_message);
+                }
 
-        if (mSocket->readAbsolut(buff_, 2) == 2)
-            handle_read(2, RT_WORD5);
-        else if (mSocket->isConnected())
-        {
-            _message.append(" [RT_WORD5]");
-            XCEPTCOMM(_message);
-        }
-        else
-        {
-            setWaitTime(WAIT_RECONNECT);
-            return;
-        }
+                setWaitTime(WAIT_RECONNECT);
+                return;
+            }
 
-        if (mSocket->readAbsolut(buff_, 1) == 1)
-            handle_read(1, RT_SEP2);
-        else if (mSocket->isConnected())
-        {
-            _message.append(" [RT_SEP2]");
-            XCEPTCOMM(_message);
-        }
-        else
-        {
-            setWaitTime(WAIT_RECONNECT);
-            return;
+            // The data block is parsed directly from the receive buffer.
+            const char *data = &mRecvBuffer[mRecvStart + ICSP_HEADER_SIZE];
+            mRecvStart += ICSP_HEADER_SIZE + len;
+            handle_read(data, len);
         }
+        while (isRunning() && mSocket && mSocket->isConnected() && haveFrame());
+    }
+    catch (TXceptNetwork& e)
+    {
+        mRecvStart = mRecvEnd = 0;
+        setWaitTime(WAIT_RECONNECT);
+    }
+}
 
-        if (mSocket->readAbsolut(buff_, 2) == 2)
-            handle_read(2, RT_COUNT);
-        else if (mSocket->isConnected())
-        {
-            _message.append(" [RT_COUNT]");
-            XCEPTCOMM(_message);
-        }
-        else
-        {
-            setWaitTime(WAIT_RECONNECT);
-            return;
-        }
+/*
+ * Reads as much as available from the network until the buffer contains at
+ * least "need" bytes. Because the socket delivers all bytes the controller
+ * has sent so far, usually a single read fills the buffer with several
+ * frames. The not yet processed bytes are moved to the start of the buffer
+ * if there is not enough space left at the end.
+ */
+bool TAmxNet::fillBuffer(size_t need)
+{
+    DECL_TRACER("TAmxNet::fillBuffer(size_t need)");
 
-        if (mSocket->readAbsolut(buff_, 2) == 2)
-            handle_read(2, RT_MC);
-        else if (mSocket->isConnected())
-        {
-            _message.append(" [RT_MC]");
-            XCEPTCOMM(_message);
-        }
-        else
-        {
-            setWaitTime(WAIT_RECONNECT);
-            return;
-        }
+    if (need > RECV_BUF_SIZE)
+        return false;
 
-        // Calculate the length of the data block. This is the rest of the total length
-        size_t len = (comm.hlen + 3) - 0x0015;
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
 
-        if (mSocket->isConnected() && len > BUF_SIZE)
+    while ((mRecvEnd - mRecvStart) < need)
+    {
+        if (!mSocket || !mSocket->isConnected() || !isRunning())
+            return false;
+
+        if ((RECV_BUF_SIZE - mRecvStart) < need)
         {
-            _message = "Length to read is " + to_string(len) + " bytes, but the buffer is only " + to_string(BUF_SIZE) + " bytes!";
-            XCEPTCOMM(_message);
+            memmove(mRecvBuffer, mRecvBuffer + mRecvStart, mRecvEnd - mRecvStart);
+            mRecvEnd -= mRecvStart;
+            mRecvStart = 0;
         }
-        else if (!mSocket->isConnected())
+
+        ssize_t rec = mSocket->receive(mRecvBuffer + mRecvEnd, RECV_BUF_SIZE - mRecvEnd);
+
+        if (rec != TSocket::npos && rec > 0)
         {
-            setWaitTime(WAIT_RECONNECT);
-            return;
+            mRecvEnd += static_cast<size_t>(rec);
+            end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            continue;
         }
 
-        if (mSocket->readAbsolut(buff_, len) == len)
-            handle_read(len, RT_DATA);
-        else if (mSocket->isConnected())
+        if (std::chrono::steady_clock::now() >= end)
         {
-            _message.append(" [RT_DATA]");
-            XCEPTCOMM(_message);
+            string message = "[" + TConfig::getController() + "] Read: ";
+
+            if (errno)
+                message.append(strerror(errno));
+            else
+                message.append("Timeout on reading");
+
+            mSocket->close();
+            XCEPTNETWORK(message);
         }
+
+        std::this_thread::sleep_for(std::chrono::microseconds(1000));
     }
-    catch (TXceptNetwork& e)
-    {
-        setWaitTime(WAIT_RECONNECT);
-    }
+
+    return true;
 }
 
-void TAmxNet::handle_read(size_t n, R_TOKEN tk)
+bool TAmxNet::haveFrame()
 {
-    DECL_TRACER("TAmxNet::handle_read(const error_code& error, size_t n, R_TOKEN tk)");
+    size_t avail = mRecvEnd - mRecvStart;
+
+    if (avail < ICSP_HEADER_SIZE)
+        return false;
+
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(&mRecvBuffer[mRecvStart]);
+    size_t hlen = makeWord(p[1], p[2]);
+
+    if ((hlen + 3) <= 0x0015)
+        return true;    // Invalid length. The error is handled by start_read().
+
+    return avail >= (hlen + 3 - 0x0015) + ICSP_HEADER_SIZE;
+}
+
+void TAmxNet::decodeHeader(const unsigned char *p)
+{
+    if (p[0] != 0x02 || p[3] != 0x02 || p[17] != 0x0f)
+        protError = true;
+
+    comm.ID = p[0];
+    comm.hlen = makeWord(p[1], p[2]);
+    comm.sep1 = p[3];
+    comm.type = p[4];
+    comm.unk1 = makeWord(p[5], p[6]);
+    comm.device1 = makeWord(p[7], p[8]);
+    comm.port1 = makeWord(p[9], p[10]);
+    comm.system = makeWord(p[11], p[12]);
+    comm.device2 = makeWord(p[13], p[14]);
+    comm.port2 = makeWord(p[15], p[16]);
+    comm.unk6 = p[17];
+    comm.count = makeWord(p[18], p[19]);
+    comm.MC = makeWord(p[20], p[21]);
+}
+
+void TAmxNet::handle_read(const char *buf, size_t n)
+{
+    DECL_TRACER("TAmxNet::handle_read(const char *buf, size_t n)");
 
     if (stopped_ || !__CommValid || !mSocket || !mSocket->isConnected())
         return;
@@ -698,515 +666,593 @@ void TAmxNet::handle_read(size_t n, R_TOKEN tk)
     string cmd;
 
     len = (n < BUF_SIZE) ? n : BUF_SIZE - 1;
-    input_buffer_.assign((char *)&buff_[0], len);
 
-    MSG_DEBUG("Token: " << tk << ", " << len << " bytes");
+    MSG_DEBUG("Data block: " << len << " bytes");
+
+    if (protError || !isRunning())
+        return;
+
+    MSG_DEBUG("Received message type: 0x" << std::setw(4) << std::setfill('0') << std::hex << comm.MC);
 
-    switch (tk)
+    // The lengths and offsets in a message must not exceed the received
+    // data block. Otherwise the frame is malformed and is dropped.
+    auto fits = [&](size_t need) -> bool
     {
-        case RT_ID:
-            if (buff_[0] != 0x02)
-                protError = true;
-            else
-                comm.ID = buff_[0];
+        if (need <= n)
+            return true;
+
+        MSG_ERROR("Message 0x" << std::setw(4) << std::setfill('0') << std::hex << comm.MC << std::dec << " needs " << need << " bytes but has only " << n << " bytes! Dropping frame.");
+        return false;
+    };
+
+    switch (comm.MC)
+    {
+        case 0x0001:    // ACK
+        case 0x0002:    // NAK
+            if (!fits(1))
+                break;
+
+            comm.checksum = buf[0];
         break;
 
-        case RT_LEN:    comm.hlen = makeWord(buff_[0], buff_[1]); break;
+        case 0x0084:    // input channel ON
+        case 0x0085:    // input channel OFF
+        case 0x0006:    // output channel ON
+        case 0x0086:    // output channel ON status
+        case 0x0007:    // output channel OFF
+        case 0x0087:    // output channel OFF status
+        case 0x0088:    // input/output channel ON status
+        case 0x0089:    // input/output channel OFF status
+        case 0x0018:    // feedback channel ON
+        case 0x0019:    // feedback channel OFF
+            if (!fits(9))
+                break;
+
+            comm.data.chan_state.device = makeWord(buf[0], buf[1]);
+            comm.data.chan_state.port = makeWord(buf[2], buf[3]);
+            comm.data.chan_state.system = makeWord(buf[4], buf[5]);
+            comm.data.chan_state.channel = makeWord(buf[6], buf[7]);
+            comm.checksum = buf[8];
+
+            s.channel = comm.data.chan_state.channel;
+            s.level = 0;
+            s.port = comm.data.chan_state.port;
+            s.value = 0;
+
+            switch (comm.MC)
+            {
+                case 0x0006: s.MC = 0x0086; break;
+                case 0x0007: s.MC = 0x0087; break;
+            }
 
-        case RT_SEP1:
-            if (buff_[0] != 0x02)
-                protError = true;
+            if (comm.MC < 0x0020)
+            {
+                if (callback)
+                    callback(comm);
+                else
+                    MSG_WARNING("Missing callback function!");
+            }
             else
-                comm.sep1 = buff_[0];
+                sendCommand(s);
         break;
 
-        case RT_TYPE:   comm.type = buff_[0]; break;
-        case RT_WORD1:  comm.unk1 = makeWord(buff_[0], buff_[1]); break;
-        case RT_DEVICE: comm.device1 = makeWord(buff_[0], buff_[1]); break;
-        case RT_WORD2:  comm.port1 = makeWord(buff_[0], buff_[1]); break;
-        case RT_WORD3:  comm.system = makeWord(buff_[0], buff_[1]); break;
-        case RT_WORD4:  comm.device2 = makeWord(buff_[0], buff_[1]); break;
-        case RT_WORD5:  comm.port2 = makeWord(buff_[0], buff_[1]); break;
-
-        case RT_SEP2:
-            if (buff_[0] != 0x0f)
-                protError = true;
+        case 0x000a:    // level value change
+        case 0x008a:
+        {
+            if (!fits(9))
+                break;
+
+            size_t need = 9;
+
+            switch (static_cast<unsigned char>(buf[8]))
+            {
+                case 0x010:
+                case 0x011: need = 11; break;
+                case 0x020:
+                case 0x021: need = 12; break;
+                case 0x040:
+                case 0x041:
+                case 0x04f: need = 14; break;
+                case 0x08f: need = 18; break;
+            }
+
+            if (!fits(need))
+                break;
+
+            comm.data.message_value.device = makeWord(buf[0], buf[1]);
+            comm.data.message_value.port = makeWord(buf[2], buf[3]);
+            comm.data.message_value.system = makeWord(buf[4], buf[5]);
+            comm.data.message_value.value = makeWord(buf[6], buf[7]);
+            comm.data.message_value.type = buf[8];
+            val = static_cast<unsigned char>(buf[8]);
+
+            switch (val)
+            {
+                case 0x010: comm.data.message_value.content.byte = buf[9]; comm.checksum = buf[10]; break;
+                case 0x011: comm.data.message_value.content.ch = buf[9]; comm.checksum = buf[10]; break;
+                case 0x020: comm.data.message_value.content.integer = makeWord(buf[9], buf[10]); comm.checksum = buf[11]; break;
+                case 0x021: comm.data.message_value.content.sinteger = makeWord(buf[9], buf[10]); comm.checksum = buf[11]; break;
+                case 0x040: comm.data.message_value.content.dword = makeDWord(buf[9], buf[10], buf[11], buf[12]); comm.checksum = buf[13]; break;
+                case 0x041: comm.data.message_value.content.sdword = makeDWord(buf[9], buf[10], buf[11], buf[12]); comm.checksum = buf[13]; break;
+
+                case 0x04f:
+                    dw = makeDWord(buf[9], buf[10], buf[11], buf[12]);
+                    memcpy(&comm.data.message_value.content.fvalue, &dw, 4);
+                    comm.checksum = buf[13];
+                break;
+
+                case 0x08f:
+                    memcpy(&comm.data.message_value.content.dvalue, &buf[9], 8);  // FIXME: wrong byte order on Intel CPU?
+                    comm.checksum = buf[17];
+                break;
+            }
+
+            if (callback)
+                callback(comm);
             else
-                comm.unk6 = buff_[0];
+                MSG_WARNING("Missing callback function!");
+        }
         break;
 
-        case RT_COUNT:  comm.count = makeWord(buff_[0], buff_[1]); break;
-        case RT_MC:     comm.MC = makeWord(buff_[0], buff_[1]); break;
+        case 0x000b:    // string value change
+        case 0x008b:
+        case 0x000c:    // command string
+        case 0x008c:
+            if (!fits(9))
+                break;
 
-        case RT_DATA:
-            if (protError || !isRunning())
+            comm.data.message_string.device = makeWord(buf[0], buf[1]);
+            comm.data.message_string.port = makeWord(buf[2], buf[3]);
+            comm.data.message_string.system = makeWord(buf[4], buf[5]);
+            comm.data.message_string.type = buf[6];
+            comm.data.message_string.length = makeWord(buf[7], buf[8]);
+            memset(&comm.data.message_string.content[0], 0, sizeof(comm.data.message_string.content));
+            len = (buf[6] == 0x01) ? comm.data.message_string.length : comm.data.message_string.length * 2;
+
+            if (!fits(9 + len + 1))     // Header, string and checksum
                 break;
 
-            MSG_DEBUG("Received message type: 0x" << std::setw(4) << std::setfill('0') << std::hex << comm.MC);
+            if (len >= sizeof(comm.data.message_string.content))
+            {
+                len = sizeof(comm.data.message_string.content) - 1;
+                comm.data.message_string.length = (buf[6] == 0x01) ? len : len / 2;
+            }
 
-            switch (comm.MC)
+            memcpy(&comm.data.message_string.content[0], &buf[9], len);
+            comm.checksum = buf[n - 1];
+            cmd.assign((char *)&comm.data.message_string.content[0], len);
+            MSG_DEBUG("cmd=" << cmd);
+
+            if (isCommand(cmd))
             {
-                case 0x0001:    // ACK
-                case 0x0002:    // NAK
-                    comm.checksum = buff_[0];
-                break;
+                MSG_DEBUG("Command found!");
+                oldCmd.assign(cmd);
+            }
+            else
+            {
+                oldCmd.append(cmd);
+                MSG_DEBUG("Concatenated cmd=" << oldCmd);
+                memset(&comm.data.message_string.content[0], 0, sizeof(comm.data.message_string.content));
+                memcpy(&comm.data.message_string.content[0], oldCmd.c_str(), sizeof(comm.data.message_string.content) - 1);
+                comm.data.message_string.length = oldCmd.length();
+                oldCmd.clear();
+            }
 
-                case 0x0084:    // input channel ON
-                case 0x0085:    // input channel OFF
-                case 0x0006:    // output channel ON
-                case 0x0086:    // output channel ON status
-                case 0x0007:    // output channel OFF
-                case 0x0087:    // output channel OFF status
-                case 0x0088:    // input/output channel ON status
-                case 0x0089:    // input/output channel OFF status
-                case 0x0018:    // feedback channel ON
-                case 0x0019:    // feedback channel OFF
-                    comm.data.chan_state.device = makeWord(buff_[0], buff_[1]);
-                    comm.data.chan_state.port = makeWord(buff_[2], buff_[3]);
-                    comm.data.chan_state.system = makeWord(buff_[4], buff_[5]);
-                    comm.data.chan_state.channel = makeWord(buff_[6], buff_[7]);
-                    comm.checksum = buff_[8];
-
-                    s.channel = comm.data.chan_state.channel;
-                    s.level = 0;
-                    s.port = comm.data.chan_state.port;
-                    s.value = 0;
-
-                    switch (comm.MC)
-                    {
-                        case 0x0006: s.MC = 0x0086; break;
-                        case 0x0007: s.MC = 0x0087; break;
-                    }
+            if (callback)
+                callback(comm);
+            else
+                MSG_WARNING("Missing callback function!");
+        break;
 
-                    if (comm.MC < 0x0020)
-                    {
-                        if (callback)
-                            callback(comm);
-                        else
-                            MSG_WARNING("Missing callback function!");
-                    }
-                    else
-                        sendCommand(s);
+        case 0x000e:    // request level value
+            if (!fits(9))
                 break;
 
-                case 0x000a:    // level value change
-                case 0x008a:
-                    comm.data.message_value.device = makeWord(buff_[0], buff_[1]);
-                    comm.data.message_value.port = makeWord(buff_[2], buff_[3]);
-                    comm.data.message_value.system = makeWord(buff_[4], buff_[5]);
-                    comm.data.message_value.value = makeWord(buff_[6], buff_[7]);
-                    comm.data.message_value.type = buff_[8];
-                    val = (int)buff_[8];
+            comm.data.level.device = makeWord(buf[0], buf[1]);
+            comm.data.level.port = makeWord(buf[2], buf[3]);
+            comm.data.level.system = makeWord(buf[4], buf[5]);
+            comm.data.level.level = makeWord(buf[6], buf[7]);
+            comm.checksum = buf[8];
 
-                    switch (val)
-                    {
-                        case 0x010: comm.data.message_value.content.byte = buff_[9]; comm.checksum = buff_[10]; break;
-                        case 0x011: comm.data.message_value.content.ch = buff_[9]; comm.checksum = buff_[10]; break;
-                        case 0x020: comm.data.message_value.content.integer = makeWord(buff_[9], buff_[10]); comm.checksum = buff_[11]; break;
-                        case 0x021: comm.data.message_value.content.sinteger = makeWord(buff_[9], buff_[10]); comm.checksum = buff_[11]; break;
-                        case 0x040: comm.data.message_value.content.dword = makeDWord(buff_[9], buff_[10], buff_[11], buff_[12]); comm.checksum = buff_[13]; break;
-                        case 0x041: comm.data.message_value.content.sdword = makeDWord(buff_[9], buff_[10], buff_[11], buff_[12]); comm.checksum = buff_[13]; break;
-
-                        case 0x04f:
-                            dw = makeDWord(buff_[9], buff_[10], buff_[11], buff_[12]);
-                            memcpy(&comm.data.message_value.content.fvalue, &dw, 4);
-                            comm.checksum = buff_[13];
-                        break;
-
-                        case 0x08f:
-                            memcpy(&comm.data.message_value.content.dvalue, &buff_[9], 8);  // FIXME: wrong byte order on Intel CPU?
-                            comm.checksum = buff_[17];
-                        break;
-                    }
+            if (callback)
+                callback(comm);
+            else
+                MSG_WARNING("Missing callback function!");
+        break;
 
-                    if (callback)
-                        callback(comm);
-                    else
-                        MSG_WARNING("Missing callback function!");
+        case 0x000f:    // request output channel status
+            if (!fits(9))
                 break;
 
-                case 0x000b:    // string value change
-                case 0x008b:
-                case 0x000c:    // command string
-                case 0x008c:
-                    comm.data.message_string.device = makeWord(buff_[0], buff_[1]);
-                    comm.data.message_string.port = makeWord(buff_[2], buff_[3]);
-                    comm.data.message_string.system = makeWord(buff_[4], buff_[5]);
-                    comm.data.message_string.type = buff_[6];
-                    comm.data.message_string.length = makeWord(buff_[7], buff_[8]);
-                    memset(&comm.data.message_string.content[0], 0, sizeof(comm.data.message_string.content));
-                    len = (buff_[6] == 0x01) ? comm.data.message_string.length : comm.data.message_string.length * 2;
-
-                    if (len >= sizeof(comm.data.message_string.content))
-                    {
-                        len = sizeof(comm.data.message_string.content) - 1;
-                        comm.data.message_string.length = (buff_[6] == 0x01) ? len : len / 2;
-                    }
+            comm.data.channel.device = makeWord(buf[0], buf[1]);
+            comm.data.channel.port = makeWord(buf[2], buf[3]);
+            comm.data.channel.system = makeWord(buf[4], buf[5]);
+            comm.data.channel.channel = makeWord(buf[6], buf[7]);
+            comm.checksum = buf[8];
 
-                    memcpy(&comm.data.message_string.content[0], &buff_[9], len);
-                    pos = (int)(len + 10);
-                    comm.checksum = buff_[pos];
-                    cmd.assign((char *)&comm.data.message_string.content[0], len);
-                    MSG_DEBUG("cmd=" << cmd);
+            if (callback)
+                callback(comm);
+            else
+                MSG_WARNING("Missing callback function!");
+        break;
 
-                    if (isCommand(cmd))
-                    {
-                        MSG_DEBUG("Command found!");
-                        oldCmd.assign(cmd);
-                    }
-                    else
-                    {
-                        oldCmd.append(cmd);
-                        MSG_DEBUG("Concatenated cmd=" << oldCmd);
-                        memset(&comm.data.message_string.content[0], 0, sizeof(comm.data.message_string.content));
-                        memcpy(&comm.data.message_string.content[0], oldCmd.c_str(), sizeof(comm.data.message_string.content) - 1);
-                        comm.data.message_string.length = oldCmd.length();
-                        oldCmd.clear();
-                    }
+        case 0x0010:    // request port count
+        case 0x0017:    // request device info
+            if (!fits(5))
+                break;
 
-                    if (callback)
-                        callback(comm);
-                    else
-                        MSG_WARNING("Missing callback function!");
+            comm.data.reqPortCount.device = makeWord(buf[0], buf[1]);
+            comm.data.reqPortCount.system = makeWord(buf[2], buf[3]);
+            comm.checksum = buf[4];
+            s.channel = false;
+            s.level = 0;
+            s.port = 0;
+            s.value = 0x0015;
+            s.MC = (comm.MC == 0x0010) ? 0x0090 : 0x0097;
+
+            if (s.MC == 0x0097)
+            {
+                comm.data.srDeviceInfo.device = comm.device2;
+                comm.data.srDeviceInfo.system = comm.system;
+                comm.data.srDeviceInfo.flag = 0x0000;
+                comm.data.srDeviceInfo.parentID = 0;
+                comm.data.srDeviceInfo.herstID = 1;
+                msg97fill(&comm);
+            }
+            else
+                sendCommand(s);
+        break;
+
+        case 0x0011:    // request output channel count
+        case 0x0012:    // request level count
+        case 0x0013:    // request string size
+        case 0x0014:    // request command size
+            if (!fits(7))
                 break;
 
-                case 0x000e:    // request level value
-                    comm.data.level.device = makeWord(buff_[0], buff_[1]);
-                    comm.data.level.port = makeWord(buff_[2], buff_[3]);
-                    comm.data.level.system = makeWord(buff_[4], buff_[5]);
-                    comm.data.level.level = makeWord(buff_[6], buff_[7]);
-                    comm.checksum = buff_[8];
+            comm.data.reqOutpChannels.device = makeWord(buf[0], buf[1]);
+            comm.data.reqOutpChannels.port = makeWord(buf[2], buf[3]);
+            comm.data.reqOutpChannels.system = makeWord(buf[4], buf[5]);
+            comm.checksum = buf[6];
+            s.channel = false;
+            s.level = 0;
+            s.port = comm.data.reqOutpChannels.port;
+            s.value = 0;
 
-                    if (callback)
-                        callback(comm);
-                    else
-                        MSG_WARNING("Missing callback function!");
+            switch (comm.MC)
+            {
+                case 0x0011:
+                    s.MC = 0x0091;
+                    s.value = 0x0f75;   // # channels
                 break;
 
-                case 0x000f:    // request output channel status
-                    comm.data.channel.device = makeWord(buff_[0], buff_[1]);
-                    comm.data.channel.port = makeWord(buff_[2], buff_[3]);
-                    comm.data.channel.system = makeWord(buff_[4], buff_[5]);
-                    comm.data.channel.channel = makeWord(buff_[6], buff_[7]);
-                    comm.checksum = buff_[8];
+                case 0x0012:
+                    s.MC = 0x0092;
+                    s.value = 0x000d;   // # levels
+                break;
 
-                    if (callback)
-                        callback(comm);
-                    else
-                        MSG_WARNING("Missing callback function!");
+                case 0x0013:
+                    s.MC = 0x0093;
+                    s.value = 0x00c7;   // string size
                 break;
 
-                case 0x0010:    // request port count
-                case 0x0017:    // request device info
-                    comm.data.reqPortCount.device = makeWord(buff_[0], buff_[1]);
-                    comm.data.reqPortCount.system = makeWord(buff_[2], buff_[3]);
-                    comm.checksum = buff_[4];
-                    s.channel = false;
-                    s.level = 0;
-                    s.port = 0;
-                    s.value = 0x0015;
-                    s.MC = (comm.MC == 0x0010) ? 0x0090 : 0x0097;
-
-                    if (s.MC == 0x0097)
-                    {
-                        comm.data.srDeviceInfo.device = comm.device2;
-                        comm.data.srDeviceInfo.system = comm.system;
-                        comm.data.srDeviceInfo.flag = 0x0000;
-                        comm.data.srDeviceInfo.parentID = 0;
-                        comm.data.srDeviceInfo.herstID = 1;
-                        msg97fill(&comm);
-                    }
-                    else
-                        sendCommand(s);
+                case 0x0014:
+                    s.MC = 0x0094;
+                    s.value = 0x00c7;   // command size
                 break;
+            }
 
-                case 0x0011:    // request output channel count
-                case 0x0012:    // request level count
-                case 0x0013:    // request string size
-                case 0x0014:    // request command size
-                    comm.data.reqOutpChannels.device = makeWord(buff_[0], buff_[1]);
-                    comm.data.reqOutpChannels.port = makeWord(buff_[2], buff_[3]);
-                    comm.data.reqOutpChannels.system = makeWord(buff_[4], buff_[5]);
-                    comm.checksum = buff_[6];
-                    s.channel = false;
-                    s.level = 0;
-                    s.port = comm.data.reqOutpChannels.port;
-                    s.value = 0;
-
-                    switch (comm.MC)
-                    {
-                        case 0x0011:
-                            s.MC = 0x0091;
-                            s.value = 0x0f75;   // # channels
-                        break;
-
-                        case 0x0012:
-                            s.MC = 0x0092;
-                            s.value = 0x000d;   // # levels
-                        break;
-
-                        case 0x0013:
-                            s.MC = 0x0093;
-                            s.value = 0x00c7;   // string size
-                        break;
-
-                        case 0x0014:
-                            s.MC = 0x0094;
-                            s.value = 0x00c7;   // command size
-                        break;
-                    }
+            sendCommand(s);
+        break;
 
-                    sendCommand(s);
+        case 0x0015:    // request level size
+            if (!fits(9))
                 break;
 
-                case 0x0015:    // request level size
-                    comm.data.reqLevels.device = makeWord(buff_[0], buff_[1]);
-                    comm.data.reqLevels.port = makeWord(buff_[2], buff_[3]);
-                    comm.data.reqLevels.system = makeWord(buff_[4], buff_[5]);
-                    comm.data.reqLevels.level = makeWord(buff_[6], buff_[7]);
-                    comm.checksum = buff_[8];
-                    s.channel = false;
-                    s.level = comm.data.reqLevels.level;
-                    s.port = comm.data.reqLevels.port;
-                    s.value = 0;
-                    s.MC = 0x0095;
-                    sendCommand(s);
+            comm.data.reqLevels.device = makeWord(buf[0], buf[1]);
+            comm.data.reqLevels.port = makeWord(buf[2], buf[3]);
+            comm.data.reqLevels.system = makeWord(buf[4], buf[5]);
+            comm.data.reqLevels.level = makeWord(buf[6], buf[7]);
+            comm.checksum = buf[8];
+            s.channel = false;
+            s.level = comm.data.reqLevels.level;
+            s.port = comm.data.reqLevels.port;
+            s.value = 0;
+            s.MC = 0x0095;
+            sendCommand(s);
+        break;
+
+        case 0x0016:    // request status code
+            if (!fits(6))
                 break;
 
-                case 0x0016:    // request status code
-                    comm.data.sendStatusCode.device = makeWord(buff_[0], buff_[1]);
-                    comm.data.sendStatusCode.port = makeWord(buff_[2], buff_[3]);
-                    comm.data.sendStatusCode.system = makeWord(buff_[4], buff_[5]);
+            comm.data.sendStatusCode.device = makeWord(buf[0], buf[1]);
+            comm.data.sendStatusCode.port = makeWord(buf[2], buf[3]);
+            comm.data.sendStatusCode.system = makeWord(buf[4], buf[5]);
 
-                    if (callback)
-                        callback(comm);
-                    else
-                        MSG_WARNING("Missing callback function!");
+            if (callback)
+                callback(comm);
+            else
+                MSG_WARNING("Missing callback function!");
+        break;
+
+        case 0x0097:    // receive device info
+            if (!fits(31))
                 break;
 
-                case 0x0097:    // receive device info
-                    comm.data.srDeviceInfo.device = makeWord(buff_[0], buff_[1]);
-                    comm.data.srDeviceInfo.system = makeWord(buff_[2], buff_[3]);
-                    comm.data.srDeviceInfo.flag = makeWord(buff_[4], buff_[5]);
-                    comm.data.srDeviceInfo.objectID = buff_[6];
-                    comm.data.srDeviceInfo.parentID = buff_[7];
-                    comm.data.srDeviceInfo.herstID = makeWord(buff_[8], buff_[9]);
-                    comm.data.srDeviceInfo.deviceID = makeWord(buff_[10], buff_[11]);
-                    memcpy(comm.data.srDeviceInfo.serial, &buff_[12], 16);
-                    comm.data.srDeviceInfo.fwid = makeWord(buff_[28], buff_[29]);
-                    memset(comm.data.srDeviceInfo.info, 0, sizeof(comm.data.srDeviceInfo.info));
-                    memcpy(comm.data.srDeviceInfo.info, &buff_[30], comm.hlen - 0x0015 - 29);
-                    comm.checksum = buff_[comm.hlen + 3];
-                    // Prepare answer
-                    s.channel = false;
-                    s.level = 0;
-                    s.port = 0;
-                    s.value = 0;
-
-                    if (!initSend)
-                    {
-                        s.MC = 0x0097;
-                        initSend = true;
-                    }
-                    else if (!ready)
-                    {
-                        // Send counts
-                        s.MC = 0x0090;
-                        s.value = 0x0015;   // # ports
-                        sendCommand(s);
-                        s.MC = 0x0091;
-                        s.value = 0x0f75;   // # channels
-                        sendCommand(s);
-                        s.MC = 0x0092;
-                        s.value = 0x000d;   // # levels
-                        sendCommand(s);
-                        s.MC = 0x0093;
-                        s.value = 0x00c7;   // string size
-                        sendCommand(s);
-                        s.MC = 0x0094;
-                        s.value = 0x00c7;   // command size
-                        sendCommand(s);
-                        s.MC = 0x0098;
-                        ready = true;
-                    }
-                    else
-                        break;
+            comm.data.srDeviceInfo.device = makeWord(buf[0], buf[1]);
+            comm.data.srDeviceInfo.system = makeWord(buf[2], buf[3]);
+            comm.data.srDeviceInfo.flag = makeWord(buf[4], buf[5]);
+            comm.data.srDeviceInfo.objectID = buf[6];
+            comm.data.srDeviceInfo.parentID = buf[7];
+            comm.data.srDeviceInfo.herstID = makeWord(buf[8], buf[9]);
+            comm.data.srDeviceInfo.deviceID = makeWord(buf[10], buf[11]);
+            memcpy(comm.data.srDeviceInfo.serial, &buf[12], 16);
+            comm.data.srDeviceInfo.fwid = makeWord(buf[28], buf[29]);
+            memset(comm.data.srDeviceInfo.info, 0, sizeof(comm.data.srDeviceInfo.info));
+            // The info ends before the checksum
+            memcpy(comm.data.srDeviceInfo.info, &buf[30], min(n - 31, sizeof(comm.data.srDeviceInfo.info) - 1));
+            comm.checksum = buf[n - 1];
+            // Prepare answer
+            s.channel = false;
+            s.level = 0;
+            s.port = 0;
+            s.value = 0;
 
-                    sendCommand(s);
+            if (!initSend)
+            {
+                s.MC = 0x0097;
+                initSend = true;
+            }
+            else if (!ready)
+            {
+                // Send counts
+                s.MC = 0x0090;
+                s.value = 0x0015;   // # ports
+                sendCommand(s);
+                s.MC = 0x0091;
+                s.value = 0x0f75;   // # channels
+                sendCommand(s);
+                s.MC = 0x0092;
+                s.value = 0x000d;   // # levels
+                sendCommand(s);
+                s.MC = 0x0093;
+                s.value = 0x00c7;   // string size
+                sendCommand(s);
+                s.MC = 0x0094;
+                s.value = 0x00c7;   // command size
+                sendCommand(s);
+                s.MC = 0x0098;
+                ready = true;
+            }
+            else
+                break;
+
+            sendCommand(s);
+
+            MSG_DEBUG("S/N: " << comm.data.srDeviceInfo.serial << " | " << comm.data.srDeviceInfo.info);
+        break;
 
-                    MSG_DEBUG("S/N: " << comm.data.srDeviceInfo.serial << " | " << comm.data.srDeviceInfo.info);
+        case 0x00a1:    // request status
+            if (!fits(3))
                 break;
 
-                case 0x00a1:    // request status
-                    reqDevStatus = makeWord(buff_[0], buff_[1]);
-                    comm.checksum = buff_[2];
+            reqDevStatus = makeWord(buf[0], buf[1]);
+            comm.checksum = buf[2];
+        break;
+
+        case 0x0204:    // file transfer
+            if (!fits(4))
                 break;
 
-                case 0x0204:    // file transfer
-                    s.device = comm.device2;
-                    comm.data.filetransfer.ftype = makeWord(buff_[0], buff_[1]);
-                    comm.data.filetransfer.function = makeWord(buff_[2], buff_[3]);
-                    pos = 4;
+            s.device = comm.device2;
+            comm.data.filetransfer.ftype = makeWord(buf[0], buf[1]);
+            comm.data.filetransfer.function = makeWord(buf[2], buf[3]);
+            pos = 4;
 
-                    if (comm.data.filetransfer.ftype == 0 && comm.data.filetransfer.function == 0x0105)         // Directory exist?
-                    {
-                        for (size_t i = 0; i < 0x0104; i++)
-                        {
-                            comm.data.filetransfer.data[i] = buff_[pos];
-                            pos++;
-                        }
+            if (comm.data.filetransfer.ftype == 0 && comm.data.filetransfer.function == 0x0105)         // Directory exist?
+            {
+                if (!fits(pos + 0x0104))
+                    break;
 
-                        comm.data.filetransfer.data[0x0103] = 0;
-                        handleFTransfer(s, comm.data.filetransfer);
-                    }
-                    else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0100)    // Controller have more files
-                        handleFTransfer(s, comm.data.filetransfer);
-                    else if (comm.data.filetransfer.ftype == 0 && comm.data.filetransfer.function == 0x0100)    // Request directory listing
-                    {
-                        comm.data.filetransfer.unk = makeWord(buff_[4], buff_[5]);
-                        pos = 6;
+                for (size_t i = 0; i < 0x0104; i++)
+                {
+                    comm.data.filetransfer.data[i] = buf[pos];
+                    pos++;
+                }
 
-                        for (size_t i = 0; i < 0x0104; i++)
-                        {
-                            comm.data.filetransfer.data[i] = buff_[pos];
-                            pos++;
-                        }
+                comm.data.filetransfer.data[0x0103] = 0;
+                handleFTransfer(s, comm.data.filetransfer);
+            }
+            else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0100)    // Controller have more files
+                handleFTransfer(s, comm.data.filetransfer);
+            else if (comm.data.filetransfer.ftype == 0 && comm.data.filetransfer.function == 0x0100)    // Request directory listing
+            {
+                if (!fits(6))
+                    break;
 
-                        comm.data.filetransfer.data[0x0103] = 0;
-                        handleFTransfer(s, comm.data.filetransfer);
-                    }
-                    else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0102)    // controller will send a file
-                    {
-                        comm.data.filetransfer.unk = makeDWord(buff_[4], buff_[5], buff_[6], buff_[7]);
-                        comm.data.filetransfer.unk1 = makeDWord(buff_[8], buff_[9], buff_[10], buff_[11]);
-                        pos = 12;
+                comm.data.filetransfer.unk = makeWord(buf[4], buf[5]);
+                pos = 6;
 
-                        for (size_t i = 0; i < 0x0104; i++)
-                        {
-                            comm.data.filetransfer.data[i] = buff_[pos];
-                            pos++;
-                        }
+                if (!fits(pos + 0x0104))
+                    break;
 
-                        comm.data.filetransfer.data[0x0103] = 0;
-                        handleFTransfer(s, comm.data.filetransfer);
-                    }
-                    else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0103)    // file or part of a file
-                    {
-                        comm.data.filetransfer.unk = makeWord(buff_[4], buff_[5]);
-                        pos = 6;
+                for (size_t i = 0; i < 0x0104; i++)
+                {
+                    comm.data.filetransfer.data[i] = buf[pos];
+                    pos++;
+                }
 
-                        for (size_t i = 0; i < comm.data.filetransfer.unk; i++)
-                        {
-                            comm.data.filetransfer.data[i] = buff_[pos];
-                            pos++;
-                        }
+                comm.data.filetransfer.data[0x0103] = 0;
+                handleFTransfer(s, comm.data.filetransfer);
+            }
+            else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0102)    // controller will send a file
+            {
+                if (!fits(12))
+                    break;
 
-                        handleFTransfer(s, comm.data.filetransfer);
-                    }
-                    else if (comm.data.filetransfer.ftype == 0 && comm.data.filetransfer.function == 0x0104)    // Does file exist;
-                    {
-                        for (size_t i = 0; i < 0x0104; i++)
-                        {
-                            comm.data.filetransfer.data[i] = buff_[pos];
-                            pos++;
-                        }
+                comm.data.filetransfer.unk = makeDWord(buf[4], buf[5], buf[6], buf[7]);
+                comm.data.filetransfer.unk1 = makeDWord(buf[8], buf[9], buf[10], buf[11]);
+                pos = 12;
 
-                        comm.data.filetransfer.data[0x0103] = 0;
-                        handleFTransfer(s, comm.data.filetransfer);
-                    }
-                    else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0104)    // request a file
-                    {
-                        comm.data.filetransfer.unk = makeWord(buff_[4], buff_[5]);
-                        pos = 6;
+                if (!fits(pos + 0x0104))
+                    break;
 
-                        for (size_t i = 0; i < 0x0104; i++)
-                        {
-                            comm.data.filetransfer.data[i] = buff_[pos];
-                            pos++;
-                        }
+                for (size_t i = 0; i < 0x0104; i++)
+                {
+                    comm.data.filetransfer.data[i] = buf[pos];
+                    pos++;
+                }
 
-                        comm.data.filetransfer.data[0x0103] = 0;
-                        handleFTransfer(s, comm.data.filetransfer);
-                    }
-                    else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0106)    // ACK for 0x0105
-                    {
-                        comm.data.filetransfer.unk = makeDWord(buff_[4], buff_[5], buff_[6], buff_[7]);
-                        pos = 8;
-                        handleFTransfer(s, comm.data.filetransfer);
-                    }
-                    else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0002)    // request next part of file
-                        handleFTransfer(s, comm.data.filetransfer);
-                    else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0003)    // File content from controller
-                    {
-                        comm.data.filetransfer.unk = makeWord(buff_[4], buff_[5]);  // length of data block
-                        pos = 6;
+                comm.data.filetransfer.data[0x0103] = 0;
+                handleFTransfer(s, comm.data.filetransfer);
+            }
+            else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0103)    // file or part of a file
+            {
+                if (!fits(6))
+                    break;
 
-                        for (size_t i = 0; i < comm.data.filetransfer.unk; i++)
-                        {
-                            comm.data.filetransfer.data[i] = buff_[pos];
-                            pos++;
-                        }
+                comm.data.filetransfer.unk = makeWord(buf[4], buf[5]);
+                pos = 6;
 
-                        handleFTransfer(s, comm.data.filetransfer);
-                    }
-                    else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0004)    // End of file
-                        handleFTransfer(s, comm.data.filetransfer);
-                    else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0005)    // End of file ACK
-                        handleFTransfer(s, comm.data.filetransfer);
-                    else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0006)    // End of directory listing ACK
-                    {
-                        comm.data.filetransfer.unk = makeWord(buff_[4], buff_[5]);  // length of received data block
-                        pos = 6;
-                        handleFTransfer(s, comm.data.filetransfer);
-                    }
-                    else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0007)    // End of file transfer
-                        handleFTransfer(s, comm.data.filetransfer);
+                if (comm.data.filetransfer.unk > sizeof(comm.data.filetransfer.data) || !fits(pos + comm.data.filetransfer.unk))
+                    break;
 
-                break;
+                for (size_t i = 0; i < comm.data.filetransfer.unk; i++)
+                {
+                    comm.data.filetransfer.data[i] = buf[pos];
+                    pos++;
+                }
 
-                case 0x020d:    // request network information
-                    s.MC = 0x020e;
-                    s.channel = 0;
-                    s.level = 0;
-                    s.port = 0;
-                    s.value = 0;
-                    sendCommand(s);
-                break;
+                handleFTransfer(s, comm.data.filetransfer);
+            }
+            else if (comm.data.filetransfer.ftype == 0 && comm.data.filetransfer.function == 0x0104)    // Does file exist;
+            {
+                if (!fits(pos + 0x0104))
+                    break;
 
-                case 0x0501:    // ping
-                    comm.data.chan_state.device = makeWord(buff_[0], buff_[1]);
-                    comm.data.chan_state.system = makeWord(buff_[2], buff_[3]);
-                    s.channel = 0;
-                    s.level = 0;
-                    s.port = 0;
-                    s.value = 0;
-                    s.MC = 0x0581;
-                    sendCommand(s);
-                break;
+                for (size_t i = 0; i < 0x0104; i++)
+                {
+                    comm.data.filetransfer.data[i] = buf[pos];
+                    pos++;
+                }
 
-                case 0x0502:    // Date and time
-                    comm.data.blinkMessage.heartBeat = buff_[0];
-                    comm.data.blinkMessage.LED = buff_[1];
-                    comm.data.blinkMessage.month = buff_[2];
-                    comm.data.blinkMessage.day = buff_[3];
-                    comm.data.blinkMessage.year = makeWord(buff_[4], buff_[5]);
-                    comm.data.blinkMessage.hour = buff_[6];
-                    comm.data.blinkMessage.minute = buff_[7];
-                    comm.data.blinkMessage.second = buff_[8];
-                    comm.data.blinkMessage.weekday = buff_[9];
-                    comm.data.blinkMessage.extTemp = makeWord(buff_[10], buff_[11]);
-                    memset(comm.data.blinkMessage.dateTime, 0, sizeof(comm.data.blinkMessage.dateTime));
-                    memcpy(comm.data.blinkMessage.dateTime, &buff_[12], comm.hlen - 0x0015 - 11);
-                    comm.checksum = buff_[comm.hlen + 3];
-
-                    sendAllFuncTimer(comm.data.blinkMessage);
-                    sendAllFuncNetwork(mLastOnlineState == NSTATE_ONLINE ? NSTATE_ONLINE1 : NSTATE_ONLINE);
-                break;
+                comm.data.filetransfer.data[0x0103] = 0;
+                handleFTransfer(s, comm.data.filetransfer);
             }
+            else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0104)    // request a file
+            {
+                if (!fits(6))
+                    break;
+
+                comm.data.filetransfer.unk = makeWord(buf[4], buf[5]);
+                pos = 6;
+
+                if (!fits(pos + 0x0104))
+                    break;
+
+                for (size_t i = 0; i < 0x0104; i++)
+                {
+                    comm.data.filetransfer.data[i] = buf[pos];
+                    pos++;
+                }
+
+                comm.data.filetransfer.data[0x0103] = 0;
+                handleFTransfer(s, comm.data.filetransfer);
+            }
+            else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0106)    // ACK for 0x0105
+            {
+                if (!fits(8))
+                    break;
+
+                comm.data.filetransfer.unk = makeDWord(buf[4], buf[5], buf[6], buf[7]);
+                pos = 8;
+                handleFTransfer(s, comm.data.filetransfer);
+            }
+            else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0002)    // request next part of file
+                handleFTransfer(s, comm.data.filetransfer);
+            else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0003)    // File content from controller
+            {
+                if (!fits(6))
+                    break;
+
+                comm.data.filetransfer.unk = makeWord(buf[4], buf[5]);  // length of data block
+                pos = 6;
+
+                if (comm.data.filetransfer.unk > sizeof(comm.data.filetransfer.data) || !fits(pos + comm.data.filetransfer.unk))
+                    break;
+
+                for (size_t i = 0; i < comm.data.filetransfer.unk; i++)
+                {
+                    comm.data.filetransfer.data[i] = buf[pos];
+                    pos++;
+                }
+
+                handleFTransfer(s, comm.data.filetransfer);
+            }
+            else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0004)    // End of file
+                handleFTransfer(s, comm.data.filetransfer);
+            else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0005)    // End of file ACK
+                handleFTransfer(s, comm.data.filetransfer);
+            else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0006)    // End of directory listing ACK
+            {
+                if (!fits(6))
+                    break;
+
+                comm.data.filetransfer.unk = makeWord(buf[4], buf[5]);  // length of received data block
+                pos = 6;
+                handleFTransfer(s, comm.data.filetransfer);
+            }
+            else if (comm.data.filetransfer.ftype == 4 && comm.data.filetransfer.function == 0x0007)    // End of file transfer
+                handleFTransfer(s, comm.data.filetransfer);
+
+        break;
+
+        case 0x020d:    // request network information
+            s.MC = 0x020e;
+            s.channel = 0;
+            s.level = 0;
+            s.port = 0;
+            s.value = 0;
+            sendCommand(s);
+        break;
+
+        case 0x0501:    // ping
+            if (!fits(4))
+                break;
+
+            comm.data.chan_state.device = makeWord(buf[0], buf[1]);
+            comm.data.chan_state.system = makeWord(buf[2], buf[3]);
+            s.channel = 0;
+            s.level = 0;
+            s.port = 0;
+            s.value = 0;
+            s.MC = 0x0581;
+            sendCommand(s);
         break;
 
-        default:        // Every unknown or unsupported command/request should be ignored.
-            ignore = true;
+        case 0x0502:    // Date and time
+            if (!fits(13))
+                break;
+
+            comm.data.blinkMessage.heartBeat = buf[0];
+            comm.data.blinkMessage.LED = buf[1];
+            comm.data.blinkMessage.month = buf[2];
+            comm.data.blinkMessage.day = buf[3];
+            comm.data.blinkMessage.year = makeWord(buf[4], buf[5]);
+            comm.data.blinkMessage.hour = buf[6];
+            comm.data.blinkMessage.minute = buf[7];
+            comm.data.blinkMessage.second = buf[8];
+            comm.data.blinkMessage.weekday = buf[9];
+            comm.data.blinkMessage.extTemp = makeWord(buf[10], buf[11]);
+            memset(comm.data.blinkMessage.dateTime, 0, sizeof(comm.data.blinkMessage.dateTime));
+            // The date and time end before the checksum
+            memcpy(comm.data.blinkMessage.dateTime, &buf[12], min(n - 13, sizeof(comm.data.blinkMessage.dateTime) - 1));
+            comm.checksum = buf[n - 1];
+
+            sendAllFuncTimer(comm.data.blinkMessage);
+            sendAllFuncNetwork(mLastOnlineState == NSTATE_ONLINE ? NSTATE_ONLINE1 : NSTATE_ONLINE);
+        break;
     }
 }
 
@@ -1240,7 +1286,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
             com.data.channel.channel = s.channel;
             com.hlen = 0x0016 - 0x0003 + sizeof(ANET_CHANNEL);
             MSG_DEBUG("SEND: BUTTON PUSH-" << s.channel << ":" << s.port << ":" << com.device2);
-            comStack.push_back(com);
+            queueCommand(com);
             mSendReady = true;
         break;
 
@@ -1251,7 +1297,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
             com.data.channel.channel = s.channel;
             com.hlen = 0x0016 - 0x0003 + sizeof(ANET_CHANNEL);
             MSG_DEBUG("SEND: BUTTON RELEASE-" << s.channel << ":" << s.port << ":" << com.device2);
-            comStack.push_back(com);
+            queueCommand(com);
             mSendReady = true;
         break;
 
@@ -1263,7 +1309,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
             com.data.channel.channel = s.channel;
             com.hlen = 0x0016 - 0x0003 + sizeof(ANET_CHANNEL);
             MSG_DEBUG("SEND: CHANNEL ON-" << s.channel << ":" << s.port << ":" << com.device2);
-            comStack.push_back(com);
+            queueCommand(com);
             mSendReady = true;
         break;
 
@@ -1275,7 +1321,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
             com.data.channel.channel = s.channel;
             com.hlen = 0x0016 - 0x0003 + sizeof(ANET_CHANNEL);
             MSG_DEBUG("SEND: CHANNEL OFF-" << s.channel << ":" << s.port << ":" << com.device2);
-            comStack.push_back(com);
+            queueCommand(com);
             mSendReady = true;
         break;
 
@@ -1290,7 +1336,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
                 com.data.message_value.content.integer = s.value;
                 com.hlen = 0x0016 - 0x0003 + 11;
                 MSG_DEBUG("SEND: LEVEL-" << s.value << "," << s.level << ":" << s.port << ":" << com.device2);
-                comStack.push_back(com);
+                queueCommand(com);
                 mSendReady = true;
             }
         break;
@@ -1322,7 +1368,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
                     MSG_DEBUG("SEND: COMMAND-'" << s.msg << "'," << s.port << ":" << com.device2);
                 }
 
-                comStack.push_back(com);
+                queueCommand(com);
                 mSendReady = true;
             }
         break;
@@ -1351,7 +1397,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
                 memcpy(&com.data.customEvent.data[0], s.msg.c_str(), len);
 
             com.hlen = 0x0016 - 3 + 29 + len;
-            comStack.push_back(com);
+            queueCommand(com);
             mSendReady = true;
         break;
 
@@ -1360,7 +1406,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
             com.data.sendPortNumber.system = com.system;
             com.data.sendPortNumber.pcount = s.value;
             com.hlen = 0x0016 - 3 + 6;
-            comStack.push_back(com);
+            queueCommand(com);
             mSendReady = true;
         break;
 
@@ -1371,7 +1417,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
             com.data.sendOutpChannels.system = com.system;
             com.data.sendOutpChannels.count = s.value;
             com.hlen = 0x0016 - 3 + 8;
-            comStack.push_back(com);
+            queueCommand(com);
             mSendReady = true;
         break;
 
@@ -1383,7 +1429,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
             com.data.sendSize.type = DTSZ_STRING;
             com.data.sendSize.length = s.value;
             com.hlen = 0x0016 - 3 + 9;
-            comStack.push_back(com);
+            queueCommand(com);
             mSendReady = true;
         break;
 
@@ -1400,7 +1446,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
             com.data.sendLevSupport.types[4] = 0x40;
             com.data.sendLevSupport.types[5] = 0x41;
             com.hlen = 0x0016 - 0x0003 + sizeof(ANET_LEVSUPPORT);
-            comStack.push_back(com);
+            queueCommand(com);
             mSendReady = true;
         break;
 
@@ -1414,7 +1460,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
             com.data.sendStatusCode.str[0] = 'O';
             com.data.sendStatusCode.str[1] = 'K';
             com.hlen = 0x0016 - 3 + 13;
-            comStack.push_back(com);
+            queueCommand(com);
             mSendReady = true;
         break;
 
@@ -1433,7 +1479,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
             com.data.reqPortCount.device = com.device2;
             com.data.reqPortCount.system = com.system;
             com.hlen = 0x0016 - 3 + 4;
-            comStack.push_back(com);
+            queueCommand(com);
             mSendReady = true;
         break;
 
@@ -1473,7 +1519,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
             }
 
             com.hlen = 0x0016 - 3 + len;
-            comStack.push_back(com);
+            queueCommand(com);
             mSendReady = true;
         break;
 
@@ -1540,7 +1586,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
 
             com.data.network.len = total;
             com.hlen = 0x0016 - 3 + total + 1;
-            comStack.push_back(com);
+            queueCommand(com);
             mSendReady = true;
         }
         break;
@@ -1562,7 +1608,7 @@ bool TAmxNet::sendCommand(const ANET_SEND& s)
             }
 
             com.hlen = 0x0016 - 3 + 14;
-            comStack.push_back(com);
+            queueCommand(com);
             mSendReady = true;
         break;
     }
@@ -2191,7 +2237,7 @@ int TAmxNet::msg97fill(ANET_COMMAND *com)
         com->data.srDeviceInfo.len = pos;
         memcpy(com->data.srDeviceInfo.info, buf, pos);
         com->hlen = 0x0016 - 3 + 31 + pos - 1;
-        comStack.push_back(*com);
+        queueCommand(*com);
         sendCounter++;
         com->count = sendCounter;
     }
@@ -2232,37 +2278,81 @@ void TAmxNet::start_write()
 
     while (write_busy && !_restart_ && !killed && _netRunning)
     {
-        while (comStack.size() > 0)
+        // Wait until there is something to send. The timeout is only needed
+        // to recognize the end of the network.
         {
-            if (!isRunning())
-            {
-                comStack.clear();
-                write_busy = false;
-                return;
-            }
+            std::unique_lock<std::mutex> lock(mSendMutex);
+            mSendCond.wait_for(lock, std::chrono::milliseconds(100), [this] { return !mSendQueue.empty() || !isRunning(); });
+            mSendBatch.swap(mSendQueue);
+        }
 
-            mSend = comStack.at(0);
-            comStack.erase(comStack.begin());   // delete oldest element
-            unsigned char *buf = makeBuffer(mSend);
+        if (!isRunning())
+        {
+            std::lock_guard<std::mutex> guard(mSendMutex);
+            mSendQueue.clear();
+            mSendBatch.clear();
+            write_busy = false;
+            return;
+        }
+
+        if (mSendBatch.empty())
+            continue;
+
+        // All frames queued since the last pass are written at once.
+        size_t total = mSendBatch.size();
+        size_t pos = 0;
 
-            if (buf == nullptr)
+        while (pos < total && mSocket && mSocket->isConnected())
+        {
+            ssize_t sent = mSocket->send(reinterpret_cast<char *>(mSendBatch.data() + pos), total - pos);
+
+            if (sent == TSocket::npos || sent <= 0)
             {
-                MSG_ERROR("Error creating a buffer! Token number: " << mSend.MC);
-                continue;
+                MSG_ERROR("Error writing " << (total - pos) << " of " << total << " bytes!");
+                break;
             }
 
-            MSG_DEBUG("Wrote buffer with token 0x" << std::setw(4) << std::setfill('0') << std::hex << mSend.MC << " and " << std::setw(0) << std::setfill(' ') << std::dec << (mSend.hlen + 4) << " bytes.");
-            mSocket->send((char *)buf, mSend.hlen + 4);
-            delete[] buf;
+            pos += static_cast<size_t>(sent);
         }
 
+        MSG_DEBUG("Wrote " << pos << " bytes.");
+        mSendBatch.clear();
         mSendReady = false;
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
 
     write_busy = false;
 }
 
+/*
+ * Encodes the command and appends it to the queue of the write thread.
+ * The frame is encoded directly into the queue. Because the queue and the
+ * buffer of the write thread are swapped, both keep their memory and
+ * usually no allocation is necessary.
+ */
+void TAmxNet::queueCommand(const ANET_COMMAND& com)
+{
+    DECL_TRACER("TAmxNet::queueCommand(const ANET_COMMAND& com)");
+
+    bool valid = false;
+
+    {
+        std::lock_guard<std::mutex> guard(mSendMutex);
+        size_t pos = mSendQueue.size();
+        mSendQueue.resize(pos + com.hlen + 5);
+        valid = makeBuffer(com, mSendQueue.data() + pos);
+        mSendQueue.resize(valid ? pos + com.hlen + 4 : pos);
+    }
+
+    if (!valid)
+    {
+        MSG_ERROR("Error creating a buffer! Token number: " << com.MC);
+        return;
+    }
+
+    MSG_DEBUG("Queued buffer with token 0x" << std::setw(4) << std::setfill('0') << std::hex << com.MC << " and " << std::setw(0) << std::setfill(' ') << std::dec << (com.hlen + 4) << " bytes.");
+    mSendCond.notify_one();
+}
+
 uint16_t TAmxNet::swapWord(uint16_t w)
 {
     uint16_t word = 0;
@@ -2323,25 +2413,18 @@ bool TAmxNet::isCommand(const string& cmd)
     return false;
 }
 
-unsigned char *TAmxNet::makeBuffer(const ANET_COMMAND& s)
+bool TAmxNet::makeBuffer(const ANET_COMMAND& s, unsigned char *buf)
 {
-    DECL_TRACER("TAmxNet::makeBuffer (const ANET_COMMAND& s)");
+    DECL_TRACER("TAmxNet::makeBuffer (const ANET_COMMAND& s, unsigned char *buf)");
 
     int pos = 0;
     int len;
     bool valid = false;
-    unsigned char *buf;
 
-    try
-    {
-        buf = new unsigned char[s.hlen + 5];
-        memset(buf, 0, s.hlen + 5);
-    }
-    catch (std::exception& e)
-    {
-        MSG_ERROR("Error allocating memory: " << e.what());
-        return nullptr;
-    }
+    if (!buf)
+        return false;
+
+    memset(buf, 0, s.hlen + 5);
 
     *buf = s.ID;
     *(buf + 1) = s.hlen >> 8;
@@ -2801,15 +2884,9 @@ unsigned char *TAmxNet::makeBuffer(const ANET_COMMAND& s)
         break;
     }
 
-    if (!valid)
-    {
-        delete[] buf;
-        return 0;
-    }
-
 //    MSG_TRACE("Buffer:");
 //    TError::logHex((char *)buf, s.hlen + 4);
-    return buf;
+    return valid;
 }
 
 void TAmxNet::setSerialNum(const string& sn)
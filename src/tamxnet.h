@@ -28,9 +28,10 @@
 #include <cstdio>
 #include <atomic>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "tsocket.h"
-#include "tvector.h"
 
 #if defined(__ANDROID__) || defined(__MACH__)
 typedef unsigned long int ulong;
@@ -43,6 +44,8 @@ namespace amx
 {
 #define MAX_CHUNK   0x07d0  // Maximum size a part of a file can have. The file will be splitted into this size of chunks.
 #define BUF_SIZE    0x1000  // 4096 bytes
+#define RECV_BUF_SIZE   (BUF_SIZE * 4)  // Size of the receive buffer
+#define ICSP_HEADER_SIZE    0x0016  // Size of the header of an ICSP frame including the message code
 
 #define NSTATE_OFFLINE      0
 #define NSTATE_OFFLINE1     1
@@ -422,30 +425,14 @@ namespace amx
             void start();
 
         private:
-            enum R_TOKEN
-            {
-                RT_NONE,
-                RT_ID,
-                RT_LEN,
-                RT_SEP1,
-                RT_TYPE,
-                RT_WORD1,
-                RT_DEVICE,
-                RT_WORD2,
-                RT_WORD3,
-                RT_WORD4,
-                RT_WORD5,
-                RT_SEP2,
-                RT_COUNT,
-                RT_MC,
-                RT_DATA
-            };
-
             void init();
             void handle_connect();
             void runWrite();
             void start_read();
-            void handle_read(size_t n, R_TOKEN tk);
+            void handle_read(const char *buf, size_t n);
+            bool fillBuffer(size_t need);
+            bool haveFrame();
+            void decodeHeader(const unsigned char *p);
             void start_write();
             void handleFTransfer(ANET_SEND& s, ANET_FILETRANSFER& ft);
             uint16_t swapWord(uint16_t w);
@@ -453,7 +440,8 @@ namespace amx
             unsigned char calcChecksum(const unsigned char *buffer, size_t len);
             uint16_t makeWord(unsigned char b1, unsigned char b2);
             uint32_t makeDWord(unsigned char b1, unsigned char b2, unsigned char b3, unsigned char b4);
-            unsigned char *makeBuffer(const ANET_COMMAND& s);
+            bool makeBuffer(const ANET_COMMAND& s, unsigned char *buf);
+            void queueCommand(const ANET_COMMAND& com);
             int msg97fill(ANET_COMMAND *com);
             bool isCommand(const std::string& cmd);
             bool isRunning() { return !(stopped_ || killed || prg_stopped); }
@@ -472,16 +460,17 @@ namespace amx
             size_t lenSnd{0};
             std::thread mThread;
             std::thread mWriteThread;   // Thread used to write to the Netlinx.
-            std::string input_buffer_;
             std::string panName;        // The technical name of the panel
-            TVector<ANET_COMMAND> comStack; // commands to answer
+            std::vector<unsigned char> mSendQueue;  // Encoded frames waiting to be sent
+            std::vector<unsigned char> mSendBatch;  // Encoded frames actually sent by the write thread
+            std::mutex mSendMutex;      // Protects mSendQueue
+            std::condition_variable mSendCond;  // Wakes up the write thread
             std::vector<DEVICE_INFO> devInfo;
             std::string oldCmd;
             std::string serNum;
             std::string sndFileName;
             std::string rcvFileName;
             ANET_COMMAND comm;          // received command
-            ANET_COMMAND mSend;         // answer / request
             int panelID{0};             // Panel ID of currently legalized panel.
             int mWaitTime{3};           // [seconds]: Wait by default for 3 seconds
             int mOldWaitTime{3};        // [seconds]: The previous wait time in case of change
@@ -498,7 +487,9 @@ namespace amx
             bool isOpenSnd{false};
             bool isOpenRcv{false};
             bool _retry{false};
-            char buff_[BUF_SIZE];       // Internal used buffer for network communication
+            char mRecvBuffer[RECV_BUF_SIZE];    // Receive buffer; holds several frames
+            size_t mRecvStart{0};       // Start of the first not processed byte in mRecvBuffer
+            size_t mRecvEnd{0};         // End of the received bytes in mRecvBuffer
             int mLastOnlineState{NSTATE_OFFLINE};
     };
 }
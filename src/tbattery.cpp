@@ -17,7 +17,6 @@
  */
 #include <string>
 #include <fstream>
-#include <thread>
 #if defined(__OSX_AVAILABLE) && !defined(__IOS_AVAILABLE)
 #include <cstring>
 #include <IOKit/IOKitLib.h>
@@ -50,7 +49,6 @@ using std::exception;
 using std::map;
 using std::pair;
 using std::ifstream;
-using std::thread;
 
 #if defined(__OSX_AVAILABLE) && !defined(__IOS_AVAILABLE)
 #define BAT_CURRENT_CAPACITY        "CurrentCapacity"
@@ -78,6 +76,7 @@ TBattery::~TBattery()
     DECL_TRACER("TBattery::~TBattery()");
 #if (defined(__linux__) || defined(__OSX_AVAILABLE)) && !defined(__IOS_AVAILABLE)
     mTimerRun = false;
+    TTimerWheel::cancel(mTimerID);
 #endif
 }
 
@@ -204,35 +203,30 @@ void TBattery::runTimer()
 {
     DECL_TRACER("TBattery::runTimer()");
 
-    try
-    {
-        mTimerThread = thread([=] {
-            MSG_PROTOCOL("Thread \"TBattery::runTimer()\" was started.");
+    mTimerID = TTimerWheel::schedule(std::chrono::seconds(1), std::chrono::seconds(1), [this] { return timerTick(); });
 
-            while (mTimerRun)
-            {
-                std::this_thread::sleep_for(std::chrono::seconds(1));
+    if (!mTimerID)
+        MSG_ERROR("Error starting the battery timer!");
+}
 
-                if (!mTimerRun)
-                    break;
+/*
+ * This is called by the timer wheel once every second.
+ */
+bool TBattery::timerTick()
+{
+    if (!mTimerRun)
+        return false;
 #ifdef __linux__
-                int load = linuxBattery();
+    int load = linuxBattery();
 #elif defined(__OSX_AVAILABLE)
-                int load = macBattery();
+    int load = macBattery();
 #endif
-                bool charge = isCharging();
+    bool charge = isCharging();
 
-                if (_callback && (mOldLoad != load || mOldAc != charge))
-                    _callback(load, charge);
-            }
-        });
+    if (_callback && (mOldLoad != load || mOldAc != charge))
+        _callback(load, charge);
 
-        mTimerThread.detach();
-    }
-    catch (std::exception& e)
-    {
-        MSG_ERROR("Error starting a thread to handle the battery timer: " << e.what());
-    }
+    return true;
 }
 #endif
 
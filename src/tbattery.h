@@ -18,10 +18,11 @@
 #ifndef TBATTERY_H
 #define TBATTERY_H
 
-#include <thread>
 #include <map>
 #include <functional>
 
+#include "ttimerwheel.h"
+
 class TBattery
 {
     public:
@@ -49,6 +50,7 @@ class TBattery
 #endif
 #if defined(__linux__) || defined(__OSX_AVAILABLE)
         void runTimer();
+        bool timerTick();
 #endif
     private:
         std::function<void (int load, bool charge)> _callback{nullptr};
@@ -60,7 +62,7 @@ class TBattery
         bool mOldAc{false};             // The old state of charging
 #if defined(__linux__) || defined(__OSX_AVAILABLE)
         bool mTimerRun{false};          // TRUE = Timer runs; FALSE = Timer stops
-        std::thread mTimerThread;       // Thread for timer
+        TTimerWheel::TIMER_ID mTimerID{0};  // The timer checking the battery
 #endif
 };
 
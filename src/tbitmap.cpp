@@ -18,6 +18,8 @@
 
 #include <cstring>
 
+#include <include/core/SkBitmap.h>
+
 #include "tbitmap.h"
 #include "terror.h"
 
@@ -33,9 +35,8 @@ TBitmap::TBitmap(const unsigned char* data, size_t size)
     if (!data || !size)
         return;
 
-    mData = new unsigned char[size];
-    memmove(mData, data, size);
-    mSize = size;
+    allocate(size);
+    memmove(mData.get(), data, size);
 }
 
 TBitmap::TBitmap(const unsigned char* data, int width, int height, int pixsize)
@@ -45,41 +46,73 @@ TBitmap::TBitmap(const unsigned char* data, int width, int height, int pixsize)
     if (!data || width <= 0 || height <= 0 || pixsize < 1)
         return;
 
-    mSize = ((size_t)width * (size_t)pixsize) * (size_t)height;
-    mData = new unsigned char[mSize];
-    memmove(mData, data, mSize);
+    allocate(((size_t)width * (size_t)pixsize) * (size_t)height);
+    memmove(mData.get(), data, mSize);
     mPixelSize = pixsize;
     mPixline = width * pixsize;
     mWidth = width;
     mHeight = height;
 }
 
-TBitmap::TBitmap(const TBitmap& bm)
+TBitmap::TBitmap(const SkBitmap& bm)
 {
-    DECL_TRACER("TBitmap::TBitmap(const TBitmap& bm)");
+    DECL_TRACER("TBitmap::TBitmap(const SkBitmap& bm)");
+
+    int width = bm.info().width();
+    int height = bm.info().height();
+    int pixsize = bm.info().bytesPerPixel();
+
+    if (!bm.getPixels() || width <= 0 || height <= 0 || pixsize < 1)
+        return;
 
-    if (bm.mSize > 0)
+    size_t pixline = (size_t)width * (size_t)pixsize;
+
+    if (pixsize == 4 && bm.rowBytes() == pixline)
+    {
+        // Share the pixels. The copy of the SkBitmap holds a reference to
+        // the pixels as long as any TBitmap uses them.
+        SkBitmap *keep = new SkBitmap(bm);
+        mData = std::shared_ptr<unsigned char>(static_cast<unsigned char *>(keep->getPixels()), [keep](unsigned char *) { delete keep; });
+        mSize = pixline * (size_t)height;
+    }
+    else
     {
-        mData = new unsigned char[bm.mSize];
-        memmove(mData, bm.mData, bm.mSize);
-        mSize = bm.mSize;
+        // The lines are padded or the pixel size is not supported by the
+        // GUI. Copy the pixels line by line.
+        allocate(pixline * (size_t)height);
+
+        for (int y = 0; y < height; ++y)
+            memmove(mData.get() + pixline * y, static_cast<const unsigned char *>(bm.getPixels()) + bm.rowBytes() * y, pixline);
     }
 
-    mPixline = bm.mPixline;
-    mPixelSize = bm.mPixelSize;
-    mWidth = bm.mWidth;
-    mHeight = bm.mHeight;
+    mPixelSize = pixsize;
+    mPixline = static_cast<int>(pixline);
+    mWidth = width;
+    mHeight = height;
+}
+
+TBitmap::TBitmap(const TBitmap& bm)
+    : mData(bm.mData),
+      mSize(bm.mSize),
+      mPixline(bm.mPixline),
+      mWidth(bm.mWidth),
+      mHeight(bm.mHeight),
+      mPixelSize(bm.mPixelSize)
+{
+    DECL_TRACER("TBitmap::TBitmap(const TBitmap& bm)");
 }
 
 TBitmap::~TBitmap()
 {
     DECL_TRACER("TBitmap::~TBitmap()");
+}
 
-    if (mData)
-        delete[] mData;
+void TBitmap::allocate(size_t size)
+{
+    DECL_TRACER("TBitmap::allocate(size_t size)");
 
-    mData = nullptr;
-    mSize = 0;
+    mData = std::shared_ptr<unsigned char>(new unsigned char[size], std::default_delete<unsigned char[]>());
+    mSize = size;
 }
 
 void TBitmap::setPixline(int pl)
@@ -112,9 +145,8 @@ void TBitmap::setBitmap(const unsigned char* data, size_t size)
     if (!data || !size)
         return;
 
-    mData = new unsigned char [size];
-    memmove(mData, data, size);
-    mSize = size;
+    allocate(size);
+    memmove(mData.get(), data, size);
 }
 
 void TBitmap::setBitmap(const unsigned char* data, int width, int height, int pixsize)
@@ -126,9 +158,8 @@ void TBitmap::setBitmap(const unsigned char* data, int width, int height, int pi
     if (!data || width <= 0 || height <= 0 || pixsize < 1)
         return;
 
-    mSize = ((size_t)width * (size_t)pixsize) * (size_t)height;
-    mData = new unsigned char[mSize];
-    memmove(mData, data, mSize);
+    allocate(((size_t)width * (size_t)pixsize) * (size_t)height);
+    memmove(mData.get(), data, mSize);
     mPixelSize = pixsize;
     mPixline = width * pixsize;
     mWidth = width;
@@ -142,7 +173,7 @@ unsigned char *TBitmap::getBitmap(size_t* size)
     if (size)
         *size = mSize;
 
-    return mData;
+    return mData.get();
 }
 
 void TBitmap::setWidth(int w)
@@ -245,12 +276,7 @@ void TBitmap::clear()
 {
     DECL_TRACER("TBitmap::clear()");
 
-    if (mData)
-    {
-        delete[] mData;
-        mData = nullptr;
-    }
-
+    mData.reset();
     mSize = 0;
     mPixline = mWidth = mHeight = 0;
     mPixelSize = 4;
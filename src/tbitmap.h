@@ -20,7 +20,18 @@
 #define __TBITMAP_H__
 
 #include <cstring>
+#include <memory>
 
+class SkBitmap;
+
+/**
+ * @brief The TBitmap class
+ * This class transports the pixels of an image from the drawing code to the
+ * GUI. The pixels are immutable and reference counted. A copy of a TBitmap
+ * shares the pixels with the original. Therefore it is cheap to pass it by
+ * value through signals and callbacks. The content of the buffer returned by
+ * getBitmap() must never be changed.
+ */
 class TBitmap
 {
     public:
@@ -28,6 +39,13 @@ class TBitmap
         TBitmap(const TBitmap& bm);
         TBitmap(const unsigned char *data, size_t size);
         TBitmap(const unsigned char *data, int width, int height, int pixsize=4);
+        /**
+         * Takes the pixels of a Skia bitmap. If the bitmap has 4 bytes per
+         * pixel and no padding at the end of the lines, the pixels are not
+         * copied. The TBitmap holds a reference to them instead. The caller
+         * must not draw into \p bm afterwards.
+         */
+        explicit TBitmap(const SkBitmap& bm);
         ~TBitmap();
 
         void setBitmap(const unsigned char *data, size_t size);
@@ -51,15 +69,9 @@ class TBitmap
 
         TBitmap& operator=(const TBitmap& bm)
         {
-            this->clear();
-
-            if (bm.mSize > 0)
-            {
-                this->mData = new unsigned char[bm.mSize];
-                memmove(this->mData, bm.mData, bm.mSize);
-                this->mSize = bm.mSize;
-            }
-
+            // The pixels are shared, not copied.
+            this->mData = bm.mData;
+            this->mSize = bm.mSize;
             this->mPixline = bm.mPixline;
             this->mPixelSize = bm.mPixelSize;
             this->mWidth = bm.mWidth;
@@ -69,7 +81,9 @@ class TBitmap
         }
 
     private:
-        unsigned char *mData{nullptr};
+        void allocate(size_t size);
+
+        std::shared_ptr<unsigned char> mData;
         size_t mSize{0};
         int mPixline{0};
         int mWidth{0};
@@ -60,10 +60,14 @@
 #include "tpagemanager.h"
 #include "tsystemsound.h"
 #include "timgcache.h"
+#include "timgsource.h"
 #include "turl.h"
 #include "tlock.h"
 #include "ttpinit.h"
 #include "tlauncher.h"
+#include "tthreadpool.h"
+#include "tpixelkernels.h"
+#include "ttextlayout.h"
 #if TESTMODE == 1
 #include "testmode.h"
 #endif
@@ -101,6 +105,7 @@ using namespace Button;
 using namespace Expat;
 
 #define MAX_BUFFER          65536
+#define MAX_PARALLEL_DOWNLOADS  2     // Maximum number of dynamic images loaded at the same time
 
 #define RLOG_INFO           0x00fe
 #define RLOG_WARNING        0x00fd
@@ -115,6 +120,7 @@ extern amx::TAmxNet *gAmxNet;
 extern TPageManager *gPageManager;
 
 THR_REFRESH_t *TButton::mThrRefresh = nullptr;
+std::atomic<uint64_t> TButton::mGeometryGeneration{0};
 vector<BITMAP_CACHE> nBitmapCache;     // Holds the images who are delayed because they are external
 
 SYSTEF_t sysTefs[] = {
@@ -234,14 +240,7 @@ TButton::~TButton()
         delete mTimer;
     }
 
-    if (mAniRunning)
-    {
-        ulong tm = nu * ru + nd * rd;
-        mAniStop = true;
-
-        while (mAniRunning)
-            std::this_thread::sleep_for(std::chrono::milliseconds(tm * 100));
-    }
+    stopAnimation();
 
     THR_REFRESH_t *next, *p = mThrRefresh;
 
@@ -311,21 +310,25 @@ size_t TButton::initialize(TExpat *xml, size_t index)
         {
             lt = xml->convertElementToInt(content);
             mPosLeft = lt;
+            mGeometryGeneration++;
         }
         else if (ename.compare("tp") == 0)          // Top
         {
             tp = xml->convertElementToInt(content);
             mPosTop = tp;
+            mGeometryGeneration++;
         }
         else if (ename.compare("wt") == 0)          // Width
         {
             wt = xml->convertElementToInt(content);
             mWidthOrig = wt;
+            mGeometryGeneration++;
         }
         else if (ename.compare("ht") == 0)          // Height
         {
             ht = xml->convertElementToInt(content);
             mHeightOrig = ht;
+            mGeometryGeneration++;
         }
         else if (ename.compare("zo") == 0)          // Z-Order
             zo = xml->convertElementToInt(content);
@@ -766,6 +769,7 @@ bool TButton::createSoftButton(const EXTBUTTON_t& bt)
     tp = mPosTop = bt.tp;
     wt = bt.wt;
     ht = bt.ht;
+    mGeometryGeneration++;
     zo = bt.zo;
     hs = bt.hs;
     bs = bt.bs;
@@ -817,7 +821,7 @@ TBitmap TButton::getLastBitmap()
     if (mLastImage.empty())
         makeElement(mActInstance);
 
-    TBitmap bitmap((unsigned char *)mLastImage.getPixels(), mLastImage.info().width(), mLastImage.info().height());
+    TBitmap bitmap(mLastImage);
     return bitmap;
 }
 
@@ -1256,13 +1260,9 @@ bool TButton::createButtons(bool force)
 
         if (!bmExistMi && !srIter->mi.empty())        // Do we have a chameleon image?
         {
-            sk_sp<SkData> image;
             SkBitmap bm;
 
-            if (!(image = readImage(srIter->mi)))
-                return false;
-
-            DecodeDataToBitmap(image, &bm);
+            TImgSource::getBitmap(srIter->mi, &bm);
 
             if (bm.empty())
             {
@@ -1278,13 +1278,9 @@ bool TButton::createButtons(bool force)
 
         if (!bmExistBm && !srIter->bm.empty() && !srIter->dynamic)        // Do we have a bitmap?
         {
-            sk_sp<SkData> image;
             SkBitmap bm;
 
-            if (!(image = readImage(srIter->bm)))
-                return false;
-
-            DecodeDataToBitmap(image, &bm);
+            TImgSource::getBitmap(srIter->bm, &bm);
 
             if (bm.empty())
             {
@@ -2991,7 +2987,10 @@ void TButton::setLeft(int left)
         return;
 
     if (mPosLeft != left)
+    {
         mChanged = true;
+        mGeometryGeneration++;
+    }
 
     mPosLeft = left;
     makeElement(mActInstance);
@@ -3005,7 +3004,10 @@ void TButton::setTop(int top)
         return;
 
     if (mPosTop != top)
+    {
         mChanged = true;
+        mGeometryGeneration++;
+    }
 
     mPosTop = top;
     makeElement(mActInstance);
@@ -3019,7 +3021,10 @@ void TButton::setLeftTop(int left, int top)
         return;
 
     if (mPosLeft != left || mPosTop != top)
+    {
         mChanged = true;
+        mGeometryGeneration++;
+    }
     else
         return;
 
@@ -3051,6 +3056,8 @@ void TButton::setRectangle(int left, int top, int right, int bottom)
 
     if (top >= 0 && bottom > top)
         ht = height;
+
+    mGeometryGeneration++;
 }
 
 void TButton::getRectangle(int *left, int *top, int *height, int *width)
@@ -3083,6 +3090,7 @@ void TButton::resetButton()
     mPosTop = tp;
     wt = mWidthOrig;
     ht = mHeightOrig;
+    mGeometryGeneration++;
 }
 
 void TButton::setResourceName(const string& name, int instance)
@@ -3751,25 +3759,27 @@ bool TButton::startAnimation(int st, int end, int time)
 
     int start = std::max(1, st);
 
-    if (mAniRunning || mThrAni.joinable())
+    if (mAniRunning)
     {
         MSG_PROTOCOL("Animation is already running!");
         return true;
     }
 
-    int number = end - start;
+    int number = std::max(end - start, 1);
     ulong stepTime = ((ulong)time * 10L) / (ulong)number;
     mAniRunTime = (ulong)time * 10L;
+    mAniStop = false;
+    mAniRunning = true;
+    int instance = start - 1;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    mAniTimer = TTimerWheel::schedule(std::chrono::milliseconds(0), std::chrono::milliseconds(std::max(stepTime, 1UL)),
+                                      [this, instance, start, end, startTime]() mutable { return runAnimationRange(instance, start, end, startTime); });
 
-    try
-    {
-        mAniStop = false;
-        mThrAni = thread([=] { runAnimationRange(start, end, stepTime); });
-        mThrAni.detach();
-    }
-    catch (exception& e)
+    if (!mAniTimer)
     {
-        MSG_ERROR("Error starting the button animation thread: " << e.what());
+        MSG_ERROR("Error starting the button animation!");
+        mAniRunning = false;
+        mAniRunTime = 0;
         return false;
     }
 
@@ -3993,7 +4003,7 @@ void TButton::_imageRefresh(const string& url)
         imgButton = ooButton;
     }
 
-    mLastImage = imgButton;
+    setLastImage(imgButton);
     mChanged = false;
 
     if (!prg_stopped && visible && _displayButton)
@@ -4003,32 +4013,9 @@ void TButton::_imageRefresh(const string& url)
         int rleft = mPosLeft;
         int rtop = mPosTop;
 #ifdef _SCALE_SKIA_
-        if (gPageManager && gPageManager->getScaleFactor() != 1.0)
-        {
-            rwidth = static_cast<int>(static_cast<double>(wt) * gPageManager->getScaleFactor());
-            rheight = static_cast<int>(static_cast<double>(ht) * gPageManager->getScaleFactor());
-            rleft = static_cast<int>(static_cast<double>(mPosLeft) * gPageManager->getScaleFactor());
-            rtop = static_cast<int>(static_cast<double>(mPosTop) * gPageManager->getScaleFactor());
-
-            SkPaint paint;
-            paint.setBlendMode(SkBlendMode::kSrc);
-            paint.setFilterQuality(kHigh_SkFilterQuality);
-            // Calculate new dimension
-            SkImageInfo info = imgButton.info();
-            int width = (int)((double)info.width() * gPageManager->getScaleFactor());
-            int height = (int)((double)info.height() * gPageManager->getScaleFactor());
-            // Create a canvas and draw new image
-            sk_sp<SkImage> im = SkImage::MakeFromBitmap(imgButton);
-            imgButton.allocN32Pixels(width, height);
-            imgButton.eraseColor(SK_ColorTRANSPARENT);
-            SkCanvas can(imgButton, SkSurfaceProps());
-            SkRect rect = SkRect::MakeXYWH(0, 0, width, height);
-            can.drawImageRect(im, rect, SkSamplingOptions(), &paint);
-            rowBytes = imgButton.info().minRowBytes();
-            mLastImage = imgButton;
-        }
+        scaleToDevice(imgButton, &rleft, &rtop, &rwidth, &rheight);
 #endif
-        TBitmap image((unsigned char *)imgButton.getPixels(), imgButton.info().width(), imgButton.info().height());
+        TBitmap image(imgButton);
         _displayButton(mHandle, parent, image, rwidth, rheight, rleft, rtop, isPassThrough(), sr[mActInstance].md, sr[mActInstance].mr);
 
         if (sr[mActInstance].md > 0 && sr[mActInstance].mr > 0)
@@ -4413,20 +4400,14 @@ bool TButton::buttonBitmap(SkBitmap* bm, int inst)
 
         if (!TImgCache::getBitmap(sr[instance].mi, &bmMi, _BMTYPE_CHAMELEON, &sr[instance].mi_width, &sr[instance].mi_height))
         {
-            sk_sp<SkData> data = readImage(sr[instance].mi);
             bool loaded = false;
 
-            if (data)
+            if (TImgSource::getBitmap(sr[instance].mi, &bmMi))
             {
-                DecodeDataToBitmap(data, &bmMi);
-
-                if (!bmMi.empty())
-                {
-                    TImgCache::addImage(sr[instance].mi, bmMi, _BMTYPE_CHAMELEON);
-                    loaded = true;
-                    sr[instance].mi_width = bmMi.info().width();
-                    sr[instance].mi_height = bmMi.info().height();
-                }
+                TImgCache::addImage(sr[instance].mi, bmMi, _BMTYPE_CHAMELEON);
+                loaded = true;
+                sr[instance].mi_width = bmMi.info().width();
+                sr[instance].mi_height = bmMi.info().height();
             }
 
             if(!loaded)
@@ -4446,20 +4427,14 @@ bool TButton::buttonBitmap(SkBitmap* bm, int inst)
         {
             if (!TImgCache::getBitmap(sr[instance].bm, &bmBm, _BMTYPE_BITMAP, &sr[instance].bm_width, &sr[instance].bm_height))
             {
-                sk_sp<SkData> data = readImage(sr[instance].bm);
                 bool loaded = false;
 
-                if (data)
+                if (TImgSource::getBitmap(sr[instance].bm, &bmBm))
                 {
-                    DecodeDataToBitmap(data, &bmBm);
-
-                    if (!bmBm.empty())
-                    {
-                        TImgCache::addImage(sr[instance].bm, bmBm, _BMTYPE_BITMAP);
-                        loaded = true;
-                        sr[instance].bm_width = bmBm.info().width();
-                        sr[instance].bm_height = bmBm.info().height();
-                    }
+                    TImgCache::addImage(sr[instance].bm, bmBm, _BMTYPE_BITMAP);
+                    loaded = true;
+                    sr[instance].bm_width = bmBm.info().width();
+                    sr[instance].bm_height = bmBm.info().height();
                 }
 
                 if (!loaded)
@@ -4588,20 +4563,14 @@ bool TButton::buttonBitmap(SkBitmap* bm, int inst)
 
         if (!tp5 && !TImgCache::getBitmap(sr[instance].bm, &image, _BMTYPE_BITMAP, &sr[instance].bm_width, &sr[instance].bm_height))
         {
-            sk_sp<SkData> data = readImage(sr[instance].bm);
             bool loaded = false;
 
-            if (data)
+            if (TImgSource::getBitmap(sr[instance].bm, &image))
             {
-                DecodeDataToBitmap(data, &image);
-
-                if (!image.empty())
-                {
-                    TImgCache::addImage(sr[instance].mi, image, _BMTYPE_BITMAP);
-                    loaded = true;
-                    sr[instance].bm_width = image.info().width();
-                    sr[instance].bm_height = image.info().height();
-                }
+                TImgCache::addImage(sr[instance].mi, image, _BMTYPE_BITMAP);
+                loaded = true;
+                sr[instance].bm_width = image.info().width();
+                sr[instance].bm_height = image.info().height();
             }
 
             if (!loaded)
@@ -4728,18 +4697,12 @@ bool TButton::buttonBitmap5(SkBitmap* bm, int instance, bool ignFirst)
 
         if (!TImgCache::getBitmap(sr[instance].bitmaps[i].fileName, &bmBm, _BMTYPE_BITMAP, &width, &height))
         {
-            sk_sp<SkData> data = readImage(sr[instance].bitmaps[i].fileName);
             bool loaded = false;
 
-            if (data)
+            if (TImgSource::getBitmap(sr[instance].bitmaps[i].fileName, &bmBm))
             {
-                DecodeDataToBitmap(data, &bmBm);
-
-                if (!bmBm.empty())
-                {
-                    TImgCache::addImage(sr[instance].bitmaps[i].fileName, bmBm, _BMTYPE_BITMAP);
-                    loaded = true;
-                }
+                TImgCache::addImage(sr[instance].bitmaps[i].fileName, bmBm, _BMTYPE_BITMAP);
+                loaded = true;
             }
 
             if (!loaded)
@@ -5380,11 +5343,13 @@ bool TButton::buttonDynamic(SkBitmap* bm, int instance, bool show, bool *state,
         if (state)
             *state = true;  // Prevent the calling method from displaying the button
 
-        MSG_TRACE("Starting thread for loading a dynamic image ...");
-        mThrRes = std::thread([=] { this->funcResource(&resource, url, bc, instance); });
-        MSG_TRACE("Thread started. Detaching ...");
-        mThrRes.detach();
-        MSG_TRACE("Thread is running and detached.");
+        MSG_TRACE("Queueing a task for loading a dynamic image ...");
+
+        // A download may block for the length of the HTTP timeout. Therefore
+        // only a few of them may run in parallel to keep workers available
+        // for button presses.
+        if (!TThreadPool::postLimited("TButton::funcResource", [=] { this->funcResource(&resource, url, bc, instance); }, MAX_PARALLEL_DOWNLOADS))
+            MSG_ERROR("Error queueing the task to load a dynamic image!");
     }
     catch (std::exception& e)
     {
@@ -5814,18 +5779,12 @@ bool TButton::barLevel(SkBitmap* bm, int, int level)
 
         if (!TImgCache::getBitmap(sr[0].mi, &bmMi, _BMTYPE_CHAMELEON, &sr[0].mi_width, &sr[0].mi_height))
         {
-            sk_sp<SkData> data = readImage(sr[0].mi);
             bool loaded = false;
 
-            if (data)
+            if (TImgSource::getBitmap(sr[0].mi, &bmMi))
             {
-                DecodeDataToBitmap(data, &bmMi);
-
-                if (!bmMi.empty())
-                {
-                    TImgCache::addImage(sr[0].mi, bmMi, _BMTYPE_CHAMELEON);
-                    loaded = true;
-                }
+                TImgCache::addImage(sr[0].mi, bmMi, _BMTYPE_CHAMELEON);
+                loaded = true;
             }
 
             if (!loaded)
@@ -5872,36 +5831,40 @@ bool TButton::barLevel(SkBitmap* bm, int, int level)
         if (!allocPixels(sr[0].mi_width, sr[0].mi_height, &img))
             return false;
 
-        SkCanvas canvas(img);
         SkColor col1 = TColor::getSkiaColor(sr[1].cf);
         SkColor col2 = TColor::getSkiaColor(sr[1].cb);
         MSG_DEBUG("Have " << sr[0].mi_width << " x " << sr[0].mi_height << " pixels.");
+        // The visible part of the bargraph is mixed row by row. The result
+        // is premultiplied, because the target bitmap expects this.
+        vector<uint32_t> redBuffer, maskBuffer;
+        vector<uint32_t> row(sr[0].mi_width);
+        const uint32_t *red = TPixelKernels::getColors(imgRed, redBuffer);
+        const uint32_t *mask = (imgMask.empty() ? nullptr : TPixelKernels::getColors(imgMask, maskBuffer));
+        int redWidth = pixmapRed.info().width();
+        int maskWidth = (mask ? pixmapMask.info().width() : 0);
+        int endX = std::min(width, redWidth);
+        int endY = std::min(height, pixmapRed.info().height());
 
-        for (int ix = 0; ix < sr[0].mi_width; ix++)
+        if (mask)
         {
-            for (int iy = 0; iy < sr[0].mi_height; iy++)
-            {
-                SkPaint paint;
-                SkColor pixel;
-
-                if (ix >= startX && ix < width && iy >= startY && iy < height)
-                {
-                    SkColor pixelRed = pixmapRed.getColor(ix, iy);
-                    SkColor pixelMask;
-
-                    if (!imgMask.empty())
-                        pixelMask = pixmapMask.getColor(ix, iy);
-                    else
-                        pixelMask = SK_ColorWHITE;
+            endX = std::min(endX, maskWidth);
+            endY = std::min(endY, pixmapMask.info().height());
+        }
 
-                    pixel = baseColor(pixelRed, pixelMask, col1, col2);
-                }
-                else
-                    pixel = SK_ColorTRANSPARENT;
+        for (int iy = 0; iy < sr[0].mi_height; iy++)
+        {
+            uint32_t *wpix = img.getAddr32(0, iy);
+            std::fill(row.begin(), row.end(), SK_ColorTRANSPARENT);
 
-                paint.setColor(pixel);
-                canvas.drawPoint(ix, iy, paint);
+            if (red && iy >= startY && iy < endY && endX > startX)
+            {
+                const uint32_t *redRow = red + static_cast<size_t>(iy) * redWidth + startX;
+                const uint32_t *maskRow = (mask ? mask + static_cast<size_t>(iy) * maskWidth + startX : nullptr);
+                TPixelKernels::chameleon(row.data() + startX, redRow, maskRow, endX - startX, col1, col2, SK_ColorWHITE, isBigEndian(), false);
             }
+
+            for (int ix = 0; ix < sr[0].mi_width; ix++)
+                wpix[ix] = SkPreMultiplyColor(row[ix]);
         }
 
         if (img.empty())
@@ -6638,18 +6601,9 @@ bool TButton::buttonText(SkBitmap* bm, int inst)
 
     if (lines > 1 || sr[instance].ww)
     {
-        vector<string> textLines;
-
-        if (!sr[instance].ww)
-        {
-            textLines = splitLine(sr[instance].te, true);
-            lines = static_cast<int>(textLines.size());
-        }
-        else
-        {
-            textLines = splitLine(sr[instance].te, wt, ht, skFont, paint);
-            lines = static_cast<int>(textLines.size());
-        }
+        std::shared_ptr<const TEXT_LAYOUT_t> layout = TTextLayout::getLayout(sr[instance].te, wt, ht, (sr[instance].ww ? TW_WORDS : TW_LINES), skFont, paint);
+        const vector<TEXT_LINE_t>& textLines = layout->lines;
+        lines = static_cast<int>(textLines.size());
 
         MSG_DEBUG("Calculated number of lines: " << lines);
         int lineHeight = (metrics.fAscent * -1) + metrics.fDescent;
@@ -6662,22 +6616,11 @@ bool TButton::buttonText(SkBitmap* bm, int inst)
         }
 */
         MSG_DEBUG("Line height: " << lineHeight << ", total height: " << totalHeight);
-        vector<string>::iterator iter;
         int line = 0;
-        int maxWidth = 0;
+        int maxWidth = static_cast<int>(layout->maxWidth);
 
         if (textLines.size() > 0)
         {
-            // Calculate the maximum width
-            for (iter = textLines.begin(); iter != textLines.end(); ++iter)
-            {
-                SkRect rect;
-                skFont.measureText(iter->c_str(), iter->length(), SkTextEncoding::kUTF8, &rect, &paint);
-
-                if (rect.width() > maxWidth)
-                    maxWidth = rect.width();
-            }
-
             POSITION_t pos = calcImagePosition(maxWidth, totalHeight, SC_TEXT, instance);
 
             if (!pos.valid)
@@ -6689,13 +6632,12 @@ bool TButton::buttonText(SkBitmap* bm, int inst)
 
             SkScalar lnHt = metrics.fAscent * -1;
 
-            for (iter = textLines.begin(); iter != textLines.end(); ++iter)
+            for (const TEXT_LINE_t& textLine : textLines)
             {
-                sk_sp<SkTextBlob> blob = SkTextBlob::MakeFromString(iter->c_str(), skFont);
-                MSG_DEBUG("Trying to print line: " << *iter);
+                sk_sp<SkTextBlob> blob = textLine.blob;
+                MSG_DEBUG("Trying to print line: " << textLine.text);
                 // We want to take care about the horizontal position.
-                SkRect rect;
-                skFont.measureText(iter->c_str(), iter->length(), SkTextEncoding::kUTF8, &rect, &paint);
+                const SkRect& rect = textLine.bounds;
                 SkScalar horizontal = 0.0;
 
                 switch(sr[instance].jt)
@@ -6737,9 +6679,9 @@ bool TButton::buttonText(SkBitmap* bm, int inst)
     else    // single line
     {
         string text = sr[instance].te;
-        sk_sp<SkTextBlob> blob = SkTextBlob::MakeFromString(text.data(), skFont);
-        SkRect rect;
-        skFont.measureText(text.data(), text.size(), SkTextEncoding::kUTF8, &rect, &paint);
+        std::shared_ptr<const TEXT_LAYOUT_t> layout = TTextLayout::getLayout(text, wt, ht, TW_NONE, skFont, paint);
+        sk_sp<SkTextBlob> blob = layout->lines[0].blob;
+        const SkRect& rect = layout->lines[0].bounds;
         MSG_DEBUG("Calculated Skia rectangle of font: width=" << rect.width() << ", height=" << rect.height());
         POSITION_t position;
 
@@ -7088,42 +7030,51 @@ bool TButton::buttonBorder(SkBitmap* bm, int inst, TSystemDraw::LINE_TYPE_t lnTy
             return false;
 
         MSG_DEBUG("Got images \"" << bd.bl << "\" and \"" << bd.bl_alpha << "\" with size " << imgBL.info().width() << " x " << imgBL.info().height());
-        MSG_DEBUG("Button image size: " << (imgTL.info().width() + imgT.info().width() + imgTR.info().width()) << " x " << (imgTL.info().height() + imgL.info().height() + imgBL.info().height()));
-        MSG_DEBUG("Total size: " << wt << " x " << ht);
-        stretchImageWidth(&imgB, wt - imgBL.info().width() - imgBR.info().width());
-        stretchImageWidth(&imgT, wt - imgTL.info().width() - imgTR.info().width());
-        stretchImageHeight(&imgL, ht - imgTL.info().height() - imgBL.info().height());
-        stretchImageHeight(&imgR, ht - imgTR.info().height() - imgBR.info().height());
-        MSG_DEBUG("Stretched button image size: " << (imgTL.info().width() + imgT.info().width() + imgTR.info().width()) << " x " << (imgTL.info().height() + imgL.info().height() + imgBL.info().height()));
-        // Draw the frame
+        // If a frame with the same border, color and size was already drawn,
+        // we take it from the cache.
         SkBitmap frame;
-        allocPixels(bm->info().width(), bm->info().height(), &frame);
-        frame.eraseColor(SK_ColorTRANSPARENT);
-        SkCanvas target(*bm, SkSurfaceProps());
-        SkCanvas canvas(frame, SkSurfaceProps());
-        SkPaint paint;
+        string frameKey = "btn:" + bd.border.baseFile + "|" + std::to_string(lineType) + "|" + std::to_string(color) + "|" + std::to_string(wt) + "x" + std::to_string(ht);
+
+        if (!TImgCache::getBitmap(frameKey, &frame, _BMTYPE_FRAME) || frame.info().dimensions() != bm->info().dimensions())
+        {
+            MSG_DEBUG("Button image size: " << (imgTL.info().width() + imgT.info().width() + imgTR.info().width()) << " x " << (imgTL.info().height() + imgL.info().height() + imgBL.info().height()));
+            MSG_DEBUG("Total size: " << wt << " x " << ht);
+            stretchImageWidth(&imgB, wt - imgBL.info().width() - imgBR.info().width());
+            stretchImageWidth(&imgT, wt - imgTL.info().width() - imgTR.info().width());
+            stretchImageHeight(&imgL, ht - imgTL.info().height() - imgBL.info().height());
+            stretchImageHeight(&imgR, ht - imgTR.info().height() - imgBR.info().height());
+            MSG_DEBUG("Stretched button image size: " << (imgTL.info().width() + imgT.info().width() + imgTR.info().width()) << " x " << (imgTL.info().height() + imgL.info().height() + imgBL.info().height()));
+            // Draw the frame
+            allocPixels(bm->info().width(), bm->info().height(), &frame);
+            frame.eraseColor(SK_ColorTRANSPARENT);
+            SkCanvas canvas(frame, SkSurfaceProps());
+            SkPaint paint;
 
-        paint.setBlendMode(SkBlendMode::kSrcOver);
-        paint.setAntiAlias(true);
-        sk_sp<SkImage> _image = SkImages::RasterFromBitmap(imgB);   // bottom
-        canvas.drawImage(_image, imgBL.info().width(), ht - imgB.info().height(), SkSamplingOptions(), &paint);
-        _image = SkImages::RasterFromBitmap(imgT);                  // top
-        canvas.drawImage(_image, imgTL.info().width(), 0, SkSamplingOptions(), &paint);
-        _image = SkImages::RasterFromBitmap(imgBR);                 // bottom right
-        canvas.drawImage(_image, wt - imgBR.info().width(), ht - imgBR.info().height(), SkSamplingOptions(), &paint);
-        _image = SkImages::RasterFromBitmap(imgTR);                 // top right
-        canvas.drawImage(_image, wt - imgTR.info().width(), 0, SkSamplingOptions(), &paint);
-        _image = SkImages::RasterFromBitmap(imgTL);                 // top left
-        canvas.drawImage(_image, 0, 0, SkSamplingOptions(), &paint);
-        _image = SkImages::RasterFromBitmap(imgBL);                 // bottom left
-        canvas.drawImage(_image, 0, ht - imgBL.info().height(), SkSamplingOptions(), &paint);
-        _image = SkImages::RasterFromBitmap(imgL);                  // left
-        canvas.drawImage(_image, 0, imgTL.info().height(), SkSamplingOptions(), &paint);
-        _image = SkImages::RasterFromBitmap(imgR);                  // right
-        canvas.drawImage(_image, wt - imgR.info().width(), imgTR.info().height(), SkSamplingOptions(), &paint);
+            paint.setBlendMode(SkBlendMode::kSrcOver);
+            paint.setAntiAlias(true);
+            sk_sp<SkImage> _image = SkImages::RasterFromBitmap(imgB);   // bottom
+            canvas.drawImage(_image, imgBL.info().width(), ht - imgB.info().height(), SkSamplingOptions(), &paint);
+            _image = SkImages::RasterFromBitmap(imgT);                  // top
+            canvas.drawImage(_image, imgTL.info().width(), 0, SkSamplingOptions(), &paint);
+            _image = SkImages::RasterFromBitmap(imgBR);                 // bottom right
+            canvas.drawImage(_image, wt - imgBR.info().width(), ht - imgBR.info().height(), SkSamplingOptions(), &paint);
+            _image = SkImages::RasterFromBitmap(imgTR);                 // top right
+            canvas.drawImage(_image, wt - imgTR.info().width(), 0, SkSamplingOptions(), &paint);
+            _image = SkImages::RasterFromBitmap(imgTL);                 // top left
+            canvas.drawImage(_image, 0, 0, SkSamplingOptions(), &paint);
+            _image = SkImages::RasterFromBitmap(imgBL);                 // bottom left
+            canvas.drawImage(_image, 0, ht - imgBL.info().height(), SkSamplingOptions(), &paint);
+            _image = SkImages::RasterFromBitmap(imgL);                  // left
+            canvas.drawImage(_image, 0, imgTL.info().height(), SkSamplingOptions(), &paint);
+            _image = SkImages::RasterFromBitmap(imgR);                  // right
+            canvas.drawImage(_image, wt - imgR.info().width(), imgTR.info().height(), SkSamplingOptions(), &paint);
+            TImgCache::addImage(frameKey, frame, _BMTYPE_FRAME);
+        }
 
+        SkCanvas target(*bm, SkSurfaceProps());
+        SkPaint paint;
         erasePart(bm, frame, Border::ERASE_OUTSIDE, imgL.info().width());
-        _image = SkImages::RasterFromBitmap(frame);
+        sk_sp<SkImage> _image = SkImages::RasterFromBitmap(frame);
         paint.setBlendMode(SkBlendMode::kSrcATop);
         target.drawImage(_image, 0, 0, SkSamplingOptions(), &paint);
     }
@@ -7168,76 +7119,85 @@ SkRect TButton::calcRect(int width, int height, int pen)
     return rect;
 }
 
-void TButton::runAnimation()
+/*
+ * The following methods are called by the timer wheel. Each call draws
+ * the next instance of the animation. They return FALSE when the
+ * animation should end.
+ */
+bool TButton::runAnimation(int& instance)
 {
-    DECL_TRACER("TButton::runAnimation()");
+    DECL_TRACER("TButton::runAnimation(int& instance)");
 
-    if (mAniRunning)
-        return;
+    if (mAniStop || prg_stopped)
+    {
+        mAniRunning = false;
+        return false;
+    }
 
-    mAniRunning = true;
-    int instance = 0;
     int max = (int)sr.size();
-    ulong tm = nu * ru + nd * rd;
+    mActInstance = instance;
+    mChanged = true;
 
-    while (mAniRunning && !mAniStop && !prg_stopped)
+    if (visible && !drawButton(instance))
     {
-        mActInstance = instance;
-        mChanged = true;
-
-        if (visible && !drawButton(instance))
-            break;
-
-        instance++;
+        mAniRunning = false;
+        return false;
+    }
 
-        if (instance >= max)
-            instance = 0;
+    instance++;
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(tm));
-    }
+    if (instance >= max)
+        instance = 0;
 
-    mAniRunning = false;
+    return true;
 }
 
-void TButton::runAnimationRange(int start, int end, ulong step)
+bool TButton::runAnimationRange(int& instance, int start, int end, std::chrono::steady_clock::time_point startTime)
 {
-    DECL_TRACER("TButton::runAnimationRange(int start, int end, ulong step)");
+    DECL_TRACER("TButton::runAnimationRange(int& instance, int start, int end, std::chrono::steady_clock::time_point startTime)");
 
-    if (mAniRunning)
-        return;
-
-    mAniRunning = true;
-    int instance = start - 1;
-    int max = std::min(end, (int)sr.size());
-    std::chrono::steady_clock::time_point startt = std::chrono::steady_clock::now();
+    if (mAniStop || prg_stopped)
+    {
+        mAniRunTime = 0;
+        mAniRunning = false;
+        return false;
+    }
 
-    while (mAniRunning && !mAniStop && !prg_stopped)
+    if (mAniRunTime > 0)
     {
-        mActInstance = instance;
-        mChanged = true;
+        std::chrono::nanoseconds difftime = std::chrono::steady_clock::now() - startTime;
+        ulong duration = std::chrono::duration_cast<std::chrono::milliseconds>(difftime).count();
 
-        if (visible)
-            drawButton(instance);   // We ignore the state and try to draw the next instance
+        if (duration >= mAniRunTime)
+        {
+            mAniRunTime = 0;
+            mAniRunning = false;
+            return false;
+        }
+    }
 
-        instance++;
+    int max = std::min(end, (int)sr.size());
+    mActInstance = instance;
+    mChanged = true;
 
-        if (instance >= max)
-            instance = start - 1;
+    if (visible)
+        drawButton(instance);   // We ignore the state and try to draw the next instance
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(step));
+    instance++;
 
-        if (mAniRunTime > 0)
-        {
-            std::chrono::steady_clock::time_point current = std::chrono::steady_clock::now();
-            std::chrono::nanoseconds difftime = current - startt;
-            ulong duration = std::chrono::duration_cast<std::chrono::milliseconds>(difftime).count();
+    if (instance >= max)
+        instance = start - 1;
 
-            if (duration >= mAniRunTime)
-                break;
-        }
-    }
+    return true;
+}
+
+void TButton::stopAnimation()
+{
+    DECL_TRACER("TButton::stopAnimation()");
 
-    mAniRunTime = 0;
+    mAniStop = true;
+    TTimerWheel::cancel(mAniTimer);
+    mAniTimer = 0;
     mAniRunning = false;
 }
 
@@ -7251,21 +7211,22 @@ bool TButton::drawButtonMultistateAni()
     if (!visible || hd)    // Do nothing if this button is invisible
         return true;
 
-    if (mAniRunning || mThrAni.joinable())
+    if (mAniRunning)
     {
         MSG_TRACE("Animation is already running!");
         return true;
     }
 
-    try
-    {
-        mAniStop = false;
-        mThrAni = thread([=] { runAnimation(); });
-        mThrAni.detach();
-    }
-    catch (exception& e)
+    ulong tm = nu * ru + nd * rd;
+    int instance = 0;
+    mAniStop = false;
+    mAniRunning = true;
+    mAniTimer = TTimerWheel::schedule(std::chrono::milliseconds(0), std::chrono::milliseconds(std::max(tm, 1UL)), [this, instance]() mutable { return runAnimation(instance); });
+
+    if (!mAniTimer)
     {
-        MSG_ERROR("Error starting the button animation thread: " << e.what());
+        MSG_ERROR("Error starting the button animation!");
+        mAniRunning = false;
         return false;
     }
 
@@ -7473,7 +7434,7 @@ bool TButton::drawButton(int instance, bool show, bool subview)
         imgButton = ooButton;
     }
 
-    mLastImage = imgButton;
+    setLastImage(imgButton);
     mChanged = false;
 
     if (!prg_stopped && !dynState)
@@ -7483,30 +7444,7 @@ bool TButton::drawButton(int instance, bool show, bool subview)
         int rleft = mPosLeft;
         int rtop = mPosTop;
 #ifdef _SCALE_SKIA_
-        if (gPageManager && gPageManager->getScaleFactor() != 1.0)
-        {
-            rwidth = (int)((double)wt * gPageManager->getScaleFactor());
-            rheight = (int)((double)ht * gPageManager->getScaleFactor());
-            rleft = (int)((double)mPosLeft * gPageManager->getScaleFactor());
-            rtop = (int)((double)mPosTop * gPageManager->getScaleFactor());
-
-            SkPaint paint;
-            paint.setBlendMode(SkBlendMode::kSrc);
-            paint.setFilterQuality(kHigh_SkFilterQuality);
-            // Calculate new dimension
-            SkImageInfo info = imgButton.info();
-            int width = (int)((double)info.width() * gPageManager->getScaleFactor());
-            int height = (int)((double)info.height() * gPageManager->getScaleFactor());
-            // Create a canvas and draw new image
-            sk_sp<SkImage> im = SkImage::MakeFromBitmap(imgButton);
-            imgButton.allocN32Pixels(width, height);
-            imgButton.eraseColor(SK_ColorTRANSPARENT);
-            SkCanvas can(imgButton, SkSurfaceProps());
-            SkRect rect = SkRect::MakeXYWH(0, 0, width, height);
-            can.drawImageRect(im, rect, SkSamplingOptions(), &paint);
-            rowBytes = imgButton.info().minRowBytes();
-            mLastImage = imgButton;
-        }
+        scaleToDevice(imgButton, &rleft, &rtop, &rwidth, &rheight);
 #endif
         if (show)
         {
@@ -7515,7 +7453,7 @@ bool TButton::drawButton(int instance, bool show, bool subview)
 
             if (type != SUBPAGE_VIEW && !mSubViewPart)
             {
-                TBitmap image((unsigned char *)imgButton.getPixels(), imgButton.info().width(), imgButton.info().height());
+                TBitmap image(imgButton);
                 _displayButton(mHandle, parent, image, rwidth, rheight, rleft, rtop, isPassThrough(), sr[mActInstance].md, sr[mActInstance].mr);
 
                 if (sr[mActInstance].md > 0 && sr[mActInstance].mr > 0)
@@ -7700,7 +7638,7 @@ bool TButton::drawTextArea(int instance)
         imgButton = ooButton;
     }
 
-    mLastImage = imgButton;
+    setLastImage(imgButton);
     mChanged = false;
 
     if (!prg_stopped)
@@ -7711,31 +7649,8 @@ bool TButton::drawTextArea(int instance)
         int rtop = mPosTop;
         size_t rowBytes = imgButton.info().minRowBytes();
 #ifdef _SCALE_SKIA_
-        if (gPageManager && gPageManager->getScaleFactor() != 1.0)
-        {
-            size_t rowBytes = imgButton.info().minRowBytes();
-            rwidth = (int)((double)wt * gPageManager->getScaleFactor());
-            rheight = (int)((double)ht * gPageManager->getScaleFactor());
-            rleft = (int)((double)mPosLeft * gPageManager->getScaleFactor());
-            rtop = (int)((double)mPosTop * gPageManager->getScaleFactor());
-
-            SkPaint paint;
-            paint.setBlendMode(SkBlendMode::kSrc);
-            paint.setFilterQuality(kHigh_SkFilterQuality);
-            // Calculate new dimension
-            SkImageInfo info = imgButton.info();
-            int width = (int)((double)info.width() * gPageManager->getScaleFactor());
-            int height = (int)((double)info.height() * gPageManager->getScaleFactor());
-            // Create a canvas and draw new image
-            sk_sp<SkImage> im = SkImage::MakeFromBitmap(imgButton);
-            imgButton.allocN32Pixels(width, height);
-            imgButton.eraseColor(SK_ColorTRANSPARENT);
-            SkCanvas can(imgButton, SkSurfaceProps());
-            SkRect rect = SkRect::MakeXYWH(0, 0, width, height);
-            can.drawImageRect(im, rect, SkSamplingOptions(), &paint);
-            rowBytes = imgButton.info().minRowBytes();
-            mLastImage = imgButton;
-        }
+        scaleToDevice(imgButton, &rleft, &rtop, &rwidth, &rheight);
+        rowBytes = imgButton.info().minRowBytes();
 #endif
         if (gPageManager && gPageManager->getCallbackInputText())
         {
@@ -7916,7 +7831,7 @@ bool TButton::drawMultistateBargraph(int level, bool show)
         imgButton = ooButton;
     }
 
-    mLastImage = imgButton;
+    setLastImage(imgButton);
     mChanged = false;
 
     if (!prg_stopped)
@@ -7926,37 +7841,11 @@ bool TButton::drawMultistateBargraph(int level, bool show)
         int rleft = mPosLeft;
         int rtop = mPosTop;
 #ifdef _SCALE_SKIA_
-        if (gPageManager && gPageManager->getScaleFactor() != 1.0)
-        {
-            rwidth = (int)((double)wt * gPageManager->getScaleFactor());
-            rheight = (int)((double)ht * gPageManager->getScaleFactor());
-            rleft = (int)((double)mPosLeft * gPageManager->getScaleFactor());
-            rtop = (int)((double)mPosTop * gPageManager->getScaleFactor());
-
-            SkPaint paint;
-            paint.setBlendMode(SkBlendMode::kSrc);
-            paint.setFilterQuality(kHigh_SkFilterQuality);
-            // Calculate new dimension
-            SkImageInfo info = imgButton.info();
-            int width = (int)((double)info.width() * gPageManager->getScaleFactor());
-            int height = (int)((double)info.height() * gPageManager->getScaleFactor());
-            MSG_DEBUG("Button dimension: " << width << " x " << height);
-            // Create a canvas and draw new image
-            sk_sp<SkImage> im = SkImage::MakeFromBitmap(imgButton);
-            imgButton.allocN32Pixels(width, height);
-            imgButton.eraseColor(SK_ColorTRANSPARENT);
-            SkCanvas can(imgButton, SkSurfaceProps());
-            SkRect rect = SkRect::MakeXYWH(0, 0, width, height);
-            can.drawImageRect(im, rect, SkSamplingOptions(), &paint);
-            MSG_DEBUG("Old rowBytes: " << rowBytes);
-            rowBytes = imgButton.info().minRowBytes();
-            MSG_DEBUG("New rowBytes: " << rowBytes);
-            mLastImage = imgButton;
-        }
+        scaleToDevice(imgButton, &rleft, &rtop, &rwidth, &rheight);
 #endif
         if (show)
         {
-            TBitmap image((unsigned char *)imgButton.getPixels(), imgButton.info().width(), imgButton.info().height());
+            TBitmap image(imgButton);
             _displayButton(mHandle, parent, image, rwidth, rheight, rleft, rtop, isPassThrough(), sr[mActInstance].md, sr[mActInstance].mr);
 
             if (sr[mActInstance].md > 0 && sr[mActInstance].mr > 0)
@@ -8223,7 +8112,7 @@ bool TButton::drawJoystick(int x, int y)
         imgButton = ooButton;
     }
 
-    mLastImage = imgButton;
+    setLastImage(imgButton);
     mChanged = false;
 
     if (!prg_stopped && visible && _displayButton)
@@ -8233,31 +8122,9 @@ bool TButton::drawJoystick(int x, int y)
         int rleft = mPosLeft;
         int rtop = mPosTop;
 #ifdef _SCALE_SKIA_
-        if (gPageManager && gPageManager->getScaleFactor() != 1.0)
-        {
-            rwidth = (int)((double)wt * gPageManager->getScaleFactor());
-            rheight = (int)((double)ht * gPageManager->getScaleFactor());
-            rleft = (int)((double)mPosLeft * gPageManager->getScaleFactor());
-            rtop = (int)((double)mPosTop * gPageManager->getScaleFactor());
-
-            SkPaint paint;
-            paint.setBlendMode(SkBlendMode::kSrc);
-            paint.setFilterQuality(kHigh_SkFilterQuality);
-            // Calculate new dimension
-            SkImageInfo info = imgButton.info();
-            int width = (int)((double)info.width() * gPageManager->getScaleFactor());
-            int height = (int)((double)info.height() * gPageManager->getScaleFactor());
-            // Create a canvas and draw new image
-            sk_sp<SkImage> im = SkImage::MakeFromBitmap(imgButton);
-            imgButton.allocN32Pixels(width, height);
-            imgButton.eraseColor(SK_ColorTRANSPARENT);
-            SkCanvas can(imgButton, SkSurfaceProps());
-            SkRect rect = SkRect::MakeXYWH(0, 0, width, height);
-            can.drawImageRect(im, rect, SkSamplingOptions(), &paint);
-            mLastImage = imgButton;
-        }
+        scaleToDevice(imgButton, &rleft, &rtop, &rwidth, &rheight);
 #endif
-        TBitmap image((unsigned char *)imgButton.getPixels(), imgButton.info().width(), imgButton.info().height());
+        TBitmap image(imgButton);
         _displayButton(mHandle, parent, image, rwidth, rheight, rleft, rtop, isPassThrough(), sr[mActInstance].md, sr[mActInstance].mr);
     }
 
@@ -8391,48 +8258,31 @@ SkBitmap TButton::drawCursorButton(const string &cursor, SkColor col)
     slButton.eraseColor(SK_ColorTRANSPARENT);
     SkCanvas slCan(slButton, SkSurfaceProps());
 
+    vector<uint32_t> buffer;
+    const uint32_t *pixels = TPixelKernels::getColors(imageAlpha, buffer);
+
+    if (!pixels)
+        return SkBitmap();
+
+    int alphaWidth = imageAlpha.info().width();
+    int rows = std::min(height, imageAlpha.info().height());
+    int cols = std::min(width, alphaWidth);
+
     if (!haveBaseImage)
     {
-        for (int x = 0; x < width; ++x)
-        {
-            for (int y = 0; y < height; ++y)
-            {
-                uint32_t *pix = imageBase.getAddr32(x, y);
-                SkColor color = imageAlpha.getColor(x, y);
-                SkColor alpha = SkColorGetA(color);
-
-                if (!alpha)
-                    *pix = SK_ColorTRANSPARENT;
-            }
-        }
+        for (int y = 0; y < rows; ++y)
+            TPixelKernels::applyMask(imageBase.getAddr32(0, y), pixels + static_cast<size_t>(y) * alphaWidth, cols);
     }
     else
     {
         // Colorize alpha image
-        for (int x = 0; x < width; ++x)
-        {
-            for (int y = 0; y < height; ++y)
-            {
-                uint32_t *pix = imageAlpha.getAddr32(x, y);
-                SkColor alpha = SkColorGetA(imageAlpha.getColor(x, y));
+        SkColor color = col;
 
-                if (!alpha)
-                {
-                    *pix = SK_ColorTRANSPARENT;
-                    continue;
-                }
+        if (!isBigEndian())
+            color = SkColorSetARGB(SkColorGetA(col), SkColorGetB(col), SkColorGetG(col), SkColorGetR(col));
 
-                if (isBigEndian())
-                    *pix = SkColorSetA(col, alpha);
-                else
-                {
-                    SkColor red = SkColorGetR(col);
-                    SkColor green = SkColorGetG(col);
-                    SkColor blue = SkColorGetB(col);
-                    *pix = SkColorSetARGB(alpha, blue, green, red);
-                }
-            }
-        }
+        for (int y = 0; y < imageAlpha.info().height(); ++y)
+            TPixelKernels::alphaToColor(imageAlpha.getAddr32(0, y), pixels + static_cast<size_t>(y) * alphaWidth, alphaWidth, color, SK_ColorTRANSPARENT);
     }
 
     sk_sp<SkImage> _image = SkImages::RasterFromBitmap(imageAlpha);
@@ -8530,7 +8380,7 @@ bool TButton::drawList(bool show)
         imgButton = ooButton;
     }
 
-    mLastImage = imgButton;
+    setLastImage(imgButton);
     mChanged = false;
 
     if (!prg_stopped)
@@ -8541,31 +8391,8 @@ bool TButton::drawList(bool show)
         int rtop = mPosTop;
         size_t rowBytes = imgButton.info().minRowBytes();
 #ifdef _SCALE_SKIA_
-        if (gPageManager && gPageManager->getScaleFactor() != 1.0)
-        {
-            size_t rowBytes = imgButton.info().minRowBytes();
-            rwidth = (int)((double)wt * gPageManager->getScaleFactor());
-            rheight = (int)((double)ht * gPageManager->getScaleFactor());
-            rleft = (int)((double)mPosLeft * gPageManager->getScaleFactor());
-            rtop = (int)((double)mPosTop * gPageManager->getScaleFactor());
-
-            SkPaint paint;
-            paint.setBlendMode(SkBlendMode::kSrc);
-            paint.setFilterQuality(kHigh_SkFilterQuality);
-            // Calculate new dimension
-            SkImageInfo info = imgButton.info();
-            int width = (int)((double)info.width() * gPageManager->getScaleFactor());
-            int height = (int)((double)info.height() * gPageManager->getScaleFactor());
-            // Create a canvas and draw new image
-            sk_sp<SkImage> im = SkImage::MakeFromBitmap(imgButton);
-            imgButton.allocN32Pixels(width, height);
-            imgButton.eraseColor(SK_ColorTRANSPARENT);
-            SkCanvas can(imgButton, SkSurfaceProps());
-            SkRect rect = SkRect::MakeXYWH(0, 0, width, height);
-            can.drawImageRect(im, rect, SkSamplingOptions(), &paint);
-            rowBytes = imgButton.info().minRowBytes();
-            mLastImage = imgButton;
-        }
+        scaleToDevice(imgButton, &rleft, &rtop, &rwidth, &rheight);
+        rowBytes = imgButton.info().minRowBytes();
 #endif
         if (show && gPageManager && gPageManager->getCallbackListBox())
         {
@@ -8727,7 +8554,7 @@ bool TButton::drawBargraph(int instance, int level, bool show)
         imgButton = ooButton;
     }
 
-    mLastImage = imgButton;
+    setLastImage(imgButton);
     mChanged = false;
 
     if (!prg_stopped && show && visible && instance == mActInstance && _displayButton)
@@ -8737,33 +8564,11 @@ bool TButton::drawBargraph(int instance, int level, bool show)
         int rleft = mPosLeft;
         int rtop = mPosTop;
 #ifdef _SCALE_SKIA_
-        if (gPageManager && gPageManager->getScaleFactor() != 1.0)
-        {
-            rwidth = (int)((double)wt * gPageManager->getScaleFactor());
-            rheight = (int)((double)ht * gPageManager->getScaleFactor());
-            rleft = (int)((double)mPosLeft * gPageManager->getScaleFactor());
-            rtop = (int)((double)mPosTop * gPageManager->getScaleFactor());
-
-            SkPaint paint;
-            paint.setBlendMode(SkBlendMode::kSrc);
-            paint.setFilterQuality(kHigh_SkFilterQuality);
-            // Calculate new dimension
-            SkImageInfo info = imgButton.info();
-            int width = (int)((double)info.width() * gPageManager->getScaleFactor());
-            int height = (int)((double)info.height() * gPageManager->getScaleFactor());
-            // Create a canvas and draw new image
-            sk_sp<SkImage> im = SkImage::MakeFromBitmap(imgButton);
-            imgButton.allocN32Pixels(width, height);
-            imgButton.eraseColor(SK_ColorTRANSPARENT);
-            SkCanvas can(imgButton, SkSurfaceProps());
-            SkRect rect = SkRect::MakeXYWH(0, 0, width, height);
-            can.drawImageRect(im, rect, SkSamplingOptions(), &paint);
-            mLastImage = imgButton;
-        }
+        scaleToDevice(imgButton, &rleft, &rtop, &rwidth, &rheight);
 #endif
         if (type != SUBPAGE_VIEW && !mSubViewPart)
         {
-            TBitmap image((unsigned char *)imgButton.getPixels(), imgButton.info().width(), imgButton.info().height());
+            TBitmap image(imgButton);
             _displayButton(mHandle, parent, image, rwidth, rheight, rleft, rtop, isPassThrough(), sr[mActInstance].md, sr[mActInstance].mr);
         }
         else if (type != SUBPAGE_VIEW && mSubViewPart)
@@ -9151,41 +8956,37 @@ SkBitmap TButton::drawImageButton(SkBitmap& imgRed, SkBitmap& imgMask, int width
     if (!allocPixels(width, height, &maskBm))
         return SkBitmap();
 
-    maskBm.eraseColor(SK_ColorTRANSPARENT);
+    vector<uint32_t> redBuffer, maskBuffer;
+    const uint32_t *red = TPixelKernels::getColors(imgRed, redBuffer);
+    const uint32_t *mask = (haveBothImages ? TPixelKernels::getColors(imgMask, maskBuffer) : nullptr);
+    int redWidth = pixmapRed.info().width();
+    int redHeight = pixmapRed.info().height();
+    int maskWidth = (mask ? pixmapMask.info().width() : 0);
+    int maskHeight = (mask ? pixmapMask.info().height() : 0);
+    SkColor noMask = SkColorSetA(SK_ColorWHITE, 0);
+    bool swapRB = isBigEndian();
 
-    for (int ix = 0; ix < width; ix++)
+    for (int iy = 0; iy < height; iy++)
     {
-        for (int iy = 0; iy < height; iy++)
-        {
-            SkColor pixelRed;
-            SkColor pixelMask;
-
-            if (ix < pixmapRed.info().width() && iy < pixmapRed.info().height())
-                pixelRed = pixmapRed.getColor(ix, iy);
-            else
-                pixelRed = 0;
-
-            if (haveBothImages && !imgMask.empty() &&
-                    ix < pixmapMask.info().width() && iy < pixmapMask.info().height())
-                pixelMask = pixmapMask.getColor(ix, iy);
-            else
-                pixelMask = SkColorSetA(SK_ColorWHITE, 0);
-
-            SkColor pixel = baseColor(pixelRed, pixelMask, col1, col2);
-            uint32_t alpha = SkColorGetA(pixel);
-            uint32_t *wpix = nullptr;
-
-            if (ix < maskBm.info().width() && iy < maskBm.info().height())
-                wpix = maskBm.getAddr32(ix, iy);
-
-            if (!wpix)
-                continue;
+        uint32_t *wpix = maskBm.getAddr32(0, iy);
+        const uint32_t *redRow = ((red && iy < redHeight) ? red + static_cast<size_t>(iy) * redWidth : nullptr);
+        const uint32_t *maskRow = ((mask && iy < maskHeight) ? mask + static_cast<size_t>(iy) * maskWidth : nullptr);
+        int redEnd = (redRow ? std::min(width, redWidth) : 0);
+        int ix = (maskRow ? std::min(redEnd, maskWidth) : redEnd);
 
-            if (alpha == 0)
-                pixel = pixelMask;
+        if (ix > 0)
+            TPixelKernels::chameleon(wpix, redRow, maskRow, ix, col1, col2, noMask, swapRB, true);
 
-            *wpix = pixel;
+        // Pixels of the red image outside of the mask
+        if (ix < redEnd)
+        {
+            TPixelKernels::chameleon(wpix + ix, redRow + ix, nullptr, redEnd - ix, col1, col2, noMask, swapRB, true);
+            ix = redEnd;
         }
+
+        // Outside of the red image only the mask is visible
+        for (; ix < width; ix++)
+            wpix[ix] = ((maskRow && ix < maskWidth) ? maskRow[ix] : noMask);
     }
 
     return maskBm;
@@ -9221,36 +9022,25 @@ SkBitmap TButton::combineImages(SkBitmap& base, SkBitmap& alpha, SkColor col)
     if (!allocPixels(width, height, &Bm))
         return Bm;
 
-    Bm.eraseColor(SK_ColorTRANSPARENT);
-
-    for (int ix = 0; ix < width; ix++)
-    {
-        for (int iy = 0; iy < height; iy++)
-        {
-            SkColor pixelAlpha = alpha.getColor(ix, iy);
-            uint32_t *bpix = Bm.getAddr32(ix, iy);
+    // Skia reads image files in the natural byte order of the CPU.
+    // While on Intel CPUs the byte order is little endian it is
+    // mostly big endian on other CPUs. This means that the order of
+    // the colors is RGB on big endian CPUs (ARM, ...) and BGR on others.
+    // To compensate this, we check the endianess of the CPU and set
+    // the byte order according.
+    SkColor color = col;
 
-            uchar al    = SkColorGetA(pixelAlpha);
-            uchar red   = SkColorGetR(col);
-            uchar green = SkColorGetG(col);
-            uchar blue  = SkColorGetB(col);
+    if (isBigEndian())
+        color = SkColorSetARGB(SkColorGetA(col), SkColorGetB(col), SkColorGetG(col), SkColorGetR(col));
 
-            if (pixelAlpha == 0)
-                red = green = blue = 0;
+    vector<uint32_t> buffer;
+    const uint32_t *pixels = TPixelKernels::getColors(alpha, buffer);
 
-            // Skia reads image files in the natural byte order of the CPU.
-            // While on Intel CPUs the byte order is little endian it is
-            // mostly big endian on other CPUs. This means that the order of
-            // the colors is RGB on big endian CPUs (ARM, ...) and BGR on others.
-            // To compensate this, we check the endianess of the CPU and set
-            // the byte order according.
+    if (!pixels)
+        return SkBitmap();
 
-            if (isBigEndian())
-                *bpix = SkColorSetARGB(al, blue, green, red);
-            else
-                *bpix = SkColorSetARGB(al, red, green, blue);
-        }
-    }
+    for (int y = 0; y < height; ++y)
+        TPixelKernels::alphaToColor(Bm.getAddr32(0, y), pixels + static_cast<size_t>(y) * width, width, color, SK_ColorTRANSPARENT);
 
     SkPaint paint;
     paint.setBlendMode(SkBlendMode::kSrcOver);
@@ -9308,45 +9098,18 @@ SkBitmap TButton::colorImage(SkBitmap& base, SkBitmap& alpha, SkColor col, SkCol
     if (!allocPixels(width, height, &maskBm))
         return SkBitmap();
 
-    maskBm.eraseColor(SK_ColorTRANSPARENT);
+    vector<uint32_t> buffer;
+    const uint32_t *pixels = TPixelKernels::getColors(alpha.empty() ? base : alpha, buffer);
 
-    for (int ix = 0; ix < width; ix++)
+    if (!pixels)
     {
-        for (int iy = 0; iy < height; iy++)
-        {
-            SkColor pixelAlpha = 0;
-
-            if (!alpha.empty())
-                pixelAlpha = alpha.getColor(ix, iy);
-            else
-                pixelAlpha = base.getColor(ix, iy);
-
-            uint32_t *wpix = maskBm.getAddr32(ix, iy);
-
-            if (!wpix)
-            {
-                MSG_ERROR("No pixel buffer!");
-                break;
-            }
-
-            uint32_t ala = SkColorGetA(pixelAlpha);
-
-            if (ala == 0 && !useBG)
-                pixelAlpha = SK_ColorTRANSPARENT;
-            else if (ala == 0)
-                pixelAlpha = bg;
-            else
-            {
-                uint32_t red   = SkColorGetR(col);
-                uint32_t green = SkColorGetG(col);
-                uint32_t blue  = SkColorGetB(col);
-                pixelAlpha = SkColorSetARGB(ala, red, green, blue);
-            }
-
-            *wpix = pixelAlpha;
-        }
+        MSG_ERROR("No pixel buffer!");
+        return SkBitmap();
     }
 
+    for (int y = 0; y < height; ++y)
+        TPixelKernels::alphaToColor(maskBm.getAddr32(0, y), pixels + static_cast<size_t>(y) * width, width, col, useBG ? bg : SK_ColorTRANSPARENT);
+
     if (!alpha.empty())
     {
         SkPaint paint;
@@ -9418,6 +9181,29 @@ bool TButton::getBorderFragment(const string& path, const string& pathAlpha, SkB
         return false;
     }
 
+    // The colorized fragments are cached. Usualy a page has many buttons
+    // with the same border and color.
+    string key = "btn:" + path + "|" + pathAlpha + "|" + std::to_string(color);
+
+    if (TImgCache::getBitmap(key, image, _BMTYPE_BORDER))
+        return true;
+
+    if (!loadBorderFragment(path, pathAlpha, image, color))
+        return false;
+
+    TImgCache::addImage(key, *image, _BMTYPE_BORDER);
+    return true;
+}
+
+/**
+ * @brief loadBorderFragment - load and colorize a part of a border
+ * This does the work for getBorderFragment() if the fragment is not in the
+ * cache.
+ */
+bool TButton::loadBorderFragment(const string& path, const string& pathAlpha, SkBitmap* image, SkColor color)
+{
+    DECL_TRACER("TButton::loadBorderFragment(const string& path, const string& pathAlpha, SkBitmap* image, SkColor color)");
+
     sk_sp<SkData> im;
     SkBitmap bm;
     bool haveBaseImage = false;
@@ -9440,19 +9226,14 @@ bool TButton::getBorderFragment(const string& path, const string& pathAlpha, SkB
                 SkImageInfo info = image->info();
                 SkBitmap b;
                 allocPixels(info.width(), info.height(), &b);
-                b.eraseColor(SK_ColorTRANSPARENT);
+                vector<uint32_t> buffer;
+                const uint32_t *pixels = TPixelKernels::getColors(*image, buffer);
 
-                for (int x = 0; x < info.width(); ++x)
-                {
-                    for (int y = 0; y < info.height(); ++y)
-                    {
-                        SkColor alpha = SkColorGetA(image->getColor(x, y));
-                        uint32_t *pix = b.getAddr32(x, y);
+                if (!pixels)
+                    b.eraseColor(SK_ColorTRANSPARENT);
 
-                        if (alpha > 0)
-                            *pix = swCol;
-                    }
-                }
+                for (int y = 0; pixels && y < info.height(); ++y)
+                    TPixelKernels::alphaToSolid(b.getAddr32(0, y), pixels + static_cast<size_t>(y) * info.width(), info.width(), swCol);
 
                 SkPaint paint;
                 paint.setAntiAlias(true);
@@ -9485,20 +9266,12 @@ bool TButton::getBorderFragment(const string& path, const string& pathAlpha, SkB
     // colored by the border color.
     if (image->info().dimensions() == bm.info().dimensions())
     {
-        for (int y = 0; y < image->info().height(); ++y)
-        {
-            for (int x = 0; x < image->info().width(); ++x)
-            {
-                SkColor col = bm.getColor(x, y);
-                SkColor alpha = SkColorGetA(col);
-                uint32_t *pix = bm.getAddr32(x, y);
+        vector<uint32_t> buffer;
+        const uint32_t *pixels = TPixelKernels::getColors(bm, buffer);
+        int width = bm.info().width();
 
-                if (alpha == 0)
-                    *pix = SK_ColorTRANSPARENT;
-                else
-                    *pix = SkColorSetA(swCol, alpha);
-            }
-        }
+        for (int y = 0; pixels && y < bm.info().height(); ++y)
+            TPixelKernels::alphaToColor(bm.getAddr32(0, y), pixels + static_cast<size_t>(y) * width, width, swCol, SK_ColorTRANSPARENT);
     }
 
     // Here we draw the border fragment over the base image.
@@ -9564,26 +9337,21 @@ void TButton::showLastButton()
     if (!prg_stopped && visible)
     {
         ulong parent = mHandle & 0xffff0000;
-        size_t rowBytes = mLastImage.info().minRowBytes();
+        SkBitmap lastImage = mLastImage;
         int rwidth = wt;
         int rheight = ht;
         int rleft = mPosLeft;
         int rtop = mPosTop;
 #ifdef _SCALE_SKIA_
-        if (gPageManager && gPageManager->getScaleFactor() != 1.0)
-        {
-            rwidth = (int)((double)wt * gPageManager->getScaleFactor());
-            rheight = (int)((double)ht * gPageManager->getScaleFactor());
-            rleft = (int)((double)mPosLeft * gPageManager->getScaleFactor());
-            rtop = (int)((double)mPosTop * gPageManager->getScaleFactor());
-        }
+        scaleToDevice(lastImage, &rleft, &rtop, &rwidth, &rheight);
 #endif
+        size_t rowBytes = lastImage.info().minRowBytes();
         if (type == TEXT_INPUT)
         {
             if (gPageManager && gPageManager->getCallbackInputText())
             {
                 BITMAP_t bm;
-                bm.buffer = (unsigned char *)mLastImage.getPixels();
+                bm.buffer = (unsigned char *)lastImage.getPixels();
                 bm.rowBytes = rowBytes;
                 bm.left = rleft;
                 bm.top = rtop;
@@ -9597,7 +9365,7 @@ void TButton::showLastButton()
             if (gPageManager && gPageManager->getCallbackListBox())
             {
                 BITMAP_t bm;
-                bm.buffer = (unsigned char *)mLastImage.getPixels();
+                bm.buffer = (unsigned char *)lastImage.getPixels();
                 bm.rowBytes = rowBytes;
                 bm.left = rleft;
                 bm.top = rtop;
@@ -9610,14 +9378,14 @@ void TButton::showLastButton()
         {
             if (gPageManager && gPageManager->getDisplayViewButton())
             {
-                TBitmap image((unsigned char *)mLastImage.getPixels(), mLastImage.info().width(), mLastImage.info().height());
+                TBitmap image(lastImage);
                 TColor::COLOR_T bgcolor = TColor::getAMXColor(sr[mActInstance].cf);
-                gPageManager->getDisplayViewButton()(mHandle, getParent(), (on.empty() ? false : true), image, wt, ht, mPosLeft, mPosTop, sa, bgcolor);
+                gPageManager->getDisplayViewButton()(mHandle, getParent(), (on.empty() ? false : true), image, rwidth, rheight, rleft, rtop, sa, bgcolor);
             }
         }
         else if (_displayButton)
         {
-            TBitmap image((unsigned char *)mLastImage.getPixels(), mLastImage.info().width(), mLastImage.info().height());
+            TBitmap image(lastImage);
             _displayButton(mHandle, parent, image, rwidth, rheight, rleft, rtop, isPassThrough(), sr[mActInstance].md, sr[mActInstance].mr);
 
             if (sr[mActInstance].md > 0 && sr[mActInstance].mr > 0)
@@ -9698,7 +9466,7 @@ void TButton::hide(bool total)
 
         if (_displayButton)
         {
-            TBitmap image((unsigned char *)imgButton.getPixels(), imgButton.info().width(), imgButton.info().height());
+            TBitmap image(imgButton);
             _displayButton(mHandle, parent, image, rwidth, rheight, rleft, rtop, isPassThrough(), sr[mActInstance].md, sr[mActInstance].mr);
             mChanged = false;
         }
@@ -9939,9 +9707,18 @@ bool TButton::isPixelTransparent(int x, int y)
     // If this is not a "button", we don't check for alpha value
     if (type == GENERAL || type == MULTISTATE_GENERAL)
     {
-        float alpha = mLastImage.getAlphaf(x, y);   // Get the alpha value (0.0 to 1.0)
+        std::lock_guard<std::mutex> guard(mutex_hitmask);
+
+        if (mHitMask.empty())
+            makeHitMask();
+
+        // The mask may have been made from an image of another size.
+        if (x >= mHitMaskWidth || y >= mHitMaskHeight)
+            return true;
 
-        if (alpha != 0.0)
+        size_t bit = static_cast<size_t>(y) * mHitMaskWidth + x;
+
+        if (bit / 8 < mHitMask.size() && (mHitMask[bit / 8] & (1 << (bit % 8))))
             return false;
     }
     else
@@ -9950,6 +9727,112 @@ bool TButton::isPixelTransparent(int x, int y)
     return true;
 }
 
+/**
+ * Sets the last calculated image. The hit mask is made from this image
+ * the next time a click must be tested.
+ *
+ * @param bm    The image of the button.
+ */
+void TButton::setLastImage(const SkBitmap& bm)
+{
+    DECL_TRACER("TButton::setLastImage(const SkBitmap& bm)");
+
+    std::lock_guard<std::mutex> guard(mutex_hitmask);
+    mLastImage = bm;
+    mHitMask.clear();
+    mHitMaskWidth = mHitMaskHeight = 0;
+#ifdef _SCALE_SKIA_
+    mDeviceImage.reset();
+#endif
+}
+
+#ifdef _SCALE_SKIA_
+/**
+ * Scales the finished image of the button into the size it has on the
+ * screen. The GUI gets the image in it's final size and only needs to copy
+ * it. The position and the size of the button are scaled too.
+ * The last image (mLastImage) keeps the logical size, because the hit test
+ * and the subviews work with logical coordinates. The scaled image is kept
+ * until the next image is set.
+ *
+ * @param img       The last image of the button. On return it contains the
+ *                  scaled image.
+ * @param left      Receives the scaled left position.
+ * @param top       Receives the scaled top position.
+ * @param width     Receives the scaled width.
+ * @param height    Receives the scaled height.
+ */
+void TButton::scaleToDevice(SkBitmap& img, int *left, int *top, int *width, int *height)
+{
+    DECL_TRACER("TButton::scaleToDevice(SkBitmap& img, int *left, int *top, int *width, int *height)");
+
+    if (!gPageManager || gPageManager->getScaleFactor() == 1.0)
+        return;
+
+    double factor = gPageManager->getScaleFactor();
+    *left = static_cast<int>(static_cast<double>(mPosLeft) * factor);
+    *top = static_cast<int>(static_cast<double>(mPosTop) * factor);
+    *width = static_cast<int>(static_cast<double>(wt) * factor);
+    *height = static_cast<int>(static_cast<double>(ht) * factor);
+
+    std::lock_guard<std::mutex> guard(mutex_hitmask);
+
+    if (mDeviceImage.empty())
+    {
+        SkBitmap scaled;
+
+        if (!scaleBitmap(img, &scaled, static_cast<int>(static_cast<double>(img.info().width()) * factor), static_cast<int>(static_cast<double>(img.info().height()) * factor)))
+            return;
+
+        mDeviceImage = scaled;
+    }
+
+    img = mDeviceImage;
+}
+#endif
+
+/*
+ * Makes a mask with 1 bit for each pixel of the last image. A bit is set
+ * if the pixel is not fully transparent. The image is converted to an alpha
+ * image first. Then a hit test doesn't need to read the color pixels.
+ * The caller must hold the lock "mutex_hitmask".
+ */
+void TButton::makeHitMask()
+{
+    DECL_TRACER("TButton::makeHitMask()");
+
+    int width = mLastImage.info().width();
+    int height = mLastImage.info().height();
+    size_t pixels = static_cast<size_t>(width) * height;
+    std::vector<uint8_t> alpha(pixels);
+    mHitMask.assign((pixels + 7) / 8, 0);
+    mHitMaskWidth = width;
+    mHitMaskHeight = height;
+
+    if (mLastImage.readPixels(SkImageInfo::MakeA8(width, height), alpha.data(), width, 0, 0))
+    {
+        for (size_t i = 0; i < pixels; ++i)
+        {
+            if (alpha[i])
+                mHitMask[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+        }
+
+        return;
+    }
+
+    // The image couldn't be converted. Take the alpha values one by one.
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            size_t i = static_cast<size_t>(y) * width + x;
+
+            if (mLastImage.getAlphaf(x, y) != 0.0)
+                mHitMask[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+        }
+    }
+}
+
 bool TButton::checkForSound()
 {
     DECL_TRACER("TButton::checkForSound()");
@@ -10119,7 +10002,6 @@ bool TButton::doClick(int x, int y, bool pressed)
 
     amx::ANET_SEND scmd;
     int instance = 0;
-    int sx = x, sy = y;
     bool isSystem = isSystemButton();
     int lastLevel = 0;
     int lastJoyX = 0;
@@ -10144,31 +10026,18 @@ bool TButton::doClick(int x, int y, bool pressed)
 
     if (pressed && gPageManager && !checkForSound() && (ch > 0 || lv > 0 || !pushFunc.empty() || isSystem))
     {
-        TSystemSound sysSound(TConfig::getSystemPath(TConfig::SOUNDS));
+        string sound = TSystemSound::getCachedTouchSound();
 
-        if (gPageManager->havePlaySound() && sysSound.getSystemSoundState())
-            gPageManager->getCallPlaySound()(sysSound.getTouchFeedbackSound());
+        if (gPageManager->havePlaySound() && !sound.empty())
+            gPageManager->getCallPlaySound()(sound);
     }
 
-#ifdef _SCALE_SKIA_
-    // To be able to test a button for a transparent pixel, we must scale
-    // the coordinates because the test is made on the last drawn image and
-    // this image is scaled (if scaling is activated).
-    if (TConfig::getScale() && gPageManager && gPageManager->getScaleFactor() != 1.0)
-    {
-        double scaleFactor = gPageManager->getScaleFactor();
-        sx = (int)((double)x * scaleFactor);
-        sy = (int)((double)y * scaleFactor);
-    }
-#endif
-
     // Handle system buttons. Here the system keyboard buttons are handled.
     if (_buttonPress && mActInstance >= 0 && static_cast<size_t>(mActInstance) < sr.size() && cp == 0 && ch > 0)
     {
         // Handling the keyboard buttons is very expensive. To not block too
-        // long, we let it run in a separate thread.
-        std::thread thr = std::thread([=] { _buttonPress(ch, static_cast<uint>(mHandle), pressed); });
-        thr.detach();
+        // long, we let it run in a worker thread.
+        TThreadPool::post("TButton::buttonPress", [=] { _buttonPress(ch, static_cast<uint>(mHandle), pressed); });
     }
 
     // If the button is marked as password protected, then we must display
@@ -10801,7 +10670,7 @@ bool TButton::doClick(int x, int y, bool pressed)
             // If there is nothing in "hs", then it depends on the pixel of the
             // layer. Only if the pixel the coordinates point to are not
             // transparent, the button takes the click.
-            if (hs.empty() && isPixelTransparent(sx, sy))
+            if (hs.empty() && isPixelTransparent(x, y))
                 return false;
 
             // Play sound, if one is defined
@@ -10829,7 +10698,7 @@ bool TButton::doClick(int x, int y, bool pressed)
             // If there is nothing in "hs", then it depends on the pixel of the
             // layer. Only if the pixel the coordinates point to are not
             // transparent, the button takes the click.
-            if (hs.empty() && isPixelTransparent(sx, sy))
+            if (hs.empty() && isPixelTransparent(x, y))
                 return false;
         }
         else if (fb == FB_INV_CHANNEL)
@@ -10843,7 +10712,7 @@ bool TButton::doClick(int x, int y, bool pressed)
             // If there is nothing in "hs", then it depends on the pixel of the
             // layer. Only if the pixel the coordinates point to are not
             // transparent, the button takes the click.
-            if (hs.empty() && isPixelTransparent(sx, sy))
+            if (hs.empty() && isPixelTransparent(x, y))
                 return false;
 
             // Play sound, if one is defined
@@ -10871,7 +10740,7 @@ bool TButton::doClick(int x, int y, bool pressed)
             // If there is nothing in "hs", then it depends on the pixel of the
             // layer. Only if the pixel the coordinates point to are not
             // transparent, the button takes the click.
-            if (hs.empty() && isPixelTransparent(sx, sy))
+            if (hs.empty() && isPixelTransparent(x, y))
                 return false;
 
             // Play sound, if one is defined
@@ -11576,59 +11445,6 @@ bool TButton::sendCommand(bool pressed)
     return true;
 }
 
-/**
- * Based on the pixels in the \a basePix, the function decides whether to return
- * the value of \a col1 or \a col2. A red pixel returns the color \a col1 and
- * a green pixel returns the color \a col2. If there is no red and no green
- * pixel, a transparent pixel is returned.
- *
- * @param basePix
- * This is a pixel from a mask containing red and/or green pixels.
- *
- * @param maskPix
- * This is a pixel from a mask containing more or less tranparent pixels. If
- * the alpha channel of \a basePix is 0 (transparent) this pixel is returned.
- *
- * @param col1
- * The first color.
- *
- * @param col2
- * The second color.
- *
- * @return
- * An array containing the color for one pixel.
- */
-SkColor TButton::baseColor(SkColor basePix, SkColor maskPix, SkColor col1, SkColor col2)
-{
-    uint alpha = SkColorGetA(basePix);
-    uint green = SkColorGetG(basePix);
-    uint red = 0;
-
-    if (isBigEndian())
-        red = SkColorGetB(basePix);
-    else
-        red = SkColorGetR(basePix);
-
-    if (alpha == 0)
-        return maskPix;
-
-    if (red && green)
-    {
-        if (red < green)
-            return col2;
-
-        return col1;
-    }
-
-    if (red)
-        return col1;
-
-    if (green)
-        return col2;
-
-    return SK_ColorTRANSPARENT; // transparent pixel
-}
-
 TEXT_EFFECT TButton::textEffect(const std::string& effect)
 {
     DECL_TRACER("TButton::textEffect(const std::string& effect)");
@@ -12263,6 +12079,34 @@ string TButton::getBitmapNames(const SR_T& sr)
     return names;
 }
 
+void TButton::getImageFiles(vector<string>& files)
+{
+    DECL_TRACER("TButton::getImageFiles(vector<string>& files)");
+
+    for (const SR_T& s : sr)
+    {
+        if (!s.mi.empty())
+            files.push_back(s.mi);
+
+        if (s.dynamic)
+            continue;
+
+        if (!TTPInit::isG5())
+        {
+            if (!s.bm.empty())
+                files.push_back(s.bm);
+
+            continue;
+        }
+
+        for (int i = 0; i < MAX_IMAGES; ++i)
+        {
+            if (!s.bitmaps[i].fileName.empty())
+                files.push_back(s.bitmaps[i].fileName);
+        }
+    }
+}
+
 int TButton::getLevelValue()
 {
     DECL_TRACER("TButton::getLevelValue()");
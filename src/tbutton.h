@@ -23,6 +23,9 @@
 #include <map>
 #include <functional>
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
 
 #include <include/core/SkImage.h>
 #include <include/core/SkCanvas.h>
@@ -473,6 +476,12 @@ namespace Button
              * Returns the top position of the button in pixels.
              */
             int getTopPosition() { return mPosTop; }
+            /**
+             * Returns a counter which is incremented whenever the position
+             * or size of any button changes. This is used to find out if
+             * an index of the button positions must be rebuilt.
+             */
+            static uint64_t getGeometryGeneration() { return mGeometryGeneration.load(std::memory_order_acquire); }
             /**
              * Returns the original left position.
              */
@@ -661,6 +670,13 @@ namespace Button
             bool isSystemButton();
             void addPushFunction(std::string& func, std::string& page);
             void clearPushFunctions() { pushFunc.clear(); }
+            const std::vector<PUSH_FUNC_T>& getPushFunctions() { return pushFunc; }
+            /**
+             * Appends the names of the image files of all instances of the
+             * button to \p files. This is used to decode the images in
+             * advance.
+             */
+            void getImageFiles(std::vector<std::string>& files);
             void clearPushFunction(const std::string& action);
             void refresh();
             /**
@@ -1399,12 +1415,12 @@ namespace Button
             POSITION_t calcImagePosition(int width, int height, CENTER_CODE cc, int number, int line = 0);
             IMAGE_SIZE_t calcImageSize(int imWidth, int imHeight, int instance, bool aspect=false);
             void calcImageSizePercent(int imWidth, int imHeight, int btWidth, int btHeight, int btFrame, int *realX, int *realY);
-            SkColor baseColor(SkColor basePix, SkColor maskPix, SkColor col1, SkColor col2);
             TEXT_EFFECT textEffect(const std::string& effect);
             int numberLines(const std::string& str);
             SkRect calcRect(int width, int height, int pen);
-            void runAnimation();    // Method started as thread for button animation
-            void runAnimationRange(int start, int end, ulong step);     // Method started as thread for a limited time
+            bool runAnimation(int& instance);   // One step of a button animation; called by the timer wheel
+            bool runAnimationRange(int& instance, int start, int end, std::chrono::steady_clock::time_point startTime);  // One step of an animation running for a limited time
+            void stopAnimation();
             bool drawAlongOrder(SkBitmap *imgButton, int instance);
 
             void getDrawOrder(const std::string& sdo, DRAW_ORDER *order);
@@ -1416,6 +1432,11 @@ namespace Button
             bool buttonText(SkBitmap *bm, int instance);
             bool buttonBorder(SkBitmap *bm, int instance, TSystemDraw::LINE_TYPE_t lnType=TSystemDraw::LT_OFF);
             bool isPixelTransparent(int x, int y);
+            void setLastImage(const SkBitmap& bm);
+            void makeHitMask();
+#ifdef _SCALE_SKIA_
+            void scaleToDevice(SkBitmap& img, int *left, int *top, int *width, int *height);
+#endif
             bool barLevel(SkBitmap *bm, int instance, int level);
             bool makeElement(int instance=-1);
             bool loadImage(SkBitmap *bm, SkBitmap& image, int instance);
@@ -1434,6 +1455,7 @@ namespace Button
             SkBitmap colorImage(SkBitmap& base, SkBitmap& alpha, SkColor col, SkColor bg=0, bool useBG=false);
             bool retrieveImage(const std::string& path, SkBitmap *image);
             bool getBorderFragment(const std::string& path, const std::string& pathAlpha, SkBitmap *image, SkColor color);
+            bool loadBorderFragment(const std::string& path, const std::string& pathAlpha, SkBitmap *image, SkColor color);
             SkBitmap drawSliderButton(const std::string& slider, SkColor col);
             SkBitmap drawCursorButton(const std::string& cursor, SkColor col);
             POINT_t getImagePosition(int width, int height);
@@ -1562,6 +1584,13 @@ namespace Button
             TPalette *mPalette{nullptr}; // The color palette
             // Image management
             SkBitmap mLastImage;    // The last calculated image
+#ifdef _SCALE_SKIA_
+            SkBitmap mDeviceImage;  // mLastImage scaled to the size on the screen
+#endif
+            std::vector<uint8_t> mHitMask;  // 1 bit for each pixel of mLastImage; 1 = pixel is not transparent
+            int mHitMaskWidth{0};           // The width of the image mHitMask was made from
+            int mHitMaskHeight{0};          // The height of the image mHitMask was made from
+            std::mutex mutex_hitmask;
             ulong mHandle{0};       // internal used handle to identify button
             uint32_t mButtonID{0};  // A CRC32 checksum identifying the button.
             int mParentHeight{0};   // The height of the parent page / subpage
@@ -1571,8 +1600,7 @@ namespace Button
             int mGlobalOO{-1};      // Opacity of the whole subpage, if any
             int mActInstance{0};    // Active instance
             DRAW_ORDER mDOrder[ORD_ELEM_COUNT];  // The order to draw the elements of a button
-            std::thread mThrAni;    // Thread handle for animation
-            std::thread mThrRes;    // A resouce (download of a remote image/video) running in background
+            TTimerWheel::TIMER_ID mAniTimer{0}; // Timer of the animation
             std::thread mThrSlider; // Thread to move a slider (bargraph)
             std::atomic<bool> mAniRunning{false}; // TRUE = Animation is running
             std::atomic<bool> mAniStop{false};  // If TRUE, the running animation will stop
@@ -1588,6 +1616,7 @@ namespace Button
             bool mSystemReg{false}; // TRUE = registered as system button
             amx::ANET_BLINK mLastBlink; // This is used for the system clock buttons
             TTimer *mTimer{nullptr};    // This is for buttons displaying the time or a date. It's a thread running in background.
+            static std::atomic<uint64_t> mGeometryGeneration;  // Incremented on every change of the position or size of a button
             static THR_REFRESH_t *mThrRefresh;  // If  we have a source to reread periodicaly, this starts a thread to do that.
             ulong mAniRunTime{0};   // The time in milliseconds an animation should run. 0 = run forever.
             BITMAP_CACHE mBCDummy;  // A dummy retuned in case no cache exists or the element was not found.
@@ -18,6 +18,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <mutex>
 
 #include "tcolor.h"
 #include "terror.h"
@@ -33,10 +34,54 @@ using std::hex;
 using std::dec;
 using std::resetiosflags;
 
+#define COLOR_CACHE_MAX     4096    // The maximum number of resolved colors in the cache
+
+std::unordered_map<string, TColor::COLOR_T> TColor::mCache;
+
+std::mutex _colorCache;
+
+/*
+ * The colors are resolved only once. The result is stored in a cache with
+ * the color string as the key. Because the color names depend on the
+ * palette, the cache is cleared whenever the palette changes.
+ */
 TColor::COLOR_T TColor::getAMXColor(const string& color)
 {
     DECL_TRACER("TColor::getAMXColor(const string& color)");
 
+    if (color.empty() || !mPalette)
+        return resolveColor(color);
+
+    {
+        std::lock_guard<std::mutex> guard(_colorCache);
+        std::unordered_map<string, COLOR_T>::iterator iter = mCache.find(color);
+
+        if (iter != mCache.end())
+            return iter->second;
+    }
+
+    COLOR_T col = resolveColor(color);
+    std::lock_guard<std::mutex> guard(_colorCache);
+
+    if (mCache.size() >= COLOR_CACHE_MAX)
+        mCache.clear();
+
+    mCache.insert(std::pair<string, COLOR_T>(color, col));
+    return col;
+}
+
+void TColor::clearCache()
+{
+    DECL_TRACER("TColor::clearCache()");
+
+    std::lock_guard<std::mutex> guard(_colorCache);
+    mCache.clear();
+}
+
+TColor::COLOR_T TColor::resolveColor(const string& color)
+{
+    DECL_TRACER("TColor::resolveColor(const string& color)");
+
     if (color.empty())
     {
         MSG_WARNING("Empty color name is ignored!");
@@ -20,6 +20,7 @@
 #define __TCOLOR_H__
 
 #include <string>
+#include <unordered_map>
 #include <include/core/SkColor.h>
 #include "tpalette.h"
 
@@ -49,7 +50,8 @@ class TColor
         TColor() {};
 
         static COLOR_T getAMXColor(const std::string& color);
-        static void setPalette(TPalette *pal) { mPalette = pal; }
+        static void setPalette(TPalette *pal) { mPalette = pal; clearCache(); }
+        static void clearCache();
         static COLOR_T splitColors(PDATA_T& pd);
         static SkColor getSkiaColor(const std::string& color);
         static ulong getColor(const std::string& color);
@@ -78,7 +80,10 @@ class TColor
         static SkColor calcColorRange(int red, int green, int blue, int alpha, int colStep, std::vector<SkColor> *colRange, bool plus, int width);
 
     private:
+        static COLOR_T resolveColor(const std::string& color);
+
         static TPalette *mPalette;
+        static std::unordered_map<std::string, COLOR_T> mCache;    // Already resolved colors
 };
 
 #endif
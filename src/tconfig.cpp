@@ -126,7 +126,12 @@ struct SETTINGS
     bool tbsuppress{false};     //!< TRUE = Don't show toolbar even if enough space
     bool tbforce{true};         //!< Only if "tbsuppress" = FALSE: TRUE = The toolbar is forced to display, FALSE = The toolbar is only visible if there is enough space left
     bool profiling{false};      //!< TRUE = The declaration traces meassure the time and write it to the log
+    string traceFilter{"ALL"};  //!< The subsystems traced by the declaration traces (AMXNET|BUTTON|PAGEMANAGER|OTHER)
+    bool logAsync{true};        //!< TRUE = The log messages are written by a separate thread
+    int logFlushInterval{250};  //!< The time in milliseconds between two writes of the asynchronous log
+    size_t logBufferSize{1024}; //!< The maximum size of the asynchronous log queue in Kb
     size_t max_cache{100};      //!< Size of internal button cache in Mb
+    size_t max_image_cache{64}; //!< Size of the cache for decoded source images in Mb; 0 = no cache
     string password1;           //!< First panel password
     string password2;           //!< Second panel password
     string password3;           //!< Third panel password
@@ -630,7 +635,7 @@ bool TConfig::saveProjectPath(const string &path)
 
 void TConfig::saveFormat(bool format)
 {
-    DECL_TRACER(string("TConfig::saveFormat(bool format) ") + (format ? "[TRUE]" : "[FALSE]"));
+    DECL_TRACER("TConfig::saveFormat(bool format)");
 
     if (mTemporary)
         localSettings_temp.longformat = format;
@@ -1304,7 +1309,12 @@ bool TConfig::saveSettings()
         lines += string("CertCheck=") + (localSettings.certCheck ? "true" : "false") + "\n";
         lines += string("Scale=") + (localSettings.scale ? "true" : "false") + "\n";
         lines += string("Profiling=") + (localSettings.profiling ? "true" : "false") + "\n";
+        lines += "TraceFilter=" + localSettings.traceFilter + "\n";
+        lines += string("LogAsync=") + (localSettings.logAsync ? "true" : "false") + "\n";
+        lines += "LogFlushInterval=" + std::to_string(localSettings.logFlushInterval) + "\n";
+        lines += "LogBufferSize=" + std::to_string(localSettings.logBufferSize) + "\n";
         lines += "MaxButtonCache=" + std::to_string(localSettings.max_cache) + "\n";
+        lines += "MaxImageCache=" + std::to_string(localSettings.max_image_cache) + "\n";
         lines += string("Password1=") + localSettings.password1 + "\n";
         lines += string("Password2=") + localSettings.password2 + "\n";
         lines += string("Password3=") + localSettings.password3 + "\n";
@@ -1426,10 +1436,27 @@ bool TConfig::getProfiling()
     return mTemporary ? localSettings_temp.profiling : localSettings.profiling;
 }
 
+bool TConfig::getLogAsync()
+{
+    return mTemporary ? localSettings_temp.logAsync : localSettings.logAsync;
+}
+
+int TConfig::getLogFlushInterval()
+{
+    int interval = mTemporary ? localSettings_temp.logFlushInterval : localSettings.logFlushInterval;
+    return interval > 0 ? interval : 250;
+}
+
+size_t TConfig::getLogBufferSize()
+{
+    size_t size = mTemporary ? localSettings_temp.logBufferSize : localSettings.logBufferSize;
+    return (size > 0 ? size : 1024) * 1024;
+}
+
 size_t TConfig::getButttonCache()
 {
     if (mTemporary && localSettings_temp.max_cache > 0)
-        return localSettings_temp.max_cache;
+        return localSettings_temp.max_cache * 1000 * 1000;
 
     if (!mTemporary && localSettings.max_cache > 0)
         return localSettings.max_cache * 1000 * 1000;
@@ -1437,6 +1464,11 @@ size_t TConfig::getButttonCache()
     return 0;
 }
 
+size_t TConfig::getImageCache()
+{
+    return (mTemporary ? localSettings_temp.max_image_cache : localSettings.max_image_cache) * 1000 * 1000;
+}
+
 string & TConfig::getPassword1()
 {
     DECL_TRACER("TConfig::getPassword1()");
@@ -2257,8 +2289,36 @@ bool TConfig::readConfig()
                 localSettings.tbsuppress = isTrue(right);
             else if (caseCompare(left, "Profiling") == 0 && !right.empty())
                 localSettings.profiling = isTrue(right);
+            else if (caseCompare(left, "TraceFilter") == 0 && !right.empty())
+            {
+                localSettings.traceFilter = right;
+#ifdef _WITH_TRACER_
+                TTracer::setSubsystems(TTracer::strToSubsystems(right));
+#endif
+            }
+            else if (caseCompare(left, "LogAsync") == 0 && !right.empty())
+                localSettings.logAsync = isTrue(right);
+            else if (caseCompare(left, "LogFlushInterval") == 0 && !right.empty())
+                localSettings.logFlushInterval = atoi(right.c_str());
+            else if (caseCompare(left, "LogBufferSize") == 0 && !right.empty())
+            {
+                int size = atoi(right.c_str());
+
+                if (size > 0)
+                    localSettings.logBufferSize = size;
+                else
+                {
+#ifdef __ANDROID__
+                    __android_log_print(ANDROID_LOG_ERROR, "tpanel", "TConfig::readConfig: Invalid log buffer size %s", right.c_str());
+#else
+                    cerr << "TConfig::readConfig: Invalid log buffer size " << right << endl;
+#endif
+                }
+            }
             else if (caseCompare(left, "MaxButtonCache") == 0 && !right.empty())
                 localSettings.max_cache = atoi(right.c_str());
+            else if (caseCompare(left, "MaxImageCache") == 0 && !right.empty())
+                localSettings.max_image_cache = atoi(right.c_str());
             else if (caseCompare(left, "Password1") == 0 && !right.empty())
                 localSettings.password1 = right;
             else if (caseCompare(left, "Password2") == 0 && !right.empty())
@@ -101,7 +101,11 @@ class TConfig
         static bool getToolbarForce();
         static bool getToolbarSuppress();
         static bool getProfiling();
+        static bool getLogAsync();
+        static int getLogFlushInterval();
+        static size_t getLogBufferSize();
         static size_t getButttonCache();
+        static size_t getImageCache();
         static std::string& getPassword1();
         static std::string& getPassword2();
         static std::string& getPassword3();
@@ -22,6 +22,8 @@
 #include <time.h>
 #include <mutex>
 #include <thread>
+#include <cstring>
+#include <strings.h>
 //#ifdef __APPLE__
 //#include <unistd.h>
 //#include <sys/syscall.h>
@@ -216,6 +218,8 @@ TStreamError::TStreamError(const string& logFile, const std::string& logLevel)
 
 TStreamError::~TStreamError()
 {
+    TLogWriter::stop();
+
     if (mOfStream.is_open())
         mOfStream.close();
 
@@ -269,7 +273,7 @@ void TStreamError::setLogLevel(const std::string& slv)
 #else
         unsigned int llv = _getLevel(lv);
 
-        if (llv != HLOG_DEBUG && llv != HLOG_TRACE)
+        if (llv != HLOG_DEBUG)
             mLogLevel |= llv;
 #endif  // NDEBUG
         pos = slv.find("|", start);
@@ -278,11 +282,12 @@ void TStreamError::setLogLevel(const std::string& slv)
 #ifdef NDEBUG
     unsigned int llv = _getLevel(lv);
 
-    if (llv != HLOG_DEBUG && llv != HLOG_TRACE)
+    if (llv != HLOG_DEBUG)
         mLogLevel |= llv;
 #else
     mLogLevel |= _getLevel(slv.substr(start));
 #endif  // NDEBUG
+    _updateTracer();
 #ifdef __ANDROID__
     __android_log_print(ANDROID_LOG_INFO, "tpanel", "TStreamError::setLogLevel: New loglevel: %s (%02x)", slv.c_str(), mLogLevel);
 #else
@@ -308,9 +313,11 @@ bool TStreamError::checkFilter(terrtype_t err)
         return true;
     else if (err == TERRERROR && (mLogLevel & HLOG_ERROR) != 0)
         return true;
-#ifndef NDEBUG
+#ifdef _WITH_TRACER_
     else if (err == TERRTRACE && (mLogLevel & HLOG_TRACE) != 0)
         return true;
+#endif
+#ifndef NDEBUG
     else if (err == TERRDEBUG && (mLogLevel & HLOG_DEBUG) != 0)
         return true;
 #endif
@@ -331,7 +338,11 @@ bool TStreamError::checkFilter(unsigned int lv)
     if ((mLogLevel & lv) != 0 && lv != HLOG_PROTOCOL)
     {
 #ifdef NDEBUG
-        if (lv == HLOG_DEBUG || lv == HLOG_TRACE)
+        if (lv == HLOG_DEBUG)
+            return false;
+#endif
+#ifndef _WITH_TRACER_
+        if (lv == HLOG_TRACE)
             return false;
 #endif
         return true;
@@ -356,10 +367,11 @@ unsigned int TStreamError::_getLevel(const std::string& slv)
 
     if (slv.compare(SLOG_PROTOCOL) == 0)
         return HLOG_PROTOCOL;
-#ifndef NDEBUG
+#ifdef _WITH_TRACER_
     if (slv.compare(SLOG_TRACE) == 0)
         return HLOG_TRACE;
-
+#endif
+#ifndef NDEBUG
     if (slv.compare(SLOG_DEBUG) == 0)
         return HLOG_DEBUG;
 
@@ -496,6 +508,9 @@ void TStreamError::_init(bool reinit)
     }
 #endif  // LOGPATH == LPATH_FILE
 
+    if (TConfig::getLogAsync())
+        TLogWriter::start(TConfig::getLogBufferSize(), TConfig::getLogFlushInterval());
+
     if (reinit)
         return;
 
@@ -687,6 +702,7 @@ void TStreamError::startTemporaryLogLevel(unsigned int l)
     mLogLevelOld = mLogLevel;
     mLogLevel |= l;
     haveTemporaryLogLevel = true;
+    _updateTracer();
 }
 
 void TStreamError::endTemporaryLogLevel()
@@ -696,49 +712,134 @@ void TStreamError::endTemporaryLogLevel()
 
     mLogLevel = mLogLevelOld;
     haveTemporaryLogLevel = false;
+    _updateTracer();
+}
+
+void TStreamError::_updateTracer()
+{
+#ifdef _WITH_TRACER_
+    TTracer::setLogLevel(mLogLevel);
+#endif
 }
 
 /********************************************************************/
-#ifndef NDEBUG
+#ifdef _WITH_TRACER_
 std::mutex tracer_mutex;
 
-TTracer::TTracer(const std::string& msg, int line, const char *file, threadID_t tid)
-    : mThreadID(tid)
+namespace
+{
+    /*
+     * The trace messages are written into the queue of the asynchronous
+     * log writer, if it is active. Otherwise they are written directly.
+     */
+    std::ostream& _traceBegin(bool async)
+    {
+        if (async)
+            return TLogWriter::stream();
+
+        return *TError::Current()->getStream();
+    }
+
+    void _traceEnd(std::ostream& os, bool async)
+    {
+        if (async)
+        {
+            os << '\n';
+            TLogWriter::commit(HLOG_TRACE);
+        }
+        else
+            os << std::endl;
+    }
+}
+
+std::atomic<unsigned int> TTracer::mActive{0};
+unsigned int TTracer::mSubsystems{TRACE_ALL};
+unsigned int TTracer::mLogLevel{HLOG_NONE};
+
+void TTracer::setSubsystems(unsigned int subsystems)
+{
+    mSubsystems = subsystems;
+    setLogLevel(mLogLevel);
+}
+
+void TTracer::setLogLevel(unsigned int level)
+{
+    mLogLevel = level;
+    mActive.store(((level & HLOG_TRACE) != 0) ? mSubsystems : TRACE_NONE, std::memory_order_relaxed);
+}
+
+/*
+ * Converts a string like "AMXNET|BUTTON" into the bit field of the
+ * subsystems. Unknown names are ignored.
+ */
+unsigned int TTracer::strToSubsystems(const string& str)
+{
+    unsigned int subs = TRACE_NONE;
+    size_t start = 0;
+
+    while (start <= str.length())
+    {
+        size_t pos = str.find('|', start);
+        string part = str.substr(start, (pos == string::npos ? string::npos : pos - start));
+
+        if (strcasecmp(part.c_str(), "ALL") == 0)
+            subs |= TRACE_ALL;
+        else if (strcasecmp(part.c_str(), "AMXNET") == 0)
+            subs |= TRACE_AMXNET;
+        else if (strcasecmp(part.c_str(), "BUTTON") == 0)
+            subs |= TRACE_BUTTON;
+        else if (strcasecmp(part.c_str(), "PAGEMANAGER") == 0)
+            subs |= TRACE_PAGEMANAGER;
+        else if (strcasecmp(part.c_str(), "OTHER") == 0)
+            subs |= TRACE_OTHER;
+
+        if (pos == string::npos)
+            break;
+
+        start = pos + 1;
+    }
+
+    return subs;
+}
+
+void TTracer::start(const char *msg, int line, const char *file)
 {
     if (!TConfig::isInitialized() || !TStreamError::checkFilter(HLOG_TRACE))
         return;
 
     std::lock_guard<mutex> guard(tracer_mutex);
 
-    mFile = file;
-    size_t pos = mFile.find_last_of("/");
-
-    if (pos != string::npos)
-        mFile = mFile.substr(pos + 1);
+    mThreadID = _getThreadID();
+    mFile = strrchr(file, '/');
+    mFile = mFile ? mFile + 1 : file;
 
     TError::setErrorType(TERRTRACE);
-    std::lock_guard<mutex> guardm(message_mutex);
+    bool async = TLogWriter::isActive();
+    std::unique_lock<mutex> guardm(message_mutex, std::defer_lock);
+
+    if (!async)
+        guardm.lock();
+
+    std::ostream& os = _traceBegin(async);
 
     if (!TConfig::isLongFormat())
-        *TError::Current()->getStream() << "TRC, " << std::setw(5) << std::right << line << ", " << _threadIDtoStr(mThreadID) << ", " << indent << "{entry " << msg << std::endl;
+        os << "TRC, " << std::setw(5) << std::right << line << ", " << _threadIDtoStr(mThreadID) << ", " << indent << "{entry " << msg;
     else
-        *TError::Current()->getStream() << TStreamError::getTime() <<  ", TRC, " << std::setw(5) << std::right << line << ", " << std::setw(20) << std::left << mFile << ", " << _threadIDtoStr(mThreadID) << ", " << indent << "{entry " << msg << std::endl;
+        os << TStreamError::getTime() <<  ", TRC, " << std::setw(5) << std::right << line << ", " << std::setw(20) << std::left << mFile << ", " << _threadIDtoStr(mThreadID) << ", " << indent << "{entry " << msg;
+
+    _traceEnd(os, async);
 
     TError::Current()->incIndent();
     mHeadMsg = msg;
-    mLine = line;
 
-//    __android_log_print(ANDROID_LOG_INFO, "tpanel", "[TRACE] %s", msg.c_str());
+//    __android_log_print(ANDROID_LOG_INFO, "tpanel", "[TRACE] %s", msg);
 
     if (TConfig::getProfiling())
         mTimePoint = std::chrono::steady_clock::now();
 }
 
-TTracer::~TTracer()
+void TTracer::stop()
 {
-    if (!TConfig::isInitialized() || !TStreamError::checkFilter(HLOG_TRACE))
-        return;
-
     std::lock_guard<mutex> guard(tracer_mutex);
     TError::setErrorType(TERRTRACE);
     TError::Current()->decIndent();
@@ -755,24 +856,24 @@ TTracer::~TTracer()
         nanosecs = s.str();
     }
 
-    std::lock_guard<mutex> guardm(message_mutex);
+    bool async = TLogWriter::isActive();
+    std::unique_lock<mutex> guardm(message_mutex, std::defer_lock);
 
-    if (TConfig::getProfiling())
-    {
-        if (!TConfig::isLongFormat())
-            *TError::Current()->getStream() << "TRC,      , " << _threadIDtoStr(mThreadID) << ", " << indent << "}exit " << mHeadMsg << " Elapsed time: " << nanosecs << std::endl;
-        else
-            *TError::Current()->getStream() << TStreamError::getTime() << ", TRC,      , " << std::setw(20) << std::left << mFile << ", " << _threadIDtoStr(mThreadID) << ", " << indent << "}exit " << mHeadMsg << " Elapsed time: " << nanosecs << std::endl;
-    }
+    if (!async)
+        guardm.lock();
+
+    std::ostream& os = _traceBegin(async);
+
+    if (!TConfig::isLongFormat())
+        os << "TRC,      , " << _threadIDtoStr(mThreadID) << ", " << indent << "}exit " << mHeadMsg;
     else
-    {
-        if (!TConfig::isLongFormat())
-            *TError::Current()->getStream() << "TRC,      , " << _threadIDtoStr(mThreadID) << ", " << indent << "}exit " << mHeadMsg << std::endl;
-        else
-            *TError::Current()->getStream() << TStreamError::getTime() << ", TRC,      , " << std::setw(20) << std::left << mFile << ", " << _threadIDtoStr(mThreadID) << ", " << indent << "}exit " << mHeadMsg << std::endl;
-    }
+        os << TStreamError::getTime() << ", TRC,      , " << std::setw(20) << std::left << mFile << ", " << _threadIDtoStr(mThreadID) << ", " << indent << "}exit " << mHeadMsg;
+
+    if (TConfig::getProfiling())
+        os << " Elapsed time: " << nanosecs;
 
-    mHeadMsg.clear();
+    _traceEnd(os, async);
+    mHeadMsg = nullptr;
 }
 #endif
 
@@ -935,6 +1036,11 @@ std::ostream & TError::append(int lv, int line, const std::string& file, std::os
 }
 
 std::string TError::append(int lv, int line, const std::string& file)
+{
+    return append(lv, line, file, mThreadID);
+}
+
+std::string TError::append(int lv, int line, const std::string& file, threadID_t tid)
 {
     std::string prefix;
 
@@ -960,9 +1066,9 @@ std::string TError::append(int lv, int line, const std::string& file)
         f = f.substr(pos + 1);
 
     if (!TConfig::isLongFormat())
-        s << prefix << std::setw(5) << std::right << line << ", " << _threadIDtoStr(mThreadID) << ", ";
+        s << prefix << std::setw(5) << std::right << line << ", " << _threadIDtoStr(tid) << ", ";
     else
-        s << TStreamError::getTime() << ", " << prefix << std::setw(5) << std::right << line << ", " << std::setw(20) << std::left << f << ", " << _threadIDtoStr(mThreadID) << ", ";
+        s << TStreamError::getTime() << ", " << prefix << std::setw(5) << std::right << line << ", " << std::setw(20) << std::left << f << ", " << _threadIDtoStr(tid) << ", ";
 
     return s.str();
 }
@@ -26,6 +26,10 @@
 #include <chrono>
 //#include <mutex>
 #include <thread>
+#include <atomic>
+#include <type_traits>
+
+#include "tlogwriter.h"
 
 #define LPATH_FILE          1   //!< Creates a log file and protocolls there
 #define LPATH_SYSLOG        2   //!< Writes to the syslog.
@@ -52,6 +56,22 @@
 #define SLOG_PROTOCOL       "PROTOCOL"
 #define SLOG_ALL            "ALL"
 
+// The function tracer (DECL_TRACER) is always compiled into debug builds. To
+// have it in a release build too, define _WITH_TRACER_ (cmake -DWITH_TRACER=ON).
+#if !defined(NDEBUG) && !defined(_WITH_TRACER_)
+#define _WITH_TRACER_
+#endif
+
+// Subsystems of the function tracer. They can be switched on and off at
+// runtime with TTracer::setSubsystems() or the configuration option
+// "TraceFilter".
+#define TRACE_NONE          0x0000
+#define TRACE_AMXNET        0x0001      //!< Network communication with the controller (tamxnet.cpp)
+#define TRACE_BUTTON        0x0002      //!< Buttons (tbutton.cpp)
+#define TRACE_PAGEMANAGER   0x0004      //!< Page manager (tpagemanager.cpp)
+#define TRACE_OTHER         0x8000      //!< All other modules
+#define TRACE_ALL           (TRACE_AMXNET | TRACE_BUTTON | TRACE_PAGEMANAGER | TRACE_OTHER)
+
 #define T_UNUSED(x) (void)x;
 
 typedef enum terrtype_t
@@ -86,7 +106,7 @@ class TStreamError
         static void setLogFileOnly(const std::string& lf) { mLogfile = lf; }
         static std::string& getLogFile() { return mLogfile; }
         static void setLogLevel(const std::string& slv);
-        static void setLogLevel(unsigned int ll) { mLogLevel = ll; }
+        static void setLogLevel(unsigned int ll) { mLogLevel = ll; _updateTracer(); }
         static unsigned int getLogLevel() { return mLogLevel; }
 //        static void logMsg(std::ostream& str);
         static bool checkFilter(terrtype_t err);
@@ -110,6 +130,7 @@ class TStreamError
     private:
         static unsigned int _getLevel(const std::string& slv);
         static void _init(bool reinit=false);
+        static void _updateTracer();
 
         const TStreamError& operator=(const TStreamError& ref);
 
@@ -125,23 +146,84 @@ class TStreamError
         static char *mBuffer;
 };
 
-#ifndef NDEBUG
+#ifdef _WITH_TRACER_
+/*
+ * Returns TRUE if the file name \p file (usually __FILE__) ends with the
+ * file name \p name. This is evaluated by the compiler.
+ */
+constexpr bool _traceIsFile(const char *file, const char *name)
+{
+    size_t lf = 0, ln = 0;
+
+    while (file[lf])
+        lf++;
+
+    while (name[ln])
+        ln++;
+
+    if (ln > lf)
+        return false;
+
+    for (size_t i = 0; i < ln; ++i)
+    {
+        if (file[lf - ln + i] != name[i])
+            return false;
+    }
+
+    return (lf == ln || file[lf - ln - 1] == '/' || file[lf - ln - 1] == '\\');
+}
+
+/*
+ * Maps a source file to the subsystem of the tracer.
+ */
+constexpr unsigned int _traceSubsystem(const char *file)
+{
+    return _traceIsFile(file, "tamxnet.cpp") ? TRACE_AMXNET :
+           _traceIsFile(file, "tbutton.cpp") ? TRACE_BUTTON :
+           _traceIsFile(file, "tpagemanager.cpp") ? TRACE_PAGEMANAGER : TRACE_OTHER;
+}
+
+/**
+ * @brief The TTracer class
+ * An object of this class is created by the macro DECL_TRACER() on entry of
+ * a function. It writes the entry and the exit of the function into the
+ * logfile.
+ * As long as the tracer is disabled for a subsystem, the macro evaluates only
+ * one bit in a global variable and the class does nothing.
+ */
 class TTracer
 {
     public:
-        TTracer(const std::string& msg, int line, const char *file, threadID_t tid);
-        ~TTracer();
+        TTracer(const char *msg, int line, const char *file)
+        {
+            if (msg)
+                start(msg, line, file);
+        }
+
+        ~TTracer()
+        {
+            if (mHeadMsg)
+                stop();
+        }
+
+        static bool isActive(unsigned int subsystem) { return (mActive.load(std::memory_order_relaxed) & subsystem) != 0; }
+        static void setSubsystems(unsigned int subsystems);
+        static unsigned int getSubsystems() { return mSubsystems; }
+        static unsigned int strToSubsystems(const std::string& str);
+        static void setLogLevel(unsigned int level);
 
     private:
-        std::string mHeadMsg;
-        int mLine{0};
-        std::string mFile;
+        void start(const char *msg, int line, const char *file);
+        void stop();
+
+        const char *mHeadMsg{nullptr};
+        const char *mFile{nullptr};
         std::chrono::steady_clock::time_point mTimePoint;
-#ifdef __ANDROID__
         threadID_t mThreadID;
-#else
-        threadID_t mThreadID{0};
-#endif
+
+        static std::atomic<unsigned int> mActive;       // The active subsystems; 0 if tracing is disabled
+        static unsigned int mSubsystems;                // The selected subsystems
+        static unsigned int mLogLevel;                  // The last log level set
 };
 #endif
 
@@ -163,6 +245,7 @@ class TError : public std::ostream
         static void setErrorType(terrtype_t et) { mErrType = et; }
         static std::ostream& append(int lv, int line, const std::string& file, std::ostream& os);
         static std::string append(int lv, int line, const std::string& file);
+        static std::string append(int lv, int line, const std::string& file, threadID_t tid);
         static TStreamError* Current();
         static TStreamError* Current(threadID_t tid);
         static void clear() { mHaveError = false; msError.clear(); mErrType = TERRNONE; mLastLine = 0; mLastFile = ""; }
@@ -187,20 +270,77 @@ class TError : public std::ostream
         static std::string mLastFile;
 };
 
-#define MSG_INFO(msg)       { if (TStreamError::checkFilter(HLOG_INFO)) { _lock(); *TError::Current(_getThreadID())->getStream() << TError::append(HLOG_INFO, __LINE__, __FILE__) << msg << std::endl; TStreamError::resetFlags(); _unlock(); }}
-#define MSG_WARNING(msg)    { if (TStreamError::checkFilter(HLOG_WARNING)) { _lock(); *TError::Current(_getThreadID())->getStream() << TError::append(HLOG_WARNING, __LINE__, __FILE__) << msg << std::endl; TStreamError::resetFlags(); _unlock(); }}
-#define MSG_ERROR(msg)      { if (TStreamError::checkFilter(HLOG_ERROR)) { _lock(); *TError::Current(_getThreadID())->getStream() << TError::append(HLOG_ERROR, __LINE__, __FILE__) << msg << std::endl; TStreamError::resetFlags(); _unlock(); }}
-#ifndef NDEBUG
-#define MSG_TRACE(msg)      { if (TStreamError::checkFilter(HLOG_TRACE)) { _lock(); *TError::Current(_getThreadID())->getStream() << TError::append(HLOG_TRACE, __LINE__, __FILE__) << msg << std::endl; TStreamError::resetFlags(); _unlock(); }}
-#define MSG_DEBUG(msg)      { if (TStreamError::checkFilter(HLOG_DEBUG)) { _lock(); *TError::Current(_getThreadID())->getStream() << TError::append(HLOG_DEBUG, __LINE__, __FILE__) << msg << std::endl; TStreamError::resetFlags(); _unlock(); }}
+/**
+ * @brief The TLogLine class
+ * An object of this class is created by the logging macros for each message.
+ * If the asynchronous log writer is active, the message is formatted into the
+ * buffer of the thread and queued. Otherwise the message is written directly
+ * into the log stream while the global lock is held.
+ */
+class TLogLine
+{
+    public:
+        TLogLine(unsigned int level)
+            : mLevel(level),
+              mThreadID(_getThreadID()),
+              mAsync(TLogWriter::isActive())
+        {
+            if (mAsync)
+                mStream = &TLogWriter::stream();
+            else
+            {
+                _lock();
+                mStream = TError::Current(mThreadID)->getStream();
+            }
+        }
+
+        ~TLogLine()
+        {
+            if (mAsync)
+            {
+                *mStream << '\n';
+                TLogWriter::commit(mLevel);
+            }
+            else
+            {
+                *mStream << std::endl;
+                TStreamError::resetFlags();
+                _unlock();
+            }
+        }
+
+        std::ostream& stream() { return *mStream; }
+        threadID_t threadID() const { return mThreadID; }
+
+        TLogLine(const TLogLine&) = delete;
+        TLogLine& operator=(const TLogLine&) = delete;
+
+    private:
+        unsigned int mLevel{HLOG_NONE};
+        threadID_t mThreadID;
+        bool mAsync{false};
+        std::ostream *mStream{nullptr};
+};
+
+#define _MSG_LOG(lv, msg)   { if (TStreamError::checkFilter(lv)) { TLogLine _logLine(lv); _logLine.stream() << TError::append(lv, __LINE__, __FILE__, _logLine.threadID()) << msg; }}
+
+#define MSG_INFO(msg)       _MSG_LOG(HLOG_INFO, msg)
+#define MSG_WARNING(msg)    _MSG_LOG(HLOG_WARNING, msg)
+#define MSG_ERROR(msg)      _MSG_LOG(HLOG_ERROR, msg)
+#ifdef _WITH_TRACER_
+#define MSG_TRACE(msg)      _MSG_LOG(HLOG_TRACE, msg)
 #else
 #define MSG_TRACE(msg)      { if (TStreamError::checkFilter(HLOG_TRACE)) std::cout << msg << std::endl; }
+#endif
+#ifndef NDEBUG
+#define MSG_DEBUG(msg)      _MSG_LOG(HLOG_DEBUG, msg)
+#else
 #define MSG_DEBUG(msg)      { if (TStreamError::checkFilter(HLOG_DEBUG)) std::cout << msg << std::endl; }
 #endif
-#define MSG_PROTOCOL(msg)   { if (TStreamError::checkFilter(HLOG_PROTOCOL)) { _lock(); *TError::Current(_getThreadID())->getStream() << TError::append(HLOG_PROTOCOL, __LINE__, __FILE__) << msg << std::endl; TStreamError::resetFlags(); _unlock(); }}
+#define MSG_PROTOCOL(msg)   _MSG_LOG(HLOG_PROTOCOL, msg)
 
-#ifndef NDEBUG
-#define DECL_TRACER(msg)    TTracer _hidden_tracer(msg, __LINE__, static_cast<const char *>(__FILE__), _getThreadID());
+#ifdef _WITH_TRACER_
+#define DECL_TRACER(msg)    TTracer _hidden_tracer((TTracer::isActive(std::integral_constant<unsigned int, _traceSubsystem(__FILE__)>::value) ? msg : nullptr), __LINE__, static_cast<const char *>(__FILE__));
 #else
 #define DECL_TRACER(msg)
 #endif
@@ -209,16 +349,11 @@ class TError : public std::ostream
 #define SET_ERROR_MSG(msg)  TError::_setErrorMsg(msg, __LINE__, __FILE__)
 
 #define PRINT_LAST_ERROR()  {\
-            if (TStreamError::checkFilter(TError::getErrorType()))\
+            if (TStreamError::checkFilter(TError::getErrorType()) && (TError::haveErrorMsg() || TError::isError()))\
             {\
-                if (TError::haveErrorMsg())\
-                    *TError::Current(_getThreadID())->getStream()\
-                        << TError::append(TError::getErrorType(), TError::getLastLine(), TError::getLastFile())\
-                        << TError::getErrorMsg() << std::endl;\
-                else if (TError::isError())\
-                    *TError::Current(_getThreadID())->getStream()\
-                        << TError::append(TError::getErrorType(), TError::getLastLine(), TError::getLastFile())\
-                        << "Unknown error occured!" << std::endl;\
+                TLogLine _logLine(TError::getErrorType());\
+                _logLine.stream() << TError::append(TError::getErrorType(), TError::getLastLine(), TError::getLastFile(), _logLine.threadID())\
+                    << (TError::haveErrorMsg() ? TError::getErrorMsg() : std::string("Unknown error occured!"));\
             }\
         }
 
@@ -226,12 +361,15 @@ class TError : public std::ostream
 #define IS_LOG_WARNING()    TStreamError::checkFilter(HLOG_WARNING)
 #define IS_LOG_ERROR()      TStreamError::checkFilter(HLOG_ERROR)
 #define IS_LOG_PROTOCOL()   TStreamError::checkFilter(HLOG_PROTOCOL)
-#ifndef NDEBUG
+#ifdef _WITH_TRACER_
 #define IS_LOG_TRACE()      TStreamError::checkFilter(HLOG_TRACE)
+#else
+#define IS_LOG_TRACE()      false
+#endif
+#ifndef NDEBUG
 #define IS_LOG_DEBUG()      TStreamError::checkFilter(HLOG_DEBUG)
 #define IS_LOG_ALL()        TStreamError::checkFilter(HLOG_ALL)
 #else
-#define IS_LOG_TRACE()      false
 #define IS_LOG_DEBUG()      false
 #define IS_LOG_ALL()        false
 #endif
@@ -250,6 +388,6 @@ class TError : public std::ostream
 
 #define SetErrorMsg(msg)        setErrorMsg(msg, __LINE__, __FILE__)
 #define SetError()              setError(__LINE__, __FILE__)
-#define MSG_LASTERROR(msg)      { if (TStreamError::checkFilter(HLOG_ERROR)) { _lock(); *TError::Current(_getThreadID())->getStream() << TError::append(HLOG_ERROR, __LINE__, __FILE__) << "(" << TError::getLastLine() << ", " << TError::getLastFile() << ") " << msg << std::endl; TStreamError::resetFlags(); _unlock(); }}
+#define MSG_LASTERROR(msg)      _MSG_LOG(HLOG_ERROR, "(" << TError::getLastLine() << ", " << TError::getLastFile() << ") " << msg)
 
 #endif
@@ -18,6 +18,7 @@
 
 #include <codecvt>
 #include <mutex>
+#include <atomic>
 
 #if __cplusplus < 201402L
 #   error "This module requires at least C++14 standard!"
@@ -140,9 +141,54 @@ typedef struct FTABLE_CMAP_t
 {
     uint16_t version{0};
     uint16_t numSubtables{0};
-    FTABLE_SUBTABLE_t *subtables;
+    FTABLE_SUBTABLE_t *subtables{nullptr};
 }FTABLE_CMAP_t;
 
+#define CMAP_GLYPH_CACHE    256     // Number of characters with a cached glyph index
+#define CMAP_GLYPH_KNOWN    0x10000 // Marks a valid entry in the glyph index cache
+
+/*
+ * The parsed cmap table of one typeface. It is created once for each
+ * typeface and is never changed afterwards, except the glyph index cache.
+ * The entries of this cache are atomic. Therefore the structure can be
+ * shared between threads without locking.
+ */
+typedef struct FONT_CMAP_t
+{
+    std::vector<unsigned char> data;    // The raw cmap table. The glyph index arrays point into it.
+    FTABLE_CMAP_t table;                // The parsed table
+    FONT_TYPE type{FT_UNKNOWN};         // The type of the font
+    std::atomic<uint32_t> glyphs[CMAP_GLYPH_CACHE];  // Glyph indexes of the first characters
+
+    FONT_CMAP_t()
+    {
+        for (size_t i = 0; i < CMAP_GLYPH_CACHE; ++i)
+            glyphs[i] = 0;
+    }
+
+    FONT_CMAP_t(const FONT_CMAP_t&) = delete;
+    FONT_CMAP_t& operator=(const FONT_CMAP_t&) = delete;
+
+    ~FONT_CMAP_t()
+    {
+        if (!table.subtables)
+            return;
+
+        for (uint16_t nTbs = 0; nTbs < table.numSubtables; nTbs++)
+        {
+            if (table.subtables[nTbs].format.format == 4)
+            {
+                delete[] table.subtables[nTbs].format.fdef.format4.endCode;
+                delete[] table.subtables[nTbs].format.fdef.format4.startCode;
+                delete[] table.subtables[nTbs].format.fdef.format4.idDelta;
+                delete[] table.subtables[nTbs].format.fdef.format4.idRangeOffset;
+            }
+        }
+
+        delete[] table.subtables;
+    }
+}FONT_CMAP_t;
+
 using std::string;
 using std::vector;
 using std::map;
@@ -151,6 +197,15 @@ using std::mutex;
 using namespace Expat;
 
 mutex mutex_font;
+mutex mutex_cmap;
+
+// The parsed cmap tables of the typefaces. The key is the unique ID of the
+// typeface.
+map<SkTypefaceID, std::shared_ptr<FONT_CMAP_t> > _cmapCache;
+std::atomic<uint64_t> _cmapHits{0};
+std::atomic<uint64_t> _cmapMisses{0};
+std::atomic<uint64_t> _cmapGlyphs{0};
+std::atomic<uint64_t> _cmapGlyphHits{0};
 
 // This is an internal used font cache
 map<string, sk_sp<SkTypeface> > _tfontCache;
@@ -830,23 +885,20 @@ vector<string> TFont::getFontPathList()
     return list;
 }
 
-size_t _numTables;
-FTABLE_CMAP_t _cmapTable;
-
-void TFont::parseCmap(const unsigned char* cmaps)
+void TFont::parseCmap(const unsigned char* cmaps, FTABLE_CMAP_t& table)
 {
-    DECL_TRACER("TFont::parseCmap(const unsigned char* cmaps)");
+    DECL_TRACER("TFont::parseCmap(const unsigned char* cmaps, FTABLE_CMAP_t& table)");
 
     if (!cmaps)
         return;
 
-    _cmapTable.version = getUint16(cmaps);
-    _cmapTable.numSubtables = getUint16(cmaps+sizeof(uint16_t));
-    MSG_DEBUG("Found version " << _cmapTable.version << ", found " << _cmapTable.numSubtables << " cmap tables.");
-    _cmapTable.subtables = new FTABLE_SUBTABLE_t[_cmapTable.numSubtables];
+    table.version = getUint16(cmaps);
+    table.numSubtables = getUint16(cmaps+sizeof(uint16_t));
+    MSG_DEBUG("Found version " << table.version << ", found " << table.numSubtables << " cmap tables.");
+    table.subtables = new FTABLE_SUBTABLE_t[table.numSubtables];
     size_t pos = sizeof(uint16_t) * 2;
 
-    for (uint16_t i = 0; i < _cmapTable.numSubtables; i++)
+    for (uint16_t i = 0; i < table.numSubtables; i++)
     {
         FTABLE_SUBTABLE_t st;
         st.platformID = getUint16(cmaps+pos);
@@ -855,22 +907,22 @@ void TFont::parseCmap(const unsigned char* cmaps)
         pos += sizeof(uint16_t);
         st.offset = getUint32(cmaps+pos);
         pos += sizeof(uint32_t);
-        memmove(&_cmapTable.subtables[i], &st, sizeof(st));
+        memmove(&table.subtables[i], &st, sizeof(st));
         MSG_DEBUG("Table " << (i+1) << ": platformID=" << st.platformID << ", platformSpecificID=" << st.platformSpecificID << ", offset=" << st.offset);
     }
 
     // Get the format and read the mapping
-    for (uint16_t i = 0; i < _cmapTable.numSubtables; i++)
+    for (uint16_t i = 0; i < table.numSubtables; i++)
     {
-        if (_cmapTable.subtables[i].platformID == FTABLE_PID_MACINTOSH)   // We ignore old Macintosh format
+        if (table.subtables[i].platformID == FTABLE_PID_MACINTOSH)   // We ignore old Macintosh format
         {
-            _cmapTable.subtables[i].format.format = -1;
+            table.subtables[i].format.format = -1;
             continue;
         }
 
         FTABLE_FORMATS_t format;
-        format.format = getUint16(cmaps+_cmapTable.subtables[i].offset);
-        pos = _cmapTable.subtables[i].offset + sizeof(uint16_t);
+        format.format = getUint16(cmaps+table.subtables[i].offset);
+        pos = table.subtables[i].offset + sizeof(uint16_t);
 
         switch(format.format)
         {
@@ -931,32 +983,32 @@ void TFont::parseCmap(const unsigned char* cmaps)
                 }
 
                 format.fdef.format4.glyphIndexArray = (uint16_t *)(cmaps+pos);
-                memcpy(&_cmapTable.subtables[i].format, &format, sizeof(FTABLE_FORMATS_t));
+                memcpy(&table.subtables[i].format, &format, sizeof(FTABLE_FORMATS_t));
             break;
         }
     }
 }
 
-uint16_t TFont::getGlyphIndex(SkUnichar ch)
+uint16_t TFont::getGlyphIndex(const FTABLE_CMAP_t& table, SkUnichar ch)
 {
-    DECL_TRACER("TFont::getGlyphIndex(SkUnichar ch)");
+    DECL_TRACER("TFont::getGlyphIndex(const FTABLE_CMAP_t& table, SkUnichar ch)");
 
     uint16_t lCh = ch;
     bool symbol = false;
 
-    for (uint16_t nTbs = 0; nTbs < _cmapTable.numSubtables; nTbs++)
+    for (uint16_t nTbs = 0; nTbs < table.numSubtables; nTbs++)
     {
-        if (_cmapTable.subtables[nTbs].platformID == FTABLE_PID_UNICODE ||
-            _cmapTable.subtables[nTbs].platformID == FTABLE_PID_MICROSOFT)
+        if (table.subtables[nTbs].platformID == FTABLE_PID_UNICODE ||
+            table.subtables[nTbs].platformID == FTABLE_PID_MICROSOFT)
         {
-            if ((_cmapTable.subtables[nTbs].platformID == FTABLE_PID_UNICODE &&_cmapTable.subtables[nTbs].platformSpecificID == FTABLE_SID_UNI_VERSION1) ||
-                (_cmapTable.subtables[nTbs].platformID == FTABLE_PID_MICROSOFT && _cmapTable.subtables[nTbs].platformSpecificID == FTABLE_SID_MSC_SYMBOL))
+            if ((table.subtables[nTbs].platformID == FTABLE_PID_UNICODE &&table.subtables[nTbs].platformSpecificID == FTABLE_SID_UNI_VERSION1) ||
+                (table.subtables[nTbs].platformID == FTABLE_PID_MICROSOFT && table.subtables[nTbs].platformSpecificID == FTABLE_SID_MSC_SYMBOL))
                 symbol = true;  // Table does not have unicode table mapping (wingding)
 
             // Find the segment where the wanted character is in.
-            if (_cmapTable.subtables[nTbs].format.format == 4)
+            if (table.subtables[nTbs].format.format == 4)
             {
-                FTABLE_FORMAT4_t form = _cmapTable.subtables[nTbs].format.fdef.format4;
+                const FTABLE_FORMAT4_t& form = table.subtables[nTbs].format.fdef.format4;
                 uint16_t segCount = form.segCountX2 / 2;
                 uint16_t segment = 0xffff;
                 MSG_DEBUG("segCountX2: " << form.segCountX2 << ", # segments: " << segCount);
@@ -1007,7 +1059,7 @@ uint16_t TFont::getGlyphIndex(SkUnichar ch)
             }
             else
             {
-                MSG_WARNING("Ignoring table with unsupported format " << _cmapTable.subtables[nTbs].format.format);
+                MSG_WARNING("Ignoring table with unsupported format " << table.subtables[nTbs].format.format);
             }
         }
     }
@@ -1015,195 +1067,146 @@ uint16_t TFont::getGlyphIndex(SkUnichar ch)
     return 0xffff;
 }
 
-void TFont::_freeCmap()
+/**
+ * @brief TFont::getCmap - Returns the parsed cmap table of a typeface
+ * The cmap table of a typeface is read and parsed only once. Afterwards it
+ * is taken from the cache.
+ *
+ * @param typeFace  The typeface.
+ *
+ * @return The parsed cmap table or an empty pointer if the typeface has no
+ * valid cmap table.
+ */
+std::shared_ptr<FONT_CMAP_t> TFont::getCmap(sk_sp<SkTypeface>& typeFace)
 {
-    DECL_TRACER("TFont::_freeCmap()");
+    DECL_TRACER("TFont::getCmap(sk_sp<SkTypeface>& typeFace)");
 
-    for (uint16_t nTbs = 0; nTbs < _cmapTable.numSubtables; nTbs++)
+    if (!typeFace)
     {
-        if (_cmapTable.subtables[nTbs].platformID == FTABLE_PID_UNICODE ||
-            _cmapTable.subtables[nTbs].platformID == FTABLE_PID_MICROSOFT)
-        {
-            if (_cmapTable.subtables[nTbs].format.format == 4)
-            {
-                delete[] _cmapTable.subtables[nTbs].format.fdef.format4.endCode;
-                delete[] _cmapTable.subtables[nTbs].format.fdef.format4.startCode;
-                delete[] _cmapTable.subtables[nTbs].format.fdef.format4.idDelta;
-                delete[] _cmapTable.subtables[nTbs].format.fdef.format4.idRangeOffset;
-            }
-        }
+        MSG_ERROR("Got an empty typeface!");
+        return nullptr;
     }
 
-    delete[] _cmapTable.subtables;
-}
+    SkTypefaceID id = typeFace->uniqueID();
+    std::lock_guard<mutex> guard(mutex_cmap);
+    map<SkTypefaceID, std::shared_ptr<FONT_CMAP_t> >::iterator iter = _cmapCache.find(id);
 
-SkGlyphID *TFont::textToGlyphs(const string& str, sk_sp<SkTypeface>& typeFace, size_t *size)
-{
-    DECL_TRACER("TFont::textToGlyphs(const string& str, SkTypeface& typeFace)");
+    if (iter != _cmapCache.end())
+    {
+        _cmapHits++;
+        return iter->second;
+    }
 
-    *size = 0;
-    int tables = typeFace->countTables();
+    _cmapMisses++;
+    size_t tbSize = typeFace->getTableSize(FTABLE_cmap);
 
-    if (!tables)
+    if (!tbSize)
     {
-        MSG_ERROR("No tables in typeface!");
+        MSG_ERROR("Invalid font. Missing CMAP table!");
         return nullptr;
     }
-#if SKIAV < 20250812
-    SkFontTableTag *tbTags = new SkFontTableTag[tables];
-    int tags = typeFace->getTableTags(tbTags);
-#else
-    SkFontTableTag tbTags[MAX_TAGS];
-    int tags = std::min(typeFace->readTableTags(tbTags), MAX_TAGS);
-#endif
-    bool haveCmap = false;
-    unsigned char *cmaps = nullptr;
 
-    // Find the "cmap" and the "glyph" tables and get them
-    for (int i = 0; i < tags; i++)
+    std::shared_ptr<FONT_CMAP_t> cmap = std::make_shared<FONT_CMAP_t>();
+    cmap->data.resize(tbSize);
+
+    if (typeFace->getTableData(FTABLE_cmap, 0, tbSize, cmap->data.data()) != tbSize)
     {
-        SkFontTableTag fttg = tbTags[i];
+        MSG_ERROR("Error reading the CMAP table!");
+        return nullptr;
+    }
 
-        if (fttg == FTABLE_cmap)
-        {
-            size_t tbSize = typeFace->getTableSize(fttg);
+    parseCmap(cmap->data.data(), cmap->table);
+    cmap->type = FT_NORMAL;
 
-            if (!tbSize)
-            {
-                MSG_ERROR("CMAP font table size is 0!");
-#if SKIAV < 20250812
-                delete[] tbTags;
-#endif
-                return nullptr;
-            }
+    for (uint16_t nTbs = 0; nTbs < cmap->table.numSubtables; nTbs++)
+    {
+        const FTABLE_SUBTABLE_t& st = cmap->table.subtables[nTbs];
 
-            cmaps = new unsigned char[tbSize];
-            typeFace->getTableData(fttg, 0, tbSize, cmaps);
-            haveCmap = true;
+        if (st.platformID == FTABLE_PID_MICROSOFT && st.platformSpecificID == FTABLE_SID_MSC_SYMBOL)
+        {
+            cmap->type = FT_SYM_MS;
+            break;
+        }
+        else if (st.platformID == FTABLE_PID_UNICODE && st.platformSpecificID == FTABLE_SID_UNI_VERSION1)
+        {
+            cmap->type = FT_SYMBOL;
             break;
         }
     }
 
-    if (!haveCmap)
-    {
-        MSG_ERROR("Invalid font. Missing CMAP table!");
-#if SKIAV < 20250812
-        delete[] tbTags;
-#endif
-        return nullptr;
-    }
-#if SKIAV < 20250812
-    delete[] tbTags;
-#endif
-    parseCmap(cmaps);
-
-    std::wstring_convert<std::codecvt_utf8_utf16<char16_t>,char16_t> convert;
-    std::u16string dest = convert.from_bytes(str);
-    SkGlyphID *gIds = new SkGlyphID[dest.length()];
-    *size = dest.length();
+    _cmapCache.insert(pair<SkTypefaceID, std::shared_ptr<FONT_CMAP_t> >(id, cmap));
+    return cmap;
+}
 
-    for (size_t i = 0; i < dest.length(); i++)
-    {
-        SkUnichar uniChar = (SkUnichar)dest[i];
-        gIds[i] = getGlyphIndex(uniChar);
-    }
+FONT_CMAP_STATS_t TFont::getCmapStatistics()
+{
+    DECL_TRACER("TFont::getCmapStatistics()");
 
-    _freeCmap();
-    delete[] cmaps;
+    FONT_CMAP_STATS_t stats;
+    stats.hits = _cmapHits;
+    stats.misses = _cmapMisses;
+    stats.glyphs = _cmapGlyphs;
+    stats.glyphHits = _cmapGlyphHits;
 
-    return gIds;
+    std::lock_guard<mutex> guard(mutex_cmap);
+    stats.typefaces = _cmapCache.size();
+    return stats;
 }
 
-FONT_TYPE TFont::isSymbol(sk_sp<SkTypeface>& typeFace)
+SkGlyphID *TFont::textToGlyphs(const string& str, sk_sp<SkTypeface>& typeFace, size_t *size)
 {
-    DECL_TRACER("TFont::isSymbol(sk_sp<SkTypeface>& typeFace)");
+    DECL_TRACER("TFont::textToGlyphs(const string& str, SkTypeface& typeFace)");
 
-    if (!typeFace)
-    {
-        MSG_ERROR("Got an empty typeface!");
-        return FT_UNKNOWN;
-    }
+    *size = 0;
+    std::shared_ptr<FONT_CMAP_t> cmap = getCmap(typeFace);
 
-    mutex_font.lock();
-    int tables = typeFace->countTables();
+    if (!cmap)
+        return nullptr;
 
-    if (tables <= 0)
-    {
-        MSG_ERROR("No tables found in typeface!");
-        mutex_font.unlock();
-        return FT_UNKNOWN;
-    }
-#if SKIAV < 20250812
-    SkFontTableTag *tbTags = new SkFontTableTag[tables];
-    int tags = typeFace->getTableTags(tbTags);
-#else
-    SkFontTableTag tbTags[MAX_TAGS];
-    int tags = std::min(typeFace->readTableTags(tbTags), MAX_TAGS);
-#endif
-    bool haveCmap = false;
-    unsigned char *cmaps = nullptr;
+    std::wstring_convert<std::codecvt_utf8_utf16<char16_t>,char16_t> convert;
+    std::u16string dest = convert.from_bytes(str);
+    SkGlyphID *gIds = new SkGlyphID[dest.length()];
+    *size = dest.length();
+    _cmapGlyphs += dest.length();
 
-    // Find the "cmap" table and get it
-    for (int i = 0; i < tags; i++)
+    for (size_t i = 0; i < dest.length(); i++)
     {
-        SkFontTableTag fttg = tbTags[i];
+        SkUnichar uniChar = (SkUnichar)dest[i];
 
-        if (fttg == FTABLE_cmap)
+        // The glyph indexes of the first characters are cached. Two threads
+        // may calculate the same index at the same time. Because the result
+        // is always the same, this doesn't matter.
+        if (uniChar >= 0 && uniChar < CMAP_GLYPH_CACHE)
         {
-            size_t tbSize = typeFace->getTableSize(fttg);
+            uint32_t cached = cmap->glyphs[uniChar].load(std::memory_order_relaxed);
 
-            if (!tbSize)
+            if (cached & CMAP_GLYPH_KNOWN)
             {
-                MSG_ERROR("CMAP table has size of 0!");
-#if SKIAV < 20250812
-                delete[] tbTags;
-#endif
-                mutex_font.unlock();
-                return FT_UNKNOWN;
+                gIds[i] = static_cast<SkGlyphID>(cached & 0xffff);
+                _cmapGlyphHits++;
+                continue;
             }
 
-            cmaps = new unsigned char[tbSize];
-            typeFace->getTableData(fttg, 0, tbSize, cmaps);
-            haveCmap = true;
-            break;
+            gIds[i] = getGlyphIndex(cmap->table, uniChar);
+            cmap->glyphs[uniChar].store(gIds[i] | CMAP_GLYPH_KNOWN, std::memory_order_relaxed);
         }
+        else
+            gIds[i] = getGlyphIndex(cmap->table, uniChar);
     }
 
-    if (!haveCmap)
-    {
-        MSG_ERROR("Invalid font. Missing CMAP table!");
-#if SKIAV < 20250812
-        delete[] tbTags;
-#endif
-        mutex_font.unlock();
-        return FT_UNKNOWN;
-    }
-#if SKIAV < 20250812
-    delete[] tbTags;
-#endif
-    parseCmap(cmaps);
+    return gIds;
+}
 
-    for (uint16_t nTbs = 0; nTbs < _cmapTable.numSubtables; nTbs++)
-    {
-        if ((_cmapTable.subtables[nTbs].platformID == FTABLE_PID_UNICODE && _cmapTable.subtables[nTbs].platformSpecificID == FTABLE_SID_UNI_VERSION1) ||
-            (_cmapTable.subtables[nTbs].platformID == FTABLE_PID_MICROSOFT && _cmapTable.subtables[nTbs].platformSpecificID == FTABLE_SID_MSC_SYMBOL))
-        {
-            _freeCmap();
-            delete[] cmaps;
-            FONT_TYPE ft = FT_SYMBOL;
+FONT_TYPE TFont::isSymbol(sk_sp<SkTypeface>& typeFace)
+{
+    DECL_TRACER("TFont::isSymbol(sk_sp<SkTypeface>& typeFace)");
 
-            if (_cmapTable.subtables[nTbs].platformID == FTABLE_PID_MICROSOFT && _cmapTable.subtables[nTbs].platformSpecificID == FTABLE_SID_MSC_SYMBOL)
-                ft = FT_SYM_MS;
+    std::shared_ptr<FONT_CMAP_t> cmap = getCmap(typeFace);
 
-            mutex_font.unlock();
-            return ft;
-        }
-    }
+    if (!cmap)
+        return FT_UNKNOWN;
 
-    _freeCmap();
-    delete[] cmaps;
-    mutex_font.unlock();
-    return FT_NORMAL;
+    return cmap->type;
 }
 
 size_t TFont::utf8ToUtf16(const string& str, uint16_t **uni, bool toSymbol)
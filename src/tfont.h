@@ -21,6 +21,8 @@
 
 #include <string>
 #include <map>
+#include <memory>
+#include <cstdint>
 
 #include "tvalidatefile.h"
 
@@ -57,6 +59,18 @@ typedef enum FONT_TYPE
     FT_SYM_MS       // Proprietary Microsoft symbol font
 }FONT_TYPE;
 
+typedef struct FONT_CMAP_STATS_t
+{
+    uint64_t hits{0};           // Number of lookups finding the parsed cmap table in the cache
+    uint64_t misses{0};         // Number of cmap tables parsed
+    uint64_t glyphs{0};         // Number of converted characters
+    uint64_t glyphHits{0};      // Number of characters found in the glyph index cache
+    size_t typefaces{0};        // Number of typefaces in the cache
+}FONT_CMAP_STATS_t;
+
+struct FONT_CMAP_t;
+struct FTABLE_CMAP_t;
+
 class TFont : public TValidateFile
 {
     public:
@@ -80,11 +94,12 @@ class TFont : public TValidateFile
         static FONT_TYPE isSymbol(sk_sp<SkTypeface>& typeFace);
         static size_t utf8ToUtf16(const std::string& str, uint16_t **uni, bool toSymbol = false);
         static double pixelToPoint(int dpi, int pixel);
+        static FONT_CMAP_STATS_t getCmapStatistics();
 
     private:
-        static void parseCmap(const unsigned char *cmaps);
-        static uint16_t getGlyphIndex(SkUnichar);
-        static void _freeCmap();
+        static std::shared_ptr<FONT_CMAP_t> getCmap(sk_sp<SkTypeface>& typeFace);
+        static void parseCmap(const unsigned char *cmaps, FTABLE_CMAP_t& table);
+        static uint16_t getGlyphIndex(const FTABLE_CMAP_t& table, SkUnichar ch);
 
         std::map<int, FONT_T> mFonts;
         bool mIsG5{false};
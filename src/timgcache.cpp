@@ -23,11 +23,16 @@
 #include "tconfig.h"
 
 using std::string;
-using std::vector;
+using std::list;
+using std::unordered_map;
 using std::mutex;
+using std::lock_guard;
 
-vector<_IMGCACHE> TImgCache::mImgCache;
+list<_IMGCACHE> TImgCache::mImgCache;
+unordered_map<string, TImgCache::CACHE_ITER> TImgCache::mNameIndex[_BMTYPE_MAX];
+unordered_map<uint32_t, TImgCache::CACHE_ITER> TImgCache::mHandleIndex;
 size_t TImgCache::size{0};
+_IMGCACHE_STATS TImgCache::mStats;
 
 mutex _imgCache;
 
@@ -45,7 +50,7 @@ bool TImgCache::addImage(const string& name, SkBitmap& bm, _IMGCACHE_BMTYPE bmTy
     if (name.empty() || bm.empty())
         return false;
 
-    _imgCache.lock();
+    lock_guard<mutex> guard(_imgCache);
     _IMGCACHE ic;
 
     ic.name = name;
@@ -53,9 +58,7 @@ bool TImgCache::addImage(const string& name, SkBitmap& bm, _IMGCACHE_BMTYPE bmTy
     ic.bitmap = bm;
     ic.handle = 0;
 
-    bool ret = addImage(ic);
-    _imgCache.unlock();
-    return ret;
+    return addImage(ic);
 }
 
 bool TImgCache::addImage(const string& name, SkBitmap& bm, ulong handle, _IMGCACHE_BMTYPE bmType)
@@ -65,7 +68,7 @@ bool TImgCache::addImage(const string& name, SkBitmap& bm, ulong handle, _IMGCAC
     if (bm.empty() || handle == 0)
         return false;
 
-    _imgCache.lock();
+    lock_guard<mutex> guard(_imgCache);
     _IMGCACHE ic;
 
     if (name.empty())
@@ -77,38 +80,37 @@ bool TImgCache::addImage(const string& name, SkBitmap& bm, ulong handle, _IMGCAC
     ic.bitmap = bm;
     ic.handle = static_cast<uint32_t>(handle);
 
-    bool ret = addImage(ic);
-    _imgCache.unlock();
-    return ret;
+    return addImage(ic);
 }
 
 bool TImgCache::addImage(_IMGCACHE ic)
 {
     DECL_TRACER("TImgCache::addImage(_IMGCACHE ic)");
 
-    if (mImgCache.size() == 0)
-    {
-        mImgCache.push_back(ic);
-        size += sizeof(_IMGCACHE);
-        MSG_DEBUG("Bitmap \"" << ic.name << "\" was freshly added.");
-        return true;
-    }
+    if (ic.bmType < _BMTYPE_NONE || ic.bmType >= _BMTYPE_MAX)
+        return false;
 
-    vector<_IMGCACHE>::iterator iter;
+    unordered_map<string, CACHE_ITER>& index = mNameIndex[ic.bmType];
 
-    for (iter = mImgCache.begin(); iter != mImgCache.end(); ++iter)
+    if (index.find(ic.name) != index.end())
     {
-        if (iter->name == ic.name)
-        {
-            MSG_DEBUG("Bitmap \"" << ic.name << "\" already in cache.");
-            return true;
-        }
+        MSG_DEBUG("Bitmap \"" << ic.name << "\" already in cache.");
+        return true;
     }
 
     // Here we know that the image is not yet in the cache. So we add it now.
-    mImgCache.push_back(ic);
-    size += sizeof(_IMGCACHE);
-    MSG_DEBUG("Bitmap \"" << ic.name << "\" was added.");
+    ic.bytes = ic.bitmap.computeByteSize();
+    mImgCache.push_front(ic);
+    CACHE_ITER iter = mImgCache.begin();
+    index.emplace(iter->name, iter);
+
+    if (iter->handle)
+        mHandleIndex.emplace(iter->handle, iter);
+
+    size += iter->bytes;
+    mStats.poolEntries[iter->bmType]++;
+    mStats.poolBytes[iter->bmType] += iter->bytes;
+    MSG_DEBUG("Bitmap \"" << iter->name << "\" with " << iter->bytes << " bytes was added.");
 
     if (size > TConfig::getButttonCache())
         shrinkCache();
@@ -120,102 +122,100 @@ bool TImgCache::getBitmap(const string& name, SkBitmap *bm, _IMGCACHE_BMTYPE bmT
 {
     DECL_TRACER("TImgCache::getBitmap(const string& name, SkBitmap *bm, _IMGCACHE_BMTYPE bmType, int *width, int *height)");
 
-    if (mImgCache.size() == 0 || !bm)
+    if (width)
+        *width = 0;
+
+    if (height)
+        *height = 0;
+
+    if (!bm)
         return false;
 
-    vector<_IMGCACHE>::iterator iter;
+    lock_guard<mutex> guard(_imgCache);
+    CACHE_ITER iter;
 
-    for (iter = mImgCache.begin(); iter != mImgCache.end(); ++iter)
+    if (bmType >= _BMTYPE_MAX || !findName(name, bmType, &iter) || iter->bmType != bmType)
     {
-        if (iter->name == name && iter->bmType == bmType)
-        {
-            *bm = iter->bitmap;
+        mStats.misses++;
 
-            if (width && !iter->bitmap.empty())
-                *width = iter->bitmap.info().width();
-            else if (width)
-                *width = 0;
+        if (bmType < _BMTYPE_MAX)
+            mStats.poolMisses[bmType]++;
 
-            if (height && !iter->bitmap.empty())
-                *height = iter->bitmap.info().height();
-            else if (height)
-                *height = 0;
-
-            MSG_DEBUG("Bitmap \"" << iter->name << "\" was found.");
-            return true;
-        }
+        return false;
     }
 
-    if (width)
-        *width = 0;
+    *bm = iter->bitmap;
 
-    if (height)
-        *height = 0;
+    if (width && !iter->bitmap.empty())
+        *width = iter->bitmap.info().width();
 
-    return false;
+    if (height && !iter->bitmap.empty())
+        *height = iter->bitmap.info().height();
+
+    touch(iter);
+    mStats.hits++;
+    mStats.poolHits[iter->bmType]++;
+    MSG_DEBUG("Bitmap \"" << iter->name << "\" was found.");
+    return true;
 }
 
 bool TImgCache::getBitmap(SkBitmap *bm, ulong handle, int *width, int *height, _IMGCACHE_BMTYPE bmType)
 {
     DECL_TRACER("TImgCache::getBitmap(SkBitmap *bm, uint32_t handle, int *width, int *height, _IMGCACHE_BMTYPE bmType)");
 
-    if (mImgCache.size() == 0 || !bm || handle == 0)
+    if (!bm || handle == 0)
         return false;
 
-    vector<_IMGCACHE>::iterator iter;
+    lock_guard<mutex> guard(_imgCache);
+    CACHE_ITER iter;
 
-    for (iter = mImgCache.begin(); iter != mImgCache.end(); ++iter)
+    if (!findHandle(handle, bmType, &iter))
     {
-        if (iter->handle == handle)
-        {
-            if (bmType != _BMTYPE_NONE && iter->bmType != bmType)
-                return false;
+        if (width)
+            *width = 0;
 
-            *bm = iter->bitmap;
+        if (height)
+            *height = 0;
 
-            if (width && !iter->bitmap.empty())
-                *width = iter->bitmap.info().width();
+        mStats.misses++;
 
-            if (height && !iter->bitmap.empty())
-                *height = iter->bitmap.info().height();
+        if (bmType < _BMTYPE_MAX)
+            mStats.poolMisses[bmType]++;
 
-            MSG_DEBUG("Bitmap \"" << iter->name << "\" was found.");
-            return true;
-        }
+        return false;
     }
 
-    if (width)
-        *width = 0;
+    *bm = iter->bitmap;
 
-    if (height)
-        *height = 0;
+    if (width && !iter->bitmap.empty())
+        *width = iter->bitmap.info().width();
 
-    return false;
+    if (height && !iter->bitmap.empty())
+        *height = iter->bitmap.info().height();
+
+    touch(iter);
+    mStats.hits++;
+    mStats.poolHits[iter->bmType]++;
+    MSG_DEBUG("Bitmap \"" << iter->name << "\" was found.");
+    return true;
 }
 
 bool TImgCache::delBitmap(const string& name, _IMGCACHE_BMTYPE bmType)
 {
     DECL_TRACER("TImgCache::delBitmap(const string& name, _IMGCACHE_BMTYPE bmType)");
 
-    if (name.empty() || mImgCache.size() == 0)
+    if (name.empty() || bmType >= _BMTYPE_MAX)
         return false;
 
-    _imgCache.lock();
-    vector<_IMGCACHE>::iterator iter;
+    lock_guard<mutex> guard(_imgCache);
+    unordered_map<string, CACHE_ITER>::iterator idx = mNameIndex[bmType].find(name);
 
-    for (iter = mImgCache.begin(); iter != mImgCache.end(); ++iter)
-    {
-        if (iter->name == name && iter->bmType == bmType)
-        {
-            MSG_DEBUG("Bitmap \"" << iter->name << "\" will be erased.");
-            mImgCache.erase(iter);
-            _imgCache.unlock();
-            return true;
-        }
-    }
+    if (idx == mNameIndex[bmType].end())
+        return false;
 
-    _imgCache.unlock();
-    return false;
+    MSG_DEBUG("Bitmap \"" << name << "\" will be erased.");
+    erase(idx->second);
+    return true;
 }
 
 bool TImgCache::delBitmap(ulong handle, _IMGCACHE_BMTYPE bmType)
@@ -225,44 +225,34 @@ bool TImgCache::delBitmap(ulong handle, _IMGCACHE_BMTYPE bmType)
     if (!handle)
         return false;
 
-    _imgCache.lock();
-    vector<_IMGCACHE>::iterator iter;
+    lock_guard<mutex> guard(_imgCache);
+    CACHE_ITER iter;
 
-    for (iter = mImgCache.begin(); iter != mImgCache.end(); ++iter)
-    {
-        if (iter->handle == handle)
-        {
-            if (bmType != _BMTYPE_NONE && iter->bmType != bmType)
-                return false;
-
-            MSG_DEBUG("Bitmap \"" << iter->name << "\" will be erased.");
-            mImgCache.erase(iter);
-            size -= sizeof(_IMGCACHE);
-            _imgCache.unlock();
-            return true;
-        }
-    }
+    if (!findHandle(handle, bmType, &iter))
+        return false;
 
-    _imgCache.unlock();
-    return false;
+    MSG_DEBUG("Bitmap \"" << iter->name << "\" will be erased.");
+    erase(iter);
+    return true;
 }
 
 bool TImgCache::existBitmap(const string& name, _IMGCACHE_BMTYPE bmType)
 {
     DECL_TRACER("TImgCache::existBitmap(const string& name, _IMGCACHE_BMTYPE bmType)");
 
-    if (mImgCache.size() == 0)
+    if (bmType >= _BMTYPE_MAX)
         return false;
 
-    vector<_IMGCACHE>::iterator iter;
+    lock_guard<mutex> guard(_imgCache);
+    unordered_map<string, CACHE_ITER>::iterator idx = mNameIndex[bmType].find(name);
 
-    for (iter = mImgCache.begin(); iter != mImgCache.end(); ++iter)
-    {
-        if (iter->name == name && iter->bmType == bmType)
-            return true;
-    }
+    if (idx == mNameIndex[bmType].end())
+        return false;
 
-    return false;
+    // An image asked for will be used soon. Therefore it is marked as
+    // used to prevent it from being removed in the meantime.
+    touch(idx->second);
+    return true;
 }
 
 bool TImgCache::existBitmap(ulong handle, _IMGCACHE_BMTYPE bmType)
@@ -272,20 +262,14 @@ bool TImgCache::existBitmap(ulong handle, _IMGCACHE_BMTYPE bmType)
     if (!handle)
         return false;
 
-    vector<_IMGCACHE>::iterator iter;
-
-    for (iter = mImgCache.begin(); iter != mImgCache.end(); ++iter)
-    {
-        if (iter->handle == handle)
-        {
-            if (bmType != _BMTYPE_NONE && iter->bmType != bmType)
-                return false;
+    lock_guard<mutex> guard(_imgCache);
+    CACHE_ITER iter;
 
-            return true;
-        }
-    }
+    if (!findHandle(handle, bmType, &iter))
+        return false;
 
-    return false;
+    touch(iter);
+    return true;
 }
 
 bool TImgCache::replaceBitmap(const std::string &name, SkBitmap& bm, _IMGCACHE_BMTYPE bmType)
@@ -295,30 +279,19 @@ bool TImgCache::replaceBitmap(const std::string &name, SkBitmap& bm, _IMGCACHE_B
     if (name.empty() || bm.empty())
         return false;
 
-    _imgCache.lock();
-    vector<_IMGCACHE>::iterator iter;
+    lock_guard<mutex> guard(_imgCache);
+    CACHE_ITER iter;
 
-    for (iter = mImgCache.begin(); iter != mImgCache.end(); ++iter)
-    {
-        if (iter->name == name)
-        {
-            if (bmType != _BMTYPE_NONE && iter->bmType != bmType)
-            {
-                _imgCache.unlock();
-                return false;
-            }
-
-            _IMGCACHE ic = *iter;
-            ic.bitmap = bm;
-            mImgCache.erase(iter);
-            mImgCache.push_back(ic);
-            _imgCache.unlock();
-            return true;
-        }
-    }
+    if (!findName(name, bmType, &iter))
+        return false;
 
-    _imgCache.unlock();
-    return false;
+    setBitmap(iter, bm);
+    touch(iter);
+
+    if (size > TConfig::getButttonCache())
+        shrinkCache();
+
+    return true;
 }
 
 bool TImgCache::replaceBitmap(ulong handle, SkBitmap& bm, _IMGCACHE_BMTYPE bmType)
@@ -328,48 +301,159 @@ bool TImgCache::replaceBitmap(ulong handle, SkBitmap& bm, _IMGCACHE_BMTYPE bmTyp
     if (handle == 0 || bm.empty())
         return false;
 
-    _imgCache.lock();
-    vector<_IMGCACHE>::iterator iter;
+    lock_guard<mutex> guard(_imgCache);
+    CACHE_ITER iter;
+
+    if (!findHandle(handle, bmType, &iter))
+        return false;
+
+    setBitmap(iter, bm);
+    touch(iter);
+
+    if (size > TConfig::getButttonCache())
+        shrinkCache();
+
+    return true;
+}
 
-    for (iter = mImgCache.begin(); iter != mImgCache.end(); ++iter)
+_IMGCACHE_STATS TImgCache::getStatistics()
+{
+    DECL_TRACER("TImgCache::getStatistics()");
+
+    lock_guard<mutex> guard(_imgCache);
+    _IMGCACHE_STATS stats = mStats;
+    stats.entries = mImgCache.size();
+    stats.bytes = size;
+    stats.maxBytes = TConfig::getButttonCache();
+    return stats;
+}
+
+void TImgCache::logStatistics()
+{
+    DECL_TRACER("TImgCache::logStatistics()");
+
+    static const char *names[_BMTYPE_MAX] = { "none", "chameleon", "bitmap", "icon", "URL", "border", "frame" };
+    _IMGCACHE_STATS stats = getStatistics();
+
+    MSG_INFO("Image cache: " << stats.entries << " images, " << stats.bytes << " of " << stats.maxBytes << " bytes, " << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions << " evictions");
+
+    for (int i = 0; i < _BMTYPE_MAX; ++i)
     {
-        if (iter->handle == handle)
+        uint64_t lookups = stats.poolHits[i] + stats.poolMisses[i];
+
+        if (!lookups && !stats.poolEntries[i])
+            continue;
+
+        MSG_INFO("Image cache " << names[i] << ": " << stats.poolEntries[i] << " images, " << stats.poolBytes[i] << " bytes, hit rate " << (lookups ? stats.poolHits[i] * 100 / lookups : 0) << "% of " << lookups << " lookups");
+    }
+}
+
+/*
+ * Looks for an image with the name \p name. If \p bmType is _BMTYPE_NONE
+ * and there is no image of this type, all other types are searched too.
+ * The caller must hold the lock.
+ */
+bool TImgCache::findName(const string& name, _IMGCACHE_BMTYPE bmType, CACHE_ITER *iter)
+{
+    DECL_TRACER("TImgCache::findName(const string& name, _IMGCACHE_BMTYPE bmType, CACHE_ITER *iter)");
+
+    if (name.empty() || bmType >= _BMTYPE_MAX)
+        return false;
+
+    unordered_map<string, CACHE_ITER>::iterator idx = mNameIndex[bmType].find(name);
+
+    if (idx != mNameIndex[bmType].end())
+    {
+        *iter = idx->second;
+        return true;
+    }
+
+    if (bmType != _BMTYPE_NONE)
+        return false;
+
+    for (int i = _BMTYPE_NONE + 1; i < _BMTYPE_MAX; ++i)
+    {
+        if ((idx = mNameIndex[i].find(name)) != mNameIndex[i].end())
         {
-            if (bmType != _BMTYPE_NONE && iter->bmType != bmType)
-            {
-                _imgCache.unlock();
-                return false;
-            }
-
-            _IMGCACHE ic = *iter;
-            ic.bitmap = bm;
-            mImgCache.erase(iter);
-            mImgCache.push_back(ic);
-            _imgCache.unlock();
+            *iter = idx->second;
             return true;
         }
     }
 
-    _imgCache.unlock();
     return false;
 }
 
+/*
+ * Looks for an image with the handle \p handle. If \p bmType is not
+ * _BMTYPE_NONE, the image must be of this type.
+ * The caller must hold the lock.
+ */
+bool TImgCache::findHandle(ulong handle, _IMGCACHE_BMTYPE bmType, CACHE_ITER *iter)
+{
+    DECL_TRACER("TImgCache::findHandle(ulong handle, _IMGCACHE_BMTYPE bmType, CACHE_ITER *iter)");
+
+    unordered_map<uint32_t, CACHE_ITER>::iterator idx = mHandleIndex.find(static_cast<uint32_t>(handle));
+
+    if (idx == mHandleIndex.end())
+        return false;
+
+    if (bmType != _BMTYPE_NONE && idx->second->bmType != bmType)
+        return false;
+
+    *iter = idx->second;
+    return true;
+}
+
+void TImgCache::touch(CACHE_ITER iter)
+{
+    // Splicing doesn't invalidate the iterators in the indexes.
+    if (iter != mImgCache.begin())
+        mImgCache.splice(mImgCache.begin(), mImgCache, iter);
+}
+
+void TImgCache::erase(CACHE_ITER iter)
+{
+    mNameIndex[iter->bmType].erase(iter->name);
+
+    if (iter->handle)
+    {
+        unordered_map<uint32_t, CACHE_ITER>::iterator idx = mHandleIndex.find(iter->handle);
+
+        if (idx != mHandleIndex.end() && idx->second == iter)
+            mHandleIndex.erase(idx);
+    }
+
+    size -= iter->bytes;
+    mStats.poolEntries[iter->bmType]--;
+    mStats.poolBytes[iter->bmType] -= iter->bytes;
+    mImgCache.erase(iter);
+}
+
+void TImgCache::setBitmap(CACHE_ITER iter, SkBitmap& bm)
+{
+    size_t bytes = bm.computeByteSize();
+    size = size - iter->bytes + bytes;
+    mStats.poolBytes[iter->bmType] = mStats.poolBytes[iter->bmType] - iter->bytes + bytes;
+    iter->bitmap = bm;
+    iter->bytes = bytes;
+}
+
 void TImgCache::shrinkCache()
 {
     DECL_TRACER("TImgCache::shrinkCache()");
 
-    if (mImgCache.size() == 0)
-        return;
-
     size_t s = TConfig::getButttonCache();
 
-    if (s > size || s <= sizeof(_IMGCACHE))
+    if (s == 0 || s >= size)
         return;
 
-    while (size > s && mImgCache.size() > 0)
+    // The most recently used image is never removed, because it is usualy
+    // requested immediately after it was added.
+    while (size > s && mImgCache.size() > 1)
     {
-        MSG_DEBUG("Erasing image " << mImgCache.begin()->name << " -- Size: " << size);
-        mImgCache.erase(mImgCache.begin());
-        size -= sizeof(_IMGCACHE);
+        CACHE_ITER iter = std::prev(mImgCache.end());
+        MSG_DEBUG("Erasing image " << iter->name << " -- Size: " << size);
+        erase(iter);
+        mStats.evictions++;
     }
 }
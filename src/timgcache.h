@@ -20,7 +20,8 @@
 #define __TIMGCACHE_H__
 
 #include <string>
-#include <vector>
+#include <list>
+#include <unordered_map>
 
 #include <include/core/SkBitmap.h>
 
@@ -34,7 +35,10 @@ typedef enum _IMGCACHE_BMTYPE
     _BMTYPE_CHAMELEON,
     _BMTYPE_BITMAP,
     _BMTYPE_ICON,
-    _BMTYPE_URL
+    _BMTYPE_URL,
+    _BMTYPE_BORDER,     // Colorized border fragment
+    _BMTYPE_FRAME,      // Assembled border frame of a given size
+    _BMTYPE_MAX         // Number of types; must be the last element
 }_IMGCACHE_BMTYPE;
 
 typedef struct _IMGCACHE
@@ -43,8 +47,32 @@ typedef struct _IMGCACHE
     std::string name;
     SkBitmap bitmap;
     uint32_t handle{0};
+    size_t bytes{0};                // The size of the pixels in bytes
 }_IMGCACHE;
 
+typedef struct _IMGCACHE_STATS
+{
+    size_t entries{0};              // Number of images in the cache
+    size_t bytes{0};                // Number of bytes used by the pixels of all images
+    size_t maxBytes{0};             // The configured maximum size of the cache
+    size_t poolEntries[_BMTYPE_MAX] = {0};  // Number of images for each type
+    size_t poolBytes[_BMTYPE_MAX] = {0};    // Number of bytes for each type
+    uint64_t hits{0};               // Number of successfull lookups
+    uint64_t misses{0};             // Number of failed lookups
+    uint64_t poolHits[_BMTYPE_MAX] = {0};   // Number of successfull lookups for each type
+    uint64_t poolMisses[_BMTYPE_MAX] = {0}; // Number of failed lookups for each type
+    uint64_t evictions{0};          // Number of images removed because the cache was full
+}_IMGCACHE_STATS;
+
+/**
+ * @brief The TImgCache class
+ * This class holds the images of the buttons. It is a LRU (least recently
+ * used) cache. Each image type (chameleon, bitmap, icon, URL) has it's own
+ * index, so the same file may be cached as different types. The size of the
+ * cache is the real number of bytes of the pixels. If the size grows over the
+ * configured limit (TConfig::getButttonCache()), the least recently used
+ * images are removed.
+ */
 class TImgCache
 {
     public:
@@ -58,12 +86,21 @@ class TImgCache
         static bool existBitmap(ulong handle, _IMGCACHE_BMTYPE bmType=_BMTYPE_NONE);
         static bool replaceBitmap(const std::string& name, SkBitmap& bm, _IMGCACHE_BMTYPE bmType=_BMTYPE_NONE);
         static bool replaceBitmap(ulong handle, SkBitmap& bm, _IMGCACHE_BMTYPE bmType=_BMTYPE_NONE);
+        static _IMGCACHE_STATS getStatistics();
+        static void logStatistics();
 
     protected:
         static bool addImage(_IMGCACHE ic);
 
     private:
+        typedef std::list<_IMGCACHE>::iterator CACHE_ITER;
+
         static void shrinkCache();
+        static bool findName(const std::string& name, _IMGCACHE_BMTYPE bmType, CACHE_ITER *iter);
+        static bool findHandle(ulong handle, _IMGCACHE_BMTYPE bmType, CACHE_ITER *iter);
+        static void touch(CACHE_ITER iter);
+        static void erase(CACHE_ITER iter);
+        static void setBitmap(CACHE_ITER iter, SkBitmap& bm);
         // This should never be used
         TImgCache() {}
         ~TImgCache();
@@ -76,8 +113,11 @@ class TImgCache
         }
 
         // Internal variables
-        static std::vector<_IMGCACHE> mImgCache;
+        static std::list<_IMGCACHE> mImgCache;     // The images; the most recently used image is at the front
+        static std::unordered_map<std::string, CACHE_ITER> mNameIndex[_BMTYPE_MAX];  // Index of names; one for each type
+        static std::unordered_map<uint32_t, CACHE_ITER> mHandleIndex;               // Index of handles
         static size_t size;
+        static _IMGCACHE_STATS mStats;
         SkBitmap mDummyBM;
 };
 
@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+
+#include <mutex>
+
+#include <sys/stat.h>
+
+#include <include/core/SkData.h>
+
+#include "timgsource.h"
+#include "tresources.h"
+#include "tthreadpool.h"
+#include "tconfig.h"
+#include "terror.h"
+
+using std::string;
+using std::vector;
+using std::list;
+using std::deque;
+using std::unordered_map;
+using std::unordered_set;
+using std::mutex;
+using std::lock_guard;
+
+extern bool prg_stopped;
+
+list<TImgSource::SOURCE_t> TImgSource::mCache;
+unordered_map<string, TImgSource::CACHE_ITER> TImgSource::mIndex;
+deque<string> TImgSource::mPrefetch;
+unordered_set<string> TImgSource::mPending;
+bool TImgSource::mPrefetchRunning{false};
+size_t TImgSource::mSize{0};
+_IMGSOURCE_STATS TImgSource::mStats;
+
+mutex _imgSource;
+
+bool TImgSource::getBitmap(const string& fname, SkBitmap *bm)
+{
+    DECL_TRACER("TImgSource::getBitmap(const string& fname, SkBitmap *bm)");
+
+    if (fname.empty() || !bm)
+    {
+        MSG_ERROR("TImgSource::getBitmap: Empty file name!");
+        TError::SetError();
+        return false;
+    }
+
+    SOURCE_t src;
+
+    if (!fileInfo(fname, &src))
+    {
+        MSG_ERROR("TImgSource::getBitmap: Error loading the image \"" << fname << "\"");
+        TError::SetError();
+        return false;
+    }
+
+    if (lookup(src, bm))
+        return true;
+
+    if (!decode(fname, &src))
+        return false;
+
+    *bm = src.bitmap;
+    insert(src);
+    return true;
+}
+
+void TImgSource::prefetch(const vector<string>& files)
+{
+    DECL_TRACER("TImgSource::prefetch(const vector<string>& files)");
+
+    if (TConfig::getImageCache() == 0)
+        return;
+
+    {
+        lock_guard<mutex> guard(_imgSource);
+
+        for (const string& fname : files)
+        {
+            if (fname.empty() || mPending.count(fname))
+                continue;
+
+            mPending.insert(fname);
+            mPrefetch.push_back(fname);
+        }
+
+        if (mPrefetchRunning || mPrefetch.empty())
+            return;
+
+        mPrefetchRunning = true;
+    }
+
+    if (!TThreadPool::post("prefetch images", &TImgSource::runPrefetch))
+    {
+        lock_guard<mutex> guard(_imgSource);
+        mPrefetch.clear();
+        mPending.clear();
+        mPrefetchRunning = false;
+    }
+}
+
+void TImgSource::clear()
+{
+    DECL_TRACER("TImgSource::clear()");
+
+    lock_guard<mutex> guard(_imgSource);
+    mCache.clear();
+    mIndex.clear();
+    mPrefetch.clear();
+    mPending.clear();
+    mSize = 0;
+}
+
+_IMGSOURCE_STATS TImgSource::getStatistics()
+{
+    DECL_TRACER("TImgSource::getStatistics()");
+
+    lock_guard<mutex> guard(_imgSource);
+    _IMGSOURCE_STATS stats = mStats;
+    stats.entries = mCache.size();
+    stats.bytes = mSize;
+    stats.maxBytes = TConfig::getImageCache();
+    return stats;
+}
+
+void TImgSource::logStatistics()
+{
+    DECL_TRACER("TImgSource::logStatistics()");
+
+    _IMGSOURCE_STATS stats = getStatistics();
+    uint64_t lookups = stats.hits + stats.misses;
+
+    MSG_INFO("Source image cache: " << stats.entries << " images, " << stats.bytes << " of " << stats.maxBytes << " bytes, hit rate " << (lookups ? stats.hits * 100 / lookups : 0) << "% of " << lookups << " lookups, " << stats.stale << " changed files, " << stats.evictions << " evictions, " << stats.prefetched << " prefetched");
+}
+
+/*
+ * Resolves the full path of the file \p fname and reads the modification
+ * time and the size of the file into \p src.
+ */
+bool TImgSource::fileInfo(const string& fname, SOURCE_t *src)
+{
+    DECL_TRACER("TImgSource::fileInfo(const string& fname, SOURCE_t *src)");
+
+    struct stat st;
+
+    src->path = GetResourcePath(fname.c_str()).c_str();
+
+    if (stat(src->path.c_str(), &st) != 0)
+        return false;
+
+    src->mtime = st.st_mtime;
+    src->fsize = st.st_size;
+    return true;
+}
+
+bool TImgSource::decode(const string& fname, SOURCE_t *src)
+{
+    DECL_TRACER("TImgSource::decode(const string& fname, SOURCE_t *src)");
+
+    sk_sp<SkData> data = readImage(fname);
+
+    if (!data)
+        return false;
+
+    if (!DecodeDataToBitmap(data, &src->bitmap) || src->bitmap.empty())
+    {
+        MSG_WARNING("Problem while decoding image " << fname);
+        src->bitmap.reset();
+        return false;
+    }
+
+    // The pixels are shared with every caller. Skia refuses to draw into
+    // an immutable bitmap.
+    src->bitmap.setImmutable();
+    src->bytes = src->bitmap.computeByteSize();
+    return true;
+}
+
+/*
+ * Looks for the image of the file described by \p src. If the file was
+ * changed since the image was decoded, the image is removed. If \p bm is
+ * NULL, only the existence of the image is tested and the statistics are
+ * not touched.
+ */
+bool TImgSource::lookup(const SOURCE_t& src, SkBitmap *bm)
+{
+    DECL_TRACER("TImgSource::lookup(const SOURCE_t& src, SkBitmap *bm)");
+
+    lock_guard<mutex> guard(_imgSource);
+    unordered_map<string, CACHE_ITER>::iterator idx = mIndex.find(src.path);
+
+    if (idx == mIndex.end())
+    {
+        if (bm)
+            mStats.misses++;
+
+        return false;
+    }
+
+    CACHE_ITER iter = idx->second;
+
+    if (iter->mtime != src.mtime || iter->fsize != src.fsize)
+    {
+        MSG_DEBUG("Image " << src.path << " was changed.");
+        mSize -= iter->bytes;
+        mCache.erase(iter);
+        mIndex.erase(idx);
+        mStats.stale++;
+
+        if (bm)
+            mStats.misses++;
+
+        return false;
+    }
+
+    if (!bm)
+        return true;
+
+    if (iter != mCache.begin())
+        mCache.splice(mCache.begin(), mCache, iter);
+
+    *bm = iter->bitmap;
+    mStats.hits++;
+    return true;
+}
+
+void TImgSource::insert(SOURCE_t& src)
+{
+    DECL_TRACER("TImgSource::insert(SOURCE_t& src)");
+
+    if (TConfig::getImageCache() == 0 || src.bytes > TConfig::getImageCache())
+        return;
+
+    lock_guard<mutex> guard(_imgSource);
+    unordered_map<string, CACHE_ITER>::iterator idx = mIndex.find(src.path);
+
+    // Another thread may have decoded the same file in the meantime.
+    if (idx != mIndex.end())
+    {
+        mSize -= idx->second->bytes;
+        mCache.erase(idx->second);
+        mIndex.erase(idx);
+    }
+
+    mCache.push_front(src);
+    mIndex.insert({src.path, mCache.begin()});
+    mSize += src.bytes;
+    shrinkCache();
+}
+
+/*
+ * Removes the least recently used images until the size of the cache is
+ * below the limit. The caller must hold the lock.
+ */
+void TImgSource::shrinkCache()
+{
+    DECL_TRACER("TImgSource::shrinkCache()");
+
+    size_t s = TConfig::getImageCache();
+
+    while (mSize > s && mCache.size() > 1)
+    {
+        CACHE_ITER iter = std::prev(mCache.end());
+        MSG_DEBUG("Erasing source image " << iter->path << " -- Size: " << mSize);
+        mSize -= iter->bytes;
+        mIndex.erase(iter->path);
+        mCache.erase(iter);
+        mStats.evictions++;
+    }
+}
+
+/*
+ * This runs in a worker of TThreadPool. It decodes the queued files one
+ * after the other until the queue is empty.
+ */
+void TImgSource::runPrefetch()
+{
+    DECL_TRACER("TImgSource::runPrefetch()");
+
+    while (true)
+    {
+        string fname;
+
+        {
+            lock_guard<mutex> guard(_imgSource);
+
+            if (prg_stopped || mPrefetch.empty())
+            {
+                mPrefetch.clear();
+                mPending.clear();
+                mPrefetchRunning = false;
+                return;
+            }
+
+            fname = mPrefetch.front();
+            mPrefetch.pop_front();
+            mPending.erase(fname);
+        }
+
+        SOURCE_t src;
+
+        if (!fileInfo(fname, &src) || lookup(src, nullptr))
+            continue;
+
+        if (!decode(fname, &src))
+            continue;
+
+        insert(src);
+        lock_guard<mutex> guard(_imgSource);
+        mStats.prefetched++;
+    }
+}
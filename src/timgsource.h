@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+
+#ifndef __TIMGSOURCE_H__
+#define __TIMGSOURCE_H__
+
+#include <string>
+#include <vector>
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <sys/types.h>
+#include <cstdint>
+
+#include <include/core/SkBitmap.h>
+
+typedef struct _IMGSOURCE_STATS
+{
+    size_t entries{0};              // Number of decoded images in the cache
+    size_t bytes{0};                // Number of bytes used by the pixels of all images
+    size_t maxBytes{0};             // The configured maximum size of the cache
+    uint64_t hits{0};               // Number of images taken from the cache
+    uint64_t misses{0};             // Number of images which had to be decoded
+    uint64_t stale{0};              // Number of images decoded again because the file changed
+    uint64_t evictions{0};          // Number of images removed because the cache was full
+    uint64_t prefetched{0};         // Number of images decoded in advance
+}_IMGSOURCE_STATS;
+
+/**
+ * @brief The TImgSource class
+ * This class holds the decoded source images (PNG, JPEG, ...) of the pages,
+ * popups and buttons. While TImgCache holds the images of the buttons, this
+ * cache is filled with the images as they were read from the files. This way
+ * a page or popup shown again doesn't need to read and decode it's images
+ * again.
+ *
+ * An image is identified by the full path of the file. Together with the
+ * image the modification time and the size of the file is saved. If the file
+ * was changed, the image is decoded again. The cache is a LRU cache limited
+ * to the number of bytes configured with TConfig::getImageCache().
+ *
+ * The returned bitmaps share the pixels with the cache. They are marked as
+ * immutable and must never be drawn into.
+ */
+class TImgSource
+{
+    public:
+        /**
+         * Returns the decoded image of the file \p fname. If the image is
+         * not in the cache or the file was changed, it is read and decoded.
+         *
+         * @param fname The name of the file relative to the image directory.
+         * @param bm    Receives the image.
+         *
+         * @return On success TRUE is returned. If the file couldn't be read
+         * or decoded, FALSE is returned and \p bm is not changed.
+         */
+        static bool getBitmap(const std::string& fname, SkBitmap *bm);
+        /**
+         * Decodes the images in \p files in the background. Images already
+         * in the cache or waiting to be decoded are ignored. All images are
+         * decoded one after the other by a single task of TThreadPool. This
+         * way the prefetching never occupies more than one worker.
+         *
+         * @param files The names of the image files.
+         */
+        static void prefetch(const std::vector<std::string>& files);
+        static void clear();
+        static _IMGSOURCE_STATS getStatistics();
+        static void logStatistics();
+
+    private:
+        TImgSource() {}
+
+        typedef struct SOURCE_t
+        {
+            std::string path;       // The full path of the file
+            time_t mtime{0};        // The modification time of the file
+            off_t fsize{0};         // The size of the file
+            SkBitmap bitmap;        // The decoded image
+            size_t bytes{0};        // The size of the pixels in bytes
+        }SOURCE_t;
+
+        typedef std::list<SOURCE_t>::iterator CACHE_ITER;
+
+        static bool fileInfo(const std::string& fname, SOURCE_t *src);
+        static bool decode(const std::string& fname, SOURCE_t *src);
+        static bool lookup(const SOURCE_t& src, SkBitmap *bm);
+        static void insert(SOURCE_t& src);
+        static void shrinkCache();
+        static void runPrefetch();
+
+        static std::list<SOURCE_t> mCache;                          // The images; the most recently used image is at the front
+        static std::unordered_map<std::string, CACHE_ITER> mIndex;  // Index of the full paths
+        static std::deque<std::string> mPrefetch;                   // Files waiting to be decoded in the background
+        static std::unordered_set<std::string> mPending;            // The names in mPrefetch
+        static bool mPrefetchRunning;                               // TRUE = A prefetch task is posted
+        static size_t mSize;
+        static _IMGSOURCE_STATS mStats;
+};
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#include <sstream>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "tlogwriter.h"
+#include "terror.h"
+
+using std::string;
+using std::deque;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+
+std::atomic<bool> TLogWriter::mActive{false};
+std::atomic<uint64_t> TLogWriter::mDropped{0};
+uint64_t TLogWriter::mReported{0};
+bool TLogWriter::mStop{false};
+bool TLogWriter::mFlush{false};
+size_t TLogWriter::mMaxBytes{1024 * 1024};
+size_t TLogWriter::mQueuedBytes{0};
+std::chrono::milliseconds TLogWriter::mInterval{250};
+deque<string> TLogWriter::mQueue;
+mutex TLogWriter::mMutex;
+std::condition_variable TLogWriter::mCond;
+std::thread TLogWriter::mThread;
+
+namespace
+{
+    // The buffers of each thread to format the messages. A message may
+    // call a function which logs itself while the message is formatted.
+    // Therefore every nesting level has its own buffer.
+    thread_local std::vector<std::unique_ptr<std::ostringstream>> _threadBuffers;
+    thread_local size_t _threadDepth{0};
+    bool _atExitRegistered{false};
+}
+
+void TLogWriter::start(size_t maxBytes, int interval)
+{
+    lock_guard<mutex> guard(mMutex);
+
+    if (mThread.joinable())
+        return;
+
+    mMaxBytes = maxBytes;
+    mInterval = std::chrono::milliseconds(interval > 0 ? interval : 1);
+    mStop = false;
+    mFlush = false;
+
+    try
+    {
+        mThread = std::thread(&TLogWriter::run);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "ERROR: Couldn't start the thread for logging: " << e.what() << std::endl;
+        return;
+    }
+
+    // The thread must end before the static objects are destroyed.
+    if (!_atExitRegistered)
+    {
+        std::atexit(&TLogWriter::stop);
+        _atExitRegistered = true;
+    }
+
+    mActive = true;
+}
+
+void TLogWriter::stop()
+{
+    {
+        lock_guard<mutex> guard(mMutex);
+
+        if (!mThread.joinable())
+            return;
+
+        mActive = false;
+        mStop = true;
+    }
+
+    mCond.notify_all();
+
+    if (mThread.get_id() != std::this_thread::get_id())
+        mThread.join();
+    else
+        mThread.detach();
+}
+
+std::ostream& TLogWriter::stream()
+{
+    thread_local const std::ostringstream defaultFormat;
+
+    if (_threadDepth >= _threadBuffers.size())
+        _threadBuffers.push_back(std::make_unique<std::ostringstream>());
+
+    std::ostringstream& buffer = *_threadBuffers[_threadDepth];
+    _threadDepth++;
+    buffer.str(string());
+    buffer.clear();
+    buffer.copyfmt(defaultFormat);
+    return buffer;
+}
+
+void TLogWriter::commit(unsigned int level)
+{
+    if (!_threadDepth)
+        return;
+
+    _threadDepth--;
+    string line = _threadBuffers[_threadDepth]->str();
+
+    {
+        unique_lock<mutex> lock(mMutex);
+
+        if (mStop)
+        {
+            // The writer has already terminated. Therefore the message is
+            // written directly.
+            lock.unlock();
+            deque<string> batch;
+            batch.push_back(std::move(line));
+            write(batch, 0);
+            return;
+        }
+
+        if (mQueuedBytes + line.length() > mMaxBytes)
+        {
+            mDropped++;
+            mFlush = true;
+        }
+        else
+        {
+            mQueuedBytes += line.length();
+            mQueue.push_back(std::move(line));
+
+            if (level == HLOG_ERROR || mQueuedBytes > mMaxBytes / 2)
+                mFlush = true;
+        }
+
+        if (!mFlush)
+            return;
+    }
+
+    mCond.notify_one();
+}
+
+void TLogWriter::run()
+{
+    deque<string> batch;
+    bool stop = false;
+
+    while (!stop)
+    {
+        uint64_t dropped = 0;
+
+        {
+            unique_lock<mutex> lock(mMutex);
+            mCond.wait_for(lock, mInterval, [] { return mFlush || mStop; });
+            batch.swap(mQueue);
+            mQueuedBytes = 0;
+            mFlush = false;
+            stop = mStop;
+            dropped = mDropped - mReported;
+            mReported += dropped;
+        }
+
+        if (!batch.empty() || dropped > 0)
+            write(batch, dropped);
+
+        batch.clear();
+    }
+}
+
+void TLogWriter::write(deque<string>& batch, uint64_t dropped)
+{
+    _lock();
+    std::ostream *os = TError::Current()->getStream();
+
+    for (const string& line : batch)
+        *os << line;
+
+    if (dropped > 0)
+        *os << TError::append(HLOG_WARNING, __LINE__, __FILE__, _getThreadID()) << "Dropped " << dropped << " log messages because the log queue was full!" << "\n";
+
+    os->flush();
+    _unlock();
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#ifndef __TLOGWRITER_H__
+#define __TLOGWRITER_H__
+
+#include <ostream>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief The TLogWriter class
+ * This is the asynchronous backend of the logging macros. Each thread formats
+ * it's messages into a buffer of it's own. A finished message is appended to
+ * a queue and the calling thread continues immediately. A separate thread
+ * writes the queued messages in batches into the log stream. It flushes the
+ * stream only once per batch.
+ *
+ * The queue is limited to a configurable number of bytes. If the limit is
+ * reached, further messages are dropped and counted. The number of dropped
+ * messages is written into the log with the next batch.
+ *
+ * Errors wake up the writer thread immediately.
+ */
+class TLogWriter
+{
+    public:
+        /**
+         * Starts the writer thread. If the thread is already running,
+         * nothing happens.
+         *
+         * @param maxBytes  The maximum number of bytes the queue may hold.
+         * @param interval  The time in milliseconds between two batches.
+         */
+        static void start(size_t maxBytes, int interval);
+        /**
+         * Writes all queued messages and stops the writer thread.
+         */
+        static void stop();
+        static bool isActive() { return mActive.load(std::memory_order_relaxed); }
+        /**
+         * Returns an empty buffer of the calling thread. The message must
+         * be written into this buffer and then committed with commit().
+         * Calls may be nested. Each call returns a new buffer until the
+         * message is committed.
+         */
+        static std::ostream& stream();
+        /**
+         * Appends the content of the last buffer returned by stream() to
+         * the queue.
+         *
+         * @param level The log level of the message (HLOG_...).
+         */
+        static void commit(unsigned int level);
+        static uint64_t getDropped() { return mDropped.load(std::memory_order_relaxed); }
+
+    private:
+        TLogWriter() {}
+
+        static void run();
+        static void write(std::deque<std::string>& batch, uint64_t dropped);
+
+        static std::atomic<bool> mActive;               // TRUE = Messages are queued
+        static std::atomic<uint64_t> mDropped;          // Number of dropped messages
+        static uint64_t mReported;                      // Number of dropped messages already reported
+        static bool mStop;                              // TRUE = The writer thread should terminate
+        static bool mFlush;                             // TRUE = Write the queue immediately
+        static size_t mMaxBytes;                        // The maximum size of the queue in bytes
+        static size_t mQueuedBytes;                     // The actual size of the queue in bytes
+        static std::chrono::milliseconds mInterval;     // Time between two batches
+        static std::deque<std::string> mQueue;          // The queued messages
+        static std::mutex mMutex;
+        static std::condition_variable mCond;
+        static std::thread mThread;
+};
+
+#endif
@@ -23,6 +23,8 @@
 #include "terror.h"
 #include "ttpinit.h"
 
+#include <algorithm>
+
 #if __cplusplus < 201402L
 #   error "This module requires at least C++14 standard!"
 #else
@@ -236,15 +238,52 @@ bool TMap::readMap()
         }
     }
 
+    // Build the indexes to find buttons by port and channel without
+    // scanning the whole maps.
+    buildIndex(mMap.map_cm, mIndexCm);
+    buildIndex(mMap.map_am, mIndexAm);
+    buildIndex(mMap.map_lm, mIndexLm);
     return true;
 }
 
+void TMap::buildIndex(const vector<MAP_T>& map, vector<MAP_INDEX_T>& index)
+{
+    DECL_TRACER("TMap::buildIndex(const vector<MAP_T>& map, vector<MAP_INDEX_T>& index)");
+
+    index.clear();
+    index.reserve(map.size());
+
+    for (size_t i = 0; i < map.size(); ++i)
+    {
+        MAP_INDEX_T mi;
+        mi.key = makeKey(map[i].p, map[i].c);
+        mi.idx = i;
+        index.push_back(mi);
+    }
+
+    // The stable sort keeps the original order of the entries with the same
+    // port and channel.
+    std::stable_sort(index.begin(), index.end(), [](const MAP_INDEX_T& a, const MAP_INDEX_T& b) { return a.key < b.key; });
+}
+
+void TMap::findRange(const vector<MAP_INDEX_T>& index, int port, int first, int last, vector<size_t>& result)
+{
+    DECL_TRACER("TMap::findRange(const vector<MAP_INDEX_T>& index, int port, int first, int last, vector<size_t>& result)");
+
+    int64_t kFirst = makeKey(port, first);
+    int64_t kLast = makeKey(port, last);
+    vector<MAP_INDEX_T>::const_iterator iter = std::lower_bound(index.begin(), index.end(), kFirst,
+                                                                [](const MAP_INDEX_T& mi, int64_t key) { return mi.key < key; });
+
+    for (; iter != index.end() && iter->key <= kLast; ++iter)
+        result.push_back(iter->idx);
+}
+
 vector<TMap::MAP_T> TMap::findButtons(int port, vector<int>& channels, MAP_TYPE mt)
 {
     DECL_TRACER("TMap::findButtons(int port, vector<int>& channels, MAP_TYPE mt)");
 
     vector<MAP_T> map;
-    vector<int>::iterator iter;
 
     if (channels.empty())
     {
@@ -252,32 +291,43 @@ vector<TMap::MAP_T> TMap::findButtons(int port, vector<int>& channels, MAP_TYPE
         return map;
     }
 
-    vector<MAP_T> localMap;
+    const vector<MAP_T> *localMap = nullptr;
+    const vector<MAP_INDEX_T> *index = nullptr;
 
     switch (mt)
     {
-        case TYPE_AM:   localMap = mMap.map_am; break;
-        case TYPE_CM:   localMap = mMap.map_cm; break;
-        case TYPE_LM:   localMap = mMap.map_lm; break;
+        case TYPE_AM:   localMap = &mMap.map_am; index = &mIndexAm; break;
+        case TYPE_CM:   localMap = &mMap.map_cm; index = &mIndexCm; break;
+        case TYPE_LM:   localMap = &mMap.map_lm; index = &mIndexLm; break;
     }
 
-    if (localMap.empty())
+    if (!localMap || localMap->empty())
     {
         MSG_WARNING("The internal list of elements is empty!")
         return map;
     }
 
-    for (iter = channels.begin(); iter != channels.end(); ++iter)
+    vector<size_t> found;
+    size_t i = 0;
+
+    while (i < channels.size())
     {
-        vector<MAP_T>::iterator mapIter;
+        // Channel ranges like 1.500 arrive as ascending consecutive numbers.
+        // They are resolved with one query on the index.
+        size_t j = i;
 
-        for (mapIter = localMap.begin(); mapIter != localMap.end(); ++mapIter)
-        {
-            if (mapIter->p == port && mapIter->c == *iter)
-                map.push_back(*mapIter);
-        }
+        while ((j + 1) < channels.size() && channels[j + 1] == channels[j] + 1)
+            j++;
+
+        findRange(*index, port, channels[i], channels[j], found);
+        i = j + 1;
     }
 
+    map.reserve(found.size());
+
+    for (size_t idx : found)
+        map.push_back(localMap->at(idx));
+
     MSG_DEBUG("Found " << map.size() << " buttons.");
     return map;
 }
@@ -310,8 +360,8 @@ string TMap::findImage(int bt, int page, int instance)
 {
     DECL_TRACER("TAmxCommands::findImage(int bt, int page, int instance)");
 
-    vector<MAP_BM_T> mapBm = mMap.map_bm;
-    vector<MAP_BM_T>::iterator iter;
+    const vector<MAP_BM_T>& mapBm = mMap.map_bm;
+    vector<MAP_BM_T>::const_iterator iter;
 
     if (mapBm.empty())
         return string();
@@ -334,8 +384,8 @@ string TMap::findImage(const string& name)
 {
     DECL_TRACER("TAmxCommands::findImage(const string& name)");
 
-    vector<MAP_BM_T> mapBm = mMap.map_bm;
-    vector<MAP_BM_T>::iterator iter;
+    const vector<MAP_BM_T>& mapBm = mMap.map_bm;
+    vector<MAP_BM_T>::const_iterator iter;
 
     if (mapBm.empty() || name.empty())
         return string();
@@ -371,23 +421,22 @@ vector<TMap::MAP_T> TMap::findBargraphs(int port, vector<int>& channels)
     vector<MAP_T> map;
     vector<int>::iterator iter;
 
-    if (channels.empty())
+    if (channels.empty() || mMap.map_lm.empty())
         return map;
 
+    vector<size_t> found;
+
     for (iter = channels.begin(); iter != channels.end(); ++iter)
     {
-        vector<MAP_T>::iterator mapIter;
-
-        if (!mMap.map_lm.empty())
-        {
-            for (mapIter = mMap.map_lm.begin(); mapIter != mMap.map_lm.end(); ++mapIter)
-            {
-                // To find also the joysticks, we must test for level codes
-                // less then and grater then *iter.
-                if (mapIter->p == port && (mapIter->c == *iter || mapIter->c == (*iter-1) || mapIter->c == (*iter+1)))
-                    map.push_back(*mapIter);
-            }
-        }
+        // To find also the joysticks, we must test for level codes
+        // less then and grater then *iter.
+        found.clear();
+        findRange(mIndexLm, port, *iter - 1, *iter + 1, found);
+        // Keep the order of the map file
+        std::sort(found.begin(), found.end());
+
+        for (size_t idx : found)
+            map.push_back(mMap.map_lm[idx]);
     }
 
     MSG_DEBUG("Found " << map.size() << " buttons.");
@@ -21,6 +21,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 
 #include "tvalidatefile.h"
 
@@ -109,8 +110,22 @@ class TMap : public TValidateFile
         bool readMap();
 
     private:
+        // Index entry for the maps with port and channel numbers
+        typedef struct MAP_INDEX_T
+        {
+            int64_t key{0};     // Port and channel packed into one number (see makeKey())
+            size_t idx{0};      // Index into the map vector
+        }MAP_INDEX_T;
+
+        static int64_t makeKey(int port, int channel) { return static_cast<int64_t>(port) * 0x100000000LL + channel; }
+        void buildIndex(const std::vector<MAP_T>& map, std::vector<MAP_INDEX_T>& index);
+        void findRange(const std::vector<MAP_INDEX_T>& index, int port, int first, int last, std::vector<size_t>& result);
+
         std::string mFile;
         MAPS_T mMap;
+        std::vector<MAP_INDEX_T> mIndexCm;  // Sorted index of map_cm
+        std::vector<MAP_INDEX_T> mIndexAm;  // Sorted index of map_am
+        std::vector<MAP_INDEX_T> mIndexLm;  // Sorted index of map_lm
         bool mError{false};
         bool mIsG5{false};
 };
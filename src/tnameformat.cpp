@@ -23,6 +23,7 @@
 #include <iconv.h>
 #include <sstream>
 #include "tnameformat.h"
+#include "tresources.h"
 
 #ifdef __ANDROID__
 #if __ANDROID_API__ < 28
@@ -465,49 +466,9 @@ string TNameFormat::cp1250ToUTF8(const string& str)
 {
 	DECL_TRACER("TNameFormat::cp1250ToUTF8(const string& str)");
 
-	string out;
-
-	for (size_t j = 0; j < str.length(); j++)
-	{
-		int i = -1;
-		unsigned char ch = str.at(j);
-		short utf = -1;
-
-		if (ch < 0x80)
-		{
-			do
-			{
-				i++;
-
-				if (__cht[i].ch == ch)
-				{
-					utf = __cht[i].byte;
-					break;
-				}
-			}
-			while (__cht[i].ch != 0xff);
-
-			if (utf < 0)
-				utf = ch;
-		}
-		else
-			utf = ch;
-
-		if (utf > 0x00ff)
-		{
-			out.push_back((utf >> 8) & 0x00ff);
-			out.push_back(utf & 0x00ff);
-		}
-		else if (ch > 0x7f)
-		{
-			out.push_back(0xc0 | ch >> 6);
-			out.push_back(0x80 | (ch & 0x3f));
-		}
-		else
-			out.push_back(ch);
-	}
-
-	return out;
+	// Only plain ASCII was ever looked up in the old table. So the result
+	// is the same as from latin1ToUTF8().
+	return latin1ToUTF8(str);
 }
 
 string TNameFormat::UTF8ToCp1250(const string& str)
@@ -29,6 +29,7 @@
 
 #include "tlock.h"
 #include "tresources.h"
+#include "timgsource.h"
 #include "tpagemanager.h"
 #include "tpage.h"
 #include "tdrawimage.h"
@@ -488,29 +489,23 @@ SkBitmap& TPage::getBgImage()
         if (!TTPInit::isG5() && !mPage.sr[0].bm.empty())
         {
             MSG_DEBUG("Loading image " << mPage.sr[0].bm);
-            sk_sp<SkData> rawImage = readImage(mPage.sr[0].bm);
             SkBitmap bm;
 
-            if (rawImage)
+            if (!TImgSource::getBitmap(mPage.sr[0].bm, &bm))
             {
-                MSG_DEBUG("Decoding image BM ...");
-
-                if (!DecodeDataToBitmap(rawImage, &bm))
-                {
-                    MSG_WARNING("Problem while decoding image " << mPage.sr[0].bm);
-                }
-                else if (!bm.empty())
-                {
-                    dImage.setImageBm(bm);
-                    SkImageInfo info = bm.info();
-                    mPage.sr[0].bm_width = info.width();
-                    mPage.sr[0].bm_height = info.height();
-                    haveBitmap = true;
-                }
-                else
-                {
-                    MSG_WARNING("BM image " << mPage.sr[0].bm << " seems to be empty!");
-                }
+                MSG_WARNING("Problem while decoding image " << mPage.sr[0].bm);
+            }
+            else if (!bm.empty())
+            {
+                dImage.setImageBm(bm);
+                SkImageInfo info = bm.info();
+                mPage.sr[0].bm_width = info.width();
+                mPage.sr[0].bm_height = info.height();
+                haveBitmap = true;
+            }
+            else
+            {
+                MSG_WARNING("BM image " << mPage.sr[0].bm << " seems to be empty!");
             }
         }
         else if (TTPInit::isG5() && haveImage(mPage.sr[0]))
@@ -528,29 +523,23 @@ SkBitmap& TPage::getBgImage()
         if (!mPage.sr[0].mi.empty())
         {
             MSG_DEBUG("Loading image " << mPage.sr[0].mi);
-            sk_sp<SkData> rawImage = readImage(mPage.sr[0].mi);
             SkBitmap mi;
 
-            if (rawImage)
+            if (!TImgSource::getBitmap(mPage.sr[0].mi, &mi))
             {
-                MSG_DEBUG("Decoding image MI ...");
-
-                if (!DecodeDataToBitmap(rawImage, &mi))
-                {
-                    MSG_WARNING("Problem while decoding image " << mPage.sr[0].mi);
-                }
-                else if (!mi.empty())
-                {
-                    dImage.setImageMi(mi);
-                    SkImageInfo info = mi.info();
-                    mPage.sr[0].mi_width = info.width();
-                    mPage.sr[0].mi_height = info.height();
-                    haveBitmap = true;
-                }
-                else
-                {
-                    MSG_WARNING("MI image " << mPage.sr[0].mi << " seems to be empty!");
-                }
+                MSG_WARNING("Problem while decoding image " << mPage.sr[0].mi);
+            }
+            else if (!mi.empty())
+            {
+                dImage.setImageMi(mi);
+                SkImageInfo info = mi.info();
+                mPage.sr[0].mi_width = info.width();
+                mPage.sr[0].mi_height = info.height();
+                haveBitmap = true;
+            }
+            else
+            {
+                MSG_WARNING("MI image " << mPage.sr[0].mi << " seems to be empty!");
             }
         }
 
@@ -569,40 +558,6 @@ SkBitmap& TPage::getBgImage()
 
             if (mPage.sr[0].oo < 255 && mPage.sr[0].te.empty() && mPage.sr[0].bs.empty())
                 setOpacity(&target, mPage.sr[0].oo);
-
-#ifdef _SCALE_SKIA_
-            size_t rowBytes = info.minRowBytes();
-            size_t size = info.computeByteSize(rowBytes);
-            SkImageInfo info = target.info();
-
-            if (gPageManager && gPageManager->getScaleFactor() != 1.0)
-            {
-                SkPaint paint;
-                int left, top;
-
-                paint.setBlendMode(SkBlendMode::kSrc);
-                paint.setFilterQuality(kHigh_SkFilterQuality);
-                // Calculate new dimension
-                double scaleFactor = gPageManager->getScaleFactor();
-                MSG_DEBUG("Using scale factor " << scaleFactor);
-                int lwidth = (int)((double)info.width() * scaleFactor);
-                int lheight = (int)((double)info.height() * scaleFactor);
-                int twidth = (int)((double)mPage.width * scaleFactor);
-                int theight = (int)((double)mPage.height * scaleFactor);
-                calcPosition(lwidth, lheight, &left, &top);
-                // Create a canvas and draw new image
-                sk_sp<SkImage> im = SkImage::MakeFromBitmap(target);
-
-                if (!allocPixels(twidth, theight, &target))
-                    return;
-
-                target.eraseColor(TColor::getSkiaColor(mPage.sr[0].cf));
-                SkCanvas can(target, SkSurfaceProps());
-                SkRect rect = SkRect::MakeXYWH(left, top, lwidth, lheight);
-                can.drawImageRect(im, rect, &paint);
-                MSG_DEBUG("Scaled size of background image: " << left << ", " << top << ", " << lwidth << ", " << lheight);
-            }
-#endif
         }
     }
 
@@ -684,30 +639,24 @@ void TPage::show()
         if (!TTPInit::isG5() && !sr[0].bm.empty())
         {
             MSG_DEBUG("Loading image " << sr[0].bm);
-            sk_sp<SkData> rawImage = readImage(sr[0].bm);
             SkBitmap bm;
 
-            if (rawImage && !rawImage->isEmpty())
+            if (!TImgSource::getBitmap(sr[0].bm, &bm))
             {
-                MSG_DEBUG("Decoding image BM ...");
-
-                if (!DecodeDataToBitmap(rawImage, &bm))
-                {
-                    MSG_WARNING("Problem while decoding image " << sr[0].bm);
-                }
-                else if (!bm.isNull() && !bm.empty())
-                {
-                    dImage.setImageBm(bm);
-                    SkImageInfo info = bm.info();
-                    sr[0].bm_width = info.width();
-                    sr[0].bm_height = info.height();
-                    isImage = true;
-                    MSG_DEBUG("Image " << sr[0].bm << " has dimension " << sr[0].bm_width << " x " << sr[0].bm_height);
-                }
-                else
-                {
-                    MSG_WARNING("BM image " << sr[0].bm << " seems to be empty!");
-                }
+                MSG_WARNING("Problem while decoding image " << sr[0].bm);
+            }
+            else if (!bm.isNull() && !bm.empty())
+            {
+                dImage.setImageBm(bm);
+                SkImageInfo info = bm.info();
+                sr[0].bm_width = info.width();
+                sr[0].bm_height = info.height();
+                isImage = true;
+                MSG_DEBUG("Image " << sr[0].bm << " has dimension " << sr[0].bm_width << " x " << sr[0].bm_height);
+            }
+            else
+            {
+                MSG_WARNING("BM image " << sr[0].bm << " seems to be empty!");
             }
         }
         else if (TTPInit::isG5() && haveImage(sr[0]))
@@ -720,28 +669,22 @@ void TPage::show()
                     continue;
 
                 MSG_DEBUG("Loading G5 image " << sr[0].bitmaps[i].fileName);
-                sk_sp<SkData> rawImage = readImage(sr[0].bitmaps[i].fileName);
                 SkBitmap bm;
 
-                if (rawImage && !rawImage->isEmpty())
+                if (!TImgSource::getBitmap(sr[0].bitmaps[i].fileName, &bm))
                 {
-                    MSG_DEBUG("Decoding image BM ...");
-
-                    if (!DecodeDataToBitmap(rawImage, &bm))
-                    {
-                        MSG_WARNING("Problem while decoding image " << sr[0].bitmaps[i].fileName);
-                    }
-                    else if (!bm.isNull() && !bm.empty())
-                    {
-                        dImage.setImageBm(bm);
-                        SkImageInfo info = bm.info();
-                        isImage = true;
-                        MSG_DEBUG("Image " << sr[0].bitmaps[i].fileName << " has dimension " << bm.width() << " x " << bm.height());
-                    }
-                    else
-                    {
-                        MSG_WARNING("BM image " << sr[0].bm << " seems to be empty!");
-                    }
+                    MSG_WARNING("Problem while decoding image " << sr[0].bitmaps[i].fileName);
+                }
+                else if (!bm.isNull() && !bm.empty())
+                {
+                    dImage.setImageBm(bm);
+                    SkImageInfo info = bm.info();
+                    isImage = true;
+                    MSG_DEBUG("Image " << sr[0].bitmaps[i].fileName << " has dimension " << bm.width() << " x " << bm.height());
+                }
+                else
+                {
+                    MSG_WARNING("BM image " << sr[0].bm << " seems to be empty!");
                 }
             }
         }
@@ -751,29 +694,23 @@ void TPage::show()
         if (!sr[0].mi.empty())
         {
             MSG_DEBUG("Loading image " << sr[0].mi);
-            sk_sp<SkData> rawImage = readImage(sr[0].mi);
             SkBitmap mi;
 
-            if (rawImage && !rawImage->isEmpty())
+            if (!TImgSource::getBitmap(sr[0].mi, &mi))
             {
-                MSG_DEBUG("Decoding image MI ...");
-
-                if (!DecodeDataToBitmap(rawImage, &mi))
-                {
-                    MSG_WARNING("Problem while decoding image " << sr[0].mi);
-                }
-                else if (!mi.isNull() && !mi.empty())
-                {
-                    dImage.setImageMi(mi);
-                    SkImageInfo info = mi.info();
-                    sr[0].mi_width = info.width();
-                    sr[0].mi_height = info.height();
-                    isImage = true;
-                }
-                else
-                {
-                    MSG_WARNING("MI image " << sr[0].mi << " seems to be empty!");
-                }
+                MSG_WARNING("Problem while decoding image " << sr[0].mi);
+            }
+            else if (!mi.isNull() && !mi.empty())
+            {
+                dImage.setImageMi(mi);
+                SkImageInfo info = mi.info();
+                sr[0].mi_width = info.width();
+                sr[0].mi_height = info.height();
+                isImage = true;
+            }
+            else
+            {
+                MSG_WARNING("MI image " << sr[0].mi << " seems to be empty!");
             }
         }
 
@@ -799,42 +736,6 @@ void TPage::show()
                     return;
                 }
             }
-
-#ifdef _SCALE_SKIA_
-            if (gPageManager && gPageManager->getScaleFactor() != 1.0)
-            {
-                SkPaint paint;
-                int left, top;
-                SkImageInfo info = target.info();
-
-                paint.setBlendMode(SkBlendMode::kSrc);
-                paint.setFilterQuality(kHigh_SkFilterQuality);
-                // Calculate new dimension
-                double scaleFactor = gPageManager->getScaleFactor();
-                MSG_DEBUG("Using scale factor " << scaleFactor);
-                int lwidth = (int)((double)info.width() * scaleFactor);
-                int lheight = (int)((double)info.height() * scaleFactor);
-                int twidth = (int)((double)width * scaleFactor);
-                int theight = (int)((double)height * scaleFactor);
-                calcPosition(lwidth, lheight, &left, &top);
-                // Create a canvas and draw new image
-                sk_sp<SkImage> im = SkImage::MakeFromBitmap(target);
-
-                if (!allocPixels(twidth, theight, &target))
-                {
-#if TESTMODE == 1
-                    setScreenDone();
-#endif
-                    return;
-                }
-
-                target.eraseColor(TColor::getSkiaColor(sr[0].cf));
-                SkCanvas can(target, SkSurfaceProps());
-                SkRect rect = SkRect::MakeXYWH(left, top, lwidth, lheight);
-                can.drawImageRect(im, rect, &paint);
-                MSG_DEBUG("Scaled size of background image: " << left << ", " << top << ", " << lwidth << ", " << lheight);
-            }
-#endif
         }
     }
 
@@ -855,15 +756,15 @@ void TPage::show()
 
     if (isImage)
     {
-        SkImageInfo info = target.info();
-        TBitmap image((unsigned char *)target.getPixels(), info.width(), info.height());
+        SkBitmap screen = scaleToDevice(target);
+        TBitmap image(screen);
 
         if (sr.size() > 0)
         {
 #ifdef _OPAQUE_SKIA_
-            _setBackground(handle, image, target.info().width(), target.info().height(), TColor::getColor(sr[0].cf));
+            _setBackground(handle, image, screen.info().width(), screen.info().height(), TColor::getColor(sr[0].cf));
 #else
-            _setBackground(handle, image, target.info().width(), target.info().height(), TColor::getColor(sr[0].cf), sr[0].oo);
+            _setBackground(handle, image, screen.info().width(), screen.info().height(), TColor::getColor(sr[0].cf), sr[0].oo);
 #endif
         }
     }
@@ -1174,8 +1075,8 @@ void TPage::calcPosition(int im_width, int im_height, int *left, int *top)
 #ifdef _SCALE_SKIA_
     if (scale && gPageManager && gPageManager->getScaleFactor() != 1.0)
     {
-        nw = (int)((double)width * gPageManager->getScaleFactor());
-        nh = (int)((double)height * gPageManager->getScaleFactor());
+        nw = (int)((double)mPage.width * gPageManager->getScaleFactor());
+        nh = (int)((double)mPage.height * gPageManager->getScaleFactor());
     }
 #endif
     switch (sr[0].jb)
@@ -1187,7 +1088,7 @@ void TPage::calcPosition(int im_width, int im_height, int *left, int *top)
             if (scale && gPageManager && gPageManager->getScaleFactor() != 1.0)
             {
                 *left = (int)((double)sr[0].bx * gPageManager->getScaleFactor());
-                *left = (int)((double)sr[0].by * gPageManager->getScaleFactor());
+                *top = (int)((double)sr[0].by * gPageManager->getScaleFactor());
             }
 #endif
         break;
@@ -17,6 +17,8 @@
  */
 
 #include <string>
+#include <algorithm>
+#include <climits>
 
 #include <include/core/SkFont.h>
 #include <include/core/SkFontMetrics.h>
@@ -33,6 +35,9 @@
 #include "tpagemanager.h"
 #include "tintborder.h"
 #include "timgcache.h"
+#include "timgsource.h"
+#include "tpixelkernels.h"
+#include "ttextlayout.h"
 #include "terror.h"
 
 #if __cplusplus < 201402L
@@ -57,6 +62,8 @@ using std::vector;
 using std::min;
 using std::max;
 
+#define BUTTON_GRID_CELL    64      // The width and height of a cell of the button grid in pixels
+
 bool TPageInterface::drawText(PAGE_T& pinfo, SkBitmap *img)
 {
     MSG_TRACE("TPageInterface::drawText(PAGE_T& pinfo, SkImage& img)");
@@ -112,15 +119,11 @@ bool TPageInterface::drawText(PAGE_T& pinfo, SkBitmap *img)
 
     if (lines > 1 || pinfo.sr[0].ww)
     {
-        vector<string> textLines;
+        std::shared_ptr<const TEXT_LAYOUT_t> layout = TTextLayout::getLayout(pinfo.sr[0].te, pinfo.width, pinfo.height, (pinfo.sr[0].ww ? TW_WORDS : TW_BREAKS), skFont, paint);
+        const vector<TEXT_LINE_t>& textLines = layout->lines;
 
-        if (!pinfo.sr[0].ww)
-            textLines = splitLine(pinfo.sr[0].te);
-        else
-        {
-            textLines = splitLine(pinfo.sr[0].te, pinfo.width, pinfo.height, skFont, paint);
+        if (pinfo.sr[0].ww)
             lines = (int)textLines.size();
-        }
 
         MSG_DEBUG("Calculated number of lines: " << textLines.size());
         int lineHeight = calcLineHeight(pinfo.sr[0].te, skFont);
@@ -143,14 +146,12 @@ bool TPageInterface::drawText(PAGE_T& pinfo, SkBitmap *img)
             return false;
         }
 
-        vector<string>::iterator iter;
         int line = 0;
 
-        for (iter = textLines.begin(); iter != textLines.end(); iter++)
+        for (const TEXT_LINE_t& textLine : textLines)
         {
-            sk_sp<SkTextBlob> blob = SkTextBlob::MakeFromString(iter->c_str(), skFont);
-            SkRect rect;
-            skFont.measureText(iter->c_str(), iter->length(), SkTextEncoding::kUTF8, &rect, &paint);
+            const sk_sp<SkTextBlob>& blob = textLine.blob;
+            const SkRect& rect = textLine.bounds;
             Button::POSITION_t pos = calcImagePosition(&pinfo, rect.width(), lineHeight, Button::SC_TEXT, 1);
 
             if (!pos.valid)
@@ -159,7 +160,7 @@ bool TPageInterface::drawText(PAGE_T& pinfo, SkBitmap *img)
                 TError::SetError();
                 return false;
             }
-            MSG_DEBUG("Triing to print line: " << *iter);
+            MSG_DEBUG("Triing to print line: " << textLine.text);
 
             SkScalar startX = (SkScalar)pos.left;
             SkScalar startY = (SkScalar)position.top + lineHeight * line;
@@ -173,9 +174,9 @@ bool TPageInterface::drawText(PAGE_T& pinfo, SkBitmap *img)
     }
     else    // single line
     {
-        sk_sp<SkTextBlob> blob = SkTextBlob::MakeFromString(pinfo.sr[0].te.c_str(), skFont);
-        SkRect rect;
-        skFont.measureText(pinfo.sr[0].te.c_str(), pinfo.sr[0].te.length(), SkTextEncoding::kUTF8, &rect, &paint);
+        std::shared_ptr<const TEXT_LAYOUT_t> layout = TTextLayout::getLayout(pinfo.sr[0].te, pinfo.width, pinfo.height, TW_NONE, skFont, paint);
+        const sk_sp<SkTextBlob>& blob = layout->lines[0].blob;
+        const SkRect& rect = layout->lines[0].bounds;
         Button::POSITION_t position = calcImagePosition(&pinfo, rect.width(), (rect.height() * (float)lines), Button::SC_TEXT, 0);
 
         if (!position.valid)
@@ -271,43 +272,52 @@ bool TPageInterface::drawFrame(PAGE_T& pinfo, SkBitmap* bm)
         return false;
 
     MSG_DEBUG("Got images \"" << bd.bl << "\" and \"" << bd.bl_alpha << "\" with size " << imgBL.info().width() << " x " << imgBL.info().height());
-    MSG_DEBUG("Button image size: " << (imgTL.info().width() + imgT.info().width() + imgTR.info().width()) << " x " << (imgTL.info().height() + imgL.info().height() + imgBL.info().height()));
-    MSG_DEBUG("Total size: " << pinfo.width << " x " << pinfo.height);
-    stretchImageWidth(&imgB, pinfo.width - imgBL.info().width() - imgBR.info().width());
-    stretchImageWidth(&imgT, pinfo.width - imgTL.info().width() - imgTR.info().width());
-    stretchImageHeight(&imgL, pinfo.height - imgTL.info().height() - imgBL.info().height());
-    stretchImageHeight(&imgR, pinfo.height - imgTR.info().height() - imgBR.info().height());
-    MSG_DEBUG("Stretched button image size: " << (imgTL.info().width() + imgT.info().width() + imgTR.info().width()) << " x " << (imgTL.info().height() + imgL.info().height() + imgBL.info().height()));
-    // Draw the frame
+    // If a frame with the same border, color and size was already drawn,
+    // we take it from the cache.
     SkBitmap frame;
-    allocPixels(bm->info().width(), bm->info().height(), &frame);
-    frame.eraseColor(SK_ColorTRANSPARENT);
-    SkCanvas target(*bm, SkSurfaceProps());
-    SkCanvas canvas(frame, SkSurfaceProps());
-    SkPaint paint;
+    string frameKey = "page:" + bd.border.baseFile + "|" + std::to_string(color) + "|" + std::to_string(pinfo.width) + "x" + std::to_string(pinfo.height);
 
-    paint.setBlendMode(SkBlendMode::kSrcOver);
-    paint.setAntiAlias(true);
-    sk_sp<SkImage> _image = SkImages::RasterFromBitmap(imgB);   // bottom
-    canvas.drawImage(_image, imgBL.info().width(), pinfo.height - imgB.info().height(), SkSamplingOptions(), &paint);
-    _image = SkImages::RasterFromBitmap(imgT);                  // top
-    canvas.drawImage(_image, imgTL.info().width(), 0, SkSamplingOptions(), &paint);
-    _image = SkImages::RasterFromBitmap(imgBR);                 // bottom right
-    canvas.drawImage(_image, pinfo.width - imgBR.info().width(), pinfo.height - imgBR.info().height(), SkSamplingOptions(), &paint);
-    _image = SkImages::RasterFromBitmap(imgTR);                 // top right
-    canvas.drawImage(_image, pinfo.width - imgTR.info().width(), 0, SkSamplingOptions(), &paint);
-    _image = SkImages::RasterFromBitmap(imgTL);                 // top left
-    canvas.drawImage(_image, 0, 0, SkSamplingOptions(), &paint);
-    _image = SkImages::RasterFromBitmap(imgBL);                 // bottom left
-    canvas.drawImage(_image, 0, pinfo.height - imgBL.info().height(), SkSamplingOptions(), &paint);
-    _image = SkImages::RasterFromBitmap(imgL);                  // left
-    canvas.drawImage(_image, 0, imgTL.info().height(), SkSamplingOptions(), &paint);
-    _image = SkImages::RasterFromBitmap(imgR);                  // right
-    canvas.drawImage(_image, pinfo.width - imgR.info().width(), imgTR.info().height(), SkSamplingOptions(), &paint);
+    if (!TImgCache::getBitmap(frameKey, &frame, _BMTYPE_FRAME) || frame.info().dimensions() != bm->info().dimensions())
+    {
+        MSG_DEBUG("Button image size: " << (imgTL.info().width() + imgT.info().width() + imgTR.info().width()) << " x " << (imgTL.info().height() + imgL.info().height() + imgBL.info().height()));
+        MSG_DEBUG("Total size: " << pinfo.width << " x " << pinfo.height);
+        stretchImageWidth(&imgB, pinfo.width - imgBL.info().width() - imgBR.info().width());
+        stretchImageWidth(&imgT, pinfo.width - imgTL.info().width() - imgTR.info().width());
+        stretchImageHeight(&imgL, pinfo.height - imgTL.info().height() - imgBL.info().height());
+        stretchImageHeight(&imgR, pinfo.height - imgTR.info().height() - imgBR.info().height());
+        MSG_DEBUG("Stretched button image size: " << (imgTL.info().width() + imgT.info().width() + imgTR.info().width()) << " x " << (imgTL.info().height() + imgL.info().height() + imgBL.info().height()));
+        // Draw the frame
+        allocPixels(bm->info().width(), bm->info().height(), &frame);
+        frame.eraseColor(SK_ColorTRANSPARENT);
+        SkCanvas canvas(frame, SkSurfaceProps());
+        SkPaint paint;
 
+        paint.setBlendMode(SkBlendMode::kSrcOver);
+        paint.setAntiAlias(true);
+        sk_sp<SkImage> _image = SkImages::RasterFromBitmap(imgB);   // bottom
+        canvas.drawImage(_image, imgBL.info().width(), pinfo.height - imgB.info().height(), SkSamplingOptions(), &paint);
+        _image = SkImages::RasterFromBitmap(imgT);                  // top
+        canvas.drawImage(_image, imgTL.info().width(), 0, SkSamplingOptions(), &paint);
+        _image = SkImages::RasterFromBitmap(imgBR);                 // bottom right
+        canvas.drawImage(_image, pinfo.width - imgBR.info().width(), pinfo.height - imgBR.info().height(), SkSamplingOptions(), &paint);
+        _image = SkImages::RasterFromBitmap(imgTR);                 // top right
+        canvas.drawImage(_image, pinfo.width - imgTR.info().width(), 0, SkSamplingOptions(), &paint);
+        _image = SkImages::RasterFromBitmap(imgTL);                 // top left
+        canvas.drawImage(_image, 0, 0, SkSamplingOptions(), &paint);
+        _image = SkImages::RasterFromBitmap(imgBL);                 // bottom left
+        canvas.drawImage(_image, 0, pinfo.height - imgBL.info().height(), SkSamplingOptions(), &paint);
+        _image = SkImages::RasterFromBitmap(imgL);                  // left
+        canvas.drawImage(_image, 0, imgTL.info().height(), SkSamplingOptions(), &paint);
+        _image = SkImages::RasterFromBitmap(imgR);                  // right
+        canvas.drawImage(_image, pinfo.width - imgR.info().width(), imgTR.info().height(), SkSamplingOptions(), &paint);
+        TImgCache::addImage(frameKey, frame, _BMTYPE_FRAME);
+    }
+
+    SkCanvas target(*bm, SkSurfaceProps());
+    SkPaint paint;
     Border::TIntBorder iborder;
     iborder.erasePart(bm, frame, Border::ERASE_OUTSIDE, imgL.info().width());
-    _image = SkImages::RasterFromBitmap(frame);
+    sk_sp<SkImage> _image = SkImages::RasterFromBitmap(frame);
     paint.setBlendMode(SkBlendMode::kSrcATop);
     target.drawImage(_image, 0, 0, SkSamplingOptions(), &paint);
     return true;
@@ -595,21 +605,18 @@ Button::BUTTONS_T *TPageInterface::addButton(Button::TButton* button)
         chain->button = button;
         chain->next = nullptr;
         chain->previous = nullptr;
-        Button::BUTTONS_T *bts = mButtons;
 
-        if (bts)
+        if (mButtonsLast)
         {
-            Button::BUTTONS_T *p = bts;
-
-            while (p && p->next)
-                p = p->next;
-
-            p->next = chain;
-            chain->previous = p;
+            mButtonsLast->next = chain;
+            chain->previous = mButtonsLast;
         }
         else
             mButtons = chain;
 
+        mButtonsLast = chain;
+        indexButton(button);
+        mGridValid = false;
         return chain;
     }
     catch (std::exception& e)
@@ -621,56 +628,175 @@ Button::BUTTONS_T *TPageInterface::addButton(Button::TButton* button)
     return nullptr;
 }
 
-bool TPageInterface::hasButton(int id)
+void TPageInterface::setButtons(Button::BUTTONS_T *bt)
 {
-    DECL_TRACER("TPageInterface::hasButton(int id)");
+    DECL_TRACER("TPageInterface::setButtons(Button::BUTTONS_T *bt)");
 
-    Button::BUTTONS_T *bt = mButtons;
+    mButtons = bt;
+    mButtonsLast = bt;
 
-    while (bt)
+    while (mButtonsLast && mButtonsLast->next)
+        mButtonsLast = mButtonsLast->next;
+
+    rebuildButtonIndex();
+}
+
+/*
+ * Adds a button to the indexes. If more than one button has the same button
+ * index, the first one wins.
+ */
+void TPageInterface::indexButton(Button::TButton *button)
+{
+    DECL_TRACER("TPageInterface::indexButton(Button::TButton *button)");
+
+    if (!button)
+        return;
+
+    mButtonIndex.insert(std::pair<int, Button::TButton *>(button->getButtonIndex(), button));
+    mAddressIndex[makeButtonKey(button->getAddressPort(), button->getAddressChannel())].push_back(button);
+    mLevelIndex[makeButtonKey(button->getLevelPort(), button->getLevelChannel())].push_back(button);
+}
+
+void TPageInterface::rebuildButtonIndex()
+{
+    DECL_TRACER("TPageInterface::rebuildButtonIndex()");
+
+    mButtonIndex.clear();
+    mAddressIndex.clear();
+    mLevelIndex.clear();
+
+    for (Button::BUTTONS_T *bt = mButtons; bt; bt = bt->next)
+        indexButton(bt->button);
+
+    mGridValid = false;
+}
+
+/*
+ * Builds a uniform grid over the area covered by the buttons. Each button
+ * is added to every cell its rectangle overlaps. The buttons of a cell are
+ * in the order of the chain.
+ * The caller must hold the lock "mGridMutex".
+ */
+void TPageInterface::buildButtonGrid()
+{
+    DECL_TRACER("TPageInterface::buildButtonGrid()");
+
+    mButtonGrid.clear();
+    mGridColumns = mGridRows = 0;
+    mGridGeneration = Button::TButton::getGeometryGeneration();
+    mGridValid = true;
+
+    if (!mButtons)
+        return;
+
+    int left = INT_MAX, top = INT_MAX, right = INT_MIN, bottom = INT_MIN;
+
+    for (Button::BUTTONS_T *bt = mButtons; bt; bt = bt->next)
     {
-        if (bt->button && bt->button->getButtonIndex() == id)
-            return true;
+        Button::TButton *b = bt->button;
+        left = std::min(left, b->getLeftPosition());
+        top = std::min(top, b->getTopPosition());
+        right = std::max(right, b->getLeftPosition() + b->getWidth());
+        bottom = std::max(bottom, b->getTopPosition() + b->getHeight());
+    }
 
-        bt = bt->next;
+    mGridLeft = left;
+    mGridTop = top;
+    mGridColumns = (right - left) / BUTTON_GRID_CELL + 1;
+    mGridRows = (bottom - top) / BUTTON_GRID_CELL + 1;
+    mButtonGrid.resize(static_cast<size_t>(mGridColumns) * mGridRows);
+
+    for (Button::BUTTONS_T *bt = mButtons; bt; bt = bt->next)
+    {
+        Button::TButton *b = bt->button;
+        // The right and bottom edges belong to the button too.
+        int c1 = (b->getLeftPosition() - mGridLeft) / BUTTON_GRID_CELL;
+        int c2 = (b->getLeftPosition() + b->getWidth() - mGridLeft) / BUTTON_GRID_CELL;
+        int r1 = (b->getTopPosition() - mGridTop) / BUTTON_GRID_CELL;
+        int r2 = (b->getTopPosition() + b->getHeight() - mGridTop) / BUTTON_GRID_CELL;
+
+        for (int r = r1; r <= r2; ++r)
+        {
+            for (int c = c1; c <= c2; ++c)
+                mButtonGrid[static_cast<size_t>(r) * mGridColumns + c].push_back(b);
+        }
     }
+}
 
-    return false;
+/**
+ * Returns the buttons which may contain the point \b x, \b y. The buttons
+ * are in reverse order of the chain. This means, the button on top is the
+ * first one. The caller must still test the exact rectangle of each button,
+ * because a cell of the grid is larger than a pixel.
+ *
+ * @param x     The X coordinate relative to the page.
+ * @param y     The Y coordinate relative to the page.
+ *
+ * @return The list of buttons near the point.
+ */
+vector<Button::TButton *> TPageInterface::getButtonsAt(int x, int y)
+{
+    DECL_TRACER("TPageInterface::getButtonsAt(int x, int y)");
+
+    std::lock_guard<std::mutex> guard(mGridMutex);
+
+    if (!mGridValid || mGridGeneration != Button::TButton::getGeometryGeneration())
+        buildButtonGrid();
+
+    if (x < mGridLeft || y < mGridTop)
+        return vector<Button::TButton *>();
+
+    int col = (x - mGridLeft) / BUTTON_GRID_CELL;
+    int row = (y - mGridTop) / BUTTON_GRID_CELL;
+
+    if (col >= mGridColumns || row >= mGridRows)
+        return vector<Button::TButton *>();
+
+    const vector<Button::TButton *>& cell = mButtonGrid[static_cast<size_t>(row) * mGridColumns + col];
+    return vector<Button::TButton *>(cell.rbegin(), cell.rend());
+}
+
+bool TPageInterface::hasButton(int id)
+{
+    DECL_TRACER("TPageInterface::hasButton(int id)");
+
+    return mButtonIndex.find(id) != mButtonIndex.end();
 }
 
 Button::TButton *TPageInterface::getButton(int id)
 {
     DECL_TRACER("TPageInterface::getButton(int id)");
 
-    Button::BUTTONS_T *bt = mButtons;
+    std::unordered_map<int, Button::TButton *>::iterator iter = mButtonIndex.find(id);
 
-    while (bt)
-    {
-        if (bt->button && bt->button->getButtonIndex() == id)
-            return bt->button;
-
-        bt = bt->next;
-    }
+    if (iter == mButtonIndex.end())
+        return nullptr;
 
-    return nullptr;
+    return iter->second;
 }
 
 vector<Button::TButton *> TPageInterface::getButtons(int ap, int ad)
 {
     DECL_TRACER("TPageInterface::getButtons(int ap, int ad)");
 
-    vector<Button::TButton *> list;
-    Button::BUTTONS_T *bt = mButtons;
+    std::unordered_map<uint64_t, vector<Button::TButton *> >::iterator iter = mAddressIndex.find(makeButtonKey(ap, ad));
 
-    while (bt)
-    {
-        if (bt->button->getAddressPort() == ap && bt->button->getAddressChannel() == ad)
-            list.push_back(bt->button);
+    if (iter == mAddressIndex.end())
+        return vector<Button::TButton *>();
 
-        bt = bt->next;
-    }
+    return iter->second;
+}
 
-    return list;
+vector<Button::TButton *> TPageInterface::getLevelButtons(int lp, int lv)
+{
+    DECL_TRACER("TPageInterface::getLevelButtons(int lp, int lv)");
+
+    std::unordered_map<uint64_t, vector<Button::TButton *> >::iterator iter = mLevelIndex.find(makeButtonKey(lp, lv));
+
+    if (iter == mLevelIndex.end())
+        return vector<Button::TButton *>();
+
+    return iter->second;
 }
 
 vector<Button::TButton *> TPageInterface::getAllButtons()
@@ -767,56 +893,31 @@ Button::TButton *TPageInterface::getPreviousButton()
 /*
  * Sort the button according to their Z-order.
  * The button with the highest Z-order will be the last button in the chain.
- * The algorithm is a bubble sort algorithm.
+ * Buttons with the same Z-order keep their order.
  */
 bool TPageInterface::sortButtons()
 {
     DECL_TRACER("TPageInterface::sortButtons()");
 
-    bool turned = true;
-
-    while (turned)
-    {
-        Button::BUTTONS_T *button = mButtons;
-        turned = false;
-
-        while (button)
-        {
-            int zo = button->button->getZOrder();
-
-            if (button->previous)
-            {
-                if (zo < button->previous->button->getZOrder())
-                {
-                    Button::BUTTONS_T *pprev = button->previous->previous;
-                    Button::BUTTONS_T *prev = button->previous;
-                    Button::BUTTONS_T *next = button->next;
-
-                    if (pprev)
-                        pprev->next = button;
-
-                    prev->next = next;
-                    prev->previous = button;
-                    button->next = prev;
-                    button->previous = pprev;
+    vector<Button::BUTTONS_T *> chain;
 
-                    if (!pprev)
-                        setButtons(button);
+    for (Button::BUTTONS_T *bt = mButtons; bt; bt = bt->next)
+        chain.push_back(bt);
 
-                    button = next;
-
-                    if (next)
-                        next->previous = prev;
+    if (chain.size() < 2)
+        return true;
 
-                    turned = true;
-                    continue;
-                }
-            }
+    std::stable_sort(chain.begin(), chain.end(), [](Button::BUTTONS_T *a, Button::BUTTONS_T *b) {
+        return a->button->getZOrder() < b->button->getZOrder();
+    });
 
-            button = button->next;
-        }
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        chain[i]->previous = (i > 0 ? chain[i - 1] : nullptr);
+        chain[i]->next = (i + 1 < chain.size() ? chain[i + 1] : nullptr);
     }
 
+    setButtons(chain[0]);
     return true;
 }
 
@@ -1166,6 +1267,64 @@ bool TPageInterface::haveImage(const Button::SR_T& sr)
     return false;
 }
 
+/*
+ * Collects the names of the image files of the page and of all it's
+ * buttons. The names may be passed to TImgSource::prefetch().
+ */
+void TPageInterface::getImageFiles(vector<string>& files)
+{
+    DECL_TRACER("TPageInterface::getImageFiles(vector<string>& files)");
+
+    if (!sr.empty())
+    {
+        if (!sr[0].mi.empty())
+            files.push_back(sr[0].mi);
+
+        if (!TTPInit::isG5() && !sr[0].bm.empty())
+            files.push_back(sr[0].bm);
+        else if (TTPInit::isG5())
+        {
+            for (int i = 0; i < MAX_IMAGES; ++i)
+            {
+                if (!sr[0].bitmaps[i].fileName.empty())
+                    files.push_back(sr[0].bitmaps[i].fileName);
+            }
+        }
+    }
+
+    Button::BUTTONS_T *bt = mButtons;
+
+    while (bt)
+    {
+        if (bt->button)
+            bt->button->getImageFiles(files);
+
+        bt = bt->next;
+    }
+}
+
+/*
+ * Returns the finished background \p bm in the size it has on the screen.
+ * This is done only if Skia does the scaling (_SCALE_SKIA_). Otherwise, or
+ * if the scale factor is 1, \p bm is returned unchanged. The text and the
+ * frame must already be drawn into \p bm.
+ */
+SkBitmap TPageInterface::scaleToDevice(const SkBitmap& bm)
+{
+    DECL_TRACER("TPageInterface::scaleToDevice(const SkBitmap& bm)");
+#ifdef _SCALE_SKIA_
+    if (gPageManager && gPageManager->getScaleFactor() != 1.0 && !bm.empty())
+    {
+        double factor = gPageManager->getScaleFactor();
+        SkBitmap scaled;
+
+        if (scaleBitmap(bm, &scaled, static_cast<int>(static_cast<double>(bm.info().width()) * factor), static_cast<int>(static_cast<double>(bm.info().height()) * factor)))
+            return scaled;
+    }
+#endif
+    return bm;
+}
+
 /**
  * @brief G5: Put all images together
  * The method takes all defined images, scales them and put one over the other.
@@ -1206,18 +1365,12 @@ bool TPageInterface::tp5Image(SkBitmap *bm, Button::SR_T& sr, int wt, int ht, bo
 
         if (!TImgCache::getBitmap(sr.bitmaps[i].fileName, &bmBm, _BMTYPE_BITMAP, &width, &height))
         {
-            sk_sp<SkData> data = readImage(sr.bitmaps[i].fileName);
             bool loaded = false;
 
-            if (data)
+            if (TImgSource::getBitmap(sr.bitmaps[i].fileName, &bmBm))
             {
-                DecodeDataToBitmap(data, &bmBm);
-
-                if (!bmBm.empty())
-                {
-                    TImgCache::addImage(sr.bitmaps[i].fileName, bmBm, _BMTYPE_BITMAP);
-                    loaded = true;
-                }
+                TImgCache::addImage(sr.bitmaps[i].fileName, bmBm, _BMTYPE_BITMAP);
+                loaded = true;
             }
 
             if (!loaded)
@@ -1474,6 +1627,27 @@ bool TPageInterface::getBorderFragment(const string& path, const string& pathAlp
         return false;
     }
 
+    string key = "page:" + path + "|" + pathAlpha + "|" + std::to_string(color);
+
+    if (TImgCache::getBitmap(key, image, _BMTYPE_BORDER))
+        return true;
+
+    if (!loadBorderFragment(path, pathAlpha, image, color))
+        return false;
+
+    TImgCache::addImage(key, *image, _BMTYPE_BORDER);
+    return true;
+}
+
+/**
+ * @brief loadBorderFragment - load and colorize a part of a border
+ * This does the work for getBorderFragment() if the fragment is not in the
+ * cache.
+ */
+bool TPageInterface::loadBorderFragment(const string& path, const string& pathAlpha, SkBitmap* image, SkColor color)
+{
+    DECL_TRACER("TPageInterface::loadBorderFragment(const string& path, const string& pathAlpha, SkBitmap* image, SkColor color)");
+
     sk_sp<SkData> im;
     SkBitmap bm;
     bool haveBaseImage = false;
@@ -1491,19 +1665,14 @@ bool TPageInterface::getBorderFragment(const string& path, const string& pathAlp
                 SkImageInfo info = image->info();
                 SkBitmap b;
                 allocPixels(info.width(), info.height(), &b);
-                b.eraseColor(SK_ColorTRANSPARENT);
+                vector<uint32_t> buffer;
+                const uint32_t *pixels = TPixelKernels::getColors(*image, buffer);
 
-                for (int x = 0; x < info.width(); ++x)
-                {
-                    for (int y = 0; y < info.height(); ++y)
-                    {
-                        SkColor alpha = SkColorGetA(image->getColor(x, y));
-                        uint32_t *pix = b.getAddr32(x, y);
-
-                        if (alpha > 0)
-                            *pix = color;
-                    }
-                }
+                if (!pixels)
+                    b.eraseColor(SK_ColorTRANSPARENT);
+
+                for (int y = 0; pixels && y < info.height(); ++y)
+                    TPixelKernels::alphaToSolid(b.getAddr32(0, y), pixels + static_cast<size_t>(y) * info.width(), info.width(), color);
 
                 SkPaint paint;
                 paint.setAntiAlias(true);
@@ -1536,20 +1705,12 @@ bool TPageInterface::getBorderFragment(const string& path, const string& pathAlp
     // colored by the border color.
     if (image->info().dimensions() == bm.info().dimensions())
     {
-        for (int y = 0; y < image->info().height(); ++y)
-        {
-            for (int x = 0; x < image->info().width(); ++x)
-            {
-                SkColor col = bm.getColor(x, y);
-                SkColor alpha = SkColorGetA(col);
-                uint32_t *pix = bm.getAddr32(x, y);
+        vector<uint32_t> buffer;
+        const uint32_t *pixels = TPixelKernels::getColors(bm, buffer);
+        int width = bm.info().width();
 
-                if (alpha == 0)
-                    *pix = SK_ColorTRANSPARENT;
-                else
-                    *pix = SkColorSetA(color, alpha);
-            }
-        }
+        for (int y = 0; pixels && y < bm.info().height(); ++y)
+            TPixelKernels::alphaToColor(bm.getAddr32(0, y), pixels + static_cast<size_t>(y) * width, width, color, SK_ColorTRANSPARENT);
     }
 
     // Here we draw the border fragment over the base image.
@@ -1631,59 +1792,47 @@ SkBitmap TPageInterface::colorImage(SkBitmap& base, SkBitmap& alpha, SkColor col
     if (!allocPixels(width, height, &maskBm))
         return SkBitmap();
 
-    maskBm.eraseColor(SK_ColorTRANSPARENT);
+    vector<uint32_t> buffer;
+    const uint32_t *pixels = TPixelKernels::getColors(alpha.empty() ? base : alpha, buffer);
 
-    for (int ix = 0; ix < width; ix++)
+    if (!pixels)
     {
-        for (int iy = 0; iy < height; iy++)
-        {
-            SkColor pixelAlpha = 0;
+        MSG_ERROR("No pixel buffer!");
+        return SkBitmap();
+    }
 
-            if (!alpha.empty())
-                pixelAlpha = alpha.getColor(ix, iy);
-            else
-                pixelAlpha = base.getColor(ix, iy);
+    SkColor zero = (useBG ? bg : col);
 
-            uint32_t *wpix = maskBm.getAddr32(ix, iy);
+    for (int y = 0; y < height; ++y)
+    {
+        uint32_t *wpix = maskBm.getAddr32(0, y);
+        const uint32_t *row = pixels + static_cast<size_t>(y) * width;
 
-            if (!wpix)
-            {
-                MSG_ERROR("No pixel buffer!");
-                break;
-            }
+        if (!alpha.empty())
+        {
+            TPixelKernels::alphaToColor(wpix, row, width, col, zero);
+            continue;
+        }
+
+        // Without an alpha mask the white channels of the base image are
+        // preserved.
+        uint32_t maxChan = SkColorGetG(SK_ColorWHITE);
 
+        for (int x = 0; x < width; ++x)
+        {
+            SkColor pixelAlpha = row[x];
             uint32_t ala = SkColorGetA(pixelAlpha);
 
-            if (ala == 0 && !useBG)
-                pixelAlpha = col;
-            else if (ala == 0)
-                pixelAlpha = bg;
-            else
+            if (ala == 0)
             {
-                // We've to change the red and the blue color channel because
-                // of an error in the Skia library.
-                uint32_t red = SkColorGetR(col);
-                uint32_t green = SkColorGetG(col);
-                uint32_t blue = SkColorGetB(col);
-
-                if (alpha.empty())
-                {
-                    uint32_t pred = SkColorGetR(pixelAlpha);
-                    uint32_t pgreen = SkColorGetG(pixelAlpha);
-                    uint32_t pblue = SkColorGetB(pixelAlpha);
-                    uint32_t maxChan = SkColorGetG(SK_ColorWHITE);
-
-                    red   = ((pred == maxChan) ? pred : red);
-                    green = ((pgreen == maxChan) ? pgreen : green);
-                    blue  = ((pblue == maxChan) ? pblue : blue);
-                }
-                else if (ala == 0)
-                    red = green = blue = 0;
-
-                pixelAlpha = SkColorSetARGB(ala, red, green, blue);
+                wpix[x] = zero;
+                continue;
             }
 
-            *wpix = pixelAlpha;
+            uint32_t red   = (SkColorGetR(pixelAlpha) == maxChan) ? maxChan : SkColorGetR(col);
+            uint32_t green = (SkColorGetG(pixelAlpha) == maxChan) ? maxChan : SkColorGetG(col);
+            uint32_t blue  = (SkColorGetB(pixelAlpha) == maxChan) ? maxChan : SkColorGetB(col);
+            wpix[x] = SkColorSetARGB(ala, red, green, blue);
         }
     }
 
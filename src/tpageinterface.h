@@ -20,6 +20,10 @@
 #define __TPAGEINTERFACE_H__
 
 #include <functional>
+#include <unordered_map>
+#include <cstdint>
+#include <mutex>
+#include <atomic>
 
 #include "tfont.h"
 #include "tbutton.h"
@@ -258,11 +262,13 @@ class TPageInterface : public TSystemButton
         virtual SkBitmap& getBgImage() = 0;
         virtual std::string getFillColor() = 0;
 
-        void setButtons(Button::BUTTONS_T *bt) { mButtons = bt; }
+        void setButtons(Button::BUTTONS_T *bt);
         Button::BUTTONS_T *getButtons() { return mButtons; }
         Button::BUTTONS_T *addButton(Button::TButton* button);
         Button::TButton *getButton(int id);
         std::vector<Button::TButton *> getButtons(int ap, int ad);
+        std::vector<Button::TButton *> getLevelButtons(int lp, int lv);
+        std::vector<Button::TButton *> getButtonsAt(int x, int y);
         std::vector<Button::TButton *> getAllButtons();
         bool hasButton(int id);
         bool sortButtons();
@@ -281,6 +287,8 @@ class TPageInterface : public TSystemButton
         int getSelectedRow(ulong handle);
         std::string getSelectedItem(ulong handle);
         bool haveImage(const Button::SR_T& sr);
+        void getImageFiles(std::vector<std::string>& files);
+        SkBitmap scaleToDevice(const SkBitmap& bm);
         bool tp5Image(SkBitmap *bm, Button::SR_T& sr, int wt, int ht, bool ignFirst=false);
         SkRect justifyBitmap5(Button::SR_T& sr, int wt, int ht, int index, int width, int height, int border_size);
         bool initAnimation(TSubPage *sub, ANIMATION_t *ani);
@@ -324,13 +332,34 @@ class TPageInterface : public TSystemButton
         int numberLines(const std::string& str);
         int getSystemSelection(int ta, std::vector<std::string>& list);
         bool getBorderFragment(const std::string& path, const std::string& pathAlpha, SkBitmap* image, SkColor color);
+        bool loadBorderFragment(const std::string& path, const std::string& pathAlpha, SkBitmap* image, SkColor color);
         SkBitmap retrieveBorderImage(const std::string& pa, const std::string& pb, SkColor color, SkColor bgColor);
         bool retrieveImage(const std::string& path, SkBitmap* image);
         SkBitmap colorImage(SkBitmap& base, SkBitmap& alpha, SkColor col, SkColor bg, bool useBG);
         bool stretchImageWidth(SkBitmap *bm, int width);
         bool stretchImageHeight(SkBitmap *bm, int height);
+        void indexButton(Button::TButton *button);
+        void rebuildButtonIndex();
+        void buildButtonGrid();
+        static uint64_t makeButtonKey(int port, int channel) { return (static_cast<uint64_t>(static_cast<uint32_t>(port)) << 32) | static_cast<uint32_t>(channel); }
 
         Button::BUTTONS_T *mButtons{nullptr};   // Chain of buttons
+        Button::BUTTONS_T *mButtonsLast{nullptr};   // The last button in the chain
+        // Index of the buttons in the chain. The lists of the port/channel
+        // indexes are in the same order as the chain.
+        std::unordered_map<int, Button::TButton *> mButtonIndex;                     // Buttons by button index (bi)
+        std::unordered_map<uint64_t, std::vector<Button::TButton *> > mAddressIndex; // Buttons by address port and channel (ap, ad)
+        std::unordered_map<uint64_t, std::vector<Button::TButton *> > mLevelIndex;   // Buttons by level port and channel (lp, lv)
+        // Uniform grid over the area of the buttons. Each cell contains the
+        // buttons overlapping it in the order of the chain.
+        std::vector<std::vector<Button::TButton *> > mButtonGrid;
+        int mGridLeft{0};                       // Left position of the grid
+        int mGridTop{0};                        // Top position of the grid
+        int mGridColumns{0};                    // Number of columns of the grid
+        int mGridRows{0};                       // Number of rows of the grid
+        std::atomic<bool> mGridValid{false};    // FALSE = The grid must be rebuilt
+        uint64_t mGridGeneration{0};            // The geometry generation of the buttons the grid was built with
+        std::mutex mGridMutex;
         int mLastButton{0};                     // Internal counter for iterating through button chain.
         std::vector<Button::SR_T> sr;           // Button instances
         TFont *mFonts{nullptr};                 // Holds the class with the font list
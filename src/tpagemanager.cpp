@@ -22,6 +22,7 @@
 #include <thread>
 #include <mutex>
 #include <functional>
+#include <algorithm>
 
 #ifdef __ANDROID__
 #   include <QJniObject>
@@ -72,6 +73,10 @@ namespace fs = std::filesystem;
 #include "tsystemsound.h"
 #include "tvalidatefile.h"
 #include "ttpinit.h"
+#include "tthreadpool.h"
+#include "timgcache.h"
+#include "timgsource.h"
+#include "ttextlayout.h"
 #include "tconfig.h"
 #include "tlock.h"
 #include "tintborder.h"
@@ -86,6 +91,7 @@ namespace fs = std::filesystem;
 using std::vector;
 using std::string;
 using std::map;
+using std::unordered_map;
 using std::pair;
 using std::to_string;
 using std::thread;
@@ -1185,6 +1191,8 @@ TPageManager::~TPageManager()
         mSPchain = nullptr;
         setPChain(mPchain);
         setSPChain(mSPchain);
+        clearPageIndex();
+        clearSubPageIndex();
 
         if (mAmxNet)
         {
@@ -1317,6 +1325,7 @@ void TPageManager::initialize()
         delete mFonts;
 
     mFonts = new TFont(mTSettings->getFontFileName(), mTSettings->isG5());
+    TTextLayout::clear();   // The layouts of the old fonts are invalid now
 
     if (TError::isError())
     {
@@ -1805,7 +1814,7 @@ void TPageManager::doCommand(const amx::ANET_COMMAND& cmd)
     if (!cmdLoop_busy)
         runCommands();
 
-    mCommands.push_back(cmd);
+    mCommands.push(cmd);
 }
 
 void TPageManager::commandLoop()
@@ -1820,11 +1829,12 @@ void TPageManager::commandLoop()
 
     while (cmdLoop_busy && !killed && !_restart_)
     {
-        while (mCommands.size() > 0)
-        {
-            amx::ANET_COMMAND bef = mCommands.at(0);
-            mCommands.erase(mCommands.begin());
+        amx::ANET_COMMAND bef;
 
+        // Block until a command arrives. The timeout is only needed to
+        // recognize a termination of the application.
+        while (mCommands.pop(bef, std::chrono::milliseconds(500)))
+        {
             switch (bef.MC)
             {
                 case 0x0006:
@@ -1863,7 +1873,7 @@ void TPageManager::commandLoop()
 
                 case 0x000c:	// Command string
                 {
-                    amx::ANET_MSG_STRING msg = bef.data.message_string;
+                    amx::ANET_MSG_STRING& msg = bef.data.message_string;
 
                     if (msg.length < strlen((char *)&msg.content))
                     {
@@ -1878,10 +1888,10 @@ void TPageManager::commandLoop()
                         msg.content[len] = 0;
                     }
 
-                    if (getCommand((char *)msg.content) == "^UTF" || bef.intern /*|| TTPInit::isG5()*/)  // This is already UTF8!
-                        com.assign((char *)msg.content);
-                    else
-                        com.assign(cp1250ToUTF8((char *)&msg.content));
+                    com.assign((char *)msg.content);
+
+                    if (getCommand(com) != "^UTF" && !bef.intern /*&& !TTPInit::isG5()*/)  // ^UTF is already UTF8!
+                        cp1250ToUTF8InPlace(com);
 
                     parseCommand(bef.device1, msg.port, com);
                     mCmdBuffer.clear();
@@ -1952,11 +1962,14 @@ void TPageManager::commandLoop()
                 }
                 break;
             }
-        }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            if (killed || _restart_)
+                break;
+        }
     }
 
+    TQueue<amx::ANET_COMMAND>::QUEUE_STATS_t stats = mCommands.getStatistics();
+    MSG_DEBUG("Command queue: " << stats.total << " commands, max. depth: " << stats.maxDepth << ", avg. latency: " << stats.avgLatency() << "us, max. latency: " << stats.maxLatency << "us");
     cmdLoop_busy = false;
 }
 
@@ -2130,6 +2143,7 @@ bool TPageManager::run()
 #endif
     _setPage((pg->getNumber() << 16) & 0xffff0000, width, height);
     pg->show();
+    prefetchImages(pg);
 
     TSubPage *subPg = pg->getFirstSubPage();
 
@@ -2179,20 +2193,10 @@ TPage *TPageManager::getPage(int pageID)
 {
     DECL_TRACER("TPageManager::getPage(int pageID)");
 
-    if (pageID <= 0)
+    if (pageID <= 0 || (size_t)pageID >= mPageIndex.size())
         return nullptr;
 
-    PCHAIN_T *p = mPchain;
-
-    while (p)
-    {
-        if (p->page && p->page->getNumber() == pageID)
-            return p->page;
-
-        p = p->next;
-    }
-
-    return nullptr;
+    return mPageIndex[pageID];
 }
 
 TPage *TPageManager::getPage(const string& name)
@@ -2202,17 +2206,12 @@ TPage *TPageManager::getPage(const string& name)
     if (name.empty())
         return nullptr;
 
-    PCHAIN_T *p = mPchain;
+    unordered_map<string, TPage *>::iterator iter = mPageNames.find(name);
 
-    while (p)
-    {
-        if (p->page && p->page->getName().compare(name) == 0)
-            return p->page;
-
-        p = p->next;
-    }
+    if (iter == mPageNames.end())
+        return nullptr;
 
-    return nullptr;
+    return iter->second;
 }
 
 TPage *TPageManager::loadPage(PAGELIST_T& pl, bool *refresh)
@@ -2412,11 +2411,18 @@ bool TPageManager::_setPageDo(int pageID, const string& name, bool forget)
 
     int width = mTSettings->getWidth();
     int height = mTSettings->getHeight();
-
+#ifdef _SCALE_SKIA_
+    if (mScaleFactor != 1.0)
+    {
+        width = (int)((double)width * mScaleFactor);
+        height = (int)((double)height * mScaleFactor);
+    }
+#endif
     if (_setPage)
         _setPage((mActualPage << 16) & 0xffff0000, width, height);
 
     pg->show();
+    prefetchImages(pg);
     return true;
 }
 
@@ -2425,35 +2431,20 @@ TSubPage *TPageManager::getSubPage(int pageID)
 {
     DECL_TRACER("TPageManager::getSubPage(int pageID)");
 
-    if (pageID < REGULAR_SUBPAGE_START)
+    if (pageID < REGULAR_SUBPAGE_START || (size_t)pageID >= mSubPageIndex.size())
         return nullptr;
 
-    SPCHAIN_T *p = mSPchain;
-
-    while(p)
-    {
-        if (p->page->getNumber() == pageID)
-            return p->page;
-
-        p = p->next;
-    }
-
-    return nullptr;
+    return mSubPageIndex[pageID];
 }
 
 TSubPage *TPageManager::getSubPage(const std::string& name)
 {
     DECL_TRACER("TPageManager::getSubPage(const std::string& name)");
 
-    SPCHAIN_T *p = mSPchain;
-
-    while (p)
-    {
-        if (p->page->getName().compare(name) == 0)
-            return p->page;
+    unordered_map<string, TSubPage *>::iterator iter = mSubPageNames.find(name);
 
-        p = p->next;
-    }
+    if (iter != mSubPageNames.end())
+        return iter->second;
 
     MSG_DEBUG("Page " << name << " not found in cache.");
     return nullptr;
@@ -3189,21 +3180,29 @@ bool TPageManager::addPage(TPage* pg)
     chain->page = pg;
     chain->next = nullptr;
 
-    if (mPchain)
-    {
-        PCHAIN_T *p = mPchain;
-
-        while (p->next)
-            p = p->next;
-
-        p->next = chain;
-    }
+    if (mPchainLast)
+        mPchainLast->next = chain;
     else
     {
         mPchain = chain;
         setPChain(mPchain);
     }
 
+    mPchainLast = chain;
+    // Add the page to the index. If there are more pages with the same ID
+    // or name, the first one wins.
+    int id = pg->getNumber();
+
+    if (id > 0)
+    {
+        if ((size_t)id >= mPageIndex.size())
+            mPageIndex.resize(id + 1, nullptr);
+
+        if (!mPageIndex[id])
+            mPageIndex[id] = pg;
+    }
+
+    mPageNames.insert(pair<string, TPage *>(pg->getName(), pg));
 //    MSG_DEBUG("Added page " << chain->page->getName());
     return true;
 }
@@ -3241,24 +3240,65 @@ bool TPageManager::addSubPage(TSubPage* pg)
     chain->page = pg;
     chain->next = nullptr;
 
-    if (mSPchain)
-    {
-        SPCHAIN_T *p = mSPchain;
-
-        while (p->next)
-            p = p->next;
-
-        p->next = chain;
-    }
+    if (mSPchainLast)
+        mSPchainLast->next = chain;
     else
     {
         mSPchain = chain;
         setSPChain(mSPchain);
     }
 
+    mSPchainLast = chain;
+    int id = pg->getNumber();
+
+    if (id > 0)
+    {
+        if ((size_t)id >= mSubPageIndex.size())
+            mSubPageIndex.resize(id + 1, nullptr);
+
+        // If there are subpages with the same number, the first one is
+        // found. This is the same as it is with the names.
+        if (!mSubPageIndex[id])
+            mSubPageIndex[id] = pg;
+    }
+
+    mSubPageNames.insert(pair<string, TSubPage *>(pg->getName(), pg));
+
+    if (!pg->getGroupName().empty())
+        mGroupIndex[pg->getGroupName()].push_back(pg);
+
     return true;
 }
 
+/**
+ * Moves the subpage \p pg into the popup group \p group. Every change of
+ * the group at runtime must be made with this method to keep the index of
+ * the groups up to date.
+ */
+void TPageManager::setSubPageGroup(TSubPage *pg, const string& group)
+{
+    DECL_TRACER("TPageManager::setSubPageGroup(TSubPage *pg, const string& group)");
+
+    if (!pg || pg->getGroupName() == group)
+        return;
+
+    unordered_map<string, vector<TSubPage *> >::iterator iter = mGroupIndex.find(pg->getGroupName());
+
+    if (iter != mGroupIndex.end())
+    {
+        vector<TSubPage *>& pages = iter->second;
+        pages.erase(std::remove(pages.begin(), pages.end(), pg), pages.end());
+
+        if (pages.empty())
+            mGroupIndex.erase(iter);
+    }
+
+    pg->setGroup(group);
+
+    if (!group.empty())
+        mGroupIndex[group].push_back(pg);
+}
+
 void TPageManager::dropAllPages()
 {
     DECL_TRACER("TPageManager::dropAllPages()");
@@ -3284,6 +3324,16 @@ void TPageManager::dropAllPages()
 
     mPchain = nullptr;
     setPChain(mPchain);
+    clearPageIndex();
+}
+
+void TPageManager::clearPageIndex()
+{
+    DECL_TRACER("TPageManager::clearPageIndex()");
+
+    mPchainLast = nullptr;
+    mPageIndex.clear();
+    mPageNames.clear();
 }
 
 void TPageManager::dropAllSubPages()
@@ -3311,6 +3361,66 @@ void TPageManager::dropAllSubPages()
 
     mSPchain = nullptr;
     setSPChain(mSPchain);
+    clearSubPageIndex();
+}
+
+void TPageManager::clearSubPageIndex()
+{
+    DECL_TRACER("TPageManager::clearSubPageIndex()");
+
+    mSPchainLast = nullptr;
+    mSubPageIndex.clear();
+    mSubPageNames.clear();
+    mGroupIndex.clear();
+}
+
+/*
+ * Decodes the images of the pages and popups the buttons of \p page can
+ * open in the background. Only pages and popups already loaded are taken
+ * into account, because the images of the others are unknown until their
+ * files are parsed.
+ */
+void TPageManager::prefetchImages(TPageInterface *page)
+{
+    DECL_TRACER("TPageManager::prefetchImages(TPageInterface *page)");
+
+    if (!page || TConfig::getImageCache() == 0)
+        return;
+
+    vector<TPageInterface *> targets;
+    Button::BUTTONS_T *bt = page->getButtons();
+
+    while (bt)
+    {
+        if (bt->button)
+        {
+            for (const Button::PUSH_FUNC_T& pf : bt->button->getPushFunctions())
+            {
+                if (pf.pfName.empty())
+                    continue;
+
+                TPageInterface *target = nullptr;
+
+                if (strCaseCompare(pf.pfType, "SSHOW") == 0 || strCaseCompare(pf.pfType, "STOGGLE") == 0)
+                    target = getSubPage(pf.pfName);
+                else if (strCaseCompare(pf.pfType, "SCPAGE") == 0 || strCaseCompare(pf.pfType, "STAN") == 0 || strCaseCompare(pf.pfType, "FORGET") == 0)
+                    target = getPage(pf.pfName);
+
+                if (target && target != page && std::find(targets.begin(), targets.end(), target) == targets.end())
+                    targets.push_back(target);
+            }
+        }
+
+        bt = bt->next;
+    }
+
+    vector<string> files;
+
+    for (TPageInterface *target : targets)
+        target->getImageFiles(files);
+
+    if (!files.empty())
+        TImgSource::prefetch(files);
 }
 
 bool TPageManager::destroyAll()
@@ -3500,7 +3610,7 @@ Button::TButton *TPageManager::findBargraph(int lp, int lv, ulong parent)
         if (!pg)
             return nullptr;
 
-        vector<Button::TButton *> pgBtList = pg->getAllButtons();
+        vector<Button::TButton *> pgBtList = pg->getLevelButtons(lp, lv);
         MSG_DEBUG("Found " << pgBtList.size() << " buttons.");
 
         if (pgBtList.size() > 0)
@@ -3532,7 +3642,7 @@ Button::TButton *TPageManager::findBargraph(int lp, int lv, ulong parent)
         return nullptr;
     }
 
-    vector<Button::TButton *> spBtList = sp->getAllButtons();
+    vector<Button::TButton *> spBtList = sp->getLevelButtons(lp, lv);
     MSG_DEBUG("Found " << spBtList.size() << " buttons.");
 
     if (spBtList.size() > 0)
@@ -3868,33 +3978,27 @@ Button::TButton *TPageManager::getCoordMatchPage(int x, int y)
 
     if (page)
     {
-        Button::TButton *bt = page->getLastButton();
+        // Only the buttons near the coordinates are tested. The button on
+        // top comes first.
+        vector<Button::TButton *> buttons = page->getButtonsAt(x, y);
 
-        while (bt)
+        for (Button::TButton *bt : buttons)
         {
             bool clickable = bt->isClickable();
             MSG_DEBUG("Button: " << bt->getButtonIndex() << ", l: " << bt->getLeftPosition() << ", t: " << bt->getTopPosition() << ", r: " << (bt->getLeftPosition() + bt->getWidth()) << ", b: " << (bt->getTopPosition() + bt->getHeight()) << ", x: " << x << ", y: " << y << ", " << (clickable ? "CLICKABLE" : "NOT CLICKABLE"));
 
             if (!clickable)
-            {
-                bt = page->getPreviousButton();
                 continue;
-            }
 
             if (bt->getLeftPosition() <= x && (bt->getLeftPosition() + bt->getWidth()) >= x &&
                 bt->getTopPosition() <= y && (bt->getTopPosition() + bt->getHeight()) >= y)
             {
                 if (!bt->isClickable(x - bt->getLeftPosition(), y - bt->getTopPosition()))
-                {
-                    bt = page->getPreviousButton();
                     continue;
-                }
 
                 MSG_DEBUG("Click matches button " << bt->getButtonIndex() << " (" << bt->getButtonName() << ")");
                 return bt;
             }
-
-            bt = page->getPreviousButton();
         }
     }
 
@@ -3932,17 +4036,7 @@ bool TPageManager::havePage(const string& name)
     if (name.empty())
         return false;
 
-    PCHAIN_T *pg = mPchain;
-
-    while (pg)
-    {
-        if (pg->page && pg->page->getName().compare(name) == 0)
-            return true;
-
-        pg = pg->next;
-    }
-
-    return false;
+    return mPageNames.find(name) != mPageNames.end();
 }
 
 /**
@@ -3961,17 +4055,12 @@ bool TPageManager::haveSubPage(const string& name)
     if (name.empty())
         return false;
 
-    SPCHAIN_T *pg = mSPchain;
+    unordered_map<string, TSubPage *>::iterator iter = mSubPageNames.find(name);
 
-    while (pg)
+    if (iter != mSubPageNames.end())
     {
-        if (pg->page && pg->page->getName().compare(name) == 0)
-        {
-            MSG_DEBUG("Subpage " << pg->page->getNumber() << ", " << name << " found.");
-            return true;
-        }
-
-        pg = pg->next;
+        MSG_DEBUG("Subpage " << iter->second->getNumber() << ", " << name << " found.");
+        return true;
     }
 
     MSG_DEBUG("Subpage " << name << " not found.");
@@ -3982,17 +4071,12 @@ bool TPageManager::haveSubPage(int id)
 {
     DECL_TRACER("TPageManager::haveSubPage(int id)");
 
-    SPCHAIN_T *pg = mSPchain;
+    TSubPage *pg = getSubPage(id);
 
-    while (pg)
+    if (pg)
     {
-        if (pg->page && pg->page->getNumber() == id)
-        {
-            MSG_DEBUG("Subpage " << pg->page->getNumber() << ", " << pg->page->getName() << " found.");
-            return true;
-        }
-
-        pg = pg->next;
+        MSG_DEBUG("Subpage " << pg->getNumber() << ", " << pg->getName() << " found.");
+        return true;
     }
 
     MSG_DEBUG("Subpage " << id << " not found.");
@@ -4055,18 +4139,19 @@ void TPageManager::closeGroup(const string& group)
 {
     DECL_TRACER("TPageManager::closeGroup(const string& group)");
 
-    SPCHAIN_T *pg = mSPchain;
+    unordered_map<string, vector<TSubPage *> >::iterator iter = mGroupIndex.find(group);
 
-    while (pg)
+    if (iter == mGroupIndex.end())
+        return;
+
+    for (TSubPage *pg : iter->second)
     {
-        if (pg->page->getGroupName().compare(group) == 0 && pg->page->isVisible())
+        if (pg->isVisible() && pg->getGroupName() == group)
         {
-            pg->page->regCallDropSubPage(_callDropSubPage);
-            pg->page->drop();
+            pg->regCallDropSubPage(_callDropSubPage);
+            pg->drop();
             break;
         }
-
-        pg = pg->next;
     }
 }
 
@@ -4329,6 +4414,7 @@ void TPageManager::showSubPage(int number, bool force)
     }
 
     pg->show();
+    prefetchImages(pg);
 }
 
 void TPageManager::hideSubPage(const string& name)
@@ -4399,13 +4485,10 @@ TSubPage *TPageManager::loadSubPage(const string& name)
 
 /**
  * @brief TPageManager::runClickQueue - Processing mouse clicks
- * The following method is starting a thread which tests a queue containing
- * the mouse clicks. To not drain the CPU, it sleeps for a short time if there
- * are no more events in the queue.
- * If there is an entry in the queue, it copies it to a local struct and
- * deletes it from the queue. It take always the oldest antry (first entry)
- * and removes this entry from the queue until the queue is empty. This makes
- * it to a FIFO (first in, first out).
+ * The following method is starting a thread which waits for mouse events in
+ * a queue. It blocks until an event arrives. It take always the oldest entry
+ * (first entry) and removes this entry from the queue. This makes it to a
+ * FIFO (first in, first out).
  * Depending on the state of the variable "coords" the method for mouse
  * coordinate click is executed or the method for a handle.
  * The thread runs as long as the variable "mClickQueueRun" is TRUE and the
@@ -4425,32 +4508,33 @@ void TPageManager::runClickQueue()
         std::thread thr = std::thread([=] {
             MSG_PROTOCOL("Thread \"TPageManager::runClickQueue()\" was started.");
 
+            _CLICK_QUEUE_t cq;
+
             while (mClickQueueRun && !prg_stopped)
             {
-                while (!mClickQueue.empty())
-                {
+                // Block until an event arrives. The timeout is only needed to
+                // recognize a termination of the application.
+                if (!mClickQueue.pop(cq, std::chrono::milliseconds(500)))
+                    continue;
 #ifdef QT_DEBUG
-                    if (mClickQueue[0].coords)
-                        MSG_TRACE("TPageManager::runClickQueue() -- executing: _mouseEvent(" << mClickQueue[0].x << ", " << mClickQueue[0].y << ", " << (mClickQueue[0].pressed ? "TRUE" : "FALSE") << ")")
-                    else
-                        MSG_TRACE("TPageManager::runClickQueue() -- executing: _mouseEvent(" << handleToString(mClickQueue[0].handle) << ", " << (mClickQueue[0].pressed ? "TRUE" : "FALSE") << ")")
+                if (cq.coords)
+                    MSG_TRACE("TPageManager::runClickQueue() -- executing: _mouseEvent(" << cq.x << ", " << cq.y << ", " << (cq.pressed ? "TRUE" : "FALSE") << ")")
+                else
+                    MSG_TRACE("TPageManager::runClickQueue() -- executing: _mouseEvent(" << handleToString(cq.handle) << ", " << (cq.pressed ? "TRUE" : "FALSE") << ")")
 #endif
-                    if (mClickQueue[0].eventType == _EVENT_MOUSE_CLICK)
-                    {
-                        if (mClickQueue[0].coords)
-                            _mouseEvent(mClickQueue[0].x, mClickQueue[0].y, mClickQueue[0].pressed);
-                        else
-                            _mouseEvent(mClickQueue[0].handle, mClickQueue[0].x, mClickQueue[0].y, mClickQueue[0].pressed);
-                    }
-                    else  if (mClickQueue[0].eventType == _EVENT_MOUSE_MOVE)
-                        _mouseMoveEvent(mClickQueue[0].x, mClickQueue[0].y);
-
-                    mClickQueue.erase(mClickQueue.begin()); // Remove first entry
+                if (cq.eventType == _EVENT_MOUSE_CLICK)
+                {
+                    if (cq.coords)
+                        _mouseEvent(cq.x, cq.y, cq.pressed);
+                    else
+                        _mouseEvent(cq.handle, cq.x, cq.y, cq.pressed);
                 }
-
-                std::this_thread::sleep_for(std::chrono::microseconds(10));
+                else  if (cq.eventType == _EVENT_MOUSE_MOVE)
+                    _mouseMoveEvent(cq.x, cq.y);
             }
 
+            TQueue<_CLICK_QUEUE_t>::QUEUE_STATS_t stats = mClickQueue.getStatistics();
+            MSG_DEBUG("Click queue: " << stats.total << " events, " << stats.coalesced << " coalesced moves, max. depth: " << stats.maxDepth << ", avg. latency: " << stats.avgLatency() << "us, max. latency: " << stats.maxLatency << "us");
             mClickQueueRun = false;
             return;
         });
@@ -4510,15 +4594,14 @@ void TPageManager::mouseEvent(int x, int y, bool pressed)
 {
     DECL_TRACER("TPageManager::mouseEvent(int x, int y, bool pressed)");
 
-    TTRYLOCK(click_mutex);
-
+    // Presses and releases are never merged.
     _CLICK_QUEUE_t cq;
     cq.eventType = _EVENT_MOUSE_CLICK;
     cq.x = x;
     cq.y = y;
     cq.pressed = pressed;
     cq.coords = true;
-    mClickQueue.push_back(cq);
+    mClickQueue.push(std::move(cq));
 #if TESTMODE == 1
     setScreenDone();
 #endif
@@ -4528,14 +4611,14 @@ void TPageManager::mouseMoveEvent(int x, int y)
 {
     DECL_TRACER("TPageManager::mouseMoveEvent(int x, int y)");
 
-    TTRYLOCK(click_mutex);
-
+    // If the consumer is behind, only the latest position of a move is
+    // kept. A move never replaces a press or release.
     _CLICK_QUEUE_t cq;
     cq.eventType = _EVENT_MOUSE_MOVE;
     cq.x = x;
     cq.y = y;
     cq.coords = true;
-    mClickQueue.push_back(cq);
+    mClickQueue.pushCoalesce(std::move(cq), [](const _CLICK_QUEUE_t& last) { return last.eventType == _EVENT_MOUSE_MOVE; });
 #if TESTMODE == 1
     setScreenDone();
 #endif
@@ -4643,18 +4726,16 @@ void TPageManager::mouseEvent(ulong handle, int x, int y, bool pressed)
 {
     DECL_TRACER("TPageManager::mouseEvent(ulong handle, int x, int y, bool pressed)");
 
-    if (!mClickQueue.empty() && mClickQueue.back().handle == handle && mClickQueue.back().pressed == pressed)
-        return;
-
-    TLOCKER(click_mutex);
-
     _CLICK_QUEUE_t cq;
     cq.handle = handle;
     cq.x = x;
     cq.y = y;
     cq.pressed = pressed;
-    mClickQueue.push_back(cq);
     MSG_DEBUG("Queued click for handle " << handleToString(cq.handle) << " at coordinate " << x << "x" << y << ", state " << (cq.pressed ? "PRESSED" : "RELEASED"));
+    // A repeated event with the same handle and state replaces the waiting one.
+    mClickQueue.pushCoalesce(std::move(cq), [handle, pressed](const _CLICK_QUEUE_t& last) {
+        return !last.coords && last.eventType == _EVENT_MOUSE_CLICK && last.handle == handle && last.pressed == pressed;
+    });
 }
 
 void TPageManager::_mouseEvent(ulong handle, int x, int y, bool pressed)
@@ -5010,23 +5091,13 @@ void TPageManager::androidPlay(const string& file, float volume)
 {
     DECL_TRACER("TPageManager::androidPlay(jstring file, jfloat volume)");
 
-    try
-    {
-        std::thread lThread = std::thread([=] {
-            QJniObject str = QJniObject::fromString(QString::fromStdString(file));
-            QJniObject::callStaticMethod<void>("org/qtproject/theosys/PlaySound", "play", "(Ljava/lang/String;F)V", str.object<jstring>(), static_cast<jfloat>(volume));
-        });
+    bool posted = TThreadPool::post("TPageManager::androidPlay", [=] {
+        QJniObject str = QJniObject::fromString(QString::fromStdString(file));
+        QJniObject::callStaticMethod<void>("org/qtproject/theosys/PlaySound", "play", "(Ljava/lang/String;F)V", str.object<jstring>(), static_cast<jfloat>(volume));
+    });
 
-        lThread.detach();   // We detach immediately to leave this method.
-    }
-    catch (std::exception& e)
-    {
-        MSG_ERROR("Error starting the thread to play a sound!");
-    }
-    catch(...)
-    {
-        MSG_ERROR("Unexpected exception occured [TPageManager::androidPlay()]");
-    }
+    if (!posted)
+        MSG_ERROR("Error queueing the task to play a sound!");
 }
 
 void TPageManager::androidStop()
@@ -6279,7 +6350,7 @@ void TPageManager::doAPG(int, std::vector<int>&, std::vector<std::string>& pars)
     }
 
     page->addSubPage(subPage);
-    subPage->setGroup(pars[1]);
+    setSubPageGroup(subPage, pars[1]);
     subPage->setZOrder(page->getNextZOrder());
     MSG_DEBUG("Setting new Z-order " << page->getActZOrder() << " on page " << page->getName());
     subPage->show();
@@ -6322,7 +6393,7 @@ void TPageManager::doCPG(int, std::vector<int>&, std::vector<std::string>& pars)
                 TSubPage *pg = getSubPage(pgIter->pageID);
 
                 if (pg)
-                    pg->setGroup(pgIter->group);
+                    setSubPageGroup(pg, pgIter->group);
 #if TESTMODE == 1
                 __success = true;
 #endif
@@ -6367,7 +6438,7 @@ void TPageManager::doDPG(int, std::vector<int>&, std::vector<std::string>& pars)
         TSubPage *pg = getSubPage(listPg.pageID);
 
         if (pg)
-            pg->setGroup(listPg.group);
+            setSubPageGroup(pg, listPg.group);
 #if TESTMODE == 1
         __success = true;
 #endif
@@ -12128,6 +12199,13 @@ void TPageManager::doShutdown(int, vector<int>&, vector<string>&)
 #endif
     prg_stopped = true;
     killed = true;
+    mCommands.wakeup();
+    mClickQueue.wakeup();
+    TThreadPool::logStatistics();
+    TImgCache::logStatistics();
+    TImgSource::logStatistics();
+    TTextLayout::logStatistics();
+    TThreadPool::stop();
 
     if (_shutdown)
         _shutdown();
@@ -21,6 +21,7 @@
 
 #include <functional>
 #include <thread>
+#include <unordered_map>
 #ifdef __ANDROID__
 #include <jni.h>
 #endif
@@ -39,6 +40,7 @@
 #include "tsystemdraw.h"
 #include "tsipclient.h"
 #include "tvector.h"
+#include "tqueue.h"
 #include "tbitmap.h"
 #include "tbuttonstates.h"
 #include "tqintercom.h"
@@ -542,9 +544,9 @@ class TPageManager : public TAmxCommands
         void startUp();
         /**
          * This starts a thread running the command loop. Each event from the
-         * Netlinx is entered into a vector array (doCommand()) and this
-         * method starts the event loop as a thread running as long as this
-         * class exists.
+         * Netlinx is entered into a queue (doCommand()) and this method
+         * starts the event loop as a thread running as long as this class
+         * exists.
          */
         void runCommands();
         /**
@@ -562,6 +564,12 @@ class TPageManager : public TAmxCommands
          * An ANET_COMMAND structure containing the received command.
          */
         void doCommand(const amx::ANET_COMMAND& cmd);
+        /**
+         * Returns the statistics of the command queue. This contains the
+         * actual and maximum depth of the queue as well as the time the
+         * commands waited until they were processed.
+         */
+        TQueue<amx::ANET_COMMAND>::QUEUE_STATS_t getCommandStatistics() { return mCommands.getStatistics(); }
         /**
          * Activates the setup pages unless they are not visible already.
          */
@@ -724,6 +732,7 @@ class TPageManager : public TAmxCommands
 
         bool addPage(TPage *pg);
         bool addSubPage(TSubPage *pg);
+        void setSubPageGroup(TSubPage *pg, const std::string& group);
         TSubPage *getCoordMatch(int x, int y);
         Button::TButton *getCoordMatchPage(int x, int y);
         void initialize();
@@ -731,6 +740,9 @@ class TPageManager : public TAmxCommands
         bool startComm();
 
     private:
+        void clearPageIndex();
+        void clearSubPageIndex();
+        void prefetchImages(TPageInterface *page);
         std::function<void (ulong handle, ulong parent, TBitmap image, int width, int height, int left, int top, bool passthrough, int marqtype, int marq)> _displayButton{nullptr};
         std::function<void (Button::TButton *button)> _setMarqueeText{nullptr};
         std::function<void (ulong handle)> _dropButton{nullptr};
@@ -1047,7 +1059,6 @@ class TPageManager : public TAmxCommands
         void doTPCSIP(int port, std::vector<int>& channels, std::vector<std::string>& pars);
 #endif
         std::mutex surface_mutex;
-        std::mutex click_mutex;
         std::mutex updview_mutex;
 
         bool mLevelSend{false};                         // TRUE = Level changes are send to the master
@@ -1065,6 +1076,15 @@ class TPageManager : public TAmxCommands
         TPageList *mPageList{nullptr};                  // List of available pages and subpages
         PCHAIN_T *mPchain{nullptr};                     // Pointer to chain of pages in memory
         SPCHAIN_T *mSPchain{nullptr};                   // Pointer to chain of subpages in memory for the actual page
+        PCHAIN_T *mPchainLast{nullptr};                 // The last page in the chain
+        SPCHAIN_T *mSPchainLast{nullptr};               // The last subpage in the chain
+        // Index of the pages and subpages in the chains. The IDs are indexes
+        // into the vectors.
+        std::vector<TPage *> mPageIndex;                // The pages by ID
+        std::vector<TSubPage *> mSubPageIndex;          // The subpages by ID
+        std::unordered_map<std::string, TPage *> mPageNames;        // The pages by name
+        std::unordered_map<std::string, TSubPage *> mSubPageNames;  // The subpages by name
+        std::unordered_map<std::string, std::vector<TSubPage *> > mGroupIndex;  // The subpages of each popup group in the order they were loaded
         TSettings *mTSettings{nullptr};                 // Pointer to basic settings for the panel
         TPalette *mPalette{nullptr};                    // Pointer to the color handler
         TFont *mFonts{nullptr};                         // Pointer to the font handler
@@ -1072,7 +1092,7 @@ class TPageManager : public TAmxCommands
         TApps *mApps{nullptr};                          // Pointer to external apps for Android (G5)
         TSystemDraw *mSystemDraw{nullptr};              // A pointer to the (optional) system resources
         std::thread mThreadAmxNet;                      // The thread handle to the controler handler
-        TVector<amx::ANET_COMMAND> mCommands;           // Command queue of commands received from controller
+        TQueue<amx::ANET_COMMAND> mCommands;            // Command queue of commands received from controller
         std::string mCmdBuffer;                         // Internal used buffer for commands who need more than one network package
         std::string mAkbText;                           // This is the text for the virtual keyboard (@AKB)
         std::string mAkpText;                           // This is the text for the virtual keyad (@AKP)
@@ -1086,7 +1106,7 @@ class TPageManager : public TAmxCommands
         std::vector<int> mSavedSubpages;                // When setup pages are called this contains the actual open subpages
         std::vector<_FTP_SURFACE_t> mFtpSurface;        // Contains a list of TP4 surface files gained from a NetLinx.
         std::atomic<bool> mClickQueueRun{false};        // TRUE = The click queue thread is running. FALSE: the thread should stop or is not running.
-        std::vector<_CLICK_QUEUE_t> mClickQueue;        // A queue holding click requests. Needed to serialize the clicks.
+        TQueue<_CLICK_QUEUE_t> mClickQueue;             // A queue holding click requests. Needed to serialize the clicks.
         std::vector<Button::TButton *> mUpdateViews;    // A queue for the method "updateSubViewItem()"
         bool mUpdateViewsRun{false};                    // TRUE = The thread for the queue mUpdateViews is running
         std::vector<TButtonStates *> mButtonStates;     // Holds the states for each button
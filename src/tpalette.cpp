@@ -17,6 +17,7 @@
  */
 
 #include "tpalette.h"
+#include "tcolor.h"
 #include "terror.h"
 #include "tconfig.h"
 #include "tresources.h"
@@ -41,7 +42,7 @@ namespace fs = std::filesystem;
 
 using std::string;
 using std::vector;
-using std::map;
+using std::unordered_map;
 using std::pair;
 using namespace Expat;
 
@@ -138,7 +139,7 @@ void TPalette::initialize(const std::string& file)
             }
 
             // Insert color into list and get next child if there is one.
-            mColors.insert(pair<string, PDATA_T>(pal.name, pal));
+            addColor(pal);
         }
 
         pal.clear();
@@ -148,6 +149,7 @@ void TPalette::initialize(const std::string& file)
         addSystemColors();
 
     mPaletteNames.push_back(palName);
+    TColor::clearCache();
 }
 
 void TPalette::reset()
@@ -155,7 +157,9 @@ void TPalette::reset()
     DECL_TRACER("TPalette::reset()");
 
     mColors.clear();
+    mIndex.clear();
     mPaletteNames.clear();
+    TColor::clearCache();
 }
 
 PDATA_T TPalette::findColor(const std::string& name)
@@ -168,7 +172,7 @@ PDATA_T TPalette::findColor(const std::string& name)
         return PDATA_T();
     }
 
-    map<string, PDATA_T>::iterator iter;
+    unordered_map<string, PDATA_T>::iterator iter;
 
     if ((iter = mColors.find(name)) == mColors.end())
         return PDATA_T();
@@ -180,15 +184,30 @@ PDATA_T TPalette::findColor(int pID)
 {
     DECL_TRACER("TPalette::findColor(int pID)");
 
-    map<string, PDATA_T>::iterator iter;
+    unordered_map<int, PDATA_T>::iterator iter;
 
-    for (iter = mColors.begin(); iter != mColors.end(); ++iter)
-    {
-        if (iter->second.index == pID)
-            return iter->second;
-    }
+    if ((iter = mIndex.find(pID)) == mIndex.end())
+        return PDATA_T();
+
+    return iter->second;
+}
+
+/*
+ * Adds a color to the index of names and the index of numbers. If more than
+ * one color has the same index number, the one with the alphabetically first
+ * name is used for this number.
+ */
+void TPalette::addColor(const PDATA_T& pal)
+{
+    DECL_TRACER("TPalette::addColor(const PDATA_T& pal)");
+
+    mColors.insert(pair<string, PDATA_T>(pal.name, pal));
+    unordered_map<int, PDATA_T>::iterator iter = mIndex.find(pal.index);
 
-    return PDATA_T();
+    if (iter == mIndex.end())
+        mIndex.insert(pair<int, PDATA_T>(pal.index, pal));
+    else if (pal.name < iter->second.name)
+        iter->second = pal;
 }
 
 bool TPalette::havePalette(const std::string& name)
@@ -304,5 +323,5 @@ void TPalette::addSystemColors()
     };
 
     for (iter = palArr.begin(); iter != palArr.end(); ++iter)
-        mColors.insert(pair<string, PDATA_T>(iter->name, *iter));
+        addColor(*iter);
 }
@@ -21,6 +21,7 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include "tvalidatefile.h"
 
@@ -53,9 +54,11 @@ class TPalette : public TValidateFile
     private:
         bool havePalette(const std::string& name);
         void addSystemColors();
+        void addColor(const PDATA_T& pal);
 
         std::string mPath;
-        std::map<std::string, PDATA_T> mColors;
+        std::unordered_map<std::string, PDATA_T> mColors;   // The colors by name
+        std::unordered_map<int, PDATA_T> mIndex;            // The colors by index
         std::vector<std::string> mPaletteNames;
         bool mIsG5{false};
 };
@@ -0,0 +1,482 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#include "tpixelkernels.h"
+#include "tresources.h"
+#include "terror.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#   include <immintrin.h>
+#   define KERNEL_X86
+#   if defined(__GNUC__) || defined(__clang__)
+#       define KERNEL_AVX2
+#   endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#   include <arm_neon.h>
+#   define KERNEL_NEON
+#endif
+
+using std::vector;
+
+namespace
+{
+    typedef void (*ALPHA_COLOR_FUNC)(uint32_t *, const uint32_t *, size_t, uint32_t, uint32_t);
+    typedef void (*ALPHA_SOLID_FUNC)(uint32_t *, const uint32_t *, size_t, uint32_t);
+    typedef void (*APPLY_MASK_FUNC)(uint32_t *, const uint32_t *, size_t);
+    typedef void (*CHAMELEON_FUNC)(uint32_t *, const uint32_t *, const uint32_t *, size_t, uint32_t, uint32_t, uint32_t, bool, bool);
+
+    typedef struct _KERNELS_t
+    {
+        TPixelKernels::KERNEL_ISA_t isa;
+        ALPHA_COLOR_FUNC alphaToColor;
+        ALPHA_SOLID_FUNC alphaToSolid;
+        APPLY_MASK_FUNC applyMask;
+        CHAMELEON_FUNC chameleon;
+    }_KERNELS_t;
+
+    const uint32_t ALPHA_MASK = 0xff000000;
+
+    /*
+     * Plain C++ implementation. It is used on all CPUs without a special
+     * implementation and for the pixels at the end of a row.
+     */
+    inline uint32_t alphaToColorPixel(uint32_t s, uint32_t color, uint32_t zero)
+    {
+        uint32_t a = s & ALPHA_MASK;
+        return a ? (a | (color & 0x00ffffff)) : zero;
+    }
+
+    inline uint32_t chameleonPixel(uint32_t b, uint32_t m, uint32_t col1, uint32_t col2, bool swapRB, bool maskOnTransparent)
+    {
+        if (!(b & ALPHA_MASK))
+            return m;
+
+        uint32_t red = swapRB ? (b & 0xff) : ((b >> 16) & 0xff);
+        uint32_t green = (b >> 8) & 0xff;
+        uint32_t sel = 0;
+
+        if (red < green)
+            sel = col2;
+        else if (red || green)
+            sel = col1;
+
+        if (maskOnTransparent && !(sel & ALPHA_MASK))
+            return m;
+
+        return sel;
+    }
+
+    void alphaToColorScalar(uint32_t *dst, const uint32_t *src, size_t count, uint32_t color, uint32_t zero)
+    {
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = alphaToColorPixel(src[i], color, zero);
+    }
+
+    void alphaToSolidScalar(uint32_t *dst, const uint32_t *src, size_t count, uint32_t color)
+    {
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = (src[i] & ALPHA_MASK) ? color : 0;
+    }
+
+    void applyMaskScalar(uint32_t *dst, const uint32_t *mask, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!(mask[i] & ALPHA_MASK))
+                dst[i] = 0;
+        }
+    }
+
+    void chameleonScalar(uint32_t *dst, const uint32_t *base, const uint32_t *mask, size_t count, uint32_t col1, uint32_t col2, uint32_t noMask, bool swapRB, bool maskOnTransparent)
+    {
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = chameleonPixel(base[i], mask ? mask[i] : noMask, col1, col2, swapRB, maskOnTransparent);
+    }
+
+#ifdef KERNEL_X86
+    /*
+     * SSE2 is available on every 64 bit x86 CPU. It processes 4 pixels at
+     * once.
+     */
+    inline __m128i select128(__m128i cond, __m128i a, __m128i b)
+    {
+        return _mm_or_si128(_mm_and_si128(cond, a), _mm_andnot_si128(cond, b));
+    }
+
+    void alphaToColorSSE2(uint32_t *dst, const uint32_t *src, size_t count, uint32_t color, uint32_t zero)
+    {
+        const __m128i amask = _mm_set1_epi32(static_cast<int>(ALPHA_MASK));
+        const __m128i rgb = _mm_set1_epi32(static_cast<int>(color & 0x00ffffff));
+        const __m128i z = _mm_set1_epi32(static_cast<int>(zero));
+        const __m128i null = _mm_setzero_si128();
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            __m128i a = _mm_and_si128(s, amask);
+            __m128i transparent = _mm_cmpeq_epi32(a, null);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), select128(transparent, z, _mm_or_si128(a, rgb)));
+        }
+
+        alphaToColorScalar(dst + i, src + i, count - i, color, zero);
+    }
+
+    void alphaToSolidSSE2(uint32_t *dst, const uint32_t *src, size_t count, uint32_t color)
+    {
+        const __m128i amask = _mm_set1_epi32(static_cast<int>(ALPHA_MASK));
+        const __m128i col = _mm_set1_epi32(static_cast<int>(color));
+        const __m128i null = _mm_setzero_si128();
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            __m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(s, amask), null);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_andnot_si128(transparent, col));
+        }
+
+        alphaToSolidScalar(dst + i, src + i, count - i, color);
+    }
+
+    void applyMaskSSE2(uint32_t *dst, const uint32_t *mask, size_t count)
+    {
+        const __m128i amask = _mm_set1_epi32(static_cast<int>(ALPHA_MASK));
+        const __m128i null = _mm_setzero_si128();
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask + i));
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+            __m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(m, amask), null);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_andnot_si128(transparent, d));
+        }
+
+        applyMaskScalar(dst + i, mask + i, count - i);
+    }
+
+    void chameleonSSE2(uint32_t *dst, const uint32_t *base, const uint32_t *mask, size_t count, uint32_t col1, uint32_t col2, uint32_t noMask, bool swapRB, bool maskOnTransparent)
+    {
+        const __m128i amask = _mm_set1_epi32(static_cast<int>(ALPHA_MASK));
+        const __m128i cmask = _mm_set1_epi32(0xff);
+        const __m128i c1 = _mm_set1_epi32(static_cast<int>(col1));
+        const __m128i c2 = _mm_set1_epi32(static_cast<int>(col2));
+        const __m128i nm = _mm_set1_epi32(static_cast<int>(noMask));
+        const __m128i mot = maskOnTransparent ? _mm_set1_epi32(-1) : _mm_setzero_si128();
+        const __m128i null = _mm_setzero_si128();
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(base + i));
+            __m128i m = mask ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask + i)) : nm;
+            __m128i red = swapRB ? _mm_and_si128(b, cmask) : _mm_and_si128(_mm_srli_epi32(b, 16), cmask);
+            __m128i green = _mm_and_si128(_mm_srli_epi32(b, 8), cmask);
+            // red < green: col2; red or green set: col1; otherwise transparent
+            __m128i none = _mm_cmpeq_epi32(_mm_or_si128(red, green), null);
+            __m128i sel = select128(_mm_cmplt_epi32(red, green), c2, c1);
+            sel = _mm_andnot_si128(none, sel);
+            __m128i useMask = _mm_cmpeq_epi32(_mm_and_si128(b, amask), null);
+            useMask = _mm_or_si128(useMask, _mm_and_si128(mot, _mm_cmpeq_epi32(_mm_and_si128(sel, amask), null)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), select128(useMask, m, sel));
+        }
+
+        chameleonScalar(dst + i, base + i, mask ? mask + i : nullptr, count - i, col1, col2, noMask, swapRB, maskOnTransparent);
+    }
+#endif
+
+#ifdef KERNEL_AVX2
+    /*
+     * AVX2 processes 8 pixels at once. The functions are compiled for AVX2
+     * only and are called only if the CPU supports it.
+     */
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+    AVX2_TARGET inline __m256i select256(__m256i cond, __m256i a, __m256i b)
+    {
+        return _mm256_blendv_epi8(b, a, cond);
+    }
+
+    AVX2_TARGET void alphaToColorAVX2(uint32_t *dst, const uint32_t *src, size_t count, uint32_t color, uint32_t zero)
+    {
+        const __m256i amask = _mm256_set1_epi32(static_cast<int>(ALPHA_MASK));
+        const __m256i rgb = _mm256_set1_epi32(static_cast<int>(color & 0x00ffffff));
+        const __m256i z = _mm256_set1_epi32(static_cast<int>(zero));
+        const __m256i null = _mm256_setzero_si256();
+        size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+            __m256i a = _mm256_and_si256(s, amask);
+            __m256i transparent = _mm256_cmpeq_epi32(a, null);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), select256(transparent, z, _mm256_or_si256(a, rgb)));
+        }
+
+        alphaToColorSSE2(dst + i, src + i, count - i, color, zero);
+    }
+
+    AVX2_TARGET void alphaToSolidAVX2(uint32_t *dst, const uint32_t *src, size_t count, uint32_t color)
+    {
+        const __m256i amask = _mm256_set1_epi32(static_cast<int>(ALPHA_MASK));
+        const __m256i col = _mm256_set1_epi32(static_cast<int>(color));
+        const __m256i null = _mm256_setzero_si256();
+        size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+            __m256i transparent = _mm256_cmpeq_epi32(_mm256_and_si256(s, amask), null);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_andnot_si256(transparent, col));
+        }
+
+        alphaToSolidSSE2(dst + i, src + i, count - i, color);
+    }
+
+    AVX2_TARGET void applyMaskAVX2(uint32_t *dst, const uint32_t *mask, size_t count)
+    {
+        const __m256i amask = _mm256_set1_epi32(static_cast<int>(ALPHA_MASK));
+        const __m256i null = _mm256_setzero_si256();
+        size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mask + i));
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+            __m256i transparent = _mm256_cmpeq_epi32(_mm256_and_si256(m, amask), null);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_andnot_si256(transparent, d));
+        }
+
+        applyMaskSSE2(dst + i, mask + i, count - i);
+    }
+
+    AVX2_TARGET void chameleonAVX2(uint32_t *dst, const uint32_t *base, const uint32_t *mask, size_t count, uint32_t col1, uint32_t col2, uint32_t noMask, bool swapRB, bool maskOnTransparent)
+    {
+        const __m256i amask = _mm256_set1_epi32(static_cast<int>(ALPHA_MASK));
+        const __m256i cmask = _mm256_set1_epi32(0xff);
+        const __m256i c1 = _mm256_set1_epi32(static_cast<int>(col1));
+        const __m256i c2 = _mm256_set1_epi32(static_cast<int>(col2));
+        const __m256i nm = _mm256_set1_epi32(static_cast<int>(noMask));
+        const __m256i mot = maskOnTransparent ? _mm256_set1_epi32(-1) : _mm256_setzero_si256();
+        const __m256i null = _mm256_setzero_si256();
+        size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(base + i));
+            __m256i m = mask ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mask + i)) : nm;
+            __m256i red = swapRB ? _mm256_and_si256(b, cmask) : _mm256_and_si256(_mm256_srli_epi32(b, 16), cmask);
+            __m256i green = _mm256_and_si256(_mm256_srli_epi32(b, 8), cmask);
+            __m256i none = _mm256_cmpeq_epi32(_mm256_or_si256(red, green), null);
+            __m256i sel = select256(_mm256_cmpgt_epi32(green, red), c2, c1);
+            sel = _mm256_andnot_si256(none, sel);
+            __m256i useMask = _mm256_cmpeq_epi32(_mm256_and_si256(b, amask), null);
+            useMask = _mm256_or_si256(useMask, _mm256_and_si256(mot, _mm256_cmpeq_epi32(_mm256_and_si256(sel, amask), null)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), select256(useMask, m, sel));
+        }
+
+        chameleonSSE2(dst + i, base + i, mask ? mask + i : nullptr, count - i, col1, col2, noMask, swapRB, maskOnTransparent);
+    }
+#endif
+
+#ifdef KERNEL_NEON
+    /*
+     * NEON is available on all 64 bit ARM CPUs. It processes 4 pixels at
+     * once.
+     */
+    void alphaToColorNEON(uint32_t *dst, const uint32_t *src, size_t count, uint32_t color, uint32_t zero)
+    {
+        const uint32x4_t amask = vdupq_n_u32(ALPHA_MASK);
+        const uint32x4_t rgb = vdupq_n_u32(color & 0x00ffffff);
+        const uint32x4_t z = vdupq_n_u32(zero);
+        const uint32x4_t null = vdupq_n_u32(0);
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            uint32x4_t a = vandq_u32(vld1q_u32(src + i), amask);
+            uint32x4_t transparent = vceqq_u32(a, null);
+            vst1q_u32(dst + i, vbslq_u32(transparent, z, vorrq_u32(a, rgb)));
+        }
+
+        alphaToColorScalar(dst + i, src + i, count - i, color, zero);
+    }
+
+    void alphaToSolidNEON(uint32_t *dst, const uint32_t *src, size_t count, uint32_t color)
+    {
+        const uint32x4_t amask = vdupq_n_u32(ALPHA_MASK);
+        const uint32x4_t col = vdupq_n_u32(color);
+        const uint32x4_t null = vdupq_n_u32(0);
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            uint32x4_t transparent = vceqq_u32(vandq_u32(vld1q_u32(src + i), amask), null);
+            vst1q_u32(dst + i, vbslq_u32(transparent, null, col));
+        }
+
+        alphaToSolidScalar(dst + i, src + i, count - i, color);
+    }
+
+    void applyMaskNEON(uint32_t *dst, const uint32_t *mask, size_t count)
+    {
+        const uint32x4_t amask = vdupq_n_u32(ALPHA_MASK);
+        const uint32x4_t null = vdupq_n_u32(0);
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            uint32x4_t transparent = vceqq_u32(vandq_u32(vld1q_u32(mask + i), amask), null);
+            vst1q_u32(dst + i, vbslq_u32(transparent, null, vld1q_u32(dst + i)));
+        }
+
+        applyMaskScalar(dst + i, mask + i, count - i);
+    }
+
+    void chameleonNEON(uint32_t *dst, const uint32_t *base, const uint32_t *mask, size_t count, uint32_t col1, uint32_t col2, uint32_t noMask, bool swapRB, bool maskOnTransparent)
+    {
+        const uint32x4_t amask = vdupq_n_u32(ALPHA_MASK);
+        const uint32x4_t cmask = vdupq_n_u32(0xff);
+        const uint32x4_t c1 = vdupq_n_u32(col1);
+        const uint32x4_t c2 = vdupq_n_u32(col2);
+        const uint32x4_t nm = vdupq_n_u32(noMask);
+        const uint32x4_t mot = vdupq_n_u32(maskOnTransparent ? 0xffffffff : 0);
+        const uint32x4_t null = vdupq_n_u32(0);
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            uint32x4_t b = vld1q_u32(base + i);
+            uint32x4_t m = mask ? vld1q_u32(mask + i) : nm;
+            uint32x4_t red = swapRB ? vandq_u32(b, cmask) : vandq_u32(vshrq_n_u32(b, 16), cmask);
+            uint32x4_t green = vandq_u32(vshrq_n_u32(b, 8), cmask);
+            uint32x4_t none = vceqq_u32(vorrq_u32(red, green), null);
+            uint32x4_t sel = vbslq_u32(vcltq_u32(red, green), c2, c1);
+            sel = vbslq_u32(none, null, sel);
+            uint32x4_t useMask = vceqq_u32(vandq_u32(b, amask), null);
+            useMask = vorrq_u32(useMask, vandq_u32(mot, vceqq_u32(vandq_u32(sel, amask), null)));
+            vst1q_u32(dst + i, vbslq_u32(useMask, m, sel));
+        }
+
+        chameleonScalar(dst + i, base + i, mask ? mask + i : nullptr, count - i, col1, col2, noMask, swapRB, maskOnTransparent);
+    }
+#endif
+
+    _KERNELS_t selectKernels()
+    {
+        _KERNELS_t k = { TPixelKernels::ISA_SCALAR, &alphaToColorScalar, &alphaToSolidScalar, &applyMaskScalar, &chameleonScalar };
+#if defined(KERNEL_AVX2)
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2"))
+            return { TPixelKernels::ISA_AVX2, &alphaToColorAVX2, &alphaToSolidAVX2, &applyMaskAVX2, &chameleonAVX2 };
+#endif
+#if defined(KERNEL_X86)
+        k = { TPixelKernels::ISA_SSE2, &alphaToColorSSE2, &alphaToSolidSSE2, &applyMaskSSE2, &chameleonSSE2 };
+#elif defined(KERNEL_NEON)
+        k = { TPixelKernels::ISA_NEON, &alphaToColorNEON, &alphaToSolidNEON, &applyMaskNEON, &chameleonNEON };
+#endif
+        return k;
+    }
+
+    const _KERNELS_t& kernels()
+    {
+        // Initialized thread safe on the first call.
+        static const _KERNELS_t k = selectKernels();
+        return k;
+    }
+}
+
+TPixelKernels::KERNEL_ISA_t TPixelKernels::getISA()
+{
+    return kernels().isa;
+}
+
+const char *TPixelKernels::getISAName()
+{
+    switch(getISA())
+    {
+        case ISA_SSE2:  return "SSE2";
+        case ISA_AVX2:  return "AVX2";
+        case ISA_NEON:  return "NEON";
+        default:
+            return "scalar";
+    }
+}
+
+const uint32_t *TPixelKernels::getColors(const SkBitmap& bm, vector<uint32_t>& buffer)
+{
+    DECL_TRACER("TPixelKernels::getColors(const SkBitmap& bm, vector<uint32_t>& buffer)");
+
+    if (bm.empty() || !bm.getPixels())
+        return nullptr;
+
+    int width = bm.info().width();
+    int height = bm.info().height();
+    SkAlphaType at = bm.info().alphaType();
+    bool bigEndian = isBigEndian();
+
+    // On little endian CPUs a not premultiplied BGRA pixel is the same as
+    // a SkColor.
+    if (!bigEndian && bm.info().colorType() == kBGRA_8888_SkColorType &&
+        (at == kUnpremul_SkAlphaType || at == kOpaque_SkAlphaType) &&
+        bm.rowBytes() == static_cast<size_t>(width) * sizeof(uint32_t))
+        return bm.getAddr32(0, 0);
+
+    buffer.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+
+    if (!bigEndian)
+    {
+        SkImageInfo info = SkImageInfo::Make(width, height, kBGRA_8888_SkColorType, kUnpremul_SkAlphaType);
+
+        if (bm.readPixels(info, buffer.data(), static_cast<size_t>(width) * sizeof(uint32_t), 0, 0))
+            return buffer.data();
+    }
+
+    for (int y = 0; y < height; ++y)
+    {
+        uint32_t *row = buffer.data() + static_cast<size_t>(y) * width;
+
+        for (int x = 0; x < width; ++x)
+            row[x] = bm.getColor(x, y);
+    }
+
+    return buffer.data();
+}
+
+void TPixelKernels::alphaToColor(uint32_t *dst, const uint32_t *src, size_t count, SkColor color, SkColor zero)
+{
+    kernels().alphaToColor(dst, src, count, color, zero);
+}
+
+void TPixelKernels::alphaToSolid(uint32_t *dst, const uint32_t *src, size_t count, SkColor color)
+{
+    kernels().alphaToSolid(dst, src, count, color);
+}
+
+void TPixelKernels::applyMask(uint32_t *dst, const uint32_t *mask, size_t count)
+{
+    kernels().applyMask(dst, mask, count);
+}
+
+void TPixelKernels::chameleon(uint32_t *dst, const uint32_t *base, const uint32_t *mask, size_t count,
+                              SkColor col1, SkColor col2, SkColor noMask, bool swapRB, bool maskOnTransparent)
+{
+    kernels().chameleon(dst, base, mask, count, col1, col2, noMask, swapRB, maskOnTransparent);
+}
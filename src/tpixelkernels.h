@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#ifndef __TPIXELKERNELS_H__
+#define __TPIXELKERNELS_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include <include/core/SkColor.h>
+#include <include/core/SkBitmap.h>
+
+/**
+ * @brief The TPixelKernels class
+ * This class contains the loops used to colorize masks and to draw chameleon
+ * images. All methods work on one row of pixels at a time. The pixels are
+ * 32 bit words in the layout of SkColor (ARGB, not premultiplied).
+ *
+ * Depending on the CPU the methods use SSE2, AVX2 or NEON instructions.
+ * The best available implementation is selected at runtime on the first
+ * call. On all other CPUs a plain C++ implementation is used.
+ */
+class TPixelKernels
+{
+    public:
+        typedef enum KERNEL_ISA_t
+        {
+            ISA_SCALAR,
+            ISA_SSE2,
+            ISA_AVX2,
+            ISA_NEON
+        }KERNEL_ISA_t;
+
+        /**
+         * Returns the instruction set used by the kernels.
+         */
+        static KERNEL_ISA_t getISA();
+        static const char *getISAName();
+        /**
+         * Returns the pixels of the bitmap \b bm as rows of SkColor words.
+         * If the pixels of the bitmap already have this layout, a pointer to
+         * them is returned. Otherwise they are converted into \b buffer.
+         * The length of a row is always the width of the bitmap.
+         *
+         * @param bm        The bitmap.
+         * @param buffer    Receives the converted pixels if necessary.
+         *
+         * @return A pointer to the first pixel or NULL if the bitmap is
+         * empty.
+         */
+        static const uint32_t *getColors(const SkBitmap& bm, std::vector<uint32_t>& buffer);
+        /**
+         * Every pixel with an alpha value other than 0 gets the color
+         * \b color with the alpha value of the pixel in \b src. All other
+         * pixels are set to \b zero.
+         */
+        static void alphaToColor(uint32_t *dst, const uint32_t *src, size_t count, SkColor color, SkColor zero);
+        /**
+         * Every pixel with an alpha value other than 0 is set to \b color.
+         * All other pixels are set to transparent.
+         */
+        static void alphaToSolid(uint32_t *dst, const uint32_t *src, size_t count, SkColor color);
+        /**
+         * Every pixel in \b dst where the pixel in \b mask is transparent is
+         * set to transparent. All other pixels are not changed.
+         */
+        static void applyMask(uint32_t *dst, const uint32_t *mask, size_t count);
+        /**
+         * Mixes the pixels of a chameleon image. The red pixels of \b base
+         * are replaced by \b col1 and the green pixels by \b col2. If both
+         * channels are set, the stronger one wins. Transparent pixels of
+         * \b base are taken from \b mask.
+         *
+         * @param dst       The target row.
+         * @param base      The row of the image with the red and green pixels.
+         * @param mask      The row of the mask image or NULL.
+         * @param count     The number of pixels.
+         * @param col1      The color for red pixels.
+         * @param col2      The color for green pixels.
+         * @param noMask    The mask pixel to use if \b mask is NULL.
+         * @param swapRB    TRUE = The red channel is in the place of blue.
+         * @param maskOnTransparent TRUE = A transparent result is replaced
+         *                  by the mask pixel too.
+         */
+        static void chameleon(uint32_t *dst, const uint32_t *base, const uint32_t *mask, size_t count,
+                              SkColor col1, SkColor col2, SkColor noMask, bool swapRB, bool maskOnTransparent);
+
+    private:
+        TPixelKernels() {}
+};
+
+#endif
@@ -0,0 +1,379 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+#include <QAudioSink>
+#include <QAudioDevice>
+#include <QMediaDevices>
+
+#include "tqsoundplayer.h"
+#include "terror.h"
+
+#define MAX_SOUND_FILE      (4 * 1024 * 1024)   // Maximum size of a sound file to keep in memory
+#define SINK_BUFFER_TIME    20000               // Size of the buffer of the audio sink in microseconds
+
+using std::string;
+using std::vector;
+using std::min;
+
+static inline uint16_t readLE16(const unsigned char *p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t readLE32(const unsigned char *p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+TQSoundPlayer::TQSoundPlayer(QObject *parent)
+    : QIODevice(parent)
+{
+    DECL_TRACER("TQSoundPlayer::TQSoundPlayer(QObject *parent)");
+
+    mFormat.setSampleRate(44100);
+    mFormat.setChannelCount(2);
+    mFormat.setSampleFormat(QAudioFormat::Int16);
+
+    QAudioDevice device = QMediaDevices::defaultAudioOutput();
+
+    if (!device.isNull() && !device.isFormatSupported(mFormat))
+    {
+        QAudioFormat preferred = device.preferredFormat();
+        mFormat.setSampleRate(preferred.sampleRate());
+        mFormat.setChannelCount(preferred.channelCount());
+
+        // The mixer can deliver 16 bit integers or floats.
+        if (preferred.sampleFormat() == QAudioFormat::Float)
+            mFormat.setSampleFormat(QAudioFormat::Float);
+
+        if (!device.isFormatSupported(mFormat))
+        {
+            MSG_WARNING("The audio device supports no usable format. System sounds are played by the media player.");
+            mFormat = QAudioFormat();
+            return;
+        }
+
+        MSG_DEBUG("Using audio format with " << mFormat.sampleRate() << " Hz, " << mFormat.channelCount() << " channels and " << mFormat.bytesPerSample() << " bytes per sample.");
+    }
+}
+
+TQSoundPlayer::~TQSoundPlayer()
+{
+    DECL_TRACER("TQSoundPlayer::~TQSoundPlayer()");
+
+    if (mSink)
+    {
+        mSink->stop();
+        delete mSink;
+        mSink = nullptr;
+    }
+
+    close();
+}
+
+bool TQSoundPlayer::preload(const string& file)
+{
+    DECL_TRACER("TQSoundPlayer::preload(const string& file)");
+
+    if (!mFormat.isValid())
+        return false;
+
+    auto iter = mSounds.find(file);
+
+    // The sound can only be played if the audio sink is running.
+    if (iter != mSounds.end())
+        return iter->second && startSink();
+
+    SAMPLES_t samples;
+
+    if (!decodeWave(file, samples))
+        return false;
+
+    // A file which can't be played by this class is remembered, too.
+    // This way it is not read again on the next try.
+    mSounds.insert(std::pair<string, SAMPLES_t>(file, samples));
+
+    if (!samples)
+        return false;
+
+    MSG_DEBUG("Preloaded sound " << file << " with " << samples->size() << " samples.");
+    return startSink();
+}
+
+bool TQSoundPlayer::play(const string& file, double volume)
+{
+    DECL_TRACER("TQSoundPlayer::play(const string& file, double volume)");
+
+    if (!preload(file))
+        return false;
+
+    SAMPLES_t samples = mSounds[file];
+    float vol = static_cast<float>(std::clamp(volume, 0.0, 1.0));
+    std::lock_guard<std::mutex> guard(mMutex);
+
+    // If the same sound is still playing, it starts again from the
+    // beginning instead of being mixed a second time.
+    for (VOICE_t& voice : mVoices)
+    {
+        if (voice.samples == samples)
+        {
+            voice.pos = 0;
+            voice.volume = vol;
+            return true;
+        }
+    }
+
+    VOICE_t voice;
+    voice.samples = samples;
+    voice.volume = vol;
+    mVoices.push_back(voice);
+    return true;
+}
+
+void TQSoundPlayer::stop()
+{
+    DECL_TRACER("TQSoundPlayer::stop()");
+
+    std::lock_guard<std::mutex> guard(mMutex);
+    mVoices.clear();
+}
+
+qint64 TQSoundPlayer::readData(char *data, qint64 maxlen)
+{
+//    DECL_TRACER("TQSoundPlayer::readData(char *data, qint64 maxlen)");
+
+    qint64 frameBytes = mFormat.bytesPerFrame();
+
+    if (frameBytes <= 0 || maxlen < frameBytes)
+        return 0;
+
+    qint64 len = maxlen - (maxlen % frameBytes);
+    size_t count = static_cast<size_t>(len / mFormat.bytesPerSample());
+    std::lock_guard<std::mutex> guard(mMutex);
+
+    if (mVoices.empty())
+    {
+        memset(data, 0, static_cast<size_t>(len));
+        return len;
+    }
+
+    mMix.assign(count, 0);
+    vector<VOICE_t>::iterator iter = mVoices.begin();
+
+    while (iter != mVoices.end())
+    {
+        const vector<qint16>& samples = *iter->samples;
+        size_t num = min(count, samples.size() - iter->pos);
+        const qint16 *in = samples.data() + iter->pos;
+
+        for (size_t i = 0; i < num; ++i)
+            mMix[i] += static_cast<int>(static_cast<float>(in[i]) * iter->volume);
+
+        iter->pos += num;
+
+        if (iter->pos >= samples.size())
+            iter = mVoices.erase(iter);
+        else
+            ++iter;
+    }
+
+    if (mFormat.sampleFormat() == QAudioFormat::Float)
+    {
+        float *out = reinterpret_cast<float *>(data);
+
+        for (size_t i = 0; i < count; ++i)
+            out[i] = static_cast<float>(std::clamp(mMix[i], -32768, 32767)) / 32768.0f;
+    }
+    else
+    {
+        qint16 *out = reinterpret_cast<qint16 *>(data);
+
+        for (size_t i = 0; i < count; ++i)
+            out[i] = static_cast<qint16>(std::clamp(mMix[i], -32768, 32767));
+    }
+
+    return len;
+}
+
+qint64 TQSoundPlayer::writeData(const char *, qint64)
+{
+    return 0;
+}
+
+qint64 TQSoundPlayer::bytesAvailable() const
+{
+    // The player delivers silence if nothing is playing. Therefore there
+    // is always a full buffer available.
+    return mFormat.bytesForDuration(SINK_BUFFER_TIME) + QIODevice::bytesAvailable();
+}
+
+bool TQSoundPlayer::startSink()
+{
+    DECL_TRACER("TQSoundPlayer::startSink()");
+
+    if (mSink)
+        return true;
+
+    QAudioDevice device = QMediaDevices::defaultAudioOutput();
+
+    if (device.isNull())
+    {
+        MSG_WARNING("No valid audio output device found!");
+        return false;
+    }
+
+    if (!isOpen())
+        open(QIODevice::ReadOnly);
+
+    mSink = new QAudioSink(device, mFormat, this);
+    mSink->setBufferSize(mFormat.bytesForDuration(SINK_BUFFER_TIME));
+    mSink->start(this);
+
+    if (mSink->error() != QAudio::NoError)
+    {
+        MSG_ERROR("Couldn't start the audio sink: error " << mSink->error());
+        delete mSink;
+        mSink = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+bool TQSoundPlayer::decodeWave(const string& file, SAMPLES_t& samples)
+{
+    DECL_TRACER("TQSoundPlayer::decodeWave(const string& file, SAMPLES_t& samples)");
+
+    samples = nullptr;
+    std::ifstream in(file, std::ios::in | std::ios::binary | std::ios::ate);
+
+    if (!in.is_open())
+    {
+        MSG_ERROR("Couldn't open the sound file " << file);
+        return false;
+    }
+
+    std::streamoff length = in.tellg();
+
+    if (length < 44 || length > MAX_SOUND_FILE)
+    {
+        MSG_DEBUG("The file " << file << " has a size of " << length << " bytes and is not cached.");
+        return true;
+    }
+
+    vector<unsigned char> buffer(static_cast<size_t>(length));
+    in.seekg(0);
+    in.read(reinterpret_cast<char *>(buffer.data()), length);
+
+    if (!in || memcmp(buffer.data(), "RIFF", 4) != 0 || memcmp(buffer.data() + 8, "WAVE", 4) != 0)
+    {
+        MSG_DEBUG("The file " << file << " is not a WAV file.");
+        return true;
+    }
+
+    int channels = 0, rate = 0, bits = 0;
+    const unsigned char *data = nullptr;
+    size_t dataSize = 0;
+    size_t pos = 12;
+
+    while (pos + 8 <= buffer.size())
+    {
+        const unsigned char *chunk = buffer.data() + pos;
+        size_t size = readLE32(chunk + 4);
+
+        if (size > buffer.size() - pos - 8)
+            size = buffer.size() - pos - 8;
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16)
+        {
+            if (readLE16(chunk + 8) != 1)   // Only PCM is supported
+            {
+                MSG_DEBUG("The file " << file << " is not an uncompressed WAV file.");
+                return true;
+            }
+
+            channels = readLE16(chunk + 10);
+            rate = static_cast<int>(readLE32(chunk + 12));
+            bits = readLE16(chunk + 22);
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            data = chunk + 8;
+            dataSize = size;
+        }
+
+        pos += 8 + size + (size & 1);
+    }
+
+    if (!data || channels < 1 || rate <= 0 || (bits != 8 && bits != 16))
+    {
+        MSG_DEBUG("The file " << file << " has an unsupported format.");
+        return true;
+    }
+
+    // Convert the samples into the format of the audio sink. The sample
+    // rate is converted by linear interpolation. A mono sound is played on
+    // all channels.
+    size_t bytes = static_cast<size_t>(bits / 8);
+    size_t frames = dataSize / (bytes * static_cast<size_t>(channels));
+    int outRate = mFormat.sampleRate();
+    int outChannels = mFormat.channelCount();
+
+    if (frames == 0 || outRate <= 0 || outChannels <= 0)
+        return true;
+
+    auto sample = [&](size_t frame, int channel) -> int
+    {
+        const unsigned char *p = data + (frame * static_cast<size_t>(channels) + static_cast<size_t>(channel)) * bytes;
+
+        if (bits == 8)
+            return (static_cast<int>(*p) - 128) << 8;
+
+        return static_cast<int16_t>(readLE16(p));
+    };
+
+    size_t outFrames = static_cast<size_t>(static_cast<uint64_t>(frames) * static_cast<uint64_t>(outRate) / static_cast<uint64_t>(rate));
+    std::shared_ptr<vector<qint16>> pcm = std::make_shared<vector<qint16>>(outFrames * static_cast<size_t>(outChannels));
+    qint16 *out = pcm->data();
+    double step = static_cast<double>(rate) / static_cast<double>(outRate);
+
+    for (size_t i = 0; i < outFrames; ++i)
+    {
+        double srcPos = static_cast<double>(i) * step;
+        size_t idx = static_cast<size_t>(srcPos);
+        size_t next = min(idx + 1, frames - 1);
+        double frac = srcPos - static_cast<double>(idx);
+
+        for (int c = 0; c < outChannels; ++c)
+        {
+            int channel = min(c, channels - 1);
+            int s0 = sample(idx, channel);
+            int s1 = sample(next, channel);
+            *out++ = static_cast<qint16>(std::lround(s0 + (s1 - s0) * frac));
+        }
+    }
+
+    samples = pcm;
+    return true;
+}
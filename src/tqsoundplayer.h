@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#ifndef __TQSOUNDPLAYER_H__
+#define __TQSOUNDPLAYER_H__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <QIODevice>
+#include <QAudioFormat>
+
+class QAudioSink;
+
+/**
+ * @brief The TQSoundPlayer class
+ * This class plays short sounds like the touch feedback or the system beeps
+ * with a low latency. The sounds are read and decoded only once and kept in
+ * memory as 16 bit PCM samples with the sample rate and channels of the audio
+ * device. The class itself is the device the audio sink pulls the samples
+ * from. It mixes all sounds currently playing into 16 bit integers or floats,
+ * whichever the device supports. If nothing is playing, it delivers silence.
+ * This way the audio sink is always running and a sound starts within the
+ * next buffer period.
+ *
+ * Only uncompressed WAV files up to a size of MAX_SOUND_FILE bytes are
+ * supported. For any other file play() returns FALSE and the caller must use
+ * another way to play the file.
+ */
+class TQSoundPlayer : public QIODevice
+{
+    public:
+        TQSoundPlayer(QObject *parent);
+        ~TQSoundPlayer();
+
+        /**
+         * Reads and decodes a sound file and keeps the samples in memory.
+         * If the file was already loaded, nothing happens.
+         *
+         * @param file  The path and name of a WAV file.
+         *
+         * @return On success TRUE is returned.
+         */
+        bool preload(const std::string& file);
+        /**
+         * Starts to play a sound. If the sound was not preloaded, it is
+         * loaded first.
+         *
+         * @param file      The path and name of a WAV file.
+         * @param volume    The volume in the range 0.0 to 1.0.
+         *
+         * @return If the sound can't be played by this class, FALSE is
+         * returned.
+         */
+        bool play(const std::string& file, double volume);
+        /**
+         * Stops all sounds currently playing.
+         */
+        void stop();
+
+        qint64 readData(char *data, qint64 maxlen) override;
+        qint64 writeData(const char *data, qint64 len) override;
+        qint64 bytesAvailable() const override;
+        bool isSequential() const override { return true; }
+
+    private:
+        typedef std::shared_ptr<const std::vector<qint16>> SAMPLES_t;
+
+        typedef struct VOICE_t
+        {
+            SAMPLES_t samples;      // The decoded sound
+            size_t pos{0};          // The next sample to play
+            float volume{1.0};      // The volume of this sound
+        }VOICE_t;
+
+        bool startSink();
+        bool decodeWave(const std::string& file, SAMPLES_t& samples);
+
+        QAudioFormat mFormat;                       // The format of the audio device
+        QAudioSink *mSink{nullptr};                 // The audio sink pulling the samples
+        std::map<std::string, SAMPLES_t> mSounds;   // The decoded sounds
+        std::vector<VOICE_t> mVoices;               // The sounds currently playing
+        std::vector<int> mMix;                      // The sum of the sounds before they are clipped
+        std::mutex mMutex;
+};
+
+#endif
@@ -135,7 +135,9 @@ void TQtInputLine::on_lineEdit_textChanged(const QString& arg1)
 template<typename T>
 void TQtInputLine::scaleObject(T *obj)
 {
-    DECL_TRACER("TQtInputLine::scaleObject(T *obj): " + obj->objectName().toStdString());
+    DECL_TRACER("TQtInputLine::scaleObject(T *obj)");
+
+    MSG_DEBUG("Scaling object " << obj->objectName().toStdString());
 
     QSize size = obj->size();
     size.scale(scale(size.width()), scale(size.height()), Qt::KeepAspectRatio);
@@ -86,7 +86,10 @@
 #include "tqtwait.h"
 #include "terror.h"
 #include "tresources.h"
+#include "tthreadpool.h"
 #include "tqscrollarea.h"
+#include "tqsoundplayer.h"
+#include "tsystemsound.h"
 #include "tlock.h"
 #include "build.h"
 #ifdef Q_OS_IOS
@@ -577,6 +580,9 @@ MainWindow::MainWindow()
     gPageManager->deployCallbacks();
 
     createActions();        // Create the toolbar, if enabled by settings.
+#ifndef Q_OS_ANDROID
+    preloadSounds();        // Decode the system sounds for a fast touch feedback.
+#endif
 
     // Some types used to transport data from the layer below.
     qRegisterMetaType<size_t>("size_t");
@@ -3428,11 +3434,12 @@ void MainWindow::repaintObjects()
 {
     DECL_TRACER("MainWindow::repaintObjects()");
 
-    if (mRunRedraw)
+    // The flag is set before the task is queued. Otherwise several tasks
+    // could be queued until the first one starts.
+    if (mRunRedraw.exchange(true))
         return;
 
-    std::thread thr = std::thread([=] {
-        mRunRedraw = true;
+    bool posted = TThreadPool::post("MainWindow::repaintObjects", [=] {
         TObject::OBJECT_t *obj = getFirstDirty();
 
         while (obj)
@@ -3453,7 +3460,8 @@ void MainWindow::repaintObjects()
         mRunRedraw = false;
     });
 
-    thr.detach();
+    if (!posted)
+        mRunRedraw = false;
 }
 
 void MainWindow::refresh(ulong handle)
@@ -5953,6 +5961,17 @@ void MainWindow::playSound(const string& file)
 
     gPageManager->androidPlay(file, static_cast<float>(TConfig::getSystemVolume() / 100.0));
 #else
+    // The system sounds are played from memory. Only if the file can't be
+    // played this way, the media player is used.
+    if (mSoundPlayer && mSoundPlayer->play(file, calcVolume(TConfig::getSystemVolume())))
+    {
+#if TESTMODE == 1
+        __success = true;
+        setAllDone();
+#endif
+        return;
+    }
+
     if (!mMediaPlayer)
     {
         mMediaPlayer = new QMediaPlayer(this);
@@ -6018,6 +6037,28 @@ void MainWindow::playSound(const string& file)
 #endif  // Q_OS_ANDROID
 }
 
+#ifndef Q_OS_ANDROID
+void MainWindow::preloadSounds()
+{
+    DECL_TRACER("MainWindow::preloadSounds()");
+
+    if (!mSoundPlayer)
+        mSoundPlayer = new TQSoundPlayer(this);
+
+    string path = TConfig::getSystemPath(TConfig::SOUNDS);
+    string touch = TSystemSound::getCachedTouchSound();
+
+    if (!touch.empty())
+        mSoundPlayer->preload(touch);
+
+    if (!TConfig::getSingleBeepSound().empty())
+        mSoundPlayer->preload(path + "/" + TConfig::getSingleBeepSound());
+
+    if (!TConfig::getDoubleBeepSound().empty())
+        mSoundPlayer->preload(path + "/" + TConfig::getDoubleBeepSound());
+}
+#endif
+
 void MainWindow::stopSound()
 {
     DECL_TRACER("MainWindow::stopSound()");
@@ -6026,6 +6067,9 @@ void MainWindow::stopSound()
     if (gPageManager)
         gPageManager->androidStop();
 #else
+    if (mSoundPlayer)
+        mSoundPlayer->stop();
+
     if (mMediaPlayer)
         mMediaPlayer->stop();
 #endif  // Q_OS_ANDROID
@@ -6329,30 +6373,40 @@ void MainWindow::playShowList()
 
 int MainWindow::scale(int value)
 {
-#if defined(Q_OS_ANDROID) || defined(Q_OS_IOS)
-    double s = gScale;
+#ifdef _SCALE_SKIA_
+    // Skia delivers all objects in their final size and position.
+    return value;
 #else
+#   if defined(Q_OS_ANDROID) || defined(Q_OS_IOS)
+    double s = gScale;
+#   else
     double s = mScaleFactor;
-#endif
+#   endif
     if (value <= 0 || s == 1.0 || s < 0.0)
         return value;
 
     return static_cast<int>(static_cast<double>(value) * s);
+#endif
 }
 
 bool MainWindow::isScaled()
 {
     DECL_TRACER("MainWindow::isScaled()");
-
-#if defined(Q_OS_ANDROID) || defined(Q_OS_IOS)
-    double s = gScale;
+#ifdef _SCALE_SKIA_
+    // The objects are rendered in their final size by Skia. Qt must neither
+    // scale the images nor the coordinates.
+    return false;
 #else
+#   if defined(Q_OS_ANDROID) || defined(Q_OS_IOS)
+    double s = gScale;
+#   else
     double s = mScaleFactor;
-#endif
+#   endif
     if (s > 0.0 && s != 1.0 && gPageManager && TConfig::getScale())
         return true;
 
     return false;
+#endif
 }
 
 /**
@@ -6630,57 +6684,30 @@ void MainWindow::onInputChanged(ulong handle, string& text)
 {
     DECL_TRACER("MainWindow::onInputChanged(ulong handle, string& text)");
 
-    try
-    {
-        std::thread thr = std::thread([=] {
-            if (gPageManager)
-                gPageManager->inputButtonFinished(handle, text);
-        });
-
-        thr.detach();
-    }
-    catch (std::exception& e)
-    {
-        MSG_ERROR("Error starting a thread to handle input line finish: " << e.what());
-    }
+    TThreadPool::post("MainWindow::onInputChanged", [=] {
+        if (gPageManager)
+            gPageManager->inputButtonFinished(handle, text);
+    });
 }
 
 void MainWindow::onFocusChanged(ulong handle, bool in)
 {
     DECL_TRACER("MainWindow::onFocusChanged(ulong handle, bool in)");
 
-    try
-    {
-        std::thread thr = std::thread([=] {
-            if (gPageManager)
-                gPageManager->inputFocusChanged(handle, in);
-        });
-
-        thr.detach();
-    }
-    catch (std::exception& e)
-    {
-        MSG_ERROR("Error starting a thread to handle input line finish: " << e.what());
-    }
+    TThreadPool::post("MainWindow::onFocusChanged", [=] {
+        if (gPageManager)
+            gPageManager->inputFocusChanged(handle, in);
+    });
 }
 
 void MainWindow::onCursorChanged(ulong handle, int oldPos, int newPos)
 {
     DECL_TRACER("MainWindow::onCursorChanged(ulong handle, int oldPos, int newPos)");
 
-    try
-    {
-        std::thread thr = std::thread([=] {
-            if (gPageManager)
-                gPageManager->inputCursorPositionChanged(handle, oldPos, newPos);
-        });
-
-        thr.detach();
-    }
-    catch (std::exception& e)
-    {
-        MSG_ERROR("Error starting a thread to handle input line finish: " << e.what());
-    }
+    TThreadPool::post("MainWindow::onCursorChanged", [=] {
+        if (gPageManager)
+            gPageManager->inputCursorPositionChanged(handle, oldPos, newPos);
+    });
 }
 
 void MainWindow::onGestureEvent(QObject *obj, QGestureEvent *event)
@@ -58,6 +58,7 @@ class QGeoPositionInfo;
 class QAudioOutput;
 #endif
 class TQtSettings;
+class TQSoundPlayer;
 class TQKeyboard;
 class TQKeypad;
 class TQBusy;
@@ -371,6 +372,9 @@ class MainWindow : public QMainWindow, public TObject
         void markDirty(ulong handle);
         QFont loadFont(int number, const FONT_T& f, const FONT_STYLE fs);
         double calcVolume(int value);
+#ifndef Q_OS_ANDROID
+        void preloadSounds();
+#endif
         std::string convertMask(const std::string& mask);
 #ifdef Q_OS_ANDROID
         void hideAndroidBars();
@@ -418,6 +422,9 @@ class MainWindow : public QMainWindow, public TObject
         std::atomic<bool>mRunRedraw{false};
         QGeoPositionInfoSource *mSource{nullptr};   // The geo location is used on IOS to keep app running in background
         QAudioOutput *mAudioOutput{nullptr};
+#ifndef Q_OS_ANDROID
+        TQSoundPlayer *mSoundPlayer{nullptr};   // Plays the system sounds with low latency
+#endif
 #ifdef Q_OS_IOS
         TIOSBattery *mIosBattery{nullptr};  // Class to retrive the battery status on an iPhone or iPad
         TIOSRotate *mIosRotate{nullptr};    // Class to control rotation
@@ -385,7 +385,9 @@ void TQtPhone::setPhoneState(int state, int id)
 template<typename T>
 void TQtPhone::scaleObject(T *obj)
 {
-    DECL_TRACER("TQtPhone::scaleObject(T *obj): " + obj->objectName().toStdString());
+    DECL_TRACER("TQtPhone::scaleObject(T *obj)");
+
+    MSG_DEBUG("Scaling object " << obj->objectName().toStdString());
 
     QSize size = obj->size();
     size.scale(scale(size.width()), scale(size.height()), Qt::KeepAspectRatio);
@@ -143,7 +143,9 @@ int TQtWait::scale(int value)
 template<typename T>
 void TQtWait::scaleObject(T *obj)
 {
-    DECL_TRACER("TQtWait::scaleObject(T *obj): " + obj->objectName().toStdString());
+    DECL_TRACER("TQtWait::scaleObject(T *obj)");
+
+    MSG_DEBUG("Scaling object " << obj->objectName().toStdString());
 
     QSize size = obj->size();
     size.scale(scale(size.width()), scale(size.height()), Qt::KeepAspectRatio);
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#ifndef __TQUEUE_H__
+#define __TQUEUE_H__
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief The TQueue class
+ * This is a thread safe FIFO queue for one or more producer threads
+ * and one consumer thread. In opposite to TVector the consumer doesn't need
+ * to poll the queue. It blocks in pop() until either a new element arrives
+ * or the timeout is reached. The elements are moved in and out of the queue
+ * to avoid copying large structures.
+ *
+ * Additionaly the class counts some statistics about the queue. This are the
+ * maximum depth, the number of elements passed the queue, the number of
+ * elements merged into a waiting element and the time an element waited in
+ * the queue until it was taken by the consumer.
+ */
+template <class T>
+class TQueue
+{
+    public:
+        typedef std::chrono::steady_clock clock_type;
+
+        typedef struct QUEUE_STATS_t
+        {
+            size_t depth{0};            // Actual number of elements in the queue
+            size_t maxDepth{0};         // Maximum number of elements ever in the queue
+            uint64_t total{0};          // Number of elements passed the queue
+            uint64_t coalesced{0};      // Number of elements which replaced the newest waiting element
+            uint64_t maxLatency{0};     // Maximum time in microseconds an element waited in the queue
+            uint64_t sumLatency{0};     // Sum of all waiting times in microseconds
+
+            uint64_t avgLatency() const { return total ? sumLatency / total : 0; }
+        }QUEUE_STATS_t;
+
+        TQueue() {}
+        TQueue(const TQueue&) = delete;
+        TQueue& operator=(const TQueue&) = delete;
+
+        void push(const T& val)
+        {
+            {
+                std::lock_guard<std::mutex> guard(mMutex);
+                mQueue.emplace_back(val, clock_type::now());
+                updateDepth();
+            }
+
+            mCond.notify_one();
+        }
+
+        void push(T&& val)
+        {
+            {
+                std::lock_guard<std::mutex> guard(mMutex);
+                mQueue.emplace_back(std::move(val), clock_type::now());
+                updateDepth();
+            }
+
+            mCond.notify_one();
+        }
+
+        /**
+         * Replaces the newest element in the queue if \p replace returns
+         * TRUE for it. Otherwise the element is appended. A replaced element
+         * keeps the time it was queued first. This way the measured latency
+         * includes the time the element was coalesced.
+         *
+         * @param val       The new element.
+         * @param replace   A function getting the newest element in the
+         * queue. It must return TRUE if this element can be replaced by
+         * \p val.
+         */
+        template <class Pred>
+        void pushCoalesce(T&& val, Pred replace)
+        {
+            {
+                std::lock_guard<std::mutex> guard(mMutex);
+
+                if (!mQueue.empty() && replace(static_cast<const T&>(mQueue.back().first)))
+                {
+                    mQueue.back().first = std::move(val);
+                    mStats.coalesced++;
+                    return;
+                }
+
+                mQueue.emplace_back(std::move(val), clock_type::now());
+                updateDepth();
+            }
+
+            mCond.notify_one();
+        }
+
+        /**
+         * Waits until an element is available or the timeout is reached.
+         *
+         * @param val       Receives the oldest element of the queue.
+         * @param timeout   The maximum time to wait for an element.
+         *
+         * @return On success TRUE is returned. If the timeout was reached
+         * or the method wakeup() was called while the queue is empty, FALSE
+         * is returned.
+         */
+        bool pop(T& val, std::chrono::milliseconds timeout)
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+
+            if (mQueue.empty())
+            {
+                mCond.wait_for(lock, timeout, [this] { return !mQueue.empty() || mWakeup; });
+                mWakeup = false;
+
+                if (mQueue.empty())
+                    return false;
+            }
+
+            val = std::move(mQueue.front().first);
+            uint64_t lat = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - mQueue.front().second).count());
+            mQueue.pop_front();
+            mStats.depth = mQueue.size();
+            mStats.total++;
+            mStats.sumLatency += lat;
+
+            if (lat > mStats.maxLatency)
+                mStats.maxLatency = lat;
+
+            return true;
+        }
+
+        /**
+         * Releases a thread waiting in pop(). This is used to stop the
+         * consumer without waiting for the timeout.
+         */
+        void wakeup()
+        {
+            {
+                std::lock_guard<std::mutex> guard(mMutex);
+                mWakeup = true;
+            }
+
+            mCond.notify_all();
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+            mQueue.clear();
+            mStats.depth = 0;
+        }
+
+        size_t size()
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+            return mQueue.size();
+        }
+
+        bool empty()
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+            return mQueue.empty();
+        }
+
+        QUEUE_STATS_t getStatistics()
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+            return mStats;
+        }
+
+    private:
+        void updateDepth()
+        {
+            mStats.depth = mQueue.size();
+
+            if (mStats.depth > mStats.maxDepth)
+                mStats.maxDepth = mStats.depth;
+        }
+
+        std::deque<std::pair<T, clock_type::time_point>> mQueue;
+        std::mutex mMutex;
+        std::condition_variable mCond;
+        bool mWakeup{false};
+        QUEUE_STATS_t mStats;
+};
+
+#endif
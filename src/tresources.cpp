@@ -28,6 +28,15 @@
 
 #include <iconv.h>
 #include <libgen.h>
+#include <array>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#   include <emmintrin.h>
+#   define ASCII_SSE2
+#elif defined(__aarch64__)
+#   include <arm_neon.h>
+#   define ASCII_NEON
+#endif
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -226,6 +235,101 @@ static CHTABLE __cht[] = {
     {0xFF,	0xCB99}
 };
 
+/**
+ * The UTF-8 sequence of a CP1250 character.
+ */
+typedef struct
+{
+    unsigned char len;
+    char bytes[3];
+}UTF8CHAR_t;
+
+/**
+ * Returns a table with the UTF-8 sequence of each CP1250 character. The
+ * table is calculated once from __cht on the first call.
+ */
+static const UTF8CHAR_t *getCp1250Table()
+{
+    static const std::array<UTF8CHAR_t, 256> table = []
+    {
+        std::array<UTF8CHAR_t, 256> t{};
+
+        for (unsigned int ch = 0; ch < 256; ++ch)
+        {
+            unsigned int utf = ch;
+
+            if (ch >= 0x80)
+            {
+                for (size_t i = 0; i < sizeof(__cht) / sizeof(CHTABLE); ++i)
+                {
+                    if (__cht[i].ch == ch)
+                    {
+                        utf = __cht[i].byte;
+                        break;
+                    }
+                }
+            }
+
+            UTF8CHAR_t& u = t[ch];
+
+            if (utf > 0x00ffff)
+            {
+                u.len = 3;
+                u.bytes[0] = static_cast<char>((utf >> 16) & 0x0000ff);
+                u.bytes[1] = static_cast<char>((utf >> 8) & 0x0000ff);
+                u.bytes[2] = static_cast<char>(utf & 0x0000ff);
+            }
+            else if (utf > 0x0000ff)
+            {
+                u.len = 2;
+                u.bytes[0] = static_cast<char>((utf >> 8) & 0x0000ff);
+                u.bytes[1] = static_cast<char>(utf & 0x0000ff);
+            }
+            else if (ch > 0x7f)
+            {
+                u.len = 2;
+                u.bytes[0] = static_cast<char>(0xc0 | ch >> 6);
+                u.bytes[1] = static_cast<char>(0x80 | (ch & 0x3f));
+            }
+            else
+            {
+                u.len = 1;
+                u.bytes[0] = static_cast<char>(ch);
+            }
+        }
+
+        return t;
+    }();
+
+    return table.data();
+}
+
+/**
+ * Returns the number of plain ASCII characters at the start of \p str.
+ * With SSE2 or NEON 16 bytes are tested at once.
+ */
+static size_t asciiLength(const unsigned char *str, size_t len)
+{
+    size_t i = 0;
+#if defined(ASCII_SSE2)
+    for (; i + 16 <= len; i += 16)
+    {
+        if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(str + i))) != 0)
+            break;
+    }
+#elif defined(ASCII_NEON)
+    for (; i + 16 <= len; i += 16)
+    {
+        if (vmaxvq_u8(vld1q_u8(str + i)) >= 0x80)
+            break;
+    }
+#endif
+    while (i < len && str[i] < 0x80)
+        i++;
+
+    return i;
+}
+
 SkString GetResourcePath(const char* resource, _RESOURCE_TYPE rs)
 {
     if (!resource)
@@ -378,6 +482,36 @@ SkBitmap *allocPixels(int width, int height, SkBitmap *bm)
     return bm;
 }
 
+/*
+ * Resamples the image \p src into a new image of the size \p width x
+ * \p height. The pixels are scaled directly with a cubic filter. There is
+ * no canvas involved, which makes it faster than drawing the image.
+ */
+bool scaleBitmap(const SkBitmap& src, SkBitmap *dst, int width, int height)
+{
+    DECL_TRACER("scaleBitmap(const SkBitmap& src, SkBitmap *dst, int width, int height)");
+
+    if (!dst || src.empty() || width <= 0 || height <= 0)
+        return false;
+
+    SkBitmap bm;
+
+    if (!bm.tryAllocPixels(src.info().makeWH(width, height)))
+    {
+        MSG_ERROR("Error allocating " << (width * height) << " pixels!");
+        return false;
+    }
+
+    if (!src.pixmap().scalePixels(bm.pixmap(), SkSamplingOptions(SkCubicResampler::Mitchell())))
+    {
+        MSG_ERROR("Error scaling an image from " << src.width() << "x" << src.height() << " to " << width << "x" << height);
+        return false;
+    }
+
+    *dst = bm;
+    return true;
+}
+
 SkColor reverseColor(const SkColor& col)
 {
     DECL_TRACER("reverseColor(const SkColor& col)");
@@ -498,60 +632,76 @@ string cp1250ToUTF8(const string& str)
 {
     DECL_TRACER("cp1250ToUTF8(const string& str)");
 
-    string out;
+    const unsigned char *src = reinterpret_cast<const unsigned char *>(str.data());
+    size_t len = str.length();
+    size_t start = asciiLength(src, len);
 
-    for (size_t j = 0; j < str.length(); j++)
-    {
-        int i = -1;
-        unsigned char ch = str.at(j);
-        unsigned int utf = 0x80000000;
+    if (start == len)
+        return str;
 
-        if (ch >= 0x80)
-        {
-            do
-            {
-                i++;
+    const UTF8CHAR_t *table = getCp1250Table();
+    size_t size = start;
 
-                if (__cht[i].ch == ch)
-                {
-                    utf = __cht[i].byte;
-                    break;
-                }
-            }
-            while (__cht[i].ch != 0xff);
+    for (size_t i = start; i < len; ++i)
+        size += table[src[i]].len;
 
-            if (utf == 0x80000000)
-                utf = ch;
-        }
-        else
-            utf = ch;
+    string out;
+    out.reserve(size);
+    out.append(str, 0, start);
+    size_t pos = start;
 
-        if (utf > 0x00ffff)
-        {
-            out.push_back((utf >> 16) & 0x0000ff);
-            out.push_back((utf >> 8) & 0x0000ff);
-            out.push_back(utf & 0x0000ff);
-        }
-        else if (utf > 0x0000ff)
-        {
-            out.push_back((utf >> 8) & 0x0000ff);
-            out.push_back(utf & 0x0000ff);
-        }
-        else if (ch > 0x7f)
-        {
-            out.push_back(0xc0 | ch >> 6);
-            out.push_back(0x80 | (ch & 0x3f));
-        }
-        else
-            out.push_back(ch);
+    while (pos < len)
+    {
+        const UTF8CHAR_t& u = table[src[pos]];
+        out.append(u.bytes, u.len);
+        pos++;
+        // Copy the following plain ASCII in one step
+        size_t run = asciiLength(src + pos, len - pos);
+        out.append(reinterpret_cast<const char *>(src + pos), run);
+        pos += run;
     }
 
     return out;
 }
 
+void cp1250ToUTF8InPlace(string& str)
+{
+    DECL_TRACER("cp1250ToUTF8InPlace(string& str)");
+
+    size_t len = str.length();
+    size_t start = asciiLength(reinterpret_cast<const unsigned char *>(str.data()), len);
+
+    if (start == len)
+        return;
+
+    const UTF8CHAR_t *table = getCp1250Table();
+    size_t size = start;
+
+    for (size_t i = start; i < len; ++i)
+        size += table[static_cast<unsigned char>(str[i])].len;
+
+    str.resize(size);
+    char *buf = &str[0];
+    size_t out = size;
+
+    // The conversion starts at the end. Because no character gets shorter,
+    // a byte is never overwritten before it was read.
+    for (size_t i = len; i-- > start;)
+    {
+        const UTF8CHAR_t& u = table[static_cast<unsigned char>(buf[i])];
+        out -= u.len;
+        memcpy(buf + out, u.bytes, u.len);
+    }
+}
+
 string UTF8ToCp1250(const string& str)
 {
     DECL_TRACER("UTF8ToCp1250(const string& str)");
+
+    // Plain ASCII is the same in both character sets.
+    if (asciiLength(reinterpret_cast<const unsigned char *>(str.data()), str.length()) == str.length())
+        return str;
+
 #if defined(__ANDROID__) || (defined(__APPLE__) && (TARGET_OS_IOS || TARGET_OS_SIMULATOR))
     string out;
     string::const_iterator iter;
@@ -98,6 +98,7 @@ sk_sp<SkTypeface> MakeResourceAsTypeface(const char* resource, int ttcIndex = 0,
 
 sk_sp<SkData> readImage(const std::string& fname);
 SkBitmap *allocPixels(int width, int height, SkBitmap *bm);
+bool scaleBitmap(const SkBitmap& src, SkBitmap *dst, int width, int height);
 SkColor reverseColor(const SkColor& col);
 #if SKIAV >= 20250812
 sk_sp<SkFontMgr> getFontManager();
@@ -108,6 +109,11 @@ std::string& toUpper(std::string& str);
 std::vector<std::string> StrSplit(const std::string& str, const std::string& seps, const bool trimEmpty=false);
 std::string UTF8ToCp1250(const std::string& str);
 std::string cp1250ToUTF8(const std::string& str);
+/**
+ * Converts \p str from CP1250 into UTF-8 without a temporary string. If
+ * the string contains only ASCII, it is not touched at all.
+ */
+void cp1250ToUTF8InPlace(std::string& str);
 std::string latin1ToUTF8(const std::string& str);
 std::string intToString(int num);
 std::string ReplaceString(const std::string subject, const std::string& search, const std::string& replace);
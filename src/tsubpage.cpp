@@ -23,6 +23,7 @@
 #include <include/core/SkTextBlob.h>
 
 #include "tresources.h"
+#include "timgsource.h"
 #include "texpat++.h"
 #include "tpagemanager.h"
 #include "tsubpage.h"
@@ -106,6 +107,8 @@ TSubPage::~TSubPage()
 {
     DECL_TRACER("TSubPage::~TSubPage()");
 
+    stopTimer();
+
     if (mSubpage.name.empty())
     {
         MSG_WARNING("Invalid page found!");
@@ -542,29 +545,23 @@ bool TSubPage::createPage(bool force)
             if (!TTPInit::isG5() && !mSubpage.sr[0].bm.empty())
             {
                 MSG_DEBUG("Loading image " << mSubpage.sr[0].bm);
-                sk_sp<SkData> rawImage = readImage(mSubpage.sr[0].bm);
                 SkBitmap bm;
 
-                if (rawImage)
+                if (!TImgSource::getBitmap(mSubpage.sr[0].bm, &bm))
                 {
-                    MSG_DEBUG("Decoding image BM ...");
-
-                    if (!DecodeDataToBitmap(rawImage, &bm))
-                    {
-                        MSG_WARNING("Problem while decoding image " << mSubpage.sr[0].bm);
-                    }
-                    else if (!bm.empty())
-                    {
-                        dImage.setImageBm(bm);
-                        SkImageInfo info = bm.info();
-                        mSubpage.sr[0].bm_width = info.width();
-                        mSubpage.sr[0].bm_height = info.height();
-                        isImage = true;
-                    }
-                    else
-                    {
-                        MSG_WARNING("BM image " << mSubpage.sr[0].bm << " seems to be empty!");
-                    }
+                    MSG_WARNING("Problem while decoding image " << mSubpage.sr[0].bm);
+                }
+                else if (!bm.empty())
+                {
+                    dImage.setImageBm(bm);
+                    SkImageInfo info = bm.info();
+                    mSubpage.sr[0].bm_width = info.width();
+                    mSubpage.sr[0].bm_height = info.height();
+                    isImage = true;
+                }
+                else
+                {
+                    MSG_WARNING("BM image " << mSubpage.sr[0].bm << " seems to be empty!");
                 }
             }
             else if (TTPInit::isG5() && haveImage(mSubpage.sr[0]))
@@ -589,29 +586,23 @@ bool TSubPage::createPage(bool force)
             if (!mSubpage.sr[0].mi.empty())
             {
                 MSG_DEBUG("Loading image " << mSubpage.sr[0].mi);
-                sk_sp<SkData> rawImage = readImage(mSubpage.sr[0].mi);
                 SkBitmap mi;
 
-                if (rawImage)
+                if (!TImgSource::getBitmap(mSubpage.sr[0].mi, &mi))
                 {
-                    MSG_DEBUG("Decoding image MI ...");
-
-                    if (!DecodeDataToBitmap(rawImage, &mi))
-                    {
-                        MSG_WARNING("Problem while decoding image " << mSubpage.sr[0].mi);
-                    }
-                    else if (!mi.empty())
-                    {
-                        dImage.setImageMi(mi);
-                        SkImageInfo info = mi.info();
-                        mSubpage.sr[0].mi_width = info.width();
-                        mSubpage.sr[0].mi_height = info.height();
-                        isImage = true;
-                    }
-                    else
-                    {
-                        MSG_WARNING("MI image " << mSubpage.sr[0].mi << " seems to be empty!");
-                    }
+                    MSG_WARNING("Problem while decoding image " << mSubpage.sr[0].mi);
+                }
+                else if (!mi.empty())
+                {
+                    dImage.setImageMi(mi);
+                    SkImageInfo info = mi.info();
+                    mSubpage.sr[0].mi_width = info.width();
+                    mSubpage.sr[0].mi_height = info.height();
+                    isImage = true;
+                }
+                else
+                {
+                    MSG_WARNING("MI image " << mSubpage.sr[0].mi << " seems to be empty!");
                 }
             }
 
@@ -631,42 +622,6 @@ bool TSubPage::createPage(bool force)
                 if (mSubpage.sr[0].oo < 255 && mSubpage.sr[0].te.empty() && mSubpage.sr[0].bs.empty())
                     setOpacity(&target, mSubpage.sr[0].oo);
 #endif
-
-#ifdef _SCALE_SKIA_
-                if (gPageManager && gPageManager->getScaleFactor() != 1.0)
-                {
-                    SkPaint paint;
-                    int left, top;
-                    SkImageInfo info = target.info();
-
-                    paint.setBlendMode(SkBlendMode::kSrc);
-                    paint.setFilterQuality(kHigh_SkFilterQuality);
-                    // Calculate new dimension
-                    double scaleFactor = gPageManager->getScaleFactor();
-                    MSG_DEBUG("Using scale factor " << scaleFactor);
-                    int lwidth = (int)((double)info.width() * scaleFactor);
-                    int lheight = (int)((double)info.height() * scaleFactor);
-                    int twidth = (int)((double)mSubpage.width * scaleFactor);
-                    int theight = (int)((double)mSubpage.height * scaleFactor);
-                    calcPosition(lwidth, lheight, &left, &top);
-                    // Create a canvas and draw new image
-                    sk_sp<SkImage> im = SkImage::MakeFromBitmap(target);
-
-                    if (!allocPixels(twidth, theight, &target))
-                    {
-#if TESTMODE == 1
-                        setScreenDone();
-#endif
-                        return;
-                    }
-
-                    target.eraseColor(TColor::getSkiaColor(mSubpage.sr[0].cf));
-                    SkCanvas can(target, SkSurfaceProps());
-                    SkRect rect = SkRect::MakeXYWH(left, top, lwidth, lheight);
-                    can.drawImageRect(im, rect, &paint);
-                    MSG_DEBUG("Scaled size of background image: " << left << ", " << top << ", " << lwidth << ", " << lheight);
-                }
-#endif
             }
         }
 
@@ -735,14 +690,16 @@ void TSubPage::show()
 #ifdef _OPAQUE_SKIA_
         if (mSubpage.sr[0].te.empty() && mSubpage.sr[0].bs.empty())
         {
-            TBitmap image((unsigned char *)mPageBackground.getPixels(), mPageBackground.info().width(), mPageBackground.info().height());
-            _setBackground(handle, image, mPageBackground.info().width(), mPageBackground.info().height(), TColor::getColor(mSubpage.sr[0].cf));
+            SkBitmap screen = scaleToDevice(mPageBackground);
+            TBitmap image((unsigned char *)screen.getPixels(), screen.info().width(), screen.info().height());
+            _setBackground(handle, image, screen.info().width(), screen.info().height(), TColor::getColor(mSubpage.sr[0].cf));
         }
 #else
         if (mSubpage.sr[0].te.empty() && mSubpage.sr[0].bs.empty())
         {
-            TBitmap image((unsigned char *)mPageBackground.getPixels(), mPageBackground.info().width(), mPageBackground.info().height());
-            _setBackground(handle, image, mPageBackground.info().width(), mPageBackground.info().height(), TColor::getColor(mSubpage.sr[0].cf), mSubpage.sr[0].oo);
+            SkBitmap screen = scaleToDevice(mPageBackground);
+            TBitmap image((unsigned char *)screen.getPixels(), screen.info().width(), screen.info().height());
+            _setBackground(handle, image, screen.info().width(), screen.info().height(), TColor::getColor(mSubpage.sr[0].cf), mSubpage.sr[0].oo);
         }
 #endif
     }
@@ -768,11 +725,12 @@ void TSubPage::show()
         if (mSubpage.sr[0].oo < 255)
             setOpacity(&mPageBackground, mSubpage.sr[0].oo);
 #endif
-        TBitmap image((unsigned char *)mPageBackground.getPixels(), mPageBackground.info().width(), mPageBackground.info().height());
+        SkBitmap screen = scaleToDevice(mPageBackground);
+        TBitmap image((unsigned char *)screen.getPixels(), screen.info().width(), screen.info().height());
 #ifdef _OPAQUE_SKIA_
-        _setBackground(handle, image, mPageBackground.info().width(), mPageBackground.info().height(), TColor::getColor(mSubpage.sr[0].cf));
+        _setBackground(handle, image, screen.info().width(), screen.info().height(), TColor::getColor(mSubpage.sr[0].cf));
 #else
-        _setBackground(handle, image, mPageBackground.info().width(), mPageBackground.info().height(), TColor::getColor(mSubpage.sr[0].cf), mSubpage.sr[0].oo);
+        _setBackground(handle, image, screen.info().width(), screen.info().height(), TColor::getColor(mSubpage.sr[0].cf), mSubpage.sr[0].oo);
 #endif
     }
     else if (!noSr && !isImage)
@@ -912,29 +870,23 @@ SkBitmap& TSubPage::getBgImage()
         if (!TTPInit::isG5() && !mSubpage.sr[0].bm.empty())
         {
             MSG_DEBUG("Loading image " << mSubpage.sr[0].bm);
-            sk_sp<SkData> rawImage = readImage(mSubpage.sr[0].bm);
             SkBitmap bm;
 
-            if (rawImage)
+            if (!TImgSource::getBitmap(mSubpage.sr[0].bm, &bm))
             {
-                MSG_DEBUG("Decoding image BM ...");
-
-                if (!DecodeDataToBitmap(rawImage, &bm))
-                {
-                    MSG_WARNING("Problem while decoding image " << mSubpage.sr[0].bm);
-                }
-                else if (!bm.empty())
-                {
-                    dImage.setImageBm(bm);
-                    SkImageInfo info = bm.info();
-                    mSubpage.sr[0].bm_width = info.width();
-                    mSubpage.sr[0].bm_height = info.height();
-                    haveBitmap = true;
-                }
-                else
-                {
-                    MSG_WARNING("BM image " << mSubpage.sr[0].bm << " seems to be empty!");
-                }
+                MSG_WARNING("Problem while decoding image " << mSubpage.sr[0].bm);
+            }
+            else if (!bm.empty())
+            {
+                dImage.setImageBm(bm);
+                SkImageInfo info = bm.info();
+                mSubpage.sr[0].bm_width = info.width();
+                mSubpage.sr[0].bm_height = info.height();
+                haveBitmap = true;
+            }
+            else
+            {
+                MSG_WARNING("BM image " << mSubpage.sr[0].bm << " seems to be empty!");
             }
         }
         else if (TTPInit::isG5() && haveImage(mSubpage.sr[0]))
@@ -952,29 +904,23 @@ SkBitmap& TSubPage::getBgImage()
         if (!mSubpage.sr[0].mi.empty())
         {
             MSG_DEBUG("Loading image " << mSubpage.sr[0].mi);
-            sk_sp<SkData> rawImage = readImage(mSubpage.sr[0].mi);
             SkBitmap mi;
 
-            if (rawImage)
+            if (!TImgSource::getBitmap(mSubpage.sr[0].mi, &mi))
             {
-                MSG_DEBUG("Decoding image MI ...");
-
-                if (!DecodeDataToBitmap(rawImage, &mi))
-                {
-                    MSG_WARNING("Problem while decoding image " << mSubpage.sr[0].mi);
-                }
-                else if (!mi.empty())
-                {
-                    dImage.setImageMi(mi);
-                    SkImageInfo info = mi.info();
-                    mSubpage.sr[0].mi_width = info.width();
-                    mSubpage.sr[0].mi_height = info.height();
-                    haveBitmap = true;
-                }
-                else
-                {
-                    MSG_WARNING("MI image " << mSubpage.sr[0].mi << " seems to be empty!");
-                }
+                MSG_WARNING("Problem while decoding image " << mSubpage.sr[0].mi);
+            }
+            else if (!mi.empty())
+            {
+                dImage.setImageMi(mi);
+                SkImageInfo info = mi.info();
+                mSubpage.sr[0].mi_width = info.width();
+                mSubpage.sr[0].mi_height = info.height();
+                haveBitmap = true;
+            }
+            else
+            {
+                MSG_WARNING("MI image " << mSubpage.sr[0].mi << " seems to be empty!");
             }
         }
 
@@ -993,40 +939,6 @@ SkBitmap& TSubPage::getBgImage()
 
             if (mSubpage.sr[0].oo < 255 && mSubpage.sr[0].te.empty() && mSubpage.sr[0].bs.empty())
                 setOpacity(&target, mSubpage.sr[0].oo);
-
-#ifdef _SCALE_SKIA_
-            size_t rowBytes = info.minRowBytes();
-            size_t size = info.computeByteSize(rowBytes);
-            SkImageInfo info = target.info();
-
-            if (gPageManager && gPageManager->getScaleFactor() != 1.0)
-            {
-                SkPaint paint;
-                int left, top;
-
-                paint.setBlendMode(SkBlendMode::kSrc);
-                paint.setFilterQuality(kHigh_SkFilterQuality);
-                // Calculate new dimension
-                double scaleFactor = gPageManager->getScaleFactor();
-                MSG_DEBUG("Using scale factor " << scaleFactor);
-                int lwidth = (int)((double)info.width() * scaleFactor);
-                int lheight = (int)((double)info.height() * scaleFactor);
-                int twidth = (int)((double)mSubpage.width * scaleFactor);
-                int theight = (int)((double)mSubpage.height * scaleFactor);
-                calcPosition(lwidth, lheight, &left, &top);
-                // Create a canvas and draw new image
-                sk_sp<SkImage> im = SkImage::MakeFromBitmap(target);
-
-                if (!allocPixels(twidth, theight, &target))
-                    return;
-
-                target.eraseColor(TColor::getSkiaColor(mSubpage.sr[0].cf));
-                SkCanvas can(target, SkSurfaceProps());
-                SkRect rect = SkRect::MakeXYWH(left, top, lwidth, lheight);
-                can.drawImageRect(im, rect, &paint);
-                MSG_DEBUG("Scaled size of background image: " << left << ", " << top << ", " << lwidth << ", " << lheight);
-            }
-#endif
         }
     }
 
@@ -1098,38 +1010,40 @@ void TSubPage::startTimer()
     if (mSubpage.timeout <= 0 || mTimerRunning)
         return;
 
-    try
-    {
-        mThreadTimer = std::thread([=] { runTimer(); });
-        mThreadTimer.detach();
-    }
-    catch (std::exception& e)
+    mTimerRunning = true;
+    mTimerID = TTimerWheel::schedule(std::chrono::milliseconds(mSubpage.timeout * 100), std::chrono::milliseconds(0), [this] { return runTimer(); });
+
+    if (!mTimerID)
     {
-        MSG_ERROR("Error starting a timeout thread: " << e.what());
-        return;
+        MSG_ERROR("Error starting a timeout for subpage " << mSubpage.name);
+        mTimerRunning = false;
     }
 }
 
-void TSubPage::runTimer()
+void TSubPage::stopTimer()
 {
-    DECL_TRACER("TSubPage::runTimer()");
+    DECL_TRACER("TSubPage::stopTimer()");
 
-    if (mTimerRunning)
+    if (!mTimerRunning)
         return;
 
-    mTimerRunning = true;
-    ulong tm = mSubpage.timeout * 100;
-    ulong unit = 100;
-    ulong total = 0;
+    mTimerRunning = false;
+    TTimerWheel::cancel(mTimerID);
+    mTimerID = 0;
+}
 
-    while (mTimerRunning && !prg_stopped && total < tm)
-    {
-        std::this_thread::sleep_for(std::chrono::milliseconds(unit));
-        total += unit;
-    }
+/*
+ * This is called by the timer wheel when the timeout of the subpage is over.
+ */
+bool TSubPage::runTimer()
+{
+    DECL_TRACER("TSubPage::runTimer()");
+
+    if (!mTimerRunning || prg_stopped)
+        return false;
 
     drop();
-    mTimerRunning = false;
+    return false;
 }
 
 #ifdef _SCALE_SKIA_
@@ -1158,7 +1072,7 @@ void TSubPage::calcPosition(int im_width, int im_height, int *left, int *top)
             if (scale && gPageManager && gPageManager->getScaleFactor() != 1.0)
             {
                 *left = (int)((double)mSubpage.sr[0].bx * gPageManager->getScaleFactor());
-                *left = (int)((double)mSubpage.sr[0].by * gPageManager->getScaleFactor());
+                *top = (int)((double)mSubpage.sr[0].by * gPageManager->getScaleFactor());
             }
 #endif
         break;
@@ -1231,19 +1145,11 @@ void TSubPage::doClick(int x, int y, bool pressed)
 {
     DECL_TRACER("TSubPage::doClick(int x, int y)");
 
-    BUTTONS_T *button = TPageInterface::getButtons();
+    // The buttons near the coordinates in reverse order
+    vector<TButton *> buttons = TPageInterface::getButtonsAt(x, y);
 
-    if (!button)
-        return;
-
-    // Find last button
-    while (button && button->next)
-        button = button->next;
-
-    // Scan in reverse order
-    while (button)
+    for (TButton *but : buttons)
     {
-        TButton *but = button->button;
         bool clickable = but->isClickable();
         MSG_DEBUG("Testing button " << but->getButtonIndex() << " (" << but->getButtonName() << "): " << (clickable ? "CLICKABLE" : "NOT CLICKABLE"));
 
@@ -1257,8 +1163,6 @@ void TSubPage::doClick(int x, int y, bool pressed)
             if (but->doClick(btX, btY, pressed))
                 break;
         }
-
-        button = button->previous;
     }
 }
 
@@ -1266,25 +1170,13 @@ void TSubPage::moveMouse(int x, int y)
 {
     DECL_TRACER("TSubPage::moveMouse(int x, int y)");
 
-    BUTTONS_T *button = TPageInterface::getButtons();
-
-    if (!button)
-        return;
-
-    // Find last button
-    while (button && button->next)
-        button = button->next;
+    // The buttons near the coordinates in reverse order
+    vector<TButton *> buttons = TPageInterface::getButtonsAt(x, y);
 
-    // Scan in reverse order
-    while (button)
+    for (TButton *but : buttons)
     {
-        TButton *but = button->button;
-
         if (but->getButtonType() != BARGRAPH && but->getButtonType() != JOYSTICK)
-        {
-            button = button->previous;
             continue;
-        }
 
         bool clickable = but->isClickable();
 
@@ -1304,7 +1196,5 @@ void TSubPage::moveMouse(int x, int y)
 
             break;
         }
-
-        button = button->previous;
     }
 }
@@ -26,6 +26,7 @@
 #include "tpalette.h"
 #include "tpageinterface.h"
 #include "tintborder.h"
+#include "ttimerwheel.h"
 
 class TBitmap;
 
@@ -98,7 +99,7 @@ class TSubPage : public TValidateFile, public TPageInterface, public Border::TIn
         void doClick(int x, int y, bool pressed);
         void moveMouse(int x, int y);
         void startTimer();
-        void stopTimer() { mTimerRunning = false; }
+        void stopTimer();
 #ifdef _OPAQUE_SKIA_
         void registerCallback(std::function<void (ulong handle, TBitmap image, int width, int height, ulong color)> setBackground) { _setBackground = setBackground; }
 #else
@@ -110,7 +111,7 @@ class TSubPage : public TValidateFile, public TPageInterface, public Border::TIn
 
     protected:
         void initialize();
-        void runTimer();
+        bool runTimer();
         bool createPage(bool force=false);  // Create a page in case it doesn't, but don't display it.
 #ifdef  _SCALE_SKIA_
         void calcPosition(int im_width, int im_height, int *left, int *top, bool scale = false);
@@ -136,7 +137,7 @@ class TSubPage : public TValidateFile, public TPageInterface, public Border::TIn
         int mZOrder{-1};                        // The Z-Order of the subpage if it is visible
         SkBitmap mBgImage;                      // The background image (cache).
         std::atomic<bool>mTimerRunning{false};  // TRUE= timer is running
-        std::thread mThreadTimer;               // The thread started if a timeout is defined.
+        TTimerWheel::TIMER_ID mTimerID{0};      // The timer started if a timeout is defined.
         std::vector<LIST_t> mLists;             // Lists of subpage
         SkBitmap mPageBackground;               // The background of the subpage.
 };
@@ -23,6 +23,7 @@
 #include "tbutton.h"
 #include "terror.h"
 #include "tresources.h"
+#include "tthreadpool.h"
 
 #define MAX_BANK        3
 
@@ -379,7 +380,7 @@ void TSystemButton::setDistinctFocus(ulong handle)
     if (mButtons.empty())
         return;
 
-    std::thread thr = std::thread([=] {
+    TThreadPool::post("TSystemButton::setDistinctFocus", [=] {
         vector<TButton *>::iterator iter;
 
         for (iter = mButtons.begin(); iter != mButtons.end(); ++iter)
@@ -395,8 +396,6 @@ void TSystemButton::setDistinctFocus(ulong handle)
             }
         }
     });
-
-    thr.detach();
 }
 
 void TSystemButton::setCursorPosition(ulong handle, int oldPos, int newPos)
@@ -809,7 +808,7 @@ void TSystemButton::setKeysToBank(int bank, uint handle)
     if (mButtons.empty() || bank < BANK_1 || bank > BANK_3)
         return;
 
-    std::thread thr = std::thread([=] {
+    TThreadPool::post("TSystemButton::setKeysToBank", [=] {
         vector<TButton *>::iterator iter;
         int inst = (bank - 1) * 2;
 
@@ -836,8 +835,6 @@ void TSystemButton::setKeysToBank(int bank, uint handle)
             }
         }
     });
-
-    thr.detach();
 }
 
 void TSystemButton::handleDedicatedKeys(int channel, bool pressed)
@@ -18,9 +18,18 @@
 
 #include <fstream>
 #include <functional>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
 
 #include <expat.h>
 
+#if defined(__linux__) || defined(__ANDROID__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#define HAVE_INOTIFY
+#endif
+
 #include "tsystemdraw.h"
 #include "tdirectory.h"
 #include "tresources.h"
@@ -112,6 +121,10 @@ TSystemDraw::TSystemDraw(const string &path)
 TSystemDraw::~TSystemDraw()
 {
     DECL_TRACER("TSystemDraw::~TSystemDraw()");
+#ifdef HAVE_INOTIFY
+    if (mNotifyFd >= 0)
+        close(mNotifyFd);
+#endif
 }
 
 bool TSystemDraw::loadConfig()
@@ -164,6 +177,8 @@ bool TSystemDraw::loadConfig()
     }
 
     XML_ParserFree(parser);
+    buildCatalog();
+    watchCatalog();
 /*
     if (TStreamError::checkFilter(HLOG_DEBUG))
     {
@@ -641,24 +656,321 @@ void TSystemDraw::CharacterDataHandler(void *userData, const XML_Char *s, int le
     }
 }
 
-string TSystemDraw::getDirEntry(dir::TDirectory* dir, const string& part, bool alpha)
+string TSystemDraw::getDirEntry(const vector<string>& entries, const string& part, bool alpha)
 {
-    DECL_TRACER("TSystemDraw::getDirEntry(dir::TDirectory* dir, const string& part, bool precice)");
+    DECL_TRACER("TSystemDraw::getDirEntry(const vector<string>& entries, const string& part, bool alpha)");
 
     string such = part;
 
     if (alpha)
         such += "_alpha";
 
-    string dirEntry = dir->getEntryWithPart(such, true);
+    string dirEntry = getEntryWithPart(entries, such, true);
     such = part;
 
     if (dirEntry.empty())
-        dirEntry = dir->getEntryWithPart(such, false);
+        dirEntry = getEntryWithPart(entries, such, false);
 
     return dirEntry;
 }
 
+/**
+ * @brief TSystemDraw::getEntryWithPart - Finds a file name containing \b part
+ * This works the same way as dir::TDirectory::getEntryWithPart() but on a
+ * list of file names from the catalog.
+ *
+ * @param entries   The list of file names.
+ * @param part      The part to search for.
+ * @param precice   If TRUE, \b part must be followed by a dot.
+ *
+ * @return The first matching file name or an empty string.
+ */
+string TSystemDraw::getEntryWithPart(const vector<string>& entries, const string& part, bool precice)
+{
+    vector<string>::const_iterator iter;
+    size_t pos;
+
+    for (iter = entries.begin(); iter != entries.end(); ++iter)
+    {
+        if ((pos = iter->find(part)) != string::npos && (pos + part.length()) < iter->length())
+        {
+            char next = iter->at(pos + part.length());
+            char prev = (pos > 0 ? iter->at(pos - 1) : 0);
+
+            if (next == '.')
+                return *iter;
+
+            if (precice && (next == '_' || prev != 0))
+                continue;
+
+            if ((next >= 'A' && next <= 'Z') || (next >= 'a' && next <= 'z'))
+                continue;
+
+            return *iter;
+        }
+    }
+
+    return string();
+}
+
+/**
+ * @brief TSystemDraw::getEntriesWithStart - Returns all files starting with \b start
+ *
+ * @param files     A sorted list of file names.
+ * @param start     The start of the file names.
+ *
+ * @return A list with all file names starting with \b start.
+ */
+vector<string> TSystemDraw::getEntriesWithStart(const vector<string>& files, const string& start)
+{
+    vector<string> list;
+    vector<string>::const_iterator iter = std::lower_bound(files.begin(), files.end(), start);
+
+    while (iter != files.end() && iter->compare(0, start.length(), start) == 0)
+    {
+        list.push_back(*iter);
+        ++iter;
+    }
+
+    return list;
+}
+
+/**
+ * @brief TSystemDraw::readDirectory - Reads the file names of a directory
+ *
+ * @param path  The directory to read.
+ *
+ * @return A sorted list of all file names in the directory without the path.
+ */
+vector<string> TSystemDraw::readDirectory(const string& path)
+{
+    DECL_TRACER("TSystemDraw::readDirectory(const string& path)");
+
+    vector<string> files;
+
+    try
+    {
+        for (auto& p: fs::directory_iterator(path))
+        {
+            string f = p.path().filename().string();
+
+            if (f.empty() || f[0] == '.')
+                continue;
+
+            files.push_back(f);
+        }
+    }
+    catch (std::exception& e)
+    {
+        MSG_ERROR("Error reading directory " << path << ": " << e.what());
+    }
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+/**
+ * @brief TSystemDraw::buildCatalog - Indexes the graphic files
+ * For every border, slider and cursor defined in the configuration file the
+ * files containing the graphics are looked up once. Each directory is read
+ * only one time. With this the methods getBorder(), getSliderFiles() and
+ * getCursorFiles() don't need to access the file system any more.
+ */
+void TSystemDraw::buildCatalog()
+{
+    DECL_TRACER("TSystemDraw::buildCatalog()");
+
+    std::lock_guard<std::mutex> guard(mCatalogMutex);
+
+    mBorderFiles.clear();
+    mSliderFiles.clear();
+    mCursorFiles.clear();
+
+    if (mHaveBorders)
+    {
+        string basePath = mPath + "/borders/";
+        vector<string> files = readDirectory(basePath);
+        vector<BORDER_DATA_t>::iterator brdIter;
+
+        for (brdIter = mDraw.borderData.begin(); brdIter != mDraw.borderData.end(); ++brdIter)
+        {
+            if (mBorderFiles.find(brdIter->baseFile) != mBorderFiles.end())
+                continue;
+
+            vector<string> entries = getEntriesWithStart(files, brdIter->baseFile + "_");
+
+            if (entries.size() < 8)
+                continue;
+
+            BORDER_t border;
+            border.b = basePath + getDirEntry(entries, "_b", false);
+            border.bl = basePath + getDirEntry(entries, "_bl", false);
+            border.br = basePath + getDirEntry(entries, "_br", false);
+            border.l = basePath + getDirEntry(entries, "_l", false);
+            border.r = basePath + getDirEntry(entries, "_r", false);
+            border.t = basePath + getDirEntry(entries, "_t", false);
+            border.tl = basePath + getDirEntry(entries, "_tl", false);
+            border.tr = basePath + getDirEntry(entries, "_tr", false);
+            border.b_alpha = basePath + getDirEntry(entries, "_b");
+            border.bl_alpha = basePath + getDirEntry(entries, "_bl");
+            border.br_alpha = basePath + getDirEntry(entries, "_br");
+            border.l_alpha = basePath + getDirEntry(entries, "_l");
+            border.r_alpha = basePath + getDirEntry(entries, "_r");
+            border.t_alpha = basePath + getDirEntry(entries, "_t");
+            border.tl_alpha = basePath + getDirEntry(entries, "_tl");
+            border.tr_alpha = basePath + getDirEntry(entries, "_tr");
+            // Eliminate equal paths
+            std::pair<string *, string *> pairs[] = {
+                { &border.b, &border.b_alpha },
+                { &border.t, &border.t_alpha },
+                { &border.l, &border.l_alpha },
+                { &border.r, &border.r_alpha },
+                { &border.tl, &border.tl_alpha },
+                { &border.tr, &border.tr_alpha },
+                { &border.bl, &border.bl_alpha },
+                { &border.br, &border.br_alpha }
+            };
+
+            for (auto& p : pairs)
+            {
+                if (*p.first == *p.second)
+                {
+                    if (StrContains(*p.first, "_alpha"))
+                        p.first->clear();
+                    else
+                        p.second->clear();
+                }
+            }
+
+            mBorderFiles.insert(std::pair<string, BORDER_t>(brdIter->baseFile, border));
+        }
+    }
+
+    if (mHaveSliders)
+    {
+        string myPath = mPath + "/sliders/";
+        vector<string> files = readDirectory(myPath);
+        vector<SLIDER_STYLE_t>::iterator sliIter;
+
+        for (sliIter = mDraw.sliderStyles.begin(); sliIter != mDraw.sliderStyles.end(); ++sliIter)
+        {
+            string fbase = sliIter->baseFile;
+
+            if (mSliderFiles.find(fbase) != mSliderFiles.end())
+                continue;
+
+            vector<string> entries = getEntriesWithStart(files, fbase + "_");
+
+            if (entries.empty())
+                continue;
+
+            std::pair<SLIDER_GRTYPE_t, string> parts[] = {
+                { SGR_TOP, "_t" },
+                { SGR_BOTTOM, "_b" },
+                { SGR_LEFT, "_l" },
+                { SGR_RIGHT, "_r" },
+                { SGR_HORIZONTAL, "_h" },
+                { SGR_VERTICAL, "_v" }
+            };
+
+            vector<SLIDER_t> list;
+
+            for (auto& p : parts)
+            {
+                SLIDER_t slid;
+                slid.type = p.first;
+                slid.path = myPath + getEntryWithPart(entries, fbase + p.second);
+                slid.pathAlpha = myPath + getEntryWithPart(entries, p.second + "_alpha");
+                list.push_back(slid);
+            }
+
+            mSliderFiles.insert(std::pair<string, vector<SLIDER_t>>(fbase, list));
+        }
+    }
+
+    if (mHaveCursors)
+    {
+        string path = mPath + "/cursors/";
+        vector<string> files = readDirectory(path);
+        vector<CURSOR_STYLE_t>::iterator curIter;
+
+        for (curIter = mDraw.cursorStyles.begin(); curIter != mDraw.cursorStyles.end(); ++curIter)
+        {
+            CURSOR_t cursor;
+
+            if (std::binary_search(files.begin(), files.end(), curIter->baseFile + ".png"))
+                cursor.imageBase = path + curIter->baseFile + ".png";
+
+            if (std::binary_search(files.begin(), files.end(), curIter->baseFile + "_alpha.png"))
+                cursor.imageAlpha = path + curIter->baseFile + "_alpha.png";
+
+            mCursorFiles.insert(std::pair<string, CURSOR_t>(curIter->baseFile, cursor));
+        }
+    }
+
+    MSG_DEBUG("Catalog contains " << mBorderFiles.size() << " borders, " << mSliderFiles.size() << " sliders and " << mCursorFiles.size() << " cursors.");
+}
+
+/**
+ * @brief TSystemDraw::watchCatalog - Watches the graphic directories
+ * If the system supports inotify, the directories with the borders, sliders
+ * and cursors are watched for changes. Any change causes the catalog to be
+ * rebuild with the next request. On other systems the catalog is build only
+ * once.
+ */
+void TSystemDraw::watchCatalog()
+{
+    DECL_TRACER("TSystemDraw::watchCatalog()");
+#ifdef HAVE_INOTIFY
+    if (mNotifyFd >= 0)
+        return;
+
+    mNotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (mNotifyFd < 0)
+    {
+        MSG_WARNING("Can't watch the system graphics: " << strerror(errno));
+        return;
+    }
+
+    uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE;
+    string dirs[] = { "/borders", "/sliders", "/cursors" };
+
+    for (auto& d : dirs)
+    {
+        if (isValidDir(mPath + d) && inotify_add_watch(mNotifyFd, (mPath + d).c_str(), mask) < 0)
+        {
+            MSG_WARNING("Can't watch directory " << mPath << d << ": " << strerror(errno));
+        }
+    }
+#endif
+}
+
+/**
+ * @brief TSystemDraw::checkCatalog - Rebuilds the catalog if necessary
+ * This reads the pending events from inotify without blocking. If there
+ * was any change in one of the watched directories, the catalog is rebuild.
+ */
+void TSystemDraw::checkCatalog()
+{
+#ifdef HAVE_INOTIFY
+    if (mNotifyFd < 0)
+        return;
+
+    char buffer[4096];
+    bool changed = false;
+
+    while (read(mNotifyFd, buffer, sizeof(buffer)) > 0)
+        changed = true;
+
+    if (changed)
+    {
+        MSG_INFO("System graphics have changed. Rebuilding catalog ...");
+        buildCatalog();
+    }
+#endif
+}
+
 bool TSystemDraw::getBorder(const string &family, LINE_TYPE_t lt, BORDER_t *border, const string& family2, bool info)
 {
     DECL_TRACER("TSystemDraw::getBorder(const string &family, LINE_TYPE_t lt, BORDER_t *border, const string& family2, bool info)");
@@ -666,7 +978,6 @@ bool TSystemDraw::getBorder(const string &family, LINE_TYPE_t lt, BORDER_t *bord
     if (!border || family.empty() || mDraw.borders.size() == 0)
         return false;
 
-    string basePath = mPath + "/borders/";
     // Find the border details
     vector<FAMILY_t>::iterator iter;
     bool found = false;
@@ -738,103 +1049,28 @@ bool TSystemDraw::getBorder(const string &family, LINE_TYPE_t lt, BORDER_t *bord
     }
 
     MSG_DEBUG("External system border " << family << " found.");
-    dir::TDirectory dir(basePath);
-    dir.setStripPath(true);
     vector<BORDER_DATA_t>::iterator brdIter;
     string dataName = (family2.length() > 0 ? family2 : fullName);
 
+    if (!info)
+        checkCatalog();
+
     for (brdIter = mDraw.borderData.begin(); brdIter != mDraw.borderData.end(); brdIter++)
     {
         if (brdIter->name.compare(dataName) == 0)
         {
             if (!info)
             {
-                int num = dir.scanFiles(brdIter->baseFile + "_", true);
+                std::lock_guard<std::mutex> guard(mCatalogMutex);
+                std::map<string, BORDER_t>::iterator catIter = mBorderFiles.find(brdIter->baseFile);
 
-                if (num < 8)
+                if (catIter == mBorderFiles.end())
                     continue;
 
-                border->b = basePath + getDirEntry(&dir, "_b", false);
-                border->bl = basePath + getDirEntry(&dir, "_bl", false);
-                border->br = basePath + getDirEntry(&dir, "_br", false);
-                border->l = basePath + getDirEntry(&dir, "_l", false);
-                border->r = basePath + getDirEntry(&dir, "_r", false);
-                border->t = basePath + getDirEntry(&dir, "_t", false);
-                border->tl = basePath + getDirEntry(&dir, "_tl", false);
-                border->tr = basePath + getDirEntry(&dir, "_tr", false);
-                border->b_alpha = basePath + getDirEntry(&dir, "_b");
-                border->bl_alpha = basePath + getDirEntry(&dir, "_bl");
-                border->br_alpha = basePath + getDirEntry(&dir, "_br");
-                border->l_alpha = basePath + getDirEntry(&dir, "_l");
-                border->r_alpha = basePath + getDirEntry(&dir, "_r");
-                border->t_alpha = basePath + getDirEntry(&dir, "_t");
-                border->tl_alpha = basePath + getDirEntry(&dir, "_tl");
-                border->tr_alpha = basePath + getDirEntry(&dir, "_tr");
+                BORDER_STYLE_t style = border->bdStyle;
+                *border = catIter->second;
+                border->bdStyle = style;
                 border->border = *brdIter;
-                // Eliminate equal paths
-                if (border->b == border->b_alpha)
-                {
-                    if (StrContains(border->b, "_alpha"))
-                        border->b.clear();
-                    else
-                        border->b_alpha.clear();
-                }
-
-                if (border->t == border->t_alpha)
-                {
-                    if (StrContains(border->t, "_alpha"))
-                        border->t.clear();
-                    else
-                        border->t_alpha.clear();
-                }
-
-                if (border->l == border->l_alpha)
-                {
-                    if (StrContains(border->l, "_alpha"))
-                        border->l.clear();
-                    else
-                        border->l_alpha.clear();
-                }
-
-                if (border->r == border->r_alpha)
-                {
-                    if (StrContains(border->r, "_alpha"))
-                        border->r.clear();
-                    else
-                        border->r_alpha.clear();
-                }
-
-                if (border->tl == border->tl_alpha)
-                {
-                    if (StrContains(border->tl, "_alpha"))
-                        border->tl.clear();
-                    else
-                        border->tl_alpha.clear();
-                }
-
-                if (border->tr == border->tr_alpha)
-                {
-                    if (StrContains(border->tr, "_alpha"))
-                        border->tr.clear();
-                    else
-                        border->tr_alpha.clear();
-                }
-
-                if (border->bl == border->bl_alpha)
-                {
-                    if (StrContains(border->bl, "_alpha"))
-                        border->bl.clear();
-                    else
-                        border->bl_alpha.clear();
-                }
-
-                if (border->br == border->br_alpha)
-                {
-                    if (StrContains(border->br, "_alpha"))
-                        border->br.clear();
-                    else
-                        border->br_alpha.clear();
-                }
 
                 MSG_DEBUG("Bottom        : " << border->b);
                 MSG_DEBUG("Top           : " << border->t);
@@ -995,47 +1231,12 @@ vector<SLIDER_t> TSystemDraw::getSliderFiles(const string& slider)
     if (!getSlider(slider, &sst))
         return list;
 
-    string fbase = sst.baseFile;
-    string myPath = mPath + "/sliders";
-    dir::TDirectory dir(myPath);
-    dir.setStripPath(true);
-    int num = dir.scanFiles(fbase + "_");
-
-    if (num <= 0)
-        return list;
-
-    myPath += "/";
-    SLIDER_t slid;
-
-    slid.type = SGR_TOP;
-    slid.path = myPath + dir.getEntryWithPart(fbase+"_t");
-    slid.pathAlpha = myPath + dir.getEntryWithPart("_t_alpha");
-    list.push_back(slid);
+    checkCatalog();
+    std::lock_guard<std::mutex> guard(mCatalogMutex);
+    std::map<string, vector<SLIDER_t>>::iterator iter = mSliderFiles.find(sst.baseFile);
 
-    slid.type = SGR_BOTTOM;
-    slid.path = myPath + dir.getEntryWithPart(fbase+"_b");
-    slid.pathAlpha = myPath + dir.getEntryWithPart("_b_alpha");
-    list.push_back(slid);
-
-    slid.type = SGR_LEFT;
-    slid.path = myPath + dir.getEntryWithPart(fbase+"_l");
-    slid.pathAlpha = myPath + dir.getEntryWithPart("_l_alpha");
-    list.push_back(slid);
-
-    slid.type = SGR_RIGHT;
-    slid.path = myPath + dir.getEntryWithPart(fbase+"_r");
-    slid.pathAlpha = myPath + dir.getEntryWithPart("_r_alpha");
-    list.push_back(slid);
-
-    slid.type = SGR_HORIZONTAL;
-    slid.path = myPath + dir.getEntryWithPart(fbase+"_h");
-    slid.pathAlpha = myPath + dir.getEntryWithPart("_h_alpha");
-    list.push_back(slid);
-
-    slid.type = SGR_VERTICAL;
-    slid.path = myPath + dir.getEntryWithPart(fbase+"_v");
-    slid.pathAlpha = myPath + dir.getEntryWithPart("_v_alpha");
-    list.push_back(slid);
+    if (iter != mSliderFiles.end())
+        list = iter->second;
 
     return list;
 }
@@ -1091,16 +1292,13 @@ CURSOR_t TSystemDraw::getCursorFiles(const CURSOR_STYLE_t& style)
 {
     DECL_TRACER("TSystemDraw::getCursorFiles(const CURSOR_STYLE_t& style)");
 
-    string path = mPath + "/cursors";
-    string f1 = path + "/" + style.baseFile + ".png";
-    string f2 = path + "/" + style.baseFile + "_alpha.png";
     CURSOR_t cursor;
+    checkCatalog();
+    std::lock_guard<std::mutex> guard(mCatalogMutex);
+    std::map<string, CURSOR_t>::iterator iter = mCursorFiles.find(style.baseFile);
 
-    if (fs::exists(f1))
-        cursor.imageBase = f1;
-
-    if (fs::exists(f2))
-        cursor.imageAlpha = f2;
+    if (iter != mCursorFiles.end())
+        cursor = iter->second;
 
     return cursor;
 }
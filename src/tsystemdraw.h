@@ -21,6 +21,8 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <mutex>
 #include <functional>
 
 #include <expat.h>
@@ -272,7 +274,13 @@ class TSystemDraw : public TValidateFile
             X_POPUP_EFFECT
         }XELEMENTS_t;
 
-        std::string getDirEntry(dir::TDirectory *dir, const std::string& part, bool alpha = true);
+        std::string getDirEntry(const std::vector<std::string>& entries, const std::string& part, bool alpha = true);
+        std::string getEntryWithPart(const std::vector<std::string>& entries, const std::string& part, bool precice = true);
+        std::vector<std::string> getEntriesWithStart(const std::vector<std::string>& files, const std::string& start);
+        std::vector<std::string> readDirectory(const std::string& path);
+        void buildCatalog();
+        void watchCatalog();
+        void checkCatalog();
         bool evaluateName(const std::vector<std::string>& parts, const std::string& name);
 
         std::string mPath;          // The path to the system directory tree
@@ -284,6 +292,14 @@ class TSystemDraw : public TValidateFile
         bool mHaveSliders{false};   // TRUE = system directory sliders exist
 
         DRAW_t mDraw;
+        // The catalog of the graphic files. It is build once in loadConfig()
+        // and maps the base file name of a border, slider or cursor to the
+        // files belonging to it.
+        std::map<std::string, BORDER_t> mBorderFiles;
+        std::map<std::string, std::vector<SLIDER_t>> mSliderFiles;
+        std::map<std::string, CURSOR_t> mCursorFiles;
+        std::mutex mCatalogMutex;
+        int mNotifyFd{-1};          // Handle to watch the directories for changes (inotify)
 
         static XELEMENTS_t mActData;
         static XELEMENTS_t mActFamily;
@@ -23,6 +23,7 @@
 #include "tresources.h"
 
 #include <algorithm>
+#include <mutex>
 
 #if __cplusplus < 201402L
 #   error "This module requires at least C++14 standard!"
@@ -45,6 +46,10 @@ using std::string;
 using std::vector;
 
 static std::vector<std::string> mAllSounds;    // Cache
+static std::mutex _touchSound;
+static std::string _touchPath;                 // Path of the cached touch feedback sound
+static std::string _touchFile;                 // Configured file of the cached touch feedback sound
+static std::string _touchSoundFile;            // The validated touch feedback sound
 
 TSystemSound::TSystemSound(const string& path)
         : mPath(path)
@@ -101,6 +106,28 @@ bool TSystemSound::getSystemSoundState()
     return TConfig::getSystemSoundState();
 }
 
+string TSystemSound::getCachedTouchSound()
+{
+    DECL_TRACER("TSystemSound::getCachedTouchSound()");
+
+    if (!TConfig::getSystemSoundState())
+        return string();
+
+    string path = TConfig::getSystemPath(TConfig::SOUNDS);
+    string file = TConfig::getSystemSound();
+    std::lock_guard<std::mutex> guard(_touchSound);
+
+    if (path != _touchPath || file != _touchFile)
+    {
+        TSystemSound sysSound(path);
+        _touchSoundFile = sysSound.getTouchFeedbackSound();
+        _touchPath = path;
+        _touchFile = file;
+    }
+
+    return _touchSoundFile;
+}
+
 void TSystemSound::setPath(const string& path)
 {
     DECL_TRACER("TSystemSound::setPath(const string& path)");
@@ -51,6 +51,17 @@ class TSystemSound
          * FALSE.
          */
         bool getSystemSoundState();
+        /**
+         * Returns the path and name of the sound file for touch feedback if
+         * the system sounds are activated. In opposite to the other methods
+         * this doesn't need an instance. The file is validated only once
+         * and then cached until the configured path or file changes. This
+         * way no access to the file system happens when a button is pressed.
+         *
+         * @return The path and name of the sound file or an empty string if
+         * the system sounds are deactivated or invalid.
+         */
+        static std::string getCachedTouchSound();
 
         std::vector<std::string>& getAllSingleBeep() { return mSinglePeeps; }
         std::vector<std::string>& getAllDoubleBeep() { return mDoubleBeeps; }
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#include <mutex>
+#include <cstring>
+
+#include <include/core/SkTypeface.h>
+
+#include "ttextlayout.h"
+#include "tresources.h"
+#include "terror.h"
+
+#define TEXT_LAYOUT_MAX     512     // The maximum number of layouts in the cache
+
+using std::string;
+using std::vector;
+using std::list;
+using std::unordered_map;
+using std::shared_ptr;
+using std::mutex;
+using std::lock_guard;
+
+list<TTextLayout::CACHE_ENTRY> TTextLayout::mCache;
+unordered_map<string, list<TTextLayout::CACHE_ENTRY>::iterator> TTextLayout::mIndex;
+TEXT_LAYOUT_STATS_t TTextLayout::mStats;
+
+mutex _textLayout;
+
+shared_ptr<const TEXT_LAYOUT_t> TTextLayout::getLayout(const string& text, int width, int height, TEXT_WRAP wrap, const SkFont& font, const SkPaint& paint)
+{
+    DECL_TRACER("TTextLayout::getLayout(const string& text, int width, int height, TEXT_WRAP wrap, const SkFont& font, const SkPaint& paint)");
+
+    string key = makeKey(text, width, height, wrap, font, paint);
+
+    {
+        lock_guard<mutex> guard(_textLayout);
+        auto iter = mIndex.find(key);
+
+        if (iter != mIndex.end())
+        {
+            mStats.hits++;
+            mCache.splice(mCache.begin(), mCache, iter->second);
+            return iter->second->second;
+        }
+
+        mStats.misses++;
+    }
+
+    // The layout is calculated without holding the lock. If two threads
+    // calculate the same layout, the second one replaces the first.
+    shared_ptr<const TEXT_LAYOUT_t> layout = makeLayout(text, width, height, wrap, font, paint);
+    lock_guard<mutex> guard(_textLayout);
+    auto iter = mIndex.find(key);
+
+    if (iter != mIndex.end())
+    {
+        mCache.erase(iter->second);
+        mIndex.erase(iter);
+    }
+
+    mCache.emplace_front(key, layout);
+    mIndex.insert({key, mCache.begin()});
+
+    while (mCache.size() > TEXT_LAYOUT_MAX)
+    {
+        mIndex.erase(mCache.back().first);
+        mCache.pop_back();
+        mStats.evictions++;
+    }
+
+    return layout;
+}
+
+void TTextLayout::clear()
+{
+    DECL_TRACER("TTextLayout::clear()");
+
+    lock_guard<mutex> guard(_textLayout);
+    mIndex.clear();
+    mCache.clear();
+}
+
+TEXT_LAYOUT_STATS_t TTextLayout::getStatistics()
+{
+    DECL_TRACER("TTextLayout::getStatistics()");
+
+    lock_guard<mutex> guard(_textLayout);
+    TEXT_LAYOUT_STATS_t stats = mStats;
+    stats.entries = mCache.size();
+    return stats;
+}
+
+void TTextLayout::logStatistics()
+{
+    DECL_TRACER("TTextLayout::logStatistics()");
+
+    TEXT_LAYOUT_STATS_t stats = getStatistics();
+    uint64_t lookups = stats.hits + stats.misses;
+
+    MSG_INFO("Text layout cache: " << stats.entries << " layouts, hit rate " << (lookups ? stats.hits * 100 / lookups : 0) << "% of " << lookups << " lookups, " << stats.evictions << " evictions");
+}
+
+/*
+ * The key contains all attributes influencing the layout. The numbers are
+ * appended in binary form, followed by the text.
+ */
+string TTextLayout::makeKey(const string& text, int width, int height, TEXT_WRAP wrap, const SkFont& font, const SkPaint& paint)
+{
+    DECL_TRACER("TTextLayout::makeKey(const string& text, int width, int height, TEXT_WRAP wrap, const SkFont& font, const SkPaint& paint)");
+
+    struct
+    {
+        uint32_t typeface;
+        int32_t wrap;
+        int32_t width;
+        int32_t height;
+        SkScalar size;
+        SkScalar scaleX;
+        SkScalar skewX;
+        SkScalar strokeWidth;
+        uint8_t embolden;
+        uint8_t edging;
+        uint8_t style;
+        uint8_t pad;
+    }attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.typeface = font.getTypeface() ? font.getTypeface()->uniqueID() : 0;
+    attr.wrap = wrap;
+
+    // The size of the box matters only if the text is wrapped.
+    if (wrap == TW_WORDS)
+    {
+        attr.width = width;
+        attr.height = height;
+    }
+
+    attr.size = font.getSize();
+    attr.scaleX = font.getScaleX();
+    attr.skewX = font.getSkewX();
+    attr.strokeWidth = paint.getStrokeWidth();
+    attr.embolden = font.isEmbolden() ? 1 : 0;
+    attr.edging = static_cast<uint8_t>(font.getEdging());
+    attr.style = static_cast<uint8_t>(paint.getStyle());
+
+    string key(reinterpret_cast<const char *>(&attr), sizeof(attr));
+    key.append(text);
+    return key;
+}
+
+shared_ptr<const TEXT_LAYOUT_t> TTextLayout::makeLayout(const string& text, int width, int height, TEXT_WRAP wrap, const SkFont& font, const SkPaint& paint)
+{
+    DECL_TRACER("TTextLayout::makeLayout(const string& text, int width, int height, TEXT_WRAP wrap, const SkFont& font, const SkPaint& paint)");
+
+    shared_ptr<TEXT_LAYOUT_t> layout = std::make_shared<TEXT_LAYOUT_t>();
+    SkFont skFont = font;
+    SkPaint skPaint = paint;
+    vector<string> lines;
+
+    switch(wrap)
+    {
+        case TW_NONE:   lines.push_back(text); break;
+        case TW_BREAKS: lines = splitLine(text, false); break;
+        case TW_LINES:  lines = splitLine(text, true); break;
+        case TW_WORDS:  lines = splitLine(text, width, height, skFont, skPaint); break;
+    }
+
+    layout->lines.reserve(lines.size());
+
+    for (string& line : lines)
+    {
+        TEXT_LINE_t tl;
+        tl.text = std::move(line);
+        skFont.measureText(tl.text.data(), tl.text.size(), SkTextEncoding::kUTF8, &tl.bounds, &skPaint);
+        tl.blob = SkTextBlob::MakeFromString(tl.text.c_str(), skFont);
+
+        if (tl.bounds.width() > layout->maxWidth)
+            layout->maxWidth = tl.bounds.width();
+
+        layout->lines.push_back(std::move(tl));
+    }
+
+    return layout;
+}
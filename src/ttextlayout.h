@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#ifndef __TTEXTLAYOUT_H__
+#define __TTEXTLAYOUT_H__
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+
+#include <include/core/SkFont.h>
+#include <include/core/SkPaint.h>
+#include <include/core/SkRect.h>
+#include <include/core/SkTextBlob.h>
+
+typedef enum TEXT_WRAP
+{
+    TW_NONE,        // The text is a single line
+    TW_BREAKS,      // The text is split at line breaks only
+    TW_LINES,       // The text is split at line breaks and the pipe (|) only
+    TW_WORDS        // The text is wrapped to fit into the box
+}TEXT_WRAP;
+
+typedef struct TEXT_LINE_t
+{
+    std::string text;           // The text of the line
+    SkRect bounds;              // The bounds of the text measured with the font and paint
+    sk_sp<SkTextBlob> blob;     // The positioned glyphs of the line
+}TEXT_LINE_t;
+
+typedef struct TEXT_LAYOUT_t
+{
+    std::vector<TEXT_LINE_t> lines;
+    SkScalar maxWidth{0};       // The width of the widest line
+}TEXT_LAYOUT_t;
+
+typedef struct TEXT_LAYOUT_STATS_t
+{
+    size_t entries{0};          // Number of layouts in the cache
+    uint64_t hits{0};           // Number of layouts found in the cache
+    uint64_t misses{0};         // Number of layouts calculated
+    uint64_t evictions{0};      // Number of layouts removed because the cache was full
+}TEXT_LAYOUT_STATS_t;
+
+/**
+ * @brief The TTextLayout class
+ * This class caches the layout of the texts drawn on buttons and pages.
+ * A layout consists of the line breaks, the measured bounds and a text blob
+ * for each line. The key of a layout is the text together with the typeface,
+ * the font attributes, the size of the box and the wrap mode. Texts changing
+ * between a few values, like clocks or status lines, are therefore laid out
+ * only once.
+ *
+ * A layout never changes after it was created. It is shared with the caller
+ * by a pointer. The cache holds a limited number of layouts and removes the
+ * least recently used one if it is full.
+ */
+class TTextLayout
+{
+    public:
+        /**
+         * Returns the layout of a text. If the layout is not in the cache,
+         * it is calculated and added to the cache.
+         *
+         * @param text      The text.
+         * @param width     The width of the box. Used with TW_WORDS only.
+         * @param height    The height of the box. Used with TW_WORDS only.
+         * @param wrap      The way the text is split into lines.
+         * @param font      The font to measure and shape the text.
+         * @param paint     The paint used to draw the text.
+         *
+         * @return The layout of the text. The pointer is never empty.
+         */
+        static std::shared_ptr<const TEXT_LAYOUT_t> getLayout(const std::string& text, int width, int height, TEXT_WRAP wrap, const SkFont& font, const SkPaint& paint);
+        /**
+         * Removes all layouts from the cache. This must be called whenever
+         * the fonts were reloaded.
+         */
+        static void clear();
+        static TEXT_LAYOUT_STATS_t getStatistics();
+        static void logStatistics();
+
+    private:
+        typedef std::pair<std::string, std::shared_ptr<const TEXT_LAYOUT_t> > CACHE_ENTRY;
+
+        TTextLayout() {}
+
+        static std::string makeKey(const std::string& text, int width, int height, TEXT_WRAP wrap, const SkFont& font, const SkPaint& paint);
+        static std::shared_ptr<const TEXT_LAYOUT_t> makeLayout(const std::string& text, int width, int height, TEXT_WRAP wrap, const SkFont& font, const SkPaint& paint);
+
+        static std::list<CACHE_ENTRY> mCache;       // The layouts; the most recently used is at the front
+        static std::unordered_map<std::string, std::list<CACHE_ENTRY>::iterator> mIndex;
+        static TEXT_LAYOUT_STATS_t mStats;
+};
+
+#endif
@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#include <thread>
+#include <algorithm>
+
+#include "tthreadpool.h"
+#include "terror.h"
+
+#define POOL_MIN_THREADS    2
+#define POOL_MAX_THREADS    8
+
+using std::string;
+using std::map;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::chrono::steady_clock;
+using std::chrono::microseconds;
+using std::chrono::duration_cast;
+
+/*
+ * The workers are detached and may still wait for tasks when the
+ * application ends. Therefore the data of the pool is allocated once and
+ * never deleted. Otherwise the mutex and the condition could be destroyed
+ * while a worker is using them.
+ */
+TThreadPool::_POOL_t& TThreadPool::pool()
+{
+    static _POOL_t *p = new _POOL_t;
+    return *p;
+}
+
+bool TThreadPool::post(const string& name, std::function<void()> task)
+{
+    DECL_TRACER("TThreadPool::post(const string& name, std::function<void()> task)");
+
+    return postLimited(name, std::move(task), 0);
+}
+
+bool TThreadPool::postLimited(const string& name, std::function<void()> task, size_t maxRunning)
+{
+    DECL_TRACER("TThreadPool::postLimited(const string& name, std::function<void()> task, size_t maxRunning)");
+
+    _POOL_t& p = pool();
+
+    {
+        lock_guard<mutex> guard(p.mutex);
+
+        if (p.stop || !task)
+            return false;
+
+        if (!p.threads && !startWorkers(p))
+            return false;
+
+        // The name is stored once in the map of the statistics. The keys
+        // and values of a map are never moved, so the task can point to them.
+        map<string, _TASK_STATS>::iterator iter = p.stats.emplace(name, _TASK_STATS()).first;
+        _TASK_t t;
+        t.name = &iter->first;
+        t.stats = &iter->second;
+
+        if (maxRunning > 0)
+            t.limit = std::max(std::min(maxRunning, p.threads - 1), static_cast<size_t>(1));
+
+        t.func = std::move(task);
+        t.posted = steady_clock::now();
+        p.queue.push_back(std::move(t));
+    }
+
+    // A worker waiting because of a limit would not take the task. Therefore
+    // all workers are woken up.
+    p.cond.notify_all();
+    return true;
+}
+
+void TThreadPool::stop()
+{
+    DECL_TRACER("TThreadPool::stop()");
+
+    _POOL_t& p = pool();
+
+    {
+        lock_guard<mutex> guard(p.mutex);
+        p.stop = true;
+    }
+
+    p.cond.notify_all();
+}
+
+size_t TThreadPool::getThreads()
+{
+    _POOL_t& p = pool();
+    lock_guard<mutex> guard(p.mutex);
+    return p.threads;
+}
+
+size_t TThreadPool::getQueued()
+{
+    _POOL_t& p = pool();
+    lock_guard<mutex> guard(p.mutex);
+    return p.queue.size();
+}
+
+map<string, _TASK_STATS> TThreadPool::getStatistics()
+{
+    _POOL_t& p = pool();
+    lock_guard<mutex> guard(p.mutex);
+    return p.stats;
+}
+
+void TThreadPool::logStatistics()
+{
+    DECL_TRACER("TThreadPool::logStatistics()");
+
+    map<string, _TASK_STATS> stats = getStatistics();
+    map<string, _TASK_STATS>::iterator iter;
+
+    for (iter = stats.begin(); iter != stats.end(); ++iter)
+    {
+        if (!iter->second.count)
+            continue;
+
+        MSG_INFO("Task " << iter->first << ": " << iter->second.count << " runs, wait avg/max " << (iter->second.sumWait / iter->second.count) << "/" << iter->second.maxWait << " us, run avg/max " << (iter->second.sumRun / iter->second.count) << "/" << iter->second.maxRun << " us");
+    }
+}
+
+/*
+ * Must be called while the mutex is locked.
+ */
+bool TThreadPool::startWorkers(_POOL_t& p)
+{
+    DECL_TRACER("TThreadPool::startWorkers(_POOL_t& p)");
+
+    size_t cores = std::thread::hardware_concurrency();
+    size_t num = std::min(std::max(cores, static_cast<size_t>(POOL_MIN_THREADS)), static_cast<size_t>(POOL_MAX_THREADS));
+
+    for (size_t i = 0; i < num; ++i)
+    {
+        try
+        {
+            // The workers live as long as the application. Because they only
+            // wait for new tasks, they are detached.
+            std::thread thr(&TThreadPool::worker);
+            thr.detach();
+            p.threads++;
+        }
+        catch (std::exception& e)
+        {
+            MSG_ERROR("Error starting a worker thread: " << e.what());
+            break;
+        }
+    }
+
+    MSG_DEBUG("Started " << p.threads << " worker threads.");
+    return p.threads > 0;
+}
+
+/*
+ * Returns the first task in the queue which may run now. Tasks with a limit
+ * are skipped while the maximum number of them is running. Must be called
+ * while the mutex is locked.
+ */
+std::deque<TThreadPool::_TASK_t>::iterator TThreadPool::nextTask(_POOL_t& p)
+{
+    std::deque<_TASK_t>::iterator iter;
+
+    for (iter = p.queue.begin(); iter != p.queue.end(); ++iter)
+    {
+        if (!iter->limit || iter->stats->running < iter->limit)
+            break;
+    }
+
+    return iter;
+}
+
+void TThreadPool::worker()
+{
+    _POOL_t& p = pool();
+    unique_lock<mutex> lock(p.mutex);
+
+    while (true)
+    {
+        std::deque<_TASK_t>::iterator next;
+        p.cond.wait(lock, [&p, &next] { next = nextTask(p); return next != p.queue.end() || (p.stop && p.queue.empty()); });
+
+        if (p.queue.empty())
+            break;
+
+        _TASK_t t = std::move(*next);
+        p.queue.erase(next);
+        t.stats->running++;
+        lock.unlock();
+
+        steady_clock::time_point start = steady_clock::now();
+
+        try
+        {
+            t.func();
+        }
+        catch (std::exception& e)
+        {
+            MSG_ERROR("Task " << *t.name << " ended with an exception: " << e.what());
+        }
+
+        steady_clock::time_point end = steady_clock::now();
+        uint64_t wait = static_cast<uint64_t>(duration_cast<microseconds>(start - t.posted).count());
+        uint64_t run = static_cast<uint64_t>(duration_cast<microseconds>(end - start).count());
+
+        lock.lock();
+        _TASK_STATS& st = *t.stats;
+        st.running--;
+        st.count++;
+        st.sumWait += wait;
+        st.sumRun += run;
+        st.maxWait = std::max(st.maxWait, wait);
+        st.maxRun = std::max(st.maxRun, run);
+
+        // A task waiting for the end of this one may run now.
+        if (t.limit)
+            p.cond.notify_all();
+    }
+
+    p.threads--;
+}
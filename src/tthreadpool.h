@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#ifndef __TTHREADPOOL_H__
+#define __TTHREADPOOL_H__
+
+#include <string>
+#include <deque>
+#include <map>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+typedef struct _TASK_STATS
+{
+    uint64_t count{0};              // Number of finished tasks
+    uint64_t sumWait{0};            // Sum of the time in microseconds the tasks waited in the queue
+    uint64_t maxWait{0};            // Maximum time in microseconds a task waited in the queue
+    uint64_t sumRun{0};             // Sum of the run times in microseconds
+    uint64_t maxRun{0};             // Maximum run time of a task in microseconds
+    size_t running{0};              // Number of tasks currently running
+}_TASK_STATS;
+
+/**
+ * @brief The TThreadPool class
+ * This class runs short tasks in a fixed number of worker threads. It
+ * replaces the threads which were started and detached for every single
+ * event (button press, dynamic image, input line, ...). The number of
+ * workers depends on the number of CPU cores but is limited to
+ * POOL_MAX_THREADS. Tasks which are posted while all workers are busy wait
+ * in a queue and are started in the order they were posted.
+ *
+ * A task must not wait for another task, because this could block all
+ * workers. Tasks running endless (animations, timers) should not be started
+ * here. Tasks which may block for a longer time (downloads) must be posted
+ * with a limit of parallel runs. This way they can't occupy all workers.
+ *
+ * For each task name the class counts the number of runs, the time the
+ * tasks waited in the queue and the time they needed to run.
+ */
+class TThreadPool
+{
+    public:
+        /**
+         * Appends a task to the queue. The workers are started with the
+         * first call.
+         *
+         * @param name  A short name of the task. It is used for the
+         *              statistics.
+         * @param task  The function to execute.
+         *
+         * @return On success TRUE is returned. If the pool was stopped or no
+         * worker could be started, FALSE is returned and the task was not
+         * queued.
+         */
+        static bool post(const std::string& name, std::function<void()> task);
+        /**
+         * Appends a task to the queue like post() but limits the number of
+         * tasks with the name \p name running at the same time. The limit
+         * is never more than the number of workers minus one. This way at
+         * least one worker is always available for other tasks.
+         *
+         * @param name          A short name of the task.
+         * @param task          The function to execute.
+         * @param maxRunning    The maximum number of tasks with this name
+         *                      running in parallel.
+         *
+         * @return On success TRUE is returned.
+         */
+        static bool postLimited(const std::string& name, std::function<void()> task, size_t maxRunning);
+        /**
+         * Stops the workers. Tasks already in the queue are executed. Tasks
+         * posted later are rejected.
+         */
+        static void stop();
+        static size_t getThreads();
+        static size_t getQueued();
+        static std::map<std::string, _TASK_STATS> getStatistics();
+        static void logStatistics();
+
+    private:
+        TThreadPool() {}
+
+        typedef struct _TASK_t
+        {
+            const std::string *name{nullptr};
+            _TASK_STATS *stats{nullptr};
+            size_t limit{0};        // Maximum number of parallel runs; 0 = no limit
+            std::function<void()> func;
+            std::chrono::steady_clock::time_point posted;
+        }_TASK_t;
+
+        typedef struct _POOL_t
+        {
+            std::mutex mutex;
+            std::condition_variable cond;
+            std::deque<_TASK_t> queue;
+            std::map<std::string, _TASK_STATS> stats;
+            size_t threads{0};
+            bool stop{false};
+        }_POOL_t;
+
+        static _POOL_t& pool();
+        static bool startWorkers(_POOL_t& p);
+        static std::deque<_TASK_t>::iterator nextTask(_POOL_t& p);
+        static void worker();
+};
+
+#endif
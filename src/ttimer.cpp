@@ -28,100 +28,91 @@ TTimer::~TTimer()
 {
     DECL_TRACER("TTimer::~TTimer()");
 
-    if (mRunning)
-    {
-        mStopped = true;
-
-        while (mRunning)
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
+    stop();
 }
 
 void TTimer::run()
 {
     DECL_TRACER("TTimer::run()");
 
-    if (mRunning || mThread.joinable() || mMsec == std::chrono::milliseconds(0))
+    if (mRunning || mMsec == std::chrono::milliseconds(0))
         return;
 
-    try
-    {
-        mStopped = false;
-        mOnce = false;
-        mThread = std::thread([=] { this->_run(); });
-        mThread.detach();
-    }
-    catch (std::exception& e)
-    {
-        MSG_ERROR("Error starting the TTimer thread: " << e.what());
-    }
+    mStopped = false;
+    mOnce = false;
+    _run();
 }
 
 void TTimer::run_once()
 {
     DECL_TRACER("TTimer::run_once()");
 
-    if (mRunning || mThread.joinable() || mMsec == std::chrono::milliseconds(0))
+    if (mRunning || mMsec == std::chrono::milliseconds(0))
         return;
 
-    try
-    {
-        mStopped = false;
-        mOnce = true;
-        mThread = std::thread([=] { this->_run(); });
-        mThread.detach();
-    }
-    catch (std::exception& e)
-    {
-        MSG_ERROR("Error starting the TTimer thread: " << e.what());
-    }
+    mStopped = false;
+    mOnce = true;
+    _run();
 }
 
 void TTimer::run_once(std::chrono::milliseconds ms)
 {
     DECL_TRACER("TTimer::run_once(std::chrono::milliseconds ms)");
 
-    if (mRunning || mThread.joinable() || ms == std::chrono::milliseconds(0))
+    if (mRunning || ms == std::chrono::milliseconds(0))
         return;
 
-    try
-    {
-        mStopped = false;
-        mOnce = true;
-        mMsec = ms;
-        mThread = std::thread([=] { this->_run(); });
-        mThread.detach();
-    }
-    catch (std::exception& e)
-    {
-        MSG_ERROR("Error starting the TTimer thread: " << e.what());
-    }
+    mStopped = false;
+    mOnce = true;
+    mMsec = ms;
+    _run();
+}
+
+void TTimer::stop()
+{
+    DECL_TRACER("TTimer::stop()");
+
+    mStopped = true;
+    TTimerWheel::cancel(mTimerID);
+    mTimerID = 0;
+    mRunning = false;
 }
 
 void TTimer::_run()
 {
     DECL_TRACER("TTimer::_run()");
 
-    if (mRunning)
-        return;
-
     mRunning = true;
+    mTimerID = TTimerWheel::schedule(mMsec, (mOnce ? std::chrono::milliseconds(0) : mMsec), [this] { return _tick(); });
 
-    while (!mStopped && !prg_stopped)
+    if (!mTimerID)
     {
-        std::this_thread::sleep_for(mMsec);
+        MSG_ERROR("Error starting the timer!");
+        mRunning = false;
+    }
+}
 
-        if (mStopped)
-            break;
+/*
+ * This is called by the timer wheel every time the interval is over.
+ */
+bool TTimer::_tick()
+{
+    if (mStopped || prg_stopped)
+    {
+        mRunning = false;
+        return false;
+    }
 
-        if (_callback)
-            _callback(mCounter);
+    if (_callback)
+        _callback(mCounter);
 
-        mCounter++;
+    mCounter++;
 
-        if (mOnce)
-            break;
+    if (mOnce)
+    {
+        mRunning = false;
+        return false;
     }
 
-    mRunning = false;
+    return true;
 }
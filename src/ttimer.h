@@ -19,11 +19,12 @@
 #ifndef __TTIMER_H__
 #define __TTIMER_H__
 
-#include <thread>
 #include <chrono>
 #include <functional>
 #include <atomic>
 
+#include "ttimerwheel.h"
+
 typedef unsigned long int ulong;
 
 extern bool prg_stopped;
@@ -37,19 +38,20 @@ class TTimer
         void run();
         void run_once();
         void run_once(std::chrono::milliseconds ms);
-        void stop() { mStopped = true; }
+        void stop();
         void setInterval(std::chrono::milliseconds ms) { mMsec = ms; }
         void registerCallback(std::function<void(ulong)> callback) { _callback = callback; }
         bool isRunning() { return mRunning; }
 
     protected:
         void _run();
+        bool _tick();
 
     private:
         std::function<void(ulong)> _callback{nullptr};
         std::chrono::milliseconds mMsec{0};
         bool mOnce{false};
-        std::thread mThread;
+        TTimerWheel::TIMER_ID mTimerID{0};
         ulong mCounter{0};
         std::atomic<bool> mStopped{false};
         std::atomic<bool> mRunning{false};
@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#include "ttimerwheel.h"
+#include "terror.h"
+
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+/*
+ * The thread of the wheel is detached. Therefore the data is allocated
+ * once and never deleted, because the thread may still use it when the
+ * application ends.
+ */
+TTimerWheel::_WHEEL_t& TTimerWheel::wheel()
+{
+    static _WHEEL_t *w = new _WHEEL_t;
+    return *w;
+}
+
+TTimerWheel::TIMER_ID TTimerWheel::schedule(milliseconds delay, milliseconds interval, std::function<bool()> func)
+{
+    DECL_TRACER("TTimerWheel::schedule(milliseconds delay, milliseconds interval, std::function<bool()> func)");
+
+    if (!func)
+        return 0;
+
+    _WHEEL_t& w = wheel();
+    TIMER_ID id = 0;
+
+    {
+        lock_guard<mutex> guard(w.mutex);
+
+        if (w.stop)
+            return 0;
+
+        if (!w.running)
+        {
+            try
+            {
+                w.start = steady_clock::now();
+                w.now = 0;
+                std::thread thr(&TTimerWheel::run);
+                thr.detach();
+                w.running = true;
+            }
+            catch (std::exception& e)
+            {
+                MSG_ERROR("Error starting the thread of the timer wheel: " << e.what());
+                return 0;
+            }
+        }
+
+        // If there is no timer, the thread sleeps without turning the
+        // wheel. Then the wheel is moved to the actual time directly.
+        if (w.timers.empty())
+            w.now = currentTick(w);
+
+        id = w.nextID++;
+        _TIMER_t& t = w.timers[id];
+        t.expire = currentTick(w) + toTicks(delay);
+        t.interval = (interval.count() > 0) ? std::max(toTicks(interval), static_cast<uint64_t>(1)) : 0;
+        t.func = std::move(func);
+        insert(w, id, t);
+    }
+
+    w.cond.notify_one();
+    return id;
+}
+
+bool TTimerWheel::cancel(TIMER_ID id)
+{
+    DECL_TRACER("TTimerWheel::cancel(TIMER_ID id)");
+
+    if (!id)
+        return false;
+
+    _WHEEL_t& w = wheel();
+    unique_lock<mutex> lock(w.mutex);
+    std::unordered_map<TIMER_ID, _TIMER_t>::iterator iter = w.timers.find(id);
+
+    if (iter == w.timers.end())
+        return false;
+
+    if (iter->second.slot)
+    {
+        iter->second.slot->erase(iter->second.pos);
+        w.timers.erase(iter);
+        return true;
+    }
+
+    // The callback is running. It is removed by the thread when the
+    // callback returns.
+    iter->second.cancelled = true;
+
+    if (std::this_thread::get_id() != w.threadID)
+        w.done.wait(lock, [&w, id] { return w.runningID != id; });
+
+    return true;
+}
+
+bool TTimerWheel::isScheduled(TIMER_ID id)
+{
+    _WHEEL_t& w = wheel();
+    lock_guard<mutex> guard(w.mutex);
+    std::unordered_map<TIMER_ID, _TIMER_t>::iterator iter = w.timers.find(id);
+    return (iter != w.timers.end() && !iter->second.cancelled);
+}
+
+size_t TTimerWheel::getTimers()
+{
+    _WHEEL_t& w = wheel();
+    lock_guard<mutex> guard(w.mutex);
+    return w.timers.size();
+}
+
+void TTimerWheel::stop()
+{
+    DECL_TRACER("TTimerWheel::stop()");
+
+    _WHEEL_t& w = wheel();
+
+    {
+        lock_guard<mutex> guard(w.mutex);
+        w.stop = true;
+    }
+
+    w.cond.notify_all();
+}
+
+uint64_t TTimerWheel::toTicks(milliseconds ms)
+{
+    if (ms.count() <= 0)
+        return 0;
+
+    return static_cast<uint64_t>((ms.count() + WHEEL_TICK - 1) / WHEEL_TICK);
+}
+
+uint64_t TTimerWheel::currentTick(_WHEEL_t& w)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<milliseconds>(steady_clock::now() - w.start).count() / WHEEL_TICK);
+}
+
+/*
+ * Puts a timer into the slot matching it's expiration. The mutex must be
+ * locked.
+ */
+void TTimerWheel::insert(_WHEEL_t& w, TIMER_ID id, _TIMER_t& t)
+{
+    // A timer can't expire in a tick already handled.
+    if (t.expire <= w.now)
+        t.expire = w.now + 1;
+
+    uint64_t delta = t.expire - w.now;
+
+    if (delta < WHEEL_SLOTS0)
+        t.slot = &w.level0[t.expire & (WHEEL_SLOTS0 - 1)];
+    else if (delta < (WHEEL_SLOTS0 * WHEEL_SLOTS1))
+        t.slot = &w.level1[(t.expire >> WHEEL_BITS0) & (WHEEL_SLOTS1 - 1)];
+    else
+        t.slot = &w.overflow;
+
+    t.pos = t.slot->insert(t.slot->end(), id);
+}
+
+/*
+ * Moves all timers of a slot of a higher level down into the lower levels.
+ */
+void TTimerWheel::cascade(_WHEEL_t& w, SLOT_t& slot)
+{
+    SLOT_t list;
+    list.swap(slot);
+
+    for (TIMER_ID id : list)
+        insert(w, id, w.timers[id]);
+}
+
+/*
+ * Returns the next tick where something must be done. This is either the
+ * next occupied slot of the first level or the next turn of the first
+ * level, where the second level must be cascaded. If there is no timer at
+ * all, 0 is returned.
+ */
+uint64_t TTimerWheel::nextExpire(_WHEEL_t& w)
+{
+    if (w.timers.empty())
+        return 0;
+
+    uint64_t turn = (w.now | (WHEEL_SLOTS0 - 1)) + 1;
+
+    for (uint64_t tick = w.now + 1; tick < turn; ++tick)
+    {
+        if (!w.level0[tick & (WHEEL_SLOTS0 - 1)].empty())
+            return tick;
+    }
+
+    return turn;
+}
+
+void TTimerWheel::run()
+{
+    _WHEEL_t& w = wheel();
+    unique_lock<mutex> lock(w.mutex);
+    w.threadID = std::this_thread::get_id();
+
+    while (!w.stop && !prg_stopped)
+    {
+        uint64_t next = nextExpire(w);
+
+        if (!next)
+            w.cond.wait(lock);
+        else
+        {
+            steady_clock::time_point when = w.start + milliseconds(next * WHEEL_TICK);
+            w.cond.wait_until(lock, when);
+        }
+
+        if (w.stop)
+            break;
+
+        uint64_t target = currentTick(w);
+
+        while (w.now < target)
+        {
+            w.now++;
+
+            if ((w.now & ((WHEEL_SLOTS0 * WHEEL_SLOTS1) - 1)) == 0)
+                cascade(w, w.overflow);
+
+            if ((w.now & (WHEEL_SLOTS0 - 1)) == 0)
+                cascade(w, w.level1[(w.now >> WHEEL_BITS0) & (WHEEL_SLOTS1 - 1)]);
+
+            // The timers are taken one by one from the slot, because
+            // while a callback runs, other timers of the slot may be
+            // canceled.
+            SLOT_t& expired = w.level0[w.now & (WHEEL_SLOTS0 - 1)];
+
+            while (!expired.empty())
+            {
+                TIMER_ID id = expired.front();
+                expired.pop_front();
+                std::unordered_map<TIMER_ID, _TIMER_t>::iterator iter = w.timers.find(id);
+
+                if (iter == w.timers.end())
+                    continue;
+
+                // The references into an unordered_map stay valid, even if
+                // other timers are added while the mutex is unlocked.
+                _TIMER_t& t = iter->second;
+                t.slot = nullptr;
+                w.runningID = id;
+                bool again = false;
+                lock.unlock();
+
+                try
+                {
+                    again = t.func();
+                }
+                catch (std::exception& e)
+                {
+                    MSG_ERROR("Timer " << id << " ended with an exception: " << e.what());
+                }
+
+                lock.lock();
+                w.runningID = 0;
+
+                if (again && t.interval > 0 && !t.cancelled)
+                {
+                    t.expire += t.interval;
+                    insert(w, id, t);
+                }
+                else
+                    w.timers.erase(id);
+
+                w.done.notify_all();
+            }
+        }
+    }
+
+    w.running = false;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 by Andreas Theofilu <andreas@theosys.at>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#ifndef __TTIMERWHEEL_H__
+#define __TTIMERWHEEL_H__
+
+#include <list>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+extern bool prg_stopped;
+
+#define WHEEL_TICK          10      // Resolution of the timers in milliseconds
+#define WHEEL_BITS0         8       // The first level has 256 slots of one tick (2.56 seconds)
+#define WHEEL_BITS1         6       // The second level has 64 slots of 256 ticks (163.84 seconds)
+#define WHEEL_SLOTS0        (1 << WHEEL_BITS0)
+#define WHEEL_SLOTS1        (1 << WHEEL_BITS1)
+
+/**
+ * @brief The TTimerWheel class
+ * This is a hierarchical timer wheel. All timers of the application are
+ * handled by one single thread. A timer is placed into a slot depending on
+ * the time it expires. Timers expiring within the next 256 ticks are in the
+ * first level, timers expiring within the next 16384 ticks are in the second
+ * level. All other timers are in an overflow list. The second level and the
+ * overflow list are moved down to the first level when the wheel turns
+ * around. Therefore scheduling and canceling a timer is O(1).
+ *
+ * The thread sleeps until the next occupied slot is reached. Timers
+ * expiring in the same tick are handled with the same wakeup.
+ *
+ * The callbacks run in the thread of the wheel. They must be short and
+ * must not wait for other timers. A callback returns TRUE if the timer
+ * should be started again with it's interval. If it returns FALSE or the
+ * interval is 0, the timer is removed.
+ */
+class TTimerWheel
+{
+    public:
+        typedef uint64_t TIMER_ID;
+
+        /**
+         * Starts a new timer.
+         *
+         * @param delay     The time until the callback is called the first
+         *                  time.
+         * @param interval  The time between the following calls. If this is
+         *                  0, the callback is called only once.
+         * @param func      The callback.
+         *
+         * @return The ID of the timer. It is needed to cancel the timer. On
+         * error 0 is returned.
+         */
+        static TIMER_ID schedule(std::chrono::milliseconds delay, std::chrono::milliseconds interval, std::function<bool()> func);
+        /**
+         * Removes a timer. If the callback of the timer is running in the
+         * moment, the method waits until it finished. If the method is
+         * called from a callback, it doesn't wait.
+         *
+         * @param id    The ID of the timer.
+         *
+         * @return TRUE if the timer was found.
+         */
+        static bool cancel(TIMER_ID id);
+        static bool isScheduled(TIMER_ID id);
+        static size_t getTimers();
+        static void stop();
+
+    private:
+        TTimerWheel() {}
+
+        typedef std::list<TIMER_ID> SLOT_t;
+
+        typedef struct _TIMER_t
+        {
+            uint64_t expire{0};         // The tick the timer expires
+            uint64_t interval{0};       // The interval in ticks; 0 = only once
+            std::function<bool()> func;
+            SLOT_t *slot{nullptr};      // The slot containing the timer; nullptr while the callback runs
+            SLOT_t::iterator pos;       // The position in the slot
+            bool cancelled{false};      // TRUE = The timer was canceled while the callback was running
+        }_TIMER_t;
+
+        typedef struct _WHEEL_t
+        {
+            std::mutex mutex;
+            std::condition_variable cond;       // Wakes up the thread
+            std::condition_variable done;       // Signals the end of a callback
+            SLOT_t level0[WHEEL_SLOTS0];
+            SLOT_t level1[WHEEL_SLOTS1];
+            SLOT_t overflow;
+            std::unordered_map<TIMER_ID, _TIMER_t> timers;
+            TIMER_ID nextID{1};
+            TIMER_ID runningID{0};      // The timer whose callback runs in the moment
+            uint64_t now{0};            // The tick already handled
+            std::chrono::steady_clock::time_point start;
+            std::thread::id threadID;
+            bool running{false};
+            bool stop{false};
+        }_WHEEL_t;
+
+        static _WHEEL_t& wheel();
+        static uint64_t toTicks(std::chrono::milliseconds ms);
+        static uint64_t currentTick(_WHEEL_t& w);
+        static void insert(_WHEEL_t& w, TIMER_ID id, _TIMER_t& t);
+        static void cascade(_WHEEL_t& w, SLOT_t& slot);
+        static uint64_t nextExpire(_WHEEL_t& w);
+        static void run();
+};
+
+#endif